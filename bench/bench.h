@@ -0,0 +1,169 @@
+/*****************************************************************************
+ *
+ * @file bench.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Common helpers of the DSM benchmarks
+ *
+ *****************************************************************************/
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "machine.h"
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Monotonic time in seconds
+ */
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * qsort comparator of doubles, used for latency percentiles
+ */
+static inline int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * xorshift64* pseudo-random generator
+ */
+static inline uint64_t bench_rand(uint64_t* seed) {
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+    return *seed * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * Random input identifiers
+ */
+static inline void bench_random_inputs(int* inputs, size_t input_count, int input_list_size, uint64_t seed) {
+    for (size_t i = 0; i < input_count; i++) {
+        inputs[i] = (int) (bench_rand(&seed) % (uint64_t) input_list_size);
+    }
+}
+
+/**
+ * Random machine with every state reachable from the entry state 0
+ */
+static inline void bench_random_machine(struct machine_instance* machine, int state_count, int input_count,
+    int output_count, uint64_t seed)
+{
+    char buffer[32] = { 0 };
+
+    seed = seed * 0x9E3779B97F4A7C15ull + 1;
+
+    machine->state_list_size = state_count;
+    machine->input_list_size = input_count;
+    machine->output_list_size = output_count;
+    machine->entry_state = 0;
+
+    mem_stats_init(&machine->mem);
+
+    machine->input_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, input_count * sizeof(const char*));
+    for (int i = 0; i < input_count; i++) {
+        snprintf(buffer, sizeof(buffer), "i%d", i);
+        machine->input_list[i] = mem_strdup(&machine->mem, buffer);
+    }
+
+    machine_build_resolver(machine);
+
+    machine->output_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, output_count * sizeof(const char*));
+    for (int i = 0; i < output_count; i++) {
+        snprintf(buffer, sizeof(buffer), "o%d", i);
+        machine->output_list[i] = mem_strdup(&machine->mem, buffer);
+    }
+
+    machine->state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, state_count * sizeof(struct machine_state));
+    for (int i = 0; i < state_count; i++) {
+        snprintf(buffer, sizeof(buffer), "s%d", i);
+        machine->state_list[i].symbol = mem_strdup(&machine->mem, buffer);
+        machine->state_list[i].is_final = (bench_rand(&seed) & 1) != 0;
+    }
+
+    int* next_table = (int*) malloc((size_t) state_count * input_count * sizeof(int));
+    int* output_table = (int*) malloc((size_t) state_count * input_count * sizeof(int));
+
+    for (size_t i = 0; i < (size_t) state_count * input_count; i++) {
+        next_table[i] = (int) (bench_rand(&seed) % (uint64_t) state_count);
+        output_table[i] = (int) (bench_rand(&seed) % (uint64_t) (output_count + 1)) - 1;
+    }
+
+    /* Chain the states through the first input so all of them are reachable */
+    for (int i = 0; i + 1 < state_count; i++) {
+        next_table[(size_t) i * input_count] = i + 1;
+    }
+
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+    machine_build_dense(machine, next_table, output_table);
+
+    free(next_table);
+    free(output_table);
+}
+
+/**
+ * Random machine which rows are appended whole as the lazy machine does,
+ * packing of the large tables would dominate the benchmark
+ */
+static inline void bench_dense_machine(struct machine_instance* machine, int state_count, int input_count,
+    int output_count, uint64_t seed)
+{
+    char buffer[32] = { 0 };
+
+    bench_random_machine(machine, 1, input_count, output_count, seed);
+
+    mem_free_string(&machine->mem, machine->state_list[0].symbol);
+    mem_free(&machine->mem, MEM_CATEGORY_ENTITY, machine->state_list, sizeof(struct machine_state));
+    mem_free(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table,
+        machine->trans_table_size * sizeof(struct machine_trans));
+
+    machine->state_list_size = state_count;
+    machine->trans_table_size = state_count * input_count;
+    machine->state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, state_count * sizeof(struct machine_state));
+    machine->trans_table = (struct machine_trans*) mem_alloc(&machine->mem, MEM_CATEGORY_TABLE,
+        machine->trans_table_size * sizeof(struct machine_trans));
+
+    for (int i = 0; i < state_count; i++) {
+        struct machine_trans* row = &machine->trans_table[(size_t) i * input_count];
+
+        snprintf(buffer, sizeof(buffer), "s%d", i);
+        machine->state_list[i].symbol = mem_strdup(&machine->mem, buffer);
+        machine->state_list[i].is_final = (bench_rand(&seed) & 1) != 0;
+        machine->state_list[i].base = i * input_count;
+
+        for (int j = 0; j < input_count; j++) {
+            row[j].check = i;
+            row[j].next_state = (int) (bench_rand(&seed) % (uint64_t) state_count);
+            row[j].output = (int) (bench_rand(&seed) % (uint64_t) (output_count + 1)) - 1;
+        }
+
+        machine->state_list[i].default_trans = row[0];
+    }
+
+    machine_classify_states(machine);
+}
+
+#endif /* __BENCH_H__ */
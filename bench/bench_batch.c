@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "batch.h"
+#include "bench.h"
+
+#define BENCH_RECORD_COUNT ((size_t) 10 * 1000 * 1000)
+#define BENCH_MIN_RECORD_LEN ((size_t) 8)
+#define BENCH_MAX_RECORD_LEN ((size_t) 64)
+
+/**
+ * Validator-like machine: the last state is a dead error sink, every
+ * other state falls into it on a rare input
+ */
+static void bench_validator_machine(struct machine_instance* machine, int state_count, int input_count) {
+    bench_random_machine(machine, state_count, input_count, 1, 7);
+
+    int* next_table = (int*) malloc((size_t) state_count * input_count * sizeof(int));
+    int* output_table = (int*) malloc((size_t) state_count * input_count * sizeof(int));
+    uint64_t seed = 11;
+
+    for (int i = 0; i < state_count; i++) {
+        for (int j = 0; j < input_count; j++) {
+            int next_state = machine_get_next_state(machine, i, j);
+
+            if ((i == state_count - 1) || (bench_rand(&seed) % 64 == 0)) {
+                next_state = state_count - 1;
+            }
+            else if (next_state == state_count - 1) {
+                next_state = 0;
+            }
+
+            next_table[(size_t) i * input_count + j] = next_state;
+            output_table[(size_t) i * input_count + j] = MACHINE_EMPTY_OUTPUT;
+        }
+    }
+
+    machine->state_list[state_count - 1].is_final = false;
+
+    mem_free(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table,
+        machine->trans_table_size * sizeof(struct machine_trans));
+    machine_build_dense(machine, next_table, output_table);
+
+    free(next_table);
+    free(output_table);
+}
+
+int main(int argc, char** argv) {
+    const size_t record_count = (argc > 1) ? (size_t) strtoull(argv[1], NULL, 10) : BENCH_RECORD_COUNT;
+
+    struct machine_instance machine;
+    bench_validator_machine(&machine, 512, 32);
+
+    /* Packed records of random length */
+    size_t* offsets = (size_t*) malloc((record_count + 1) * sizeof(size_t));
+    uint64_t seed = 3;
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < record_count; i++) {
+        size_t length = BENCH_MIN_RECORD_LEN + bench_rand(&seed) % (BENCH_MAX_RECORD_LEN - BENCH_MIN_RECORD_LEN + 1);
+        offsets[i + 1] = offsets[i] + length;
+    }
+
+    int* symbols = (int*) malloc(offsets[record_count] * sizeof(int));
+    bench_random_inputs(symbols, offsets[record_count], machine.input_list_size, 5);
+
+    const size_t word_count = (record_count + 63) / 64;
+    uint64_t* reference = (uint64_t*) calloc(word_count, sizeof(uint64_t));
+    uint64_t* accepted = (uint64_t*) calloc(word_count, sizeof(uint64_t));
+    int* end_states = (int*) malloc(record_count * sizeof(int));
+
+    printf("Batch acceptance benchmark: %zu records of %zu-%zu symbols (%zu symbols total)\n\n",
+        record_count, BENCH_MIN_RECORD_LEN, BENCH_MAX_RECORD_LEN, offsets[record_count]);
+
+    /* Record by record with the reference single-step loop */
+    double start = bench_now();
+    for (size_t i = 0; i < record_count; i++) {
+        int state = machine.entry_state;
+
+        for (size_t j = offsets[i]; j < offsets[i + 1]; j++) {
+            state = machine_get_next_state(&machine, state, symbols[j]);
+        }
+
+        if (machine.state_list[state].is_final) {
+            reference[i / 64] |= (uint64_t) 1 << (i % 64);
+        }
+    }
+    double reference_time = bench_now() - start;
+
+    printf("%-34s %8.3f s %10.2f Mrec/s\n", "sequential single-step", reference_time,
+        record_count / reference_time * 1e-6);
+
+    /* Record by record with the early exit */
+    start = bench_now();
+    for (size_t i = 0; i < record_count; i++) {
+        bool is_accepted = false;
+        machine_accept(&machine, symbols + offsets[i], offsets[i + 1] - offsets[i], &is_accepted);
+
+        if (is_accepted) {
+            accepted[i / 64] |= (uint64_t) 1 << (i % 64);
+        }
+    }
+    double accept_time = bench_now() - start;
+
+    printf("%-34s %8.3f s %10.2f Mrec/s\n", "sequential machine_accept", accept_time,
+        record_count / accept_time * 1e-6);
+
+    if (memcmp(reference, accepted, word_count * sizeof(uint64_t)) != 0) {
+        fprintf(stderr, "machine_accept results differ from the reference\n");
+        return EXIT_FAILURE;
+    }
+
+    const int thread_counts[] = { 1, 2, 4, 0 };
+
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+        char label[64] = { 0 };
+
+        start = bench_now();
+        machine_accept_batch(&machine, symbols, offsets, record_count, accepted, NULL, thread_counts[i]);
+        double batch_time = bench_now() - start;
+
+        if (memcmp(reference, accepted, word_count * sizeof(uint64_t)) != 0) {
+            fprintf(stderr, "Batch results differ from the reference\n");
+            return EXIT_FAILURE;
+        }
+
+        if (thread_counts[i] > 0) {
+            snprintf(label, sizeof(label), "batch, %d thread(s)", thread_counts[i]);
+        }
+        else {
+            snprintf(label, sizeof(label), "batch, all threads");
+        }
+
+        printf("%-34s %8.3f s %10.2f Mrec/s %6.2fx\n", label, batch_time,
+            record_count / batch_time * 1e-6, reference_time / batch_time);
+    }
+
+    start = bench_now();
+    machine_accept_batch(&machine, symbols, offsets, record_count, accepted, end_states, 0);
+    double end_state_time = bench_now() - start;
+
+    printf("%-34s %8.3f s %10.2f Mrec/s %6.2fx\n", "batch with end states, all threads", end_state_time,
+        record_count / end_state_time * 1e-6, reference_time / end_state_time);
+
+    free(offsets);
+    free(symbols);
+    free(reference);
+    free(accepted);
+    free(end_states);
+    machine_free(&machine);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 10000)
+#define BENCH_INPUT_COUNT ((int) 32)
+#define BENCH_OUTPUT_COUNT ((int) 8)
+
+/**
+ * @struct Result of the build in the child process
+ */
+struct bench_build_result {
+    int is_built;
+    long base_rss_kb;
+    long peak_rss_kb;
+    size_t machine_bytes;
+    size_t machine_alloc_count;
+    double build_time;
+    uint64_t fingerprint;
+};
+
+/**
+ * Explicit script of the random machine, every (state, input) pair on its own line
+ */
+static void bench_write_script(FILE* fout, int state_count) {
+    uint64_t seed = 0x5EED;
+
+    fprintf(fout, "input");
+    for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+        fprintf(fout, " input%d", i);
+    }
+
+    fprintf(fout, "\noutput");
+    for (int i = 0; i < BENCH_OUTPUT_COUNT; i++) {
+        fprintf(fout, " output%d", i);
+    }
+
+    fprintf(fout, "\nstate entry state0\n");
+    for (int i = 1; i < state_count; i++) {
+        fprintf(fout, "state state%d\n", i);
+    }
+
+    for (int i = 0; i < state_count; i++) {
+        for (int j = 0; j < BENCH_INPUT_COUNT; j++) {
+            const int to_state = (j == 0) ? (i + 1) % state_count : (int) (bench_rand(&seed) % (uint64_t) state_count);
+            const int output = (int) (bench_rand(&seed) % (uint64_t) (BENCH_OUTPUT_COUNT + 1)) - 1;
+
+            if (output < 0) {
+                fprintf(fout, "trans state%d : input%d : state%d : -\n", i, j, to_state);
+            }
+            else {
+                fprintf(fout, "trans state%d : input%d : state%d : output%d\n", i, j, to_state, output);
+            }
+        }
+    }
+}
+
+static long bench_peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Parse the script and build the machine either copying the symbols or consuming the parser
+ */
+static void bench_build(const char* script_path, bool is_move, struct bench_build_result* result) {
+    memset(result, 0, sizeof(*result));
+    result->base_rss_kb = bench_peak_rss_kb();
+
+    struct dsml_parser* parser = dsml_parse_script(script_path);
+
+    if (parser == NULL) {
+        return;
+    }
+
+    struct machine_instance machine;
+    enum machine_status status = MACHINE_STATUS_SUCCESS;
+
+    double start_time = bench_now();
+
+    if (is_move) {
+        status = machine_init_move(&machine, parser);
+    }
+    else {
+        status = machine_init(&machine, parser);
+        dsml_parser_free(parser);
+        free(parser);
+    }
+
+    result->build_time = bench_now() - start_time;
+    result->peak_rss_kb = bench_peak_rss_kb();
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        return;
+    }
+
+    result->is_built = 1;
+    result->machine_bytes = mem_stats_bytes(&machine.mem);
+    result->machine_alloc_count = machine.mem.total_alloc_count;
+    result->fingerprint = machine_fingerprint(&machine);
+
+    machine_free(&machine);
+}
+
+/**
+ * Peak RSS is a process high-water mark, so every build runs in its own child
+ */
+static bool bench_build_child(const char* script_path, bool is_move, struct bench_build_result* result) {
+    int pipe_fd[2];
+
+    if (pipe(pipe_fd) != 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        close(pipe_fd[0]);
+        bench_build(script_path, is_move, result);
+        ssize_t written = write(pipe_fd[1], result, sizeof(*result));
+        _exit((written == (ssize_t) sizeof(*result)) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(pipe_fd[1]);
+
+    bool is_read = (pid > 0) && (read(pipe_fd[0], result, sizeof(*result)) == (ssize_t) sizeof(*result));
+
+    close(pipe_fd[0]);
+
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+
+    return is_read && result->is_built;
+}
+
+int main(int argc, char** argv) {
+    const int state_count = (argc > 1) ? atoi(argv[1]) : BENCH_STATE_COUNT;
+
+    char script_path[] = "/tmp/bench_build.XXXXXX";
+    int script_fd = mkstemp(script_path);
+
+    if (script_fd < 0) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create script\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE* fout = fdopen(script_fd, "w");
+    bench_write_script(fout, state_count);
+    long script_size = ftell(fout);
+    fclose(fout);
+
+    struct bench_build_result copy_result;
+    struct bench_build_result move_result;
+
+    bool is_built = bench_build_child(script_path, false, &copy_result) &&
+        bench_build_child(script_path, true, &move_result);
+
+    unlink(script_path);
+
+    if (!is_built) {
+        fprintf(stderr, "BENCH> ERROR: Build failed\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%d states x %d inputs, script %ld bytes\n", state_count, BENCH_INPUT_COUNT, script_size);
+    printf("build       peak RSS kB   above base kB   machine bytes   allocations   build ms\n");
+    printf("copy        %-13ld %-15ld %-15zu %-13zu %.2f\n", copy_result.peak_rss_kb,
+        copy_result.peak_rss_kb - copy_result.base_rss_kb, copy_result.machine_bytes,
+        copy_result.machine_alloc_count, copy_result.build_time * 1e3);
+    printf("move        %-13ld %-15ld %-15zu %-13zu %.2f\n", move_result.peak_rss_kb,
+        move_result.peak_rss_kb - move_result.base_rss_kb, move_result.machine_bytes,
+        move_result.machine_alloc_count, move_result.build_time * 1e3);
+
+    const bool is_match = (copy_result.fingerprint == move_result.fingerprint);
+
+    printf("machines %s\n", is_match ? "match" : "MISMATCH");
+    return is_match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "machine.h"
+#include "cache.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1000)
+#define BENCH_INPUT_COUNT ((int) 32)
+#define BENCH_WARM_COUNT ((int) 20)
+
+/**
+ * Remove cache entries and the directory
+ */
+static void bench_remove_dir(const char* dir_path) {
+    DIR* dir = opendir(dir_path);
+    struct dirent* entry;
+    char path[512];
+
+    while ((dir != NULL) && ((entry = readdir(dir)) != NULL)) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+            unlink(path);
+        }
+    }
+
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    rmdir(dir_path);
+}
+
+int main(int argc, char** argv) {
+    const int state_count = (argc > 1) ? atoi(argv[1]) : BENCH_STATE_COUNT;
+
+    char cache_dir[] = "/tmp/bench_cache.XXXXXX";
+    char script_path[sizeof(cache_dir) + 16];
+
+    if (mkdtemp(cache_dir) == NULL) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create cache directory\n");
+        return EXIT_FAILURE;
+    }
+
+    snprintf(script_path, sizeof(script_path), "%s.dsml", cache_dir);
+
+    /* Script of the random machine */
+    struct machine_instance source;
+    bench_random_machine(&source, state_count, BENCH_INPUT_COUNT, 16, 31);
+
+    FILE* fout = fopen(script_path, "w");
+    machine_write_script(&source, fout);
+    fclose(fout);
+
+    const uint64_t fingerprint = machine_fingerprint(&source);
+    machine_free(&source);
+
+    struct machine_instance machine;
+    bool is_hit = false;
+    int failure_count = 0;
+
+    for (uint32_t flags = 0; flags <= CACHE_FLAG_MINIMIZE; flags++) {
+        double start_time = bench_now();
+        enum cache_status status = cache_load_machine(&machine, script_path, cache_dir, flags, &is_hit);
+        double cold_time = bench_now() - start_time;
+
+        if ((status != CACHE_STATUS_SUCCESS) || is_hit) {
+            fprintf(stderr, "BENCH> ERROR: Cold compile failed\n");
+            return EXIT_FAILURE;
+        }
+
+        uint64_t cold_fingerprint = machine_fingerprint(&machine);
+        machine_free(&machine);
+
+        start_time = bench_now();
+        for (int i = 0; i < BENCH_WARM_COUNT; i++) {
+            status = cache_load_machine(&machine, script_path, cache_dir, flags, &is_hit);
+
+            if ((status != CACHE_STATUS_SUCCESS) || !is_hit || (machine_fingerprint(&machine) != cold_fingerprint)) {
+                failure_count++;
+            }
+
+            machine_free(&machine);
+        }
+        double warm_time = (bench_now() - start_time) / BENCH_WARM_COUNT;
+
+        if ((flags == 0) && (cold_fingerprint != fingerprint)) {
+            failure_count++;
+        }
+
+        printf("%d states x %d inputs%s: cold %.2f ms, warm %.2f ms (%.0fx)\n", state_count, BENCH_INPUT_COUNT,
+            (flags & CACHE_FLAG_MINIMIZE) ? ", minimized" : "", cold_time * 1e3, warm_time * 1e3,
+            cold_time / warm_time);
+    }
+
+    /* Corrupted entries are recompiled */
+    DIR* dir = opendir(cache_dir);
+    struct dirent* entry;
+    char path[512];
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", cache_dir, entry->d_name);
+            truncate(path, 100);
+        }
+    }
+
+    closedir(dir);
+
+    if ((cache_load_machine(&machine, script_path, cache_dir, 0, &is_hit) != CACHE_STATUS_SUCCESS) || is_hit ||
+        (machine_fingerprint(&machine) != fingerprint))
+    {
+        fprintf(stderr, "BENCH> ERROR: Corrupted entry is not recompiled\n");
+        failure_count++;
+    }
+
+    machine_free(&machine);
+
+    bench_remove_dir(cache_dir);
+    unlink(script_path);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "session.h"
+#include "bench.h"
+
+#define BENCH_SESSION_COUNT ((size_t) 1 << 20)
+#define BENCH_EVENT_COUNT ((size_t) 1 << 22)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_ROUND_COUNT ((int) 3)
+
+static const int BENCH_STATE_COUNT_LIST[] = { 1 << 10, 1 << 14, 1 << 17, 1 << 20, 1 << 22 };
+
+/**
+ * Random events, every session gets 4 events on average so waves are not trivial
+ */
+static void bench_random_events(struct session_event* events, size_t event_count, uint64_t seed) {
+    for (size_t i = 0; i < event_count; i++) {
+        events[i].session = (size_t) (bench_rand(&seed) % BENCH_SESSION_COUNT);
+        events[i].input = (int) (bench_rand(&seed) % (uint64_t) BENCH_INPUT_COUNT);
+    }
+}
+
+/**
+ * Sessions start in random states, so the events read random table rows
+ */
+static void bench_reset(struct session_table* table, int state_count, uint64_t seed) {
+    for (size_t i = 0; i < table->session_count; i++) {
+        table->state_list[i] = (int) (bench_rand(&seed) % (uint64_t) state_count);
+    }
+}
+
+static double bench_mode(struct session_table* table, int state_count, const struct session_event* events,
+    int* outputs, enum session_dispatch_mode mode)
+{
+    double total_time = 0.0;
+
+    for (int i = 0; i < BENCH_ROUND_COUNT; i++) {
+        bench_reset(table, state_count, 7);
+
+        const double start_time = bench_now();
+        session_table_dispatch(table, events, BENCH_EVENT_COUNT, outputs, mode);
+        total_time += bench_now() - start_time;
+    }
+
+    return total_time / BENCH_ROUND_COUNT / (double) BENCH_EVENT_COUNT;
+}
+
+static int bench_state_count(int state_count, const struct session_event* events, int* outputs,
+    int* reference_outputs, int* reference_states)
+{
+    struct machine_instance machine;
+    struct session_table table;
+    int failure_count = 0;
+
+    bench_dense_machine(&machine, state_count, BENCH_INPUT_COUNT, 8, 31);
+    session_table_init(&table, &machine, BENCH_SESSION_COUNT);
+
+    const double direct_time = bench_mode(&table, state_count, events, reference_outputs, SESSION_DISPATCH_DIRECT);
+    memcpy(reference_states, table.state_list, BENCH_SESSION_COUNT * sizeof(int));
+
+    const double grouped_time = bench_mode(&table, state_count, events, outputs, SESSION_DISPATCH_GROUPED);
+
+    failure_count += (memcmp(outputs, reference_outputs, BENCH_EVENT_COUNT * sizeof(int)) != 0);
+    failure_count += (memcmp(table.state_list, reference_states, BENCH_SESSION_COUNT * sizeof(int)) != 0);
+
+    const double auto_time = bench_mode(&table, state_count, events, outputs, SESSION_DISPATCH_AUTO);
+
+    failure_count += (memcmp(outputs, reference_outputs, BENCH_EVENT_COUNT * sizeof(int)) != 0);
+
+    const size_t machine_size = machine.trans_table_size * sizeof(struct machine_trans) +
+        machine.state_list_size * sizeof(struct machine_state);
+
+    printf("%-9d %-12zu %-10.2f %-10.2f %-10.2f %.2fx\n", state_count, machine_size / 1024, direct_time * 1e9,
+        grouped_time * 1e9, auto_time * 1e9, direct_time / grouped_time);
+
+    session_table_free(&table);
+    machine_free(&machine);
+
+    return failure_count;
+}
+
+int main(void) {
+    struct session_event* events = (struct session_event*) malloc(BENCH_EVENT_COUNT * sizeof(struct session_event));
+    int* outputs = (int*) malloc(BENCH_EVENT_COUNT * sizeof(int));
+    int* reference_outputs = (int*) malloc(BENCH_EVENT_COUNT * sizeof(int));
+    int* reference_states = (int*) malloc(BENCH_SESSION_COUNT * sizeof(int));
+    int failure_count = 0;
+
+    bench_random_events(events, BENCH_EVENT_COUNT, 3);
+
+    struct session_table table;
+    struct machine_instance machine;
+
+    bench_random_machine(&machine, 16, BENCH_INPUT_COUNT, 8, 5);
+    session_table_init(&table, &machine, BENCH_SESSION_COUNT);
+
+    printf("%zu events over %zu sessions, %d inputs, last level cache %zu KiB, ns per event\n",
+        BENCH_EVENT_COUNT, BENCH_SESSION_COUNT, BENCH_INPUT_COUNT, table.cache_size / 1024);
+    printf("states    machine KiB  direct     grouped    auto       speedup\n");
+
+    /* Invalid event leaves every session as it is */
+    struct session_event invalid_events[2] = { { 0, 0 }, { BENCH_SESSION_COUNT, 0 } };
+    int invalid_outputs[2];
+
+    if ((session_table_dispatch(&table, invalid_events, 2, invalid_outputs, SESSION_DISPATCH_GROUPED) !=
+        SESSION_STATUS_INVAL_PARAM) || (table.state_list[0] != machine.entry_state))
+    {
+        failure_count++;
+    }
+
+    session_table_free(&table);
+    machine_free(&machine);
+
+    for (size_t i = 0; i < sizeof(BENCH_STATE_COUNT_LIST) / sizeof(BENCH_STATE_COUNT_LIST[0]); i++) {
+        failure_count += bench_state_count(BENCH_STATE_COUNT_LIST[i], events, outputs, reference_outputs,
+            reference_states);
+    }
+
+    free(events);
+    free(outputs);
+    free(reference_outputs);
+    free(reference_states);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "machine.h"
+#include "replay.h"
+#include "dsmi.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1000)
+#define BENCH_SYMBOL_COUNT ((size_t) 2000000)
+#define BENCH_VERSION_COUNT ((int) 3)
+
+static const int BENCH_INPUT_COUNT_LIST[] = { 32, 300 };
+
+static long bench_file_size(const char* path) {
+    FILE* fin = fopen(path, "rb");
+
+    if (fin == NULL) {
+        return -1;
+    }
+
+    fseek(fin, 0, SEEK_END);
+    long size = ftell(fin);
+    fclose(fin);
+    return size;
+}
+
+/**
+ * Run machine versions of the same alphabet over the text log and over its stream
+ */
+static int bench_alphabet(int input_count, const char* log_path, const char* stream_path) {
+    struct machine_instance machine_list[BENCH_VERSION_COUNT];
+    int* inputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* reference_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int failure_count = 0;
+
+    for (int i = 0; i < BENCH_VERSION_COUNT; i++) {
+        bench_random_machine(&machine_list[i], BENCH_STATE_COUNT, input_count, 16, 50 + i);
+    }
+
+    bench_random_inputs(inputs, BENCH_SYMBOL_COUNT, input_count, 11);
+
+    FILE* log = fopen(log_path, "w+b");
+
+    for (size_t i = 0; i < BENCH_SYMBOL_COUNT; i++) {
+        fputs(machine_list[0].input_list[inputs[i]], log);
+        fputc((i % 8 == 7) ? '\n' : ' ', log);
+    }
+
+    fflush(log);
+
+    /* Text runs tokenize and resolve the log every time */
+    double start_time = bench_now();
+
+    for (int i = 0; i < BENCH_VERSION_COUNT; i++) {
+        if (replay_record(&machine_list[i], log, NULL, 0, NULL) != REPLAY_STATUS_SUCCESS) {
+            failure_count++;
+        }
+    }
+
+    const double text_time = (bench_now() - start_time) / BENCH_VERSION_COUNT;
+
+    fseek(log, 0, SEEK_SET);
+
+    start_time = bench_now();
+    enum dsmi_status status = dsmi_convert(log, stream_path);
+    const double convert_time = bench_now() - start_time;
+
+    fclose(log);
+
+    struct dsmi_stream stream;
+    double stream_time = 0.0;
+
+    if ((status != DSMI_STATUS_SUCCESS) || (dsmi_open(&stream, stream_path) != DSMI_STATUS_SUCCESS)) {
+        fprintf(stderr, "BENCH> ERROR: Failed to convert the log\n");
+        failure_count++;
+        goto EXIT;
+    }
+
+    for (int i = 0; i < BENCH_VERSION_COUNT; i++) {
+        int reference_state = machine_list[i].entry_state;
+        int state = machine_list[i].entry_state;
+
+        machine_run(&machine_list[i], inputs, BENCH_SYMBOL_COUNT, reference_outputs, &reference_state);
+
+        start_time = bench_now();
+        status = dsmi_bind(&stream, &machine_list[i]);
+
+        if (status == DSMI_STATUS_SUCCESS) {
+            status = dsmi_run(&stream, 0, stream.input_count, outputs, &state);
+        }
+
+        stream_time += bench_now() - start_time;
+
+        if ((status != DSMI_STATUS_SUCCESS) || (stream.input_count != BENCH_SYMBOL_COUNT) ||
+            (state != reference_state) ||
+            (memcmp(outputs, reference_outputs, BENCH_SYMBOL_COUNT * sizeof(int)) != 0))
+        {
+            failure_count++;
+        }
+    }
+
+    stream_time /= BENCH_VERSION_COUNT;
+
+    printf("%-8d %-8d %-11ld %-10ld %-7.1f %-10.2f %-10.2f %-10.2f %.1fx\n", input_count, stream.id_width,
+        bench_file_size(log_path), bench_file_size(stream_path),
+        (double) bench_file_size(log_path) / (double) bench_file_size(stream_path), convert_time * 1e3,
+        text_time * 1e3, stream_time * 1e3, text_time / stream_time);
+
+    /* Machine without one of the stream symbols is rejected */
+    struct machine_instance other;
+    bench_random_machine(&other, BENCH_STATE_COUNT, input_count - 1, 16, 60);
+
+    if (dsmi_bind(&stream, &other) != DSMI_STATUS_UNKNOWN_SYMBOL) {
+        failure_count++;
+    }
+
+    machine_free(&other);
+    dsmi_close(&stream);
+
+EXIT:
+
+    for (int i = 0; i < BENCH_VERSION_COUNT; i++) {
+        machine_free(&machine_list[i]);
+    }
+
+    free(inputs);
+    free(reference_outputs);
+    free(outputs);
+
+    return failure_count;
+}
+
+int main(void) {
+    char log_path[] = "/tmp/bench_dsmi.XXXXXX";
+    char stream_path[sizeof(log_path) + sizeof(DSMI_FILE_EXT)];
+    int log_fd = mkstemp(log_path);
+    int failure_count = 0;
+
+    if (log_fd < 0) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create log\n");
+        return EXIT_FAILURE;
+    }
+
+    close(log_fd);
+    snprintf(stream_path, sizeof(stream_path), "%s%s", log_path, DSMI_FILE_EXT);
+
+    printf("%zu symbols, %d states, times are per machine version\n", BENCH_SYMBOL_COUNT, BENCH_STATE_COUNT);
+    printf("inputs   width    text bytes  dsmi bytes ratio   convert ms text ms    dsmi ms    speedup\n");
+
+    for (size_t i = 0; i < sizeof(BENCH_INPUT_COUNT_LIST) / sizeof(BENCH_INPUT_COUNT_LIST[0]); i++) {
+        failure_count += bench_alphabet(BENCH_INPUT_COUNT_LIST[i], log_path, stream_path);
+    }
+
+    /* Truncated stream is rejected */
+    struct dsmi_stream stream;
+    FILE* log = fopen(log_path, "w+b");
+
+    fputs("a b c a b", log);
+    fseek(log, 0, SEEK_SET);
+
+    if ((dsmi_convert(log, stream_path) != DSMI_STATUS_SUCCESS) || (truncate(stream_path,
+        (off_t) (bench_file_size(stream_path) - 1)) != 0) || (dsmi_open(&stream, stream_path) != DSMI_STATUS_INVAL_FILE))
+    {
+        failure_count++;
+    }
+
+    fclose(log);
+    unlink(log_path);
+    unlink(stream_path);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "lazy.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 20000)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_BAND_SIZE ((int) 100)
+
+/**
+ * Transition function of the banded machine: any state resets to s0, the band
+ * of states moves to the next band on its own input, the last input jumps to s1
+ * everywhere except s0
+ */
+static void bench_target(int state_count, int state, int input, int* to_state, int* output) {
+    const int band = state / BENCH_BAND_SIZE;
+
+    *to_state = 0;
+    *output = -1;
+
+    if (input == BENCH_INPUT_COUNT - 1) {
+        *to_state = 1;
+        *output = 1;
+    }
+
+    if (input == band % (BENCH_INPUT_COUNT - 1)) {
+        *to_state = ((band + 1) * BENCH_BAND_SIZE) % state_count;
+        *output = band % 2;
+    }
+
+    if ((state == 0) && (input == BENCH_INPUT_COUNT - 1)) {
+        *to_state = 2;
+        *output = -1;
+    }
+}
+
+static void bench_write_header(FILE* fout, int state_count) {
+    fprintf(fout, "input");
+    for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+        fprintf(fout, " i%d", i);
+    }
+
+    fprintf(fout, "\noutput o0 o1\nstate entry s0\nstate s1..s%d\n", state_count - 1);
+}
+
+static void bench_write_explicit(FILE* fout, int state_count) {
+    int to_state = 0;
+    int output = 0;
+
+    bench_write_header(fout, state_count);
+
+    for (int i = 0; i < state_count; i++) {
+        for (int j = 0; j < BENCH_INPUT_COUNT; j++) {
+            bench_target(state_count, i, j, &to_state, &output);
+
+            if (output < 0) {
+                fprintf(fout, "trans s%d : i%d : s%d : -\n", i, j, to_state);
+            }
+            else {
+                fprintf(fout, "trans s%d : i%d : s%d : o%d\n", i, j, to_state, output);
+            }
+        }
+    }
+}
+
+static void bench_write_compact(FILE* fout, int state_count) {
+    bench_write_header(fout, state_count);
+
+    fprintf(fout, "trans * : * : s0 : -\n");
+    fprintf(fout, "trans * : i%d : s1 : o1\n", BENCH_INPUT_COUNT - 1);
+
+    for (int band = 0; band * BENCH_BAND_SIZE < state_count; band++) {
+        const int first = band * BENCH_BAND_SIZE;
+        const int last = (first + BENCH_BAND_SIZE < state_count) ? first + BENCH_BAND_SIZE - 1 : state_count - 1;
+
+        fprintf(fout, "trans s%d..s%d : i%d : s%d : o%d\n", first, last, band % (BENCH_INPUT_COUNT - 1),
+            ((band + 1) * BENCH_BAND_SIZE) % state_count, band % 2);
+    }
+
+    fprintf(fout, "trans s0 : i%d : s2 : -\n", BENCH_INPUT_COUNT - 1);
+}
+
+/**
+ * Parse the script and build the machine, the fingerprint of the machine is returned
+ */
+static uint64_t bench_compile(void (*write_fn)(FILE*, int), int state_count, long* script_size,
+    double* parse_time, double* build_time)
+{
+    FILE* script = tmpfile();
+
+    write_fn(script, state_count);
+    *script_size = ftell(script);
+    rewind(script);
+
+    double start_time = bench_now();
+    struct dsml_parser* parser = dsml_parse_stream(script);
+    *parse_time = bench_now() - start_time;
+
+    fclose(script);
+
+    if (parser == NULL) {
+        return 0;
+    }
+
+    /* Rows are appended whole, so the build cost does not depend on the table packing */
+    struct machine_lazy lazy;
+
+    start_time = bench_now();
+    if (machine_lazy_init(&lazy, parser) != MACHINE_STATUS_SUCCESS) {
+        dsml_parser_free(parser);
+        free(parser);
+        return 0;
+    }
+
+    machine_lazy_complete(&lazy);
+    *build_time = bench_now() - start_time;
+
+    uint64_t fingerprint = machine_fingerprint(&lazy.machine);
+    machine_lazy_free(&lazy);
+    return fingerprint;
+}
+
+int main(int argc, char** argv) {
+    const int state_count = (argc > 1) ? atoi(argv[1]) : BENCH_STATE_COUNT;
+
+    long explicit_size = 0;
+    long compact_size = 0;
+    double explicit_parse_time = 0.0;
+    double compact_parse_time = 0.0;
+    double explicit_build_time = 0.0;
+    double compact_build_time = 0.0;
+
+    uint64_t explicit_fingerprint = bench_compile(bench_write_explicit, state_count, &explicit_size,
+        &explicit_parse_time, &explicit_build_time);
+    uint64_t compact_fingerprint = bench_compile(bench_write_compact, state_count, &compact_size,
+        &compact_parse_time, &compact_build_time);
+
+    printf("%d states x %d inputs\n", state_count, BENCH_INPUT_COUNT);
+    printf("script      bytes        parse ms    build ms\n");
+    printf("explicit    %-12ld %-11.2f %.2f\n", explicit_size, explicit_parse_time * 1e3, explicit_build_time * 1e3);
+    printf("compact     %-12ld %-11.2f %.2f\n", compact_size, compact_parse_time * 1e3, compact_build_time * 1e3);
+
+    const bool is_match = (explicit_fingerprint != 0) && (explicit_fingerprint == compact_fingerprint);
+
+    printf("machines %s\n", is_match ? "match" : "MISMATCH");
+    return is_match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
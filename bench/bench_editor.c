@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "editor.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 2000)
+#define BENCH_INPUT_COUNT ((int) 32)
+#define BENCH_OUTPUT_COUNT ((int) 8)
+#define BENCH_EDIT_COUNT ((int) 1000000)
+#define BENCH_PUBLISH_COUNT ((int) 100)
+#define BENCH_RUN_COUNT ((size_t) 4096)
+
+/**
+ * Reader of the published versions, counts the versions which do not match their number
+ */
+struct bench_reader {
+    struct machine_editor* editor;
+    int* inputs;
+    int* outputs;
+    int state_offset;       /* State count less the version number */
+    atomic_int is_done;
+    long acquire_count;
+    int failure_count;
+};
+
+static void* bench_read(void* context) {
+    struct bench_reader* reader = (struct bench_reader*) context;
+
+    while (!atomic_load(&reader->is_done)) {
+        const struct machine_version* version = machine_editor_acquire(reader->editor);
+        int state = version->machine.entry_state;
+
+        /* Every published version adds one state */
+        if (version->machine.state_list_size - (int) version->number != reader->state_offset) {
+            reader->failure_count++;
+        }
+
+        machine_run(&version->machine, reader->inputs, BENCH_RUN_COUNT, reader->outputs, &state);
+        machine_editor_release(version);
+        reader->acquire_count++;
+    }
+
+    return NULL;
+}
+
+/**
+ * Old way of the edit: write the script, parse and validate it and build the machine
+ */
+static double bench_rebuild(const struct machine_instance* machine, double* validate_time) {
+    FILE* script = tmpfile();
+
+    machine_write_script(machine, script);
+    rewind(script);
+
+    double start_time = bench_now();
+    struct dsml_parser* parser = dsml_parse_stream(script);
+
+    fclose(script);
+
+    const double validate_start_time = bench_now();
+    dsml_validate_dsm(parser);
+    *validate_time = bench_now() - validate_start_time;
+
+    struct machine_instance rebuilt;
+    machine_init_move(&rebuilt, parser);
+
+    const double rebuild_time = bench_now() - start_time;
+
+    machine_free(&rebuilt);
+    return rebuild_time;
+}
+
+/**
+ * Count transitions of the current version which differ from the working copy
+ */
+static int bench_check_version(struct machine_editor* editor) {
+    const struct machine_version* version = machine_editor_acquire(editor);
+    int failure_count = (version->machine.state_list_size != editor->state_list_size);
+
+    for (int i = 0; (failure_count == 0) && (i < editor->state_list_size); i++) {
+        for (int j = 0; j < editor->input_list_size; j++) {
+            struct machine_trans trans = machine_get_trans(&version->machine, i, j);
+            const size_t pair = (size_t) i * editor->input_list_cap + j;
+
+            failure_count += (trans.next_state != editor->next_table[pair]) || (trans.output != editor->output_table[pair]);
+        }
+    }
+
+    machine_editor_release(version);
+    return failure_count;
+}
+
+/**
+ * Add state which transitions repeat the ones of the `source` state
+ */
+static int bench_add_state(struct machine_editor* editor, int source, int number) {
+    char symbol[32];
+    int state = 0;
+    int failure_count = 0;
+
+    snprintf(symbol, sizeof(symbol), "n%d", number);
+    failure_count += (machine_editor_add_state(editor, symbol, false, &state) != MACHINE_STATUS_SUCCESS);
+    failure_count += (machine_editor_add_state(editor, symbol, false, NULL) != MACHINE_STATUS_REDEF_SYMBOL);
+
+    for (int i = 0; i < editor->input_list_size; i++) {
+        const size_t pair = (size_t) source * editor->input_list_cap + i;
+
+        failure_count += (editor->missing_count != editor->input_list_size - i);
+        machine_editor_set_trans(editor, state, i, editor->next_table[pair], editor->output_table[pair]);
+    }
+
+    failure_count += (editor->missing_count != 0);
+    return failure_count;
+}
+
+int main(void) {
+    struct machine_instance machine;
+    struct machine_editor editor;
+    int failure_count = 0;
+
+    bench_random_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, BENCH_OUTPUT_COUNT, 1);
+
+    double validate_time = 0.0;
+    const double rebuild_time = bench_rebuild(&machine, &validate_time);
+
+    machine_editor_init(&editor, &machine);
+
+    /* Edits of the working copy */
+    uint64_t seed = 3;
+    int* edit_list = (int*) malloc(3 * BENCH_EDIT_COUNT * sizeof(int));
+
+    for (int i = 0; i < 3 * BENCH_EDIT_COUNT; i++) {
+        edit_list[i] = (int) (bench_rand(&seed) % (uint64_t) BENCH_STATE_COUNT);
+    }
+
+    double start_time = bench_now();
+
+    for (int i = 0; i < BENCH_EDIT_COUNT; i++) {
+        machine_editor_set_trans(&editor, edit_list[3 * i], edit_list[3 * i + 1] % BENCH_INPUT_COUNT,
+            edit_list[3 * i + 2], edit_list[3 * i + 2] % BENCH_OUTPUT_COUNT);
+        failure_count += (editor.missing_count != 0);
+    }
+
+    const double edit_time = (bench_now() - start_time) / BENCH_EDIT_COUNT;
+
+    /* New input leaves a transition of every state missing */
+    int input = 0;
+    machine_editor_add_input(&editor, "extra", &input);
+    failure_count += (editor.missing_count != BENCH_STATE_COUNT);
+    failure_count += (machine_editor_publish(&editor) != MACHINE_STATUS_MISSING_TRANS);
+
+    for (int i = 0; i < BENCH_STATE_COUNT; i++) {
+        machine_editor_set_trans(&editor, i, input, i, MACHINE_EMPTY_OUTPUT);
+    }
+
+    machine_editor_clear_trans(&editor, 0, input);
+    failure_count += (editor.missing_count != 1);
+    machine_editor_set_trans(&editor, 0, input, 0, MACHINE_EMPTY_OUTPUT);
+
+    start_time = bench_now();
+    failure_count += (machine_editor_publish(&editor) != MACHINE_STATUS_SUCCESS);
+    const double publish_time = bench_now() - start_time;
+
+    /* Published version matches the working copy */
+    failure_count += bench_check_version(&editor);
+
+    const struct machine_version* version = machine_editor_acquire(&editor);
+    failure_count += (version->number != 2);
+
+    const int state_offset = version->machine.state_list_size - (int) version->number;
+    machine_editor_release(version);
+
+    printf("%d states x %d inputs\n", BENCH_STATE_COUNT, BENCH_INPUT_COUNT);
+    printf("rebuild from script %10.2f ms\n", rebuild_time * 1e3);
+    printf("  of it validation  %10.2f ms\n", validate_time * 1e3);
+    printf("edit + check        %10.1f ns\n", edit_time * 1e9);
+    printf("publish, repacked   %10.2f ms\n", publish_time * 1e3);
+
+    /* Versions are replaced under the reader */
+    struct bench_reader reader = {
+        .editor = &editor,
+        .inputs = (int*) malloc(BENCH_RUN_COUNT * sizeof(int)),
+        .outputs = (int*) malloc(BENCH_RUN_COUNT * sizeof(int)),
+        .state_offset = state_offset,
+        .acquire_count = 0,
+        .failure_count = 0,
+    };
+
+    atomic_init(&reader.is_done, 0);
+    bench_random_inputs(reader.inputs, BENCH_RUN_COUNT, BENCH_INPUT_COUNT, 5);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, bench_read, &reader);
+
+    start_time = bench_now();
+
+    for (int i = 0; i < BENCH_PUBLISH_COUNT; i++) {
+        failure_count += bench_add_state(&editor, i, i);
+        failure_count += (machine_editor_publish(&editor) != MACHINE_STATUS_SUCCESS);
+    }
+
+    const double edit_publish_time = (bench_now() - start_time) / BENCH_PUBLISH_COUNT;
+
+    atomic_store(&reader.is_done, 1);
+    pthread_join(thread, NULL);
+
+    /* Rows of the patched versions are appended to the copied table */
+    failure_count += bench_check_version(&editor);
+
+    printf("add state + publish %10.2f ms, %ld reader acquires\n", edit_publish_time * 1e3, reader.acquire_count);
+
+    failure_count += reader.failure_count;
+
+    machine_editor_free(&editor);
+    free(edit_list);
+    free(reader.inputs);
+    free(reader.outputs);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "latency.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 256)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_INPUT_TOTAL ((size_t) 1 << 24)
+#define BENCH_VALUE_COUNT ((uint64_t) 1000000)
+
+static const size_t BENCH_BLOCK_SIZE_LIST[] = { 1, 16, 4096 };
+
+/**
+ * Quantile of the uniform 1..BENCH_VALUE_COUNT values is kept within a sub-bucket
+ */
+static int bench_check_quantile(const struct latency_histogram* histogram, double quantile) {
+    const double expected = quantile * (double) BENCH_VALUE_COUNT;
+    const double value = (double) latency_histogram_quantile(histogram, quantile);
+
+    return (value < expected * (1.0 - 1.0 / LATENCY_SUB_BUCKET_COUNT)) ||
+        (value > expected * (1.0 + 1.0 / LATENCY_SUB_BUCKET_COUNT));
+}
+
+static int bench_histogram(void) {
+    struct latency_histogram* histogram = (struct latency_histogram*) malloc(sizeof(struct latency_histogram));
+    int failure_count = 0;
+
+    latency_histogram_init(histogram, NULL, LATENCY_PATH_RUN);
+    failure_count += (latency_histogram_quantile(histogram, 0.5) != 0);
+
+    for (uint64_t i = 1; i <= BENCH_VALUE_COUNT; i++) {
+        latency_histogram_add(histogram, i, 1);
+    }
+
+    failure_count += bench_check_quantile(histogram, 0.5);
+    failure_count += bench_check_quantile(histogram, 0.99);
+    failure_count += bench_check_quantile(histogram, 0.999);
+    failure_count += (latency_histogram_quantile(histogram, 1.0) != BENCH_VALUE_COUNT);
+
+    /* Small values are exact, huge ones are clamped to the last bucket */
+    latency_histogram_init(histogram, NULL, LATENCY_PATH_RUN);
+    latency_histogram_add(histogram, 7, 3);
+    failure_count += (latency_histogram_quantile(histogram, 0.5) != 7);
+
+    latency_histogram_add(histogram, UINT64_MAX, 1);
+    failure_count += (latency_histogram_quantile(histogram, 1.0) < ((uint64_t) 1 << (LATENCY_VALUE_BITS - 1)));
+
+    free(histogram);
+    return failure_count;
+}
+
+/**
+ * Recorded calls of two machines are merged apart
+ */
+static int bench_record(void) {
+    int first = 0;
+    int second = 0;
+    struct latency_summary summary;
+    int failure_count = 0;
+
+    latency_clear();
+
+    for (int i = 0; i < 100; i++) {
+        latency_record(&first, LATENCY_PATH_RUN, latency_now(), 10);
+        latency_record(&second, LATENCY_PATH_DISPATCH, latency_now(), 1);
+    }
+
+    latency_summarize(&first, LATENCY_PATH_RUN, &summary);
+    failure_count += (summary.count != 1000) || (summary.p50 > summary.p99) || (summary.p99 > summary.max);
+
+    latency_summarize(&first, LATENCY_PATH_DISPATCH, &summary);
+    failure_count += (summary.count != 0);
+
+    latency_summarize(&second, LATENCY_PATH_DISPATCH, &summary);
+    failure_count += (summary.count != 100);
+
+    latency_clear();
+    latency_summarize(&first, LATENCY_PATH_RUN, &summary);
+    failure_count += (summary.count != 0);
+
+    return failure_count;
+}
+
+int main(void) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    failure_count += bench_histogram();
+    failure_count += bench_record();
+
+    bench_random_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, 8, 1);
+
+    int* inputs = (int*) malloc(BENCH_INPUT_TOTAL * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_INPUT_TOTAL * sizeof(int));
+
+    bench_random_inputs(inputs, BENCH_INPUT_TOTAL, BENCH_INPUT_COUNT, 3);
+
+#ifdef DSM_LATENCY
+    printf("latency histograms compiled in, one of %u calls timed\n", (unsigned int) LATENCY_SAMPLE_PERIOD);
+#else
+    printf("latency histograms compiled out\n");
+#endif
+
+    printf("%-12s %s\n", "block size", "ns per transition");
+
+    for (size_t i = 0; i < sizeof(BENCH_BLOCK_SIZE_LIST) / sizeof(BENCH_BLOCK_SIZE_LIST[0]); i++) {
+        const size_t block_size = BENCH_BLOCK_SIZE_LIST[i];
+        int state = machine.entry_state;
+
+        latency_clear();
+
+        const double start_time = bench_now();
+
+        for (size_t j = 0; j < BENCH_INPUT_TOTAL; j += block_size) {
+            machine_run(&machine, &inputs[j], block_size, &outputs[j], &state);
+        }
+
+        const double time = (bench_now() - start_time) / (double) BENCH_INPUT_TOTAL;
+
+        printf("%-12zu %.2f\n", block_size, time * 1e9);
+
+#ifdef DSM_LATENCY
+        struct latency_summary summary;
+        latency_summarize(&machine, LATENCY_PATH_RUN, &summary);
+
+        /* Every sampled call is recorded with all its events */
+        failure_count += (summary.count != BENCH_INPUT_TOTAL / LATENCY_SAMPLE_PERIOD);
+        latency_print(&machine, "random", stdout);
+#endif
+    }
+
+    latency_clear();
+    free(inputs);
+    free(outputs);
+    machine_free(&machine);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "lazy.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 20000)
+#define BENCH_REACHABLE_COUNT ((int) 2000)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_OUTPUT_COUNT ((int) 8)
+#define BENCH_SYMBOL_COUNT ((size_t) 10 * 1000 * 1000)
+
+/**
+ * Parser of the machine which first `reachable_count` states only lead to
+ * each other, the rest of the declared states is never entered
+ */
+static struct dsml_parser* bench_generated_parser(int state_count, int reachable_count) {
+    struct dsml_parser* parser = (struct dsml_parser*) malloc(sizeof(struct dsml_parser));
+    char buffer[32] = { 0 };
+    uint64_t seed = 13;
+
+    dsml_parser_init(parser);
+
+    for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), "i%d", i);
+        dsml_add_input(parser, buffer);
+    }
+
+    for (int i = 0; i < BENCH_OUTPUT_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), "o%d", i);
+        dsml_add_output(parser, buffer);
+    }
+
+    for (int i = 0; i < state_count; i++) {
+        snprintf(buffer, sizeof(buffer), "s%d", i);
+        dsml_add_state(parser, buffer, (bench_rand(&seed) & 1) != 0, i == 0);
+    }
+
+    parser->has_estate = true;
+
+    for (int i = 0; i < state_count; i++) {
+        int target_count = (i < reachable_count) ? reachable_count : state_count;
+
+        for (int j = 0; j < BENCH_INPUT_COUNT; j++) {
+            struct dsml_trans* trans =
+                (struct dsml_trans*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_trans));
+            int output = (int) (bench_rand(&seed) % (uint64_t) (BENCH_OUTPUT_COUNT + 1)) - 1;
+
+            trans->from_state = parser->state_list[i];
+            trans->to_state = parser->state_list[bench_rand(&seed) % (uint64_t) target_count];
+            trans->input = parser->input_list[j];
+            trans->output = (output < 0) ? NULL : parser->output_list[output];
+
+            dsml_add_trans(parser, trans);
+        }
+    }
+
+    return parser;
+}
+
+int main(int argc, char** argv) {
+    const int state_count = (argc > 1) ? atoi(argv[1]) : BENCH_STATE_COUNT;
+    const int reachable_count = (argc > 2) ? atoi(argv[2]) : BENCH_REACHABLE_COUNT;
+
+    struct dsml_parser* parser = bench_generated_parser(state_count, reachable_count);
+
+    int* inputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* eager_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* lazy_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+
+    bench_random_inputs(inputs, BENCH_SYMBOL_COUNT, BENCH_INPUT_COUNT, 17);
+
+    struct machine_instance eager;
+    struct machine_lazy lazy;
+    struct mem_stats stats;
+
+    double start_time = bench_now();
+    machine_init(&eager, parser);
+    double eager_init_time = bench_now() - start_time;
+
+    /* The lazy machine takes the parser over */
+    start_time = bench_now();
+    machine_lazy_init(&lazy, parser);
+    double lazy_init_time = bench_now() - start_time;
+
+    /* First pass builds the rows of the lazy machine */
+    int eager_state = eager.entry_state;
+    int lazy_state = lazy.machine.entry_state;
+
+    start_time = bench_now();
+    machine_lazy_run(&lazy, inputs, BENCH_SYMBOL_COUNT, lazy_outputs, &lazy_state);
+    double lazy_cold_time = bench_now() - start_time;
+
+    machine_run(&eager, inputs, BENCH_SYMBOL_COUNT, eager_outputs, &eager_state);
+
+    bool is_equal = (eager_state == lazy_state) &&
+        (memcmp(eager_outputs, lazy_outputs, BENCH_SYMBOL_COUNT * sizeof(int)) == 0);
+
+    /* Steady state */
+    start_time = bench_now();
+    machine_run(&eager, inputs, BENCH_SYMBOL_COUNT, eager_outputs, &eager_state);
+    double eager_run_time = bench_now() - start_time;
+
+    start_time = bench_now();
+    machine_lazy_run(&lazy, inputs, BENCH_SYMBOL_COUNT, lazy_outputs, &lazy_state);
+    double lazy_run_time = bench_now() - start_time;
+
+    printf("%d declared states, %d reachable, %d inputs\n", state_count, reachable_count, BENCH_INPUT_COUNT);
+    printf("%-6s %12s %14s %14s %14s\n", "engine", "init ms", "first ns/sym", "warm ns/sym", "table bytes");
+
+    machine_stats(&eager, &stats);
+    printf("%-6s %12.2f %14.2f %14.2f %14zu\n", "eager", eager_init_time * 1e3,
+        eager_run_time * 1e9 / BENCH_SYMBOL_COUNT, eager_run_time * 1e9 / BENCH_SYMBOL_COUNT,
+        stats.bytes[MEM_CATEGORY_TABLE]);
+
+    machine_stats(&lazy.machine, &stats);
+    printf("%-6s %12.2f %14.2f %14.2f %14zu (%d rows)\n", "lazy", lazy_init_time * 1e3,
+        lazy_cold_time * 1e9 / BENCH_SYMBOL_COUNT, lazy_run_time * 1e9 / BENCH_SYMBOL_COUNT,
+        stats.bytes[MEM_CATEGORY_TABLE], lazy.row_count);
+
+    printf("outputs %s\n", is_equal ? "match" : "DIFFER");
+
+    machine_free(&eager);
+    machine_lazy_free(&lazy);
+    free(inputs);
+    free(eager_outputs);
+    free(lazy_outputs);
+
+    return is_equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
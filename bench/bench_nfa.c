@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "nfa.h"
+#include "bench.h"
+
+#define BENCH_SYMBOL_COUNT ((size_t) 1 << 22)
+#define BENCH_ACCEPT_COUNT ((int) 1000)
+#define BENCH_ACCEPT_LENGTH ((int) 64)
+
+static const int BENCH_DISTANCE_LIST[] = { 4, 8, 12, 14 };
+
+/**
+ * Machine accepting the inputs which `distance`-th last symbol is 'a': s0 guesses
+ * the position of that symbol, s1..s<distance> count the symbols after it
+ */
+static void bench_write_distance(FILE* fout, int distance) {
+    fprintf(fout, "input a b\noutput y\nstate entry s0\n");
+    fprintf(fout, "state s1..s%d\nstate final s%d\n", distance - 1, distance);
+    fprintf(fout, "trans s0 : a b : s0 : -\ntrans s0 : a : s1 : -\n");
+
+    for (int i = 1; i < distance; i++) {
+        fprintf(fout, "trans s%d : a b : s%d : -\n", i, i + 1);
+    }
+}
+
+/**
+ * Two branches of the subset give different outputs on the second 'a'
+ */
+static void bench_write_conflict(FILE* fout, int distance) {
+    (void) distance;
+
+    fprintf(fout, "input a b\noutput y z\nstate entry s0\nstate s1 s2\n");
+    fprintf(fout, "trans s0 : a : s1 : -\ntrans s0 : a : s2 : -\n");
+    fprintf(fout, "trans s1 : a : s0 : y\ntrans s2 : a : s0 : z\n");
+}
+
+static struct dsml_parser* bench_parse(void (*write_fn)(FILE*, int), int distance) {
+    FILE* script = tmpfile();
+
+    write_fn(script, distance);
+    rewind(script);
+
+    struct dsml_parser* parser = dsml_parse_nfa_stream(script);
+
+    fclose(script);
+    return parser;
+}
+
+static enum machine_status bench_determinize(struct machine_instance* machine, void (*write_fn)(FILE*, int),
+    int distance, int state_budget, struct nfa_conflict* conflict)
+{
+    struct dsml_parser* parser = bench_parse(write_fn, distance);
+
+    if (parser == NULL) {
+        return MACHINE_STATUS_INVAL_PARSER;
+    }
+
+    enum machine_status status = machine_determinize(machine, parser, state_budget, conflict);
+
+    dsml_parser_free(parser);
+    free(parser);
+    return status;
+}
+
+static bool bench_expected(const int* inputs, int input_count, int distance) {
+    return (input_count >= distance) && (inputs[input_count - distance] == 0);
+}
+
+static int bench_distance(int distance, const int* inputs, int* outputs) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    double start_time = bench_now();
+    enum machine_status status = bench_determinize(&machine, bench_write_distance, distance,
+        NFA_DEFAULT_STATE_BUDGET, NULL);
+    const double build_time = bench_now() - start_time;
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        fprintf(stderr, "BENCH> ERROR: Failed to determinize distance %d\n", distance);
+        return 1;
+    }
+
+    /* Minimal deterministic machine remembers the last `distance` symbols */
+    failure_count += (machine.state_list_size != (1 << distance));
+
+    for (int i = 0; i < BENCH_ACCEPT_COUNT; i++) {
+        const int input_count = i % BENCH_ACCEPT_LENGTH;
+        bool is_accepted = false;
+
+        machine_accept(&machine, &inputs[i * BENCH_ACCEPT_LENGTH], input_count, &is_accepted);
+        failure_count += (is_accepted != bench_expected(&inputs[i * BENCH_ACCEPT_LENGTH], input_count, distance));
+    }
+
+    int state = machine.entry_state;
+
+    start_time = bench_now();
+    machine_run(&machine, inputs, BENCH_SYMBOL_COUNT, outputs, &state);
+    const double run_time = (bench_now() - start_time) / (double) BENCH_SYMBOL_COUNT;
+
+    failure_count += (machine.state_list[state].is_final != bench_expected(inputs, BENCH_SYMBOL_COUNT, distance));
+
+    printf("%-9d %-7d %-10d %-10.2f %.2f\n", distance, distance + 1, machine.state_list_size, build_time * 1e3,
+        run_time * 1e9);
+
+    machine_free(&machine);
+    return failure_count;
+}
+
+int main(void) {
+    int* inputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int failure_count = 0;
+
+    bench_random_inputs(inputs, BENCH_SYMBOL_COUNT, 2, 7);
+
+    printf("NFA states s0..s<distance>, %zu symbols run\n", BENCH_SYMBOL_COUNT);
+    printf("distance  states  dfa states build ms   run ns/symbol\n");
+
+    for (size_t i = 0; i < sizeof(BENCH_DISTANCE_LIST) / sizeof(BENCH_DISTANCE_LIST[0]); i++) {
+        failure_count += bench_distance(BENCH_DISTANCE_LIST[i], inputs, outputs);
+    }
+
+    /* Subsets past the budget are not built */
+    struct machine_instance machine;
+
+    if (bench_determinize(&machine, bench_write_distance, 12, 1000, NULL) != MACHINE_STATUS_STATE_BUDGET) {
+        failure_count++;
+    }
+
+    /* Conflict names the input and both states */
+    struct nfa_conflict conflict;
+
+    if ((bench_determinize(&machine, bench_write_conflict, 0, NFA_DEFAULT_STATE_BUDGET, &conflict) !=
+        MACHINE_STATUS_OUTPUT_CONFLICT) || (conflict.input != 0) ||
+        (conflict.state_list[0] != 1) || (conflict.state_list[1] != 2) ||
+        (conflict.output_list[0] != 0) || (conflict.output_list[1] != 1))
+    {
+        failure_count++;
+    }
+
+    /* Deterministic constructors reject the nondeterministic parser */
+    struct dsml_parser* parser = bench_parse(bench_write_distance, 4);
+
+    if ((parser == NULL) || (machine_init(&machine, parser) != MACHINE_STATUS_INVAL_PARSER)) {
+        failure_count++;
+    }
+
+    dsml_parser_free(parser);
+    free(parser);
+
+    free(inputs);
+    free(outputs);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
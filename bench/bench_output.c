@@ -0,0 +1,181 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1024)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_OUTPUT_COUNT ((int) 4)
+#define BENCH_BLOCK_SIZE ((size_t) 1 << 16)
+#define BENCH_STEP_COUNT ((uint64_t) 1 << 28)
+#define BENCH_CHECK_COUNT ((size_t) 1 << 20)
+#define BENCH_RUN_CAP ((size_t) 1024)
+
+/**
+ * One of `period` transitions has an output, a trace of rare events
+ */
+static void bench_sparse_outputs(struct machine_instance* machine, int period, uint64_t seed) {
+    for (int i = 0; i < machine->trans_table_size; i++) {
+        machine->trans_table[i].output = (bench_rand(&seed) % (uint64_t) period == 0) ?
+            (int) (bench_rand(&seed) % BENCH_OUTPUT_COUNT) : MACHINE_EMPTY_OUTPUT;
+    }
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        machine->state_list[i].default_trans.output = MACHINE_EMPTY_OUTPUT;
+    }
+}
+
+/**
+ * Counts and runs of the prefix match the full output list
+ */
+static int bench_check(const struct machine_instance* machine, const int* inputs) {
+    int* outputs = (int*) malloc(BENCH_CHECK_COUNT * sizeof(int));
+    uint64_t counts[BENCH_OUTPUT_COUNT] = { 0 };
+    uint64_t expected_counts[BENCH_OUTPUT_COUNT] = { 0 };
+    struct machine_output_run runs[BENCH_RUN_CAP];
+    int failure_count = 0;
+
+    int state = machine->entry_state;
+    int count_state = machine->entry_state;
+    int rle_state = machine->entry_state;
+
+    size_t run_count = 0;
+    size_t position = 0;    /* Next non-empty output the runs are compared with */
+
+    for (size_t first = 0; first < BENCH_CHECK_COUNT; first += BENCH_BLOCK_SIZE) {
+        machine_run(machine, &inputs[first % BENCH_BLOCK_SIZE], BENCH_BLOCK_SIZE, &outputs[first], &state);
+        machine_run_count(machine, &inputs[first % BENCH_BLOCK_SIZE], BENCH_BLOCK_SIZE, counts, &count_state);
+    }
+
+    /* Runs are drained from a small buffer, in uneven chunks */
+    for (size_t done = 0; done < BENCH_CHECK_COUNT;) {
+        const size_t block_left = BENCH_BLOCK_SIZE - done % BENCH_BLOCK_SIZE;
+        const size_t chunk = (block_left < 1000) ? block_left : 1000;
+        size_t input_done = 0;
+
+        machine_run_rle(machine, &inputs[done % BENCH_BLOCK_SIZE], chunk, runs, 8, &run_count, &input_done,
+            &rle_state);
+        done += input_done;
+
+        /* The last run is drained once the whole prefix is run */
+        const size_t drain_count = (done == BENCH_CHECK_COUNT) ? run_count : (run_count == 8) ? run_count - 1 : 0;
+
+        for (size_t i = 0; i < drain_count; i++) {
+            for (uint64_t j = 0; j < runs[i].count; j++) {
+                while ((position < BENCH_CHECK_COUNT) && (outputs[position] == MACHINE_EMPTY_OUTPUT)) {
+                    position++;
+                }
+
+                failure_count += (position == BENCH_CHECK_COUNT) || (outputs[position++] != runs[i].output);
+            }
+        }
+
+        if ((drain_count != 0) && (done < BENCH_CHECK_COUNT)) {
+            runs[0] = runs[run_count - 1];
+            run_count = 1;
+        }
+    }
+
+    while ((position < BENCH_CHECK_COUNT) && (outputs[position] == MACHINE_EMPTY_OUTPUT)) {
+        position++;
+    }
+
+    failure_count += (position != BENCH_CHECK_COUNT);
+
+    for (size_t i = 0; i < BENCH_CHECK_COUNT; i++) {
+        if (outputs[i] != MACHINE_EMPTY_OUTPUT) {
+            expected_counts[outputs[i]]++;
+        }
+    }
+
+    failure_count += (memcmp(counts, expected_counts, sizeof(counts)) != 0);
+    failure_count += (count_state != state) || (rle_state != state);
+
+    free(outputs);
+    return failure_count;
+}
+
+int main(void) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    /* Inputs of the block repeat, the inputs are not what is measured */
+    int* inputs = (int*) malloc(BENCH_BLOCK_SIZE * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_BLOCK_SIZE * sizeof(int));
+
+    bench_random_inputs(inputs, BENCH_BLOCK_SIZE, BENCH_INPUT_COUNT, 3);
+
+    printf("%llu steps, %d states x %d inputs, %d outputs\n", (unsigned long long) BENCH_STEP_COUNT,
+        BENCH_STATE_COUNT, BENCH_INPUT_COUNT, BENCH_OUTPUT_COUNT);
+    printf("%-8s %-8s %-10s %-14s %s\n", "period", "mode", "ns/step", "result KiB", "runs");
+
+    static const int period_list[] = { 1, 16, 1024 };
+
+    for (size_t p = 0; p < sizeof(period_list) / sizeof(period_list[0]); p++) {
+        bench_dense_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, BENCH_OUTPUT_COUNT, 1);
+        bench_sparse_outputs(&machine, period_list[p], 5);
+
+        failure_count += bench_check(&machine, inputs);
+
+        /* Full output list, a block is reused but the whole run would keep every slot */
+        int state = machine.entry_state;
+        double start_time = bench_now();
+
+        for (uint64_t i = 0; i < BENCH_STEP_COUNT; i += BENCH_BLOCK_SIZE) {
+            machine_run(&machine, inputs, BENCH_BLOCK_SIZE, outputs, &state);
+        }
+
+        double time = (bench_now() - start_time) / (double) BENCH_STEP_COUNT;
+        printf("%-8d %-8s %-10.2f %-14llu -\n", period_list[p], "outputs", time * 1e9,
+            (unsigned long long) (BENCH_STEP_COUNT * sizeof(int) / 1024));
+
+        uint64_t counts[BENCH_OUTPUT_COUNT] = { 0 };
+        state = machine.entry_state;
+        start_time = bench_now();
+
+        for (uint64_t i = 0; i < BENCH_STEP_COUNT; i += BENCH_BLOCK_SIZE) {
+            machine_run_count(&machine, inputs, BENCH_BLOCK_SIZE, counts, &state);
+        }
+
+        time = (bench_now() - start_time) / (double) BENCH_STEP_COUNT;
+        printf("%-8d %-8s %-10.2f %-14.2f -\n", period_list[p], "counts", time * 1e9, sizeof(counts) / 1024.0);
+
+        struct machine_output_run runs[BENCH_RUN_CAP];
+        size_t run_count = 0;
+        uint64_t total_run_count = 0;
+
+        state = machine.entry_state;
+        start_time = bench_now();
+
+        for (uint64_t i = 0; i < BENCH_STEP_COUNT; i += BENCH_BLOCK_SIZE) {
+            for (size_t done = 0; done < BENCH_BLOCK_SIZE;) {
+                size_t input_done = 0;
+
+                machine_run_rle(&machine, &inputs[done], BENCH_BLOCK_SIZE - done, runs, BENCH_RUN_CAP, &run_count,
+                    &input_done, &state);
+                done += input_done;
+
+                if (done < BENCH_BLOCK_SIZE) {
+                    total_run_count += run_count - 1;
+                    runs[0] = runs[run_count - 1];
+                    run_count = 1;
+                }
+            }
+        }
+
+        total_run_count += run_count;
+        time = (bench_now() - start_time) / (double) BENCH_STEP_COUNT;
+        printf("%-8d %-8s %-10.2f %-14.2f %llu\n", period_list[p], "runs", time * 1e9, sizeof(runs) / 1024.0,
+            (unsigned long long) total_run_count);
+
+        machine_free(&machine);
+    }
+
+    free(inputs);
+    free(outputs);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
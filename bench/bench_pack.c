@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "machine.h"
+#include "bench.h"
+
+#define BENCH_INPUT_COUNT ((int) 32)
+#define BENCH_OUTPUT_COUNT ((int) 8)
+
+/**
+ * Build time per state may grow by this factor from the smallest to the largest machine
+ */
+#define BENCH_MAX_GROWTH ((double) 3.0)
+
+static const int BENCH_STATE_COUNT_LIST[] = { 5000, 10000, 20000, 40000, 80000 };
+
+int main(void) {
+    const size_t case_count = sizeof(BENCH_STATE_COUNT_LIST) / sizeof(BENCH_STATE_COUNT_LIST[0]);
+    double first_time = 0.0;
+    double last_time = 0.0;
+    int failure_count = 0;
+
+    printf("%d inputs, random rows, table packed by machine_build_table\n", BENCH_INPUT_COUNT);
+    printf("%-8s %-10s %-12s %-12s %s\n", "states", "build ms", "ns/state", "table slots", "of dense");
+
+    for (size_t i = 0; i < case_count; i++) {
+        struct machine_instance machine;
+        const int state_count = BENCH_STATE_COUNT_LIST[i];
+
+        const double start_time = bench_now();
+        bench_random_machine(&machine, state_count, BENCH_INPUT_COUNT, BENCH_OUTPUT_COUNT, 1);
+        const double time = bench_now() - start_time;
+
+        const double dense_size = (double) state_count * BENCH_INPUT_COUNT;
+
+        /* Every exception is in its row */
+        for (int j = 0; j < 64; j++) {
+            const int state = (int) ((uint64_t) j * 7919 % (uint64_t) state_count);
+            failure_count += (machine_get_next_state(&machine, state, 0) != (state + 1) % state_count) &&
+                (state + 1 < state_count);
+        }
+
+        printf("%-8d %-10.2f %-12.1f %-12d %.3f\n", state_count, time * 1e3, time / state_count * 1e9,
+            machine.trans_table_size, machine.trans_table_size / dense_size);
+
+        if (i == 0) {
+            first_time = time / state_count;
+        }
+
+        last_time = time / state_count;
+        machine_free(&machine);
+    }
+
+    /* Packing must stay linear in the state count */
+    printf("growth of ns/state: %.2fx (max %.1fx)\n", last_time / first_time, BENCH_MAX_GROWTH);
+    failure_count += (last_time > BENCH_MAX_GROWTH * first_time);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
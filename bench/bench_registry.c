@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "registry.h"
+#include "bench.h"
+
+#define BENCH_FAMILY_COUNT ((int) 40)
+#define BENCH_VARIANT_COUNT ((int) 8)
+#define BENCH_STATE_COUNT ((int) 200)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_SYMBOL_COUNT ((size_t) 4096)
+
+/**
+ * Remove scripts and the directory
+ */
+static void bench_remove_dir(const char* dir_path) {
+    DIR* dir = opendir(dir_path);
+    struct dirent* entry;
+    char path[512];
+
+    while ((dir != NULL) && ((entry = readdir(dir)) != NULL)) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+            unlink(path);
+        }
+    }
+
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    rmdir(dir_path);
+}
+
+/**
+ * Variants of one family differ by the state names only, so they minimize to the same table
+ */
+static void bench_write_scripts(const char* dir_path) {
+    char path[512];
+    char symbol[64];
+
+    for (int i = 0; i < BENCH_FAMILY_COUNT; i++) {
+        struct machine_instance machine;
+        bench_random_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, 8, 100 + i);
+
+        for (int j = 0; j < BENCH_VARIANT_COUNT; j++) {
+            for (int k = 0; k < machine.state_list_size; k++) {
+                snprintf(symbol, sizeof(symbol), "f%dv%ds%d", i, j, k);
+                mem_free_string(&machine.mem, machine.state_list[k].symbol);
+                machine.state_list[k].symbol = mem_strdup(&machine.mem, symbol);
+            }
+
+            snprintf(path, sizeof(path), "%s/family%d_variant%d%s", dir_path, i, j, REGISTRY_SCRIPT_EXT);
+
+            FILE* fout = fopen(path, "w");
+            machine_write_script(&machine, fout);
+            fclose(fout);
+        }
+
+        machine_free(&machine);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int thread_count = (argc > 1) ? atoi(argv[1]) : 0;
+    const int script_count = BENCH_FAMILY_COUNT * BENCH_VARIANT_COUNT;
+
+    char dir_path[] = "/tmp/bench_registry.XXXXXX";
+    char path[512];
+
+    if (mkdtemp(dir_path) == NULL) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create script directory\n");
+        return EXIT_FAILURE;
+    }
+
+    bench_write_scripts(dir_path);
+
+    /* Serial baseline: every script parsed and built one after another */
+    struct machine_instance* serial_list =
+        (struct machine_instance*) malloc(script_count * sizeof(struct machine_instance));
+    size_t serial_bytes = 0;
+    int failure_count = 0;
+
+    double start_time = bench_now();
+
+    for (int i = 0; i < script_count; i++) {
+        snprintf(path, sizeof(path), "%s/family%d_variant%d%s", dir_path, i / BENCH_VARIANT_COUNT,
+            i % BENCH_VARIANT_COUNT, REGISTRY_SCRIPT_EXT);
+
+        struct dsml_parser* parser = dsml_parse_script(path);
+
+        if ((parser == NULL) || (machine_init(&serial_list[i], parser) != MACHINE_STATUS_SUCCESS)) {
+            fprintf(stderr, "BENCH> ERROR: Failed to build '%s'\n", path);
+            return EXIT_FAILURE;
+        }
+
+        dsml_parser_free(parser);
+        free(parser);
+
+        serial_bytes += mem_stats_bytes(&serial_list[i].mem);
+    }
+
+    const double serial_time = bench_now() - start_time;
+
+    /* Registry on one thread shows the minimization cost, then on the pool */
+    struct registry registry;
+    struct mem_stats stats;
+    double registry_time[2] = { 0.0, 0.0 };
+    const int registry_thread_count[2] = { 1, thread_count };
+
+    for (int i = 0; i < 2; i++) {
+        registry_init(&registry);
+
+        start_time = bench_now();
+        enum registry_status status = registry_load_dir(&registry, dir_path, registry_thread_count[i]);
+        registry_time[i] = bench_now() - start_time;
+
+        if ((status != REGISTRY_STATUS_SUCCESS) || (registry.entry_count != script_count)) {
+            fprintf(stderr, "BENCH> ERROR: Failed to load the registry\n");
+            return EXIT_FAILURE;
+        }
+
+        if (i == 0) {
+            registry_free(&registry);
+        }
+    }
+
+    registry_stats(&registry, &stats);
+
+    /* Registry machines behave as the serially built ones */
+    int* inputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* serial_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* registry_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+
+    bench_random_inputs(inputs, BENCH_SYMBOL_COUNT, BENCH_INPUT_COUNT, 5);
+
+    for (int i = 0; i < script_count; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "family%d_variant%d", i / BENCH_VARIANT_COUNT, i % BENCH_VARIANT_COUNT);
+
+        const struct machine_instance* machine = registry_find(&registry, name);
+        int serial_state = serial_list[i].entry_state;
+        int registry_state = (machine == NULL) ? 0 : machine->entry_state;
+
+        if (machine == NULL) {
+            failure_count++;
+            continue;
+        }
+
+        machine_run(&serial_list[i], inputs, BENCH_SYMBOL_COUNT, serial_outputs, &serial_state);
+        machine_run(machine, inputs, BENCH_SYMBOL_COUNT, registry_outputs, &registry_state);
+
+        if ((memcmp(serial_outputs, registry_outputs, BENCH_SYMBOL_COUNT * sizeof(int)) != 0) ||
+            (strcmp(serial_list[i].state_list[serial_state].symbol, machine->state_list[registry_state].symbol) != 0))
+        {
+            failure_count++;
+        }
+    }
+
+    if (registry_find(&registry, "missing") != NULL) {
+        failure_count++;
+    }
+
+    printf("%d scripts (%d families x %d variants), %d states x %d inputs\n", script_count, BENCH_FAMILY_COUNT,
+        BENCH_VARIANT_COUNT, BENCH_STATE_COUNT, BENCH_INPUT_COUNT);
+    printf("load                      time ms    bytes        tables\n");
+    printf("serial parse + init       %-10.2f %-12zu %d\n", serial_time * 1e3, serial_bytes, script_count);
+    printf("registry, 1 thread        %-10.2f\n", registry_time[0] * 1e3);
+    printf("registry, %-3d threads     %-10.2f %-12zu %d\n", (thread_count > 0) ? thread_count :
+        (int) sysconf(_SC_NPROCESSORS_ONLN), registry_time[1] * 1e3, mem_stats_bytes(&stats), registry.table_count);
+
+    registry_free(&registry);
+
+    for (int i = 0; i < script_count; i++) {
+        machine_free(&serial_list[i]);
+    }
+
+    free(serial_list);
+    free(inputs);
+    free(serial_outputs);
+    free(registry_outputs);
+    bench_remove_dir(dir_path);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "machine.h"
+#include "replay.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1000)
+#define BENCH_INPUT_COUNT ((int) 32)
+#define BENCH_SYMBOL_COUNT ((size_t) 5000000)
+#define BENCH_QUERY_COUNT ((int) 1000)
+#define BENCH_FULL_QUERY_COUNT ((int) 20)
+#define BENCH_QUERY_SPAN ((uint64_t) 100)
+
+static const uint64_t BENCH_INTERVAL_LIST[] = { 1024, 16384, 262144 };
+
+static long bench_file_size(const char* path) {
+    FILE* fin = fopen(path, "rb");
+
+    if (fin == NULL) {
+        return -1;
+    }
+
+    fseek(fin, 0, SEEK_END);
+    long size = ftell(fin);
+    fclose(fin);
+    return size;
+}
+
+/**
+ * Random queries of BENCH_QUERY_SPAN symbols, outputs are checked against the reference run.
+ * Latencies are sorted on return.
+ */
+static int bench_queries(const struct machine_instance* machine, const struct replay_index* index, FILE* log,
+    const int* reference_outputs, int query_count, double* latency_list)
+{
+    int outputs[BENCH_QUERY_SPAN];
+    uint64_t seed = 0xC0FFEE;
+    int failure_count = 0;
+
+    for (int i = 0; i < query_count; i++) {
+        const uint64_t first = bench_rand(&seed) % (BENCH_SYMBOL_COUNT - BENCH_QUERY_SPAN);
+        int state = 0;
+
+        double start_time = bench_now();
+        enum replay_status status =
+            replay_query(machine, index, log, first, first + BENCH_QUERY_SPAN, outputs, &state);
+        latency_list[i] = bench_now() - start_time;
+
+        if ((status != REPLAY_STATUS_SUCCESS) ||
+            (memcmp(outputs, &reference_outputs[first], sizeof(outputs)) != 0))
+        {
+            failure_count++;
+        }
+    }
+
+    qsort(latency_list, query_count, sizeof(double), bench_compare_double);
+    return failure_count;
+}
+
+int main(int argc, char** argv) {
+    const int state_count = (argc > 1) ? atoi(argv[1]) : BENCH_STATE_COUNT;
+
+    char log_path[] = "/tmp/bench_replay.XXXXXX";
+    char index_path[sizeof(log_path) + sizeof(REPLAY_FILE_EXT)];
+    int log_fd = mkstemp(log_path);
+
+    if (log_fd < 0) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create log\n");
+        return EXIT_FAILURE;
+    }
+
+    snprintf(index_path, sizeof(index_path), "%s%s", log_path, REPLAY_FILE_EXT);
+
+    struct machine_instance machine;
+    bench_random_machine(&machine, state_count, BENCH_INPUT_COUNT, 16, 43);
+
+    /* Log of random inputs, a few symbols per line, and the reference outputs */
+    int* inputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int* reference_outputs = (int*) malloc(BENCH_SYMBOL_COUNT * sizeof(int));
+    int state = machine.entry_state;
+
+    bench_random_inputs(inputs, BENCH_SYMBOL_COUNT, BENCH_INPUT_COUNT, 7);
+    machine_run(&machine, inputs, BENCH_SYMBOL_COUNT, reference_outputs, &state);
+
+    FILE* log = fdopen(log_fd, "w+b");
+
+    for (size_t i = 0; i < BENCH_SYMBOL_COUNT; i++) {
+        fputs(machine.input_list[inputs[i]], log);
+        fputc((i % 8 == 7) ? '\n' : ' ', log);
+    }
+
+    fflush(log);
+    free(inputs);
+
+    printf("%zu symbols, log %ld bytes, %d states x %d inputs\n", BENCH_SYMBOL_COUNT, bench_file_size(log_path),
+        state_count, BENCH_INPUT_COUNT);
+
+    /* Plain run over the log */
+    double start_time = bench_now();
+    replay_record(&machine, log, NULL, 0, NULL);
+    const double plain_time = bench_now() - start_time;
+
+    printf("plain run %.2f ms\n", plain_time * 1e3);
+    printf("interval    record ms   overhead   index bytes   p50 us     p99 us\n");
+
+    double* latency_list = (double*) malloc(BENCH_QUERY_COUNT * sizeof(double));
+    int failure_count = 0;
+
+    for (size_t i = 0; i < sizeof(BENCH_INTERVAL_LIST) / sizeof(BENCH_INTERVAL_LIST[0]); i++) {
+        const uint64_t interval = BENCH_INTERVAL_LIST[i];
+        struct replay_index index;
+
+        start_time = bench_now();
+        enum replay_status status = replay_record(&machine, log, NULL, interval, index_path);
+        const double record_time = bench_now() - start_time;
+
+        if ((status != REPLAY_STATUS_SUCCESS) ||
+            (replay_index_load(&index, index_path, &machine, log) != REPLAY_STATUS_SUCCESS))
+        {
+            fprintf(stderr, "BENCH> ERROR: Failed to record the index\n");
+            failure_count++;
+            continue;
+        }
+
+        failure_count += bench_queries(&machine, &index, log, reference_outputs, BENCH_QUERY_COUNT, latency_list);
+
+        printf("%-11llu %-11.2f %-10.1f %-13ld %-10.1f %.1f\n", (unsigned long long) interval, record_time * 1e3,
+            (record_time / plain_time - 1.0) * 100.0, bench_file_size(index_path),
+            latency_list[BENCH_QUERY_COUNT / 2] * 1e6, latency_list[BENCH_QUERY_COUNT * 99 / 100] * 1e6);
+
+        replay_index_free(&index);
+    }
+
+    /* Single checkpoint at the start is the replay from the beginning of the log */
+    struct replay_index index;
+
+    if ((replay_record(&machine, log, NULL, BENCH_SYMBOL_COUNT + 1, index_path) == REPLAY_STATUS_SUCCESS) &&
+        (replay_index_load(&index, index_path, &machine, log) == REPLAY_STATUS_SUCCESS))
+    {
+        failure_count +=
+            bench_queries(&machine, &index, log, reference_outputs, BENCH_FULL_QUERY_COUNT, latency_list);
+
+        printf("no index                                           %-10.1f %.1f\n",
+            latency_list[BENCH_FULL_QUERY_COUNT / 2] * 1e6, latency_list[BENCH_FULL_QUERY_COUNT * 99 / 100] * 1e6);
+
+        replay_index_free(&index);
+    }
+    else {
+        failure_count++;
+    }
+
+    /* Index of another machine is rejected */
+    struct machine_instance other;
+    bench_random_machine(&other, state_count, BENCH_INPUT_COUNT, 16, 44);
+
+    if (replay_index_load(&index, index_path, &other, log) != REPLAY_STATUS_INVAL_INDEX) {
+        fprintf(stderr, "BENCH> ERROR: Index of another machine is accepted\n");
+        failure_count++;
+    }
+
+    machine_free(&other);
+
+    fclose(log);
+    unlink(log_path);
+    unlink(index_path);
+
+    free(latency_list);
+    free(reference_outputs);
+    machine_free(&machine);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
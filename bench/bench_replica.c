@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "machine.h"
+#include "replica.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1 << 18)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_RUN_COUNT ((size_t) 1 << 22)
+#define BENCH_MAX_WORKERS ((int) 64)
+
+static const char* bench_pages_name_list[] = { "shared", "small", "transparent", "huge" };
+
+/**
+ * Worker runs the inputs on the replica of its node
+ */
+struct bench_worker {
+    const struct replica_set* set;          /* NULL runs the source machine */
+    const struct machine_instance* source;
+    const int* inputs;
+    int* outputs;
+    int end_state;
+    double time;
+};
+
+static void* bench_work(void* context) {
+    struct bench_worker* worker = (struct bench_worker*) context;
+    const struct machine_instance* machine =
+        (worker->set != NULL) ? replica_set_local(worker->set) : worker->source;
+
+    worker->end_state = machine->entry_state;
+
+    const double start_time = bench_now();
+    machine_run(machine, worker->inputs, BENCH_RUN_COUNT, worker->outputs, &worker->end_state);
+    worker->time = bench_now() - start_time;
+
+    return NULL;
+}
+
+/**
+ * Run a worker per processor, returns ns per transition and counts the
+ * workers which outputs differ from the reference
+ */
+static double bench_workers(const struct replica_set* set, const struct machine_instance* source,
+    const int* inputs, int* const* outputs, const int* reference_outputs, int reference_state,
+    int worker_count, int* failure_count)
+{
+    struct bench_worker worker_list[BENCH_MAX_WORKERS];
+    pthread_t thread_list[BENCH_MAX_WORKERS];
+    double total_time = 0.0;
+
+    for (int i = 0; i < worker_count; i++) {
+        worker_list[i] = (struct bench_worker) {
+            .set = set,
+            .source = source,
+            .inputs = inputs,
+            .outputs = outputs[i],
+        };
+
+        pthread_create(&thread_list[i], NULL, bench_work, &worker_list[i]);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(thread_list[i], NULL);
+        total_time += worker_list[i].time;
+
+        *failure_count += (worker_list[i].end_state != reference_state) ||
+            (memcmp(outputs[i], reference_outputs, BENCH_RUN_COUNT * sizeof(int)) != 0);
+    }
+
+    return total_time / worker_count / (double) BENCH_RUN_COUNT * 1e9;
+}
+
+int main(void) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    const int worker_count = (int) ((processor_count < 1) ? 1 :
+        (processor_count > BENCH_MAX_WORKERS) ? BENCH_MAX_WORKERS : processor_count);
+
+    bench_dense_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, 8, 1);
+
+    int* inputs = (int*) malloc(BENCH_RUN_COUNT * sizeof(int));
+    int* reference_outputs = (int*) malloc(BENCH_RUN_COUNT * sizeof(int));
+    int* outputs[BENCH_MAX_WORKERS];
+    int reference_state = machine.entry_state;
+
+    bench_random_inputs(inputs, BENCH_RUN_COUNT, BENCH_INPUT_COUNT, 3);
+    machine_run(&machine, inputs, BENCH_RUN_COUNT, reference_outputs, &reference_state);
+
+    for (int i = 0; i < worker_count; i++) {
+        outputs[i] = (int*) malloc(BENCH_RUN_COUNT * sizeof(int));
+    }
+
+    const size_t table_size = machine.trans_table_size * sizeof(struct machine_trans);
+
+    printf("%d states x %d inputs, table %zu KiB, %d workers, node of the main thread %d\n",
+        BENCH_STATE_COUNT, BENCH_INPUT_COUNT, table_size / 1024, worker_count, replica_current_node());
+    printf("%-22s %-9s %-12s %-6s %s\n", "tables", "replicas", "pages", "bound", "ns per transition");
+
+    printf("%-22s %-9d %-12s %-6s %.2f\n", "source", 1, "malloc", "-",
+        bench_workers(NULL, &machine, inputs, outputs, reference_outputs, reference_state, worker_count,
+            &failure_count));
+
+    const struct {
+        const char* name;
+        uint32_t flags;
+    } mode_list[] = {
+        { "replica", 0 },
+        { "replica huge", REPLICA_FLAG_HUGE_PAGES },
+        { "replica per node", REPLICA_FLAG_PER_NODE },
+        { "replica per node huge", REPLICA_FLAG_PER_NODE | REPLICA_FLAG_HUGE_PAGES },
+    };
+
+    for (size_t i = 0; i < sizeof(mode_list) / sizeof(mode_list[0]); i++) {
+        struct replica_set set;
+
+        if (replica_set_init(&set, &machine, mode_list[i].flags) != REPLICA_STATUS_SUCCESS) {
+            failure_count++;
+            continue;
+        }
+
+        const double time = bench_workers(&set, &machine, inputs, outputs, reference_outputs, reference_state,
+            worker_count, &failure_count);
+
+        /* Unknown nodes get the first replica */
+        failure_count += (replica_set_get(&set, -1) != &set.replica_list[0].machine);
+        failure_count += (replica_set_get(&set, REPLICA_MAX_NODES) != &set.replica_list[0].machine);
+
+        printf("%-22s %-9d %-12s %-6s %.2f\n", mode_list[i].name, set.replica_count,
+            bench_pages_name_list[set.replica_list[0].pages], set.replica_list[0].is_bound ? "yes" : "no", time);
+
+        replica_set_free(&set);
+    }
+
+    for (int i = 0; i < worker_count; i++) {
+        free(outputs[i]);
+    }
+
+    free(inputs);
+    free(reference_outputs);
+    machine_free(&machine);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
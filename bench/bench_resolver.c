@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "bench.h"
+
+#define BENCH_TOKEN_COUNT ((size_t) 1 << 20)
+#define BENCH_SYMBOL_LEN ((size_t) 64)
+
+static const int BENCH_INPUT_COUNT_LIST[] = { 16, 256, 4096, 65536 };
+
+/* Short symbols fit the resolver prefix, long ones are verified past it */
+static const char* BENCH_FORMAT_LIST[] = { "i%d", "sensor.temperature.reading.%d" };
+
+/**
+ * Single state machine with `input_count` inputs named by `format`
+ */
+static void bench_alphabet_machine(struct machine_instance* machine, int input_count, const char* format) {
+    char buffer[BENCH_SYMBOL_LEN] = { 0 };
+
+    mem_stats_init(&machine->mem);
+
+    machine->state_list_size = 1;
+    machine->input_list_size = input_count;
+    machine->output_list_size = 0;
+    machine->entry_state = 0;
+
+    machine->input_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, input_count * sizeof(const char*));
+    for (int i = 0; i < input_count; i++) {
+        snprintf(buffer, sizeof(buffer), format, i);
+        machine->input_list[i] = mem_strdup(&machine->mem, buffer);
+    }
+
+    machine_build_resolver(machine);
+
+    machine->output_list = NULL;
+    machine->state_list = (struct machine_state*) mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY,
+        sizeof(struct machine_state));
+    machine->state_list[0].symbol = mem_strdup(&machine->mem, "s");
+    machine->state_list[0].is_final = true;
+
+    int* next_table = (int*) calloc(input_count, sizeof(int));
+    int* output_table = (int*) malloc(input_count * sizeof(int));
+
+    for (int i = 0; i < input_count; i++) {
+        output_table[i] = MACHINE_EMPTY_OUTPUT;
+    }
+
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+    machine_build_dense(machine, next_table, output_table);
+
+    free(next_table);
+    free(output_table);
+}
+
+/**
+ * Lookup before the resolver: linear scan over the input list
+ */
+static int bench_scan_input(const struct machine_instance* machine, const char* symbol, size_t length) {
+    for (int i = 0; i < machine->input_list_size; i++) {
+        if ((strlen(machine->input_list[i]) == length) && (memcmp(machine->input_list[i], symbol, length) == 0)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int bench_alphabet(int input_count, const char* format) {
+    struct machine_instance machine;
+
+    double start_time = bench_now();
+    bench_alphabet_machine(&machine, input_count, format);
+    const double build_time = bench_now() - start_time;
+
+    /* Tokens of the stream, every 16th of them is not an input */
+    char* symbol_data = (char*) malloc(BENCH_TOKEN_COUNT * BENCH_SYMBOL_LEN);
+    const char** symbols = (const char**) malloc(BENCH_TOKEN_COUNT * sizeof(const char*));
+    size_t* lengths = (size_t*) malloc(BENCH_TOKEN_COUNT * sizeof(size_t));
+    int* expected = (int*) malloc(BENCH_TOKEN_COUNT * sizeof(int));
+    int* inputs = (int*) malloc(BENCH_TOKEN_COUNT * sizeof(int));
+    uint64_t seed = 17;
+    int failure_count = 0;
+
+    for (size_t i = 0; i < BENCH_TOKEN_COUNT; i++) {
+        char* symbol = &symbol_data[i * BENCH_SYMBOL_LEN];
+        const int input = (int) (bench_rand(&seed) % (uint64_t) input_count);
+
+        if (i % 16 == 15) {
+            snprintf(symbol, BENCH_SYMBOL_LEN, format, input + input_count);
+            expected[i] = -1;
+        }
+        else {
+            snprintf(symbol, BENCH_SYMBOL_LEN, format, input);
+            expected[i] = input;
+        }
+
+        symbols[i] = symbol;
+        lengths[i] = strlen(symbol);
+    }
+
+    /* Scan is linear in the alphabet size, so it is timed over a part of the tokens */
+    size_t scan_count = BENCH_TOKEN_COUNT * 16 / (size_t) input_count;
+    scan_count = (scan_count > BENCH_TOKEN_COUNT) ? BENCH_TOKEN_COUNT : scan_count;
+
+    start_time = bench_now();
+    for (size_t i = 0; i < scan_count; i++) {
+        inputs[i] = bench_scan_input(&machine, symbols[i], lengths[i]);
+    }
+    const double scan_time = (bench_now() - start_time) / (double) scan_count;
+
+    failure_count += (memcmp(inputs, expected, scan_count * sizeof(int)) != 0);
+
+    start_time = bench_now();
+    for (size_t i = 0; i < BENCH_TOKEN_COUNT; i++) {
+        inputs[i] = machine_find_input(&machine, symbols[i], lengths[i]);
+    }
+    const double find_time = (bench_now() - start_time) / (double) BENCH_TOKEN_COUNT;
+
+    failure_count += (memcmp(inputs, expected, BENCH_TOKEN_COUNT * sizeof(int)) != 0);
+    memset(inputs, 0, BENCH_TOKEN_COUNT * sizeof(int));
+
+    start_time = bench_now();
+    size_t unknown_count = machine_find_inputs(&machine, symbols, lengths, BENCH_TOKEN_COUNT, inputs);
+    const double bulk_time = (bench_now() - start_time) / (double) BENCH_TOKEN_COUNT;
+
+    failure_count += (memcmp(inputs, expected, BENCH_TOKEN_COUNT * sizeof(int)) != 0);
+    failure_count += (unknown_count != BENCH_TOKEN_COUNT / 16);
+
+    const size_t resolver_bytes = machine.resolver.bucket_count * sizeof(uint32_t) +
+        (size_t) input_count * sizeof(struct machine_resolver_slot);
+
+    printf("%-8d %-7zu %-9.2f %-11zu %-9.1f %-9.1f %.1f\n", input_count, strlen(machine.input_list[0]),
+        build_time * 1e3, resolver_bytes, scan_time * 1e9, find_time * 1e9, bulk_time * 1e9);
+
+    machine_free(&machine);
+    free(symbol_data);
+    free(symbols);
+    free(lengths);
+    free(expected);
+    free(inputs);
+
+    return failure_count;
+}
+
+int main(void) {
+    int failure_count = 0;
+
+    printf("%zu tokens, 1/16 unknown, ns per token\n", BENCH_TOKEN_COUNT);
+    printf("inputs   length  build ms  bytes       scan      find      bulk\n");
+
+    for (size_t i = 0; i < sizeof(BENCH_FORMAT_LIST) / sizeof(BENCH_FORMAT_LIST[0]); i++) {
+        for (size_t j = 0; j < sizeof(BENCH_INPUT_COUNT_LIST) / sizeof(BENCH_INPUT_COUNT_LIST[0]); j++) {
+            failure_count += bench_alphabet(BENCH_INPUT_COUNT_LIST[j], BENCH_FORMAT_LIST[i]);
+        }
+    }
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "token.h"
+#include "runner.h"
+#include "bench.h"
+
+#define BENCH_STATE_COUNT ((int) 1024)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_OUTPUT_COUNT ((int) 4)
+#define BENCH_STEP_COUNT ((size_t) 1 << 22)
+#define BENCH_MAX_CHUNK ((uint64_t) 4096)
+#define BENCH_PULL_SIZE ((size_t) 256)
+
+/**
+ * Stream as the upstream stage would send it, the chunk sizes are random
+ * so the symbols are split between chunks
+ */
+struct bench_stream {
+    const char* text;
+    size_t text_size;
+    const int* inputs;
+    uint64_t seed;
+    size_t position;
+};
+
+/**
+ * Result of the mode, the first output is timed from the arrival of the first chunk
+ */
+struct bench_result {
+    double step_time;
+    double first_time;
+    size_t memory_size;
+    int failure_count;
+};
+
+static size_t bench_chunk(struct bench_stream* stream, size_t size) {
+    size_t chunk = (size_t) (1 + bench_rand(&stream->seed) % BENCH_MAX_CHUNK);
+
+    if (chunk > size - stream->position) {
+        chunk = size - stream->position;
+    }
+
+    stream->position += chunk;
+    return chunk;
+}
+
+/**
+ * Whole stream is resolved and run at once, the outputs are there at the end
+ */
+static struct bench_result bench_batch(const struct machine_instance* machine, const char* text, size_t text_size,
+    const int* expected)
+{
+    struct bench_result result = { 0 };
+    struct tokenizer tokenizer;
+    const char* token = NULL;
+    size_t length = 0;
+    size_t input_count = 0;
+
+    const double start_time = bench_now();
+
+    int* inputs = (int*) malloc(BENCH_STEP_COUNT * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_STEP_COUNT * sizeof(int));
+
+    tokenizer_init(&tokenizer);
+    tokenizer_feed(&tokenizer, text, text_size);
+
+    while (tokenizer_next(&tokenizer, &token, &length) == TOKEN_STATUS_READY) {
+        inputs[input_count++] = machine_find_input(machine, token, length);
+    }
+
+    if (tokenizer_finish(&tokenizer, &token, &length) == TOKEN_STATUS_READY) {
+        inputs[input_count++] = machine_find_input(machine, token, length);
+    }
+
+    int state = machine->entry_state;
+    machine_run(machine, inputs, input_count, outputs, &state);
+
+    result.first_time = bench_now() - start_time;
+    result.step_time = result.first_time / (double) BENCH_STEP_COUNT;
+    result.memory_size = 2 * BENCH_STEP_COUNT * sizeof(int);
+    result.failure_count = (input_count != BENCH_STEP_COUNT) ||
+        (memcmp(outputs, expected, BENCH_STEP_COUNT * sizeof(int)) != 0);
+
+    free(inputs);
+    free(outputs);
+    return result;
+}
+
+/**
+ * Text chunks pulled from one output at a time, or `pull_size` outputs at a time
+ */
+static struct bench_result bench_text(const struct machine_instance* machine, const char* text, size_t text_size,
+    const int* expected, size_t pull_size)
+{
+    struct bench_result result = { 0 };
+    struct bench_stream stream = { text, text_size, NULL, 7, 0 };
+    struct machine_runner runner;
+    int outputs[BENCH_PULL_SIZE];
+    size_t step = 0;
+
+    const double start_time = bench_now();
+
+    machine_runner_init(&runner, machine);
+
+    while (stream.position < text_size) {
+        const char* chunk = &text[stream.position];
+        machine_runner_feed_text(&runner, chunk, bench_chunk(&stream, text_size));
+
+        for (;;) {
+            size_t output_count = 0;
+            enum runner_status status = RUNNER_STATUS_READY;
+
+            if (pull_size == 1) {
+                status = machine_runner_next(&runner, outputs);
+                output_count = (status == RUNNER_STATUS_READY);
+            }
+            else {
+                status = machine_runner_pull(&runner, outputs, pull_size, &output_count);
+            }
+
+            if ((step == 0) && (output_count != 0)) {
+                result.first_time = bench_now() - start_time;
+            }
+
+            for (size_t i = 0; i < output_count; i++) {
+                result.failure_count += (step == BENCH_STEP_COUNT) || (outputs[i] != expected[step]);
+                step++;
+            }
+
+            if (status != RUNNER_STATUS_READY) {
+                result.failure_count += (status != RUNNER_STATUS_NEED_INPUT);
+                break;
+            }
+        }
+    }
+
+    if (machine_runner_finish(&runner, outputs) == RUNNER_STATUS_READY) {
+        result.failure_count += (step == BENCH_STEP_COUNT) || (outputs[0] != expected[step]);
+        step++;
+    }
+
+    result.step_time = (bench_now() - start_time) / (double) BENCH_STEP_COUNT;
+    result.memory_size = sizeof(runner) + pull_size * sizeof(int);
+    result.failure_count += (step != BENCH_STEP_COUNT) || (runner.step_count != BENCH_STEP_COUNT);
+
+    return result;
+}
+
+/**
+ * Identifier chunks of the previous stage pulled one output at a time
+ */
+static struct bench_result bench_inputs(const struct machine_instance* machine, const int* inputs,
+    const int* expected)
+{
+    struct bench_result result = { 0 };
+    struct bench_stream stream = { NULL, 0, inputs, 9, 0 };
+    struct machine_runner runner;
+    size_t step = 0;
+    int output = 0;
+
+    const double start_time = bench_now();
+
+    machine_runner_init(&runner, machine);
+
+    while (stream.position < BENCH_STEP_COUNT) {
+        const int* chunk = &inputs[stream.position];
+        machine_runner_feed_inputs(&runner, chunk, bench_chunk(&stream, BENCH_STEP_COUNT));
+
+        while (machine_runner_next(&runner, &output) == RUNNER_STATUS_READY) {
+            if (step == 0) {
+                result.first_time = bench_now() - start_time;
+            }
+
+            result.failure_count += (output != expected[step++]);
+        }
+    }
+
+    result.step_time = (bench_now() - start_time) / (double) BENCH_STEP_COUNT;
+    result.memory_size = sizeof(runner);
+    result.failure_count += (step != BENCH_STEP_COUNT);
+
+    return result;
+}
+
+/**
+ * Unknown and too long symbols are skipped without a step, the run resumes from a checkpoint
+ */
+static int bench_errors(const struct machine_instance* machine) {
+    static const char text[] = "i1 bogus i2 i";
+    struct machine_runner runner;
+    char long_token[TOKEN_MAX_LEN + 2];
+    int output = 0;
+    int failure_count = 0;
+
+    memset(long_token, 'i', sizeof(long_token) - 1);
+    long_token[sizeof(long_token) - 1] = ' ';
+
+    machine_runner_init(&runner, machine);
+    machine_runner_feed_text(&runner, text, sizeof(text) - 1);
+
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_READY);
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_UNKNOWN_INPUT);
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_READY);
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_NEED_INPUT);
+
+    /* Last symbol continues in the next chunk */
+    machine_runner_feed_text(&runner, "3", 1);
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_NEED_INPUT);
+    failure_count += (machine_runner_finish(&runner, &output) != RUNNER_STATUS_READY);
+    failure_count += (runner.step_count != 3);
+
+    int state = machine->entry_state;
+    const int inputs[] = { 1, 2, 3 };
+    int outputs[3];
+
+    machine_run(machine, inputs, 3, outputs, &state);
+    failure_count += (runner.state != state) || (output != outputs[2]);
+
+    machine_runner_resume(&runner, state, 3);
+    machine_runner_feed_text(&runner, long_token, sizeof(long_token));
+
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_TOO_LONG);
+    failure_count += (machine_runner_next(&runner, &output) != RUNNER_STATUS_NEED_INPUT);
+    failure_count += (runner.state != state) || (runner.step_count != 3);
+
+    return failure_count;
+}
+
+static void bench_print(const char* mode, struct bench_result result) {
+    printf("%-22s %-10.2f %-16.0f %zu\n", mode, result.step_time * 1e9, result.first_time * 1e9,
+        result.memory_size);
+}
+
+int main(void) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    bench_dense_machine(&machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, BENCH_OUTPUT_COUNT, 1);
+
+    int* inputs = (int*) malloc(BENCH_STEP_COUNT * sizeof(int));
+    int* expected = (int*) malloc(BENCH_STEP_COUNT * sizeof(int));
+    char* text = (char*) malloc(BENCH_STEP_COUNT * 8);
+    size_t text_size = 0;
+
+    bench_random_inputs(inputs, BENCH_STEP_COUNT, BENCH_INPUT_COUNT, 3);
+
+    /* The stream ends without a separator, its last symbol is taken by the finish */
+    for (size_t i = 0; i < BENCH_STEP_COUNT; i++) {
+        text_size += (size_t) sprintf(&text[text_size], (i + 1 < BENCH_STEP_COUNT) ? "%s " : "%s",
+            machine.input_list[inputs[i]]);
+    }
+
+    int state = machine.entry_state;
+    machine_run(&machine, inputs, BENCH_STEP_COUNT, expected, &state);
+
+    printf("%zu steps, %d states x %d inputs, chunks of 1 to %llu\n", BENCH_STEP_COUNT, BENCH_STATE_COUNT,
+        BENCH_INPUT_COUNT, (unsigned long long) BENCH_MAX_CHUNK);
+    printf("%-22s %-10s %-16s %s\n", "mode", "ns/step", "first output ns", "memory bytes");
+
+    struct bench_result result = bench_batch(&machine, text, text_size, expected);
+    failure_count += result.failure_count;
+    bench_print("text, batch", result);
+
+    result = bench_text(&machine, text, text_size, expected, 1);
+    failure_count += result.failure_count;
+    bench_print("text, runner next", result);
+
+    result = bench_text(&machine, text, text_size, expected, BENCH_PULL_SIZE);
+    failure_count += result.failure_count;
+    bench_print("text, runner pull 256", result);
+
+    result = bench_inputs(&machine, inputs, expected);
+    failure_count += result.failure_count;
+    bench_print("inputs, runner next", result);
+
+    failure_count += bench_errors(&machine);
+
+    machine_free(&machine);
+    free(inputs);
+    free(expected);
+    free(text);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "machine.h"
+#include "server.h"
+#include "bench.h"
+
+#define BENCH_CONNECTION_COUNT ((int) 4096)
+#define BENCH_ROUND_COUNT ((int) 2000)
+#define BENCH_ROUND_CONNECTIONS ((int) 128)
+#define BENCH_MESSAGE_TOKENS ((int) 16)
+#define BENCH_REPLY_SIZE ((size_t) 1024)
+
+/**
+ * @struct Client side of the connection
+ */
+struct bench_client {
+    int fd;
+    int state;
+    bool is_waiting;
+    double send_time;
+
+    char expected[BENCH_REPLY_SIZE];
+    size_t expected_size;
+    char reply[BENCH_REPLY_SIZE];
+    size_t reply_size;
+};
+
+/**
+ * Send a message of random tokens and render the replies expected by the reference run
+ */
+static void bench_send(const struct machine_instance* machine, struct bench_client* client, uint64_t* seed) {
+    char message[BENCH_REPLY_SIZE];
+    size_t message_size = 0;
+    int inputs[BENCH_MESSAGE_TOKENS];
+    int outputs[BENCH_MESSAGE_TOKENS];
+
+    for (int i = 0; i < BENCH_MESSAGE_TOKENS; i++) {
+        inputs[i] = (int) (bench_rand(seed) % (uint64_t) machine->input_list_size);
+        message_size += (size_t) sprintf(message + message_size, "%s%c",
+            machine->input_list[inputs[i]], (i + 1 < BENCH_MESSAGE_TOKENS) ? ' ' : '\n');
+    }
+
+    machine_run(machine, inputs, BENCH_MESSAGE_TOKENS, outputs, &client->state);
+
+    client->expected_size = 0;
+    for (int i = 0; i < BENCH_MESSAGE_TOKENS; i++) {
+        const char* symbol = (outputs[i] == MACHINE_EMPTY_OUTPUT) ? "-" : machine->output_list[outputs[i]];
+        client->expected_size += (size_t) sprintf(client->expected + client->expected_size, "%s\n", symbol);
+    }
+
+    client->reply_size = 0;
+    client->is_waiting = true;
+    client->send_time = bench_now();
+
+    if (write(client->fd, message, message_size) != (ssize_t) message_size) {
+        fprintf(stderr, "BENCH> ERROR: Short write\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int connection_count = (argc > 1) ? atoi(argv[1]) : BENCH_CONNECTION_COUNT;
+
+    struct machine_instance machine;
+    bench_random_machine(&machine, 256, 32, 16, 5);
+
+    struct server server;
+    if (server_init(&server, &machine) != SERVER_STATUS_SUCCESS) {
+        fprintf(stderr, "BENCH> ERROR: Failed to start server\n");
+        return EXIT_FAILURE;
+    }
+
+    struct bench_client* clients = (struct bench_client*) malloc(connection_count * sizeof(struct bench_client));
+
+    for (int i = 0; i < connection_count; i++) {
+        int fds[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+            fprintf(stderr, "BENCH> ERROR: socketpair: %s\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+        server_add_connection(&server, fds[1], fds[1]);
+
+        clients[i].fd = fds[0];
+        clients[i].state = machine.entry_state;
+        clients[i].is_waiting = false;
+    }
+
+    const size_t message_count = (size_t) BENCH_ROUND_COUNT * BENCH_ROUND_CONNECTIONS;
+    double* latency_list = (double*) malloc(message_count * sizeof(double));
+    size_t latency_count = 0;
+    size_t mismatch_count = 0;
+    uint64_t seed = 9;
+    int waiting[BENCH_ROUND_CONNECTIONS];
+
+    double start_time = bench_now();
+
+    for (int round = 0; round < BENCH_ROUND_COUNT; round++) {
+        int waiting_count = 0;
+
+        while (waiting_count < BENCH_ROUND_CONNECTIONS) {
+            int index = (int) (bench_rand(&seed) % (uint64_t) connection_count);
+
+            if (!clients[index].is_waiting) {
+                bench_send(&machine, &clients[index], &seed);
+                waiting[waiting_count++] = index;
+            }
+        }
+
+        while (waiting_count > 0) {
+            server_poll(&server, 0);
+
+            for (int i = 0; i < waiting_count;) {
+                struct bench_client* client = &clients[waiting[i]];
+                ssize_t result = read(client->fd, client->reply + client->reply_size,
+                    BENCH_REPLY_SIZE - client->reply_size);
+
+                if (result > 0) {
+                    client->reply_size += (size_t) result;
+                }
+
+                if (client->reply_size < client->expected_size) {
+                    i++;
+                    continue;
+                }
+
+                latency_list[latency_count++] = bench_now() - client->send_time;
+
+                if ((client->reply_size != client->expected_size) ||
+                    (memcmp(client->reply, client->expected, client->expected_size) != 0))
+                {
+                    mismatch_count++;
+                }
+
+                client->is_waiting = false;
+                waiting[i] = waiting[--waiting_count];
+            }
+        }
+    }
+
+    double elapsed = bench_now() - start_time;
+
+    qsort(latency_list, latency_count, sizeof(double), bench_compare_double);
+
+    printf("connections: %d, messages: %zu x %d tokens\n", connection_count, latency_count, BENCH_MESSAGE_TOKENS);
+    printf("throughput: %.0f events/s\n", (double) server.event_count / elapsed);
+    printf("latency: p50 %.1f us, p99 %.1f us, p99.9 %.1f us\n",
+        latency_list[latency_count / 2] * 1e6,
+        latency_list[latency_count * 99 / 100] * 1e6,
+        latency_list[latency_count * 999 / 1000] * 1e6);
+    printf("mismatches: %zu\n", mismatch_count);
+
+    for (int i = 0; i < connection_count; i++) {
+        close(clients[i].fd);
+    }
+
+    server_free(&server);
+    machine_free(&machine);
+    free(clients);
+    free(latency_list);
+
+    return (mismatch_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
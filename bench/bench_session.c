@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "machine.h"
+#include "session.h"
+#include "bench.h"
+
+#define BENCH_SESSION_COUNT ((size_t) 4 * 1000 * 1000)
+#define BENCH_EVENT_COUNT ((size_t) 4 * 1000 * 1000)
+#define BENCH_SESSION_PATH "/tmp/bench_session.dsms"
+
+/**
+ * Dispatch random events to random sessions
+ */
+static void bench_dispatch(struct session_table* table, int input_list_size, uint64_t seed) {
+    for (size_t i = 0; i < BENCH_EVENT_COUNT; i++) {
+        size_t session = (size_t) (bench_rand(&seed) % table->session_count);
+        int input = (int) (bench_rand(&seed) % (uint64_t) input_list_size);
+        int output;
+
+        session_table_run(table, session, &input, 1, &output);
+    }
+}
+
+static bool bench_check(const struct session_table* table, const int* expected) {
+    return memcmp(table->state_list, expected, table->session_count * sizeof(int)) == 0;
+}
+
+int main(int argc, char** argv) {
+    const size_t session_count = (argc > 1) ? (size_t) strtoull(argv[1], NULL, 10) : BENCH_SESSION_COUNT;
+    const char* path = (argc > 2) ? argv[2] : BENCH_SESSION_PATH;
+
+    struct machine_instance machine;
+    struct machine_instance other_machine;
+    struct session_table table;
+    int failure_count = 0;
+
+    bench_random_machine(&machine, 1024, 32, 8, 21);
+    bench_random_machine(&other_machine, 1024, 32, 8, 22);
+
+    double start_time = bench_now();
+
+    if (session_table_create(&table, &machine, path, session_count) != SESSION_STATUS_SUCCESS) {
+        fprintf(stderr, "BENCH> ERROR: Failed to create '%s'\n", path);
+        return EXIT_FAILURE;
+    }
+
+    printf("create %zu sessions        %8.2f ms\n", session_count, (bench_now() - start_time) * 1e3);
+
+    int* expected = (int*) malloc(session_count * sizeof(int));
+
+    bench_dispatch(&table, machine.input_list_size, 1);
+
+    start_time = bench_now();
+    session_table_checkpoint(&table);
+    printf("checkpoint                   %8.2f ms\n", (bench_now() - start_time) * 1e3);
+
+    memcpy(expected, table.state_list, session_count * sizeof(int));
+
+    /* Events after the checkpoint are lost on restart */
+    bench_dispatch(&table, machine.input_list_size, 2);
+    session_table_free(&table);
+
+    start_time = bench_now();
+    enum session_status status = session_table_open(&table, &machine, path, SESSION_RESTORE_STRICT);
+    printf("restore                      %8.2f ms\n", (bench_now() - start_time) * 1e3);
+
+    if ((status != SESSION_STATUS_SUCCESS) || !bench_check(&table, expected)) {
+        fprintf(stderr, "BENCH> ERROR: Restored states differ\n");
+        failure_count++;
+    }
+
+    /* Torn checkpoint: the latest slot is corrupted, the previous one is restored */
+    int* previous = (int*) malloc(session_count * sizeof(int));
+    memcpy(previous, expected, session_count * sizeof(int));
+
+    bench_dispatch(&table, machine.input_list_size, 3);
+    session_table_checkpoint(&table);
+    memcpy(expected, table.state_list, session_count * sizeof(int));
+
+    int latest_slot = (table.header->checkpoint_list[0].sequence > table.header->checkpoint_list[1].sequence) ? 0 : 1;
+    int* torn_slot = (int*) ((char*) table.map + table.header->checkpoint_offset[latest_slot]);
+    torn_slot[session_count / 2] ^= 1;
+    session_table_free(&table);
+
+    status = session_table_open(&table, &machine, path, SESSION_RESTORE_STRICT);
+
+    if ((status != SESSION_STATUS_SUCCESS) || !bench_check(&table, previous)) {
+        fprintf(stderr, "BENCH> ERROR: Torn checkpoint is not detected\n");
+        failure_count++;
+    }
+
+    session_table_free(&table);
+
+    /* Other machine: strict restore fails, remap translates states by symbol */
+    if (session_table_open(&table, &other_machine, path, SESSION_RESTORE_STRICT) != SESSION_STATUS_MACHINE_MISMATCH) {
+        fprintf(stderr, "BENCH> ERROR: Machine mismatch is not detected\n");
+        failure_count++;
+    }
+
+    start_time = bench_now();
+    status = session_table_open(&table, &other_machine, path, SESSION_RESTORE_REMAP);
+    printf("restore with remap           %8.2f ms\n", (bench_now() - start_time) * 1e3);
+
+    /* Both machines name state i as "s<i>" */
+    if ((status != SESSION_STATUS_SUCCESS) || !bench_check(&table, previous)) {
+        fprintf(stderr, "BENCH> ERROR: Remapped states differ\n");
+        failure_count++;
+    }
+
+    session_table_free(&table);
+
+    if (session_table_open(&table, &other_machine, path, SESSION_RESTORE_STRICT) != SESSION_STATUS_SUCCESS) {
+        fprintf(stderr, "BENCH> ERROR: Remapped file is not rewritten\n");
+        failure_count++;
+    }
+
+    session_table_free(&table);
+    unlink(path);
+
+    machine_free(&machine);
+    machine_free(&other_machine);
+    free(expected);
+    free(previous);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,291 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "machine.h"
+#include "session.h"
+#include "shared.h"
+#include "bench.h"
+
+#define BENCH_SEGMENT_NAME "/dsm_bench_shared"
+#define BENCH_STATE_COUNT ((int) 1 << 14)
+#define BENCH_INPUT_COUNT ((int) 16)
+#define BENCH_SESSION_COUNT ((size_t) 1 << 18)
+#define BENCH_EVENT_COUNT ((size_t) 1 << 22)
+#define BENCH_BATCH_SIZE ((size_t) 4096)
+
+static const int BENCH_PROCESS_COUNT_LIST[] = { 1, 2, 4 };
+
+/**
+ * Machine which state counts the inputs: the input `i` adds `i + 1` modulo the
+ * state count. The final state of a session does not depend on the order its
+ * events are applied in, so the processes can be checked against one sum.
+ */
+static void bench_counter_machine(struct machine_instance* machine) {
+    bench_dense_machine(machine, BENCH_STATE_COUNT, BENCH_INPUT_COUNT, 8, 1);
+
+    for (int i = 0; i < BENCH_STATE_COUNT; i++) {
+        struct machine_trans* row = &machine->trans_table[machine->state_list[i].base];
+
+        for (int j = 0; j < BENCH_INPUT_COUNT; j++) {
+            row[j].next_state = (i + j + 1) % BENCH_STATE_COUNT;
+        }
+
+        machine->state_list[i].default_trans = row[0];
+    }
+
+    machine_classify_states(machine);
+}
+
+/**
+ * Attach, dispatch the events and detach, exit code of the worker process
+ */
+static int bench_worker(const struct session_event* events, size_t event_count) {
+    struct shared_table table;
+    int* outputs = (int*) malloc(BENCH_BATCH_SIZE * sizeof(int));
+
+    if (shared_table_attach(&table, BENCH_SEGMENT_NAME) != SHARED_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    int exit_code = EXIT_SUCCESS;
+
+    for (size_t i = 0; i < event_count; i += BENCH_BATCH_SIZE) {
+        const size_t count = (event_count - i < BENCH_BATCH_SIZE) ? event_count - i : BENCH_BATCH_SIZE;
+
+        if (shared_table_dispatch(&table, &events[i], count, outputs) != SHARED_STATUS_SUCCESS) {
+            exit_code = EXIT_FAILURE;
+        }
+    }
+
+    shared_table_detach(&table);
+    free(outputs);
+
+    return exit_code;
+}
+
+/**
+ * Run the events split between `process_count` processes, returns ns per event
+ */
+static double bench_processes(const struct session_event* events, int process_count, int* failure_count) {
+    pid_t pid_list[8];
+    const size_t share = BENCH_EVENT_COUNT / process_count;
+
+    const double start_time = bench_now();
+
+    for (int i = 0; i < process_count; i++) {
+        pid_list[i] = fork();
+
+        if (pid_list[i] == 0) {
+            _exit(bench_worker(&events[i * share], share));
+        }
+    }
+
+    for (int i = 0; i < process_count; i++) {
+        int wait_status = 0;
+        waitpid(pid_list[i], &wait_status, 0);
+
+        *failure_count += !WIFEXITED(wait_status) || (WEXITSTATUS(wait_status) != EXIT_SUCCESS);
+    }
+
+    return (bench_now() - start_time) / (double) BENCH_EVENT_COUNT * 1e9;
+}
+
+/**
+ * Final session states are the entry state plus the input sums of all processes
+ */
+static int bench_check_states(const struct shared_table* table, const struct session_event* events,
+    int round_count)
+{
+    uint64_t* sum_list = (uint64_t*) calloc(BENCH_SESSION_COUNT, sizeof(uint64_t));
+    int failure_count = 0;
+
+    for (size_t i = 0; i < BENCH_EVENT_COUNT; i++) {
+        sum_list[events[i].session] += (uint64_t) events[i].input + 1;
+    }
+
+    for (size_t i = 0; i < BENCH_SESSION_COUNT; i++) {
+        const uint64_t expected = ((uint64_t) table->machine.entry_state + round_count * sum_list[i]) %
+            BENCH_STATE_COUNT;
+
+        failure_count += ((uint64_t) atomic_load(&table->state_list[i]) != expected);
+    }
+
+    free(sum_list);
+    return failure_count;
+}
+
+/**
+ * Crashed process leaves its slot which the next attach takes over,
+ * segment of another layout is refused
+ */
+static int bench_attach(void) {
+    struct shared_table table;
+    int failure_count = 0;
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        struct shared_table crashed;
+        _exit((shared_table_attach(&crashed, BENCH_SEGMENT_NAME) == SHARED_STATUS_SUCCESS) ? 0 : 1);
+    }
+
+    int wait_status = 0;
+    waitpid(pid, &wait_status, 0);
+    failure_count += !WIFEXITED(wait_status) || (WEXITSTATUS(wait_status) != 0);
+
+    failure_count += (shared_table_attach(&table, BENCH_SEGMENT_NAME) != SHARED_STATUS_SUCCESS);
+    failure_count += (shared_table_process_count(&table) != 1);
+
+    /* Dead process slot was the first one, it is taken over once the free ones run out */
+    failure_count += (atomic_load(&table.header->process_list[0]) != (int) pid);
+
+    table.header->version++;
+
+    struct shared_table other;
+    failure_count += (shared_table_attach(&other, BENCH_SEGMENT_NAME) != SHARED_STATUS_LAYOUT_MISMATCH);
+
+    table.header->version--;
+
+    struct session_event invalid_event = { BENCH_SESSION_COUNT, 0 };
+    int output = 0;
+    failure_count += (shared_table_dispatch(&table, &invalid_event, 1, &output) != SHARED_STATUS_INVAL_PARAM);
+
+    shared_table_detach(&table);
+    return failure_count;
+}
+
+/**
+ * Creator which dies before the segment is ready, as `shared_table_create` leaves it
+ */
+static void bench_dead_creator(void) {
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        struct shared_header header;
+        int fd = shm_open(BENCH_SEGMENT_NAME, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+        memset(&header, 0, sizeof(header));
+        header.magic = SHARED_MAGIC;
+        header.version = SHARED_LAYOUT_VERSION;
+        atomic_init(&header.creator_pid, (int) getpid());
+
+        _exit(((fd >= 0) && (write(fd, &header, sizeof(header)) == (ssize_t) sizeof(header))) ? 0 : 1);
+    }
+
+    waitpid(pid, NULL, 0);
+}
+
+/**
+ * Segment left not ready by the dead creator is removed by the attach or rebuilt by the create
+ */
+static int bench_recover(const struct machine_instance* machine) {
+    struct shared_table table;
+    int failure_count = 0;
+
+    shared_table_unlink(BENCH_SEGMENT_NAME);
+
+    bench_dead_creator();
+    failure_count += (shared_table_attach(&table, BENCH_SEGMENT_NAME) != SHARED_STATUS_NOT_READY);
+    failure_count += (shared_table_create(BENCH_SEGMENT_NAME, machine, 16) != SHARED_STATUS_SUCCESS);
+    shared_table_unlink(BENCH_SEGMENT_NAME);
+
+    bench_dead_creator();
+    failure_count += (shared_table_create(BENCH_SEGMENT_NAME, machine, 16) != SHARED_STATUS_SUCCESS);
+    failure_count += (shared_table_attach(&table, BENCH_SEGMENT_NAME) != SHARED_STATUS_SUCCESS);
+
+    shared_table_detach(&table);
+    shared_table_unlink(BENCH_SEGMENT_NAME);
+
+    return failure_count;
+}
+
+int main(void) {
+    struct machine_instance machine;
+    int failure_count = 0;
+
+    bench_counter_machine(&machine);
+
+    struct session_event* events = (struct session_event*) malloc(BENCH_EVENT_COUNT * sizeof(struct session_event));
+    int* outputs = (int*) malloc(BENCH_EVENT_COUNT * sizeof(int));
+    uint64_t seed = 3;
+
+    for (size_t i = 0; i < BENCH_EVENT_COUNT; i++) {
+        events[i].session = (size_t) (bench_rand(&seed) % BENCH_SESSION_COUNT);
+        events[i].input = (int) (bench_rand(&seed) % BENCH_INPUT_COUNT);
+    }
+
+    /* Single process dispatcher */
+    struct session_table session_table;
+    session_table_init(&session_table, &machine, BENCH_SESSION_COUNT);
+
+    double start_time = bench_now();
+
+    for (size_t i = 0; i < BENCH_EVENT_COUNT; i += BENCH_BATCH_SIZE) {
+        session_table_dispatch(&session_table, &events[i], BENCH_BATCH_SIZE, &outputs[i], SESSION_DISPATCH_DIRECT);
+    }
+
+    const double session_time = (bench_now() - start_time) / (double) BENCH_EVENT_COUNT * 1e9;
+
+    failure_count += bench_recover(&machine);
+
+    failure_count += (shared_table_create(BENCH_SEGMENT_NAME, &machine, BENCH_SESSION_COUNT) !=
+        SHARED_STATUS_SUCCESS);
+    failure_count += (shared_table_create(BENCH_SEGMENT_NAME, &machine, BENCH_SESSION_COUNT) !=
+        SHARED_STATUS_EXISTS);
+
+    failure_count += bench_attach();
+
+    /* Same events in one attached process */
+    struct shared_table table;
+    failure_count += (shared_table_attach(&table, BENCH_SEGMENT_NAME) != SHARED_STATUS_SUCCESS);
+
+    int* shared_outputs = (int*) malloc(BENCH_EVENT_COUNT * sizeof(int));
+    start_time = bench_now();
+
+    for (size_t i = 0; i < BENCH_EVENT_COUNT; i += BENCH_BATCH_SIZE) {
+        shared_table_dispatch(&table, &events[i], BENCH_BATCH_SIZE, &shared_outputs[i]);
+    }
+
+    const double shared_time = (bench_now() - start_time) / (double) BENCH_EVENT_COUNT * 1e9;
+
+    failure_count += (memcmp(outputs, shared_outputs, BENCH_EVENT_COUNT * sizeof(int)) != 0);
+    failure_count += bench_check_states(&table, events, 1);
+
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("%zu events over %zu sessions, %d states, %ld processors, ns per event\n",
+        BENCH_EVENT_COUNT, BENCH_SESSION_COUNT, BENCH_STATE_COUNT, processor_count);
+    printf("%-28s %.2f\n", "session table, 1 process", session_time);
+    printf("%-28s %.2f\n", "shared table, this process", shared_time);
+
+    /* Every round applies all events once more, the processes share the sessions */
+    for (size_t i = 0; i < sizeof(BENCH_PROCESS_COUNT_LIST) / sizeof(BENCH_PROCESS_COUNT_LIST[0]); i++) {
+        const int process_count = BENCH_PROCESS_COUNT_LIST[i];
+        const double time = bench_processes(events, process_count, &failure_count);
+
+        char label[32];
+
+        failure_count += bench_check_states(&table, events, 2 + (int) i);
+        snprintf(label, sizeof(label), "shared table, %d forked", process_count);
+        printf("%-28s %.2f\n", label, time);
+    }
+
+    failure_count += (shared_table_process_count(&table) != 1);
+
+    shared_table_detach(&table);
+    shared_table_unlink(BENCH_SEGMENT_NAME);
+
+    session_table_free(&session_table);
+    machine_free(&machine);
+    free(events);
+    free(outputs);
+    free(shared_outputs);
+
+    printf("failures: %d\n", failure_count);
+    return (failure_count == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
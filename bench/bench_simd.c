@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "simd.h"
+#include "bench.h"
+
+#define BENCH_INPUT_COUNT ((size_t) 1 << 24)
+#define BENCH_REPEAT ((int) 5)
+
+static const enum simd_isa bench_isa_list[] = {
+    SIMD_ISA_SCALAR,
+    SIMD_ISA_SSSE3,
+    SIMD_ISA_AVX2,
+    SIMD_ISA_AVX512,
+};
+
+#define BENCH_ISA_NUM ((int) (sizeof(bench_isa_list) / sizeof(bench_isa_list[0])))
+
+/**
+ * Differential check of every available engine against the reference loop
+ */
+static bool bench_check_engines(void) {
+    const size_t input_lengths[] = { 0, 1, 15, 16, 17, 31, 100, 4099 };
+    int* inputs = (int*) malloc(4099 * sizeof(int));
+    int* reference_outputs = (int*) malloc(4099 * sizeof(int));
+    int* outputs = (int*) malloc(4099 * sizeof(int));
+    int check_count = 0;
+
+    for (int state_count = 1; state_count <= SIMD_MAX_STATES; state_count++) {
+        for (int input_count = 1; input_count <= 7; input_count += 3) {
+            struct machine_instance machine;
+            bench_random_machine(&machine, state_count, input_count, 3, state_count * 31 + input_count);
+
+            for (int i = 0; i < BENCH_ISA_NUM; i++) {
+                struct machine_simd simd;
+
+                if (machine_simd_init(&simd, &machine, bench_isa_list[i]) != MACHINE_STATUS_SUCCESS) {
+                    continue;
+                }
+
+                for (size_t j = 0; j < sizeof(input_lengths) / sizeof(input_lengths[0]); j++) {
+                    const size_t length = input_lengths[j];
+                    int start_state = (int) (j % state_count);
+                    int reference_state = start_state;
+                    int state = start_state;
+
+                    bench_random_inputs(inputs, length, input_count, j + 1);
+                    machine_run(&machine, inputs, length, reference_outputs, &reference_state);
+                    machine_simd_run(&simd, inputs, length, outputs, &state);
+
+                    if ((state != reference_state) ||
+                        (memcmp(outputs, reference_outputs, length * sizeof(int)) != 0))
+                    {
+                        fprintf(stderr, "Engine '%s' differs from the reference: %d states, %d inputs, %zu steps\n",
+                            machine_simd_isa_name(bench_isa_list[i]), state_count, input_count, length);
+                        return false;
+                    }
+
+                    check_count++;
+                }
+
+                machine_simd_free(&simd);
+            }
+
+            machine_free(&machine);
+        }
+    }
+
+    printf("Differential check passed: %d runs\n\n", check_count);
+
+    free(inputs);
+    free(reference_outputs);
+    free(outputs);
+
+    return true;
+}
+
+int main(void) {
+    if (!bench_check_engines()) {
+        return EXIT_FAILURE;
+    }
+
+    const int state_counts[] = { 8, 16, 32, 64 };
+
+    int* inputs = (int*) malloc(BENCH_INPUT_COUNT * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_INPUT_COUNT * sizeof(int));
+
+    printf("Shuffle engine benchmark: %zu inputs, 8 input symbols\n\n", BENCH_INPUT_COUNT);
+    printf("%8s %10s %10s\n", "states", "engine", "ns/sym");
+
+    for (size_t i = 0; i < sizeof(state_counts) / sizeof(state_counts[0]); i++) {
+        struct machine_instance machine;
+
+        bench_random_machine(&machine, state_counts[i], 8, 4, i + 1);
+        bench_random_inputs(inputs, BENCH_INPUT_COUNT, machine.input_list_size, i + 1);
+
+        double best = 1e9;
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            int state = machine.entry_state;
+            double start = bench_now();
+            machine_run(&machine, inputs, BENCH_INPUT_COUNT, outputs, &state);
+            double elapsed = bench_now() - start;
+            best = (elapsed < best) ? elapsed : best;
+        }
+
+        printf("%8d %10s %10.2f\n", machine.state_list_size, "reference", best * 1e9 / BENCH_INPUT_COUNT);
+
+        for (int j = 0; j < BENCH_ISA_NUM; j++) {
+            struct machine_simd simd;
+
+            if (machine_simd_init(&simd, &machine, bench_isa_list[j]) != MACHINE_STATUS_SUCCESS) {
+                continue;
+            }
+
+            best = 1e9;
+            for (int r = 0; r < BENCH_REPEAT; r++) {
+                int state = machine.entry_state;
+                double start = bench_now();
+                machine_simd_run(&simd, inputs, BENCH_INPUT_COUNT, outputs, &state);
+                double elapsed = bench_now() - start;
+                best = (elapsed < best) ? elapsed : best;
+            }
+
+            printf("%8d %10s %10.2f\n", machine.state_list_size, machine_simd_isa_name(simd.isa),
+                best * 1e9 / BENCH_INPUT_COUNT);
+
+            machine_simd_free(&simd);
+        }
+
+        machine_free(&machine);
+    }
+
+    free(inputs);
+    free(outputs);
+
+    return EXIT_SUCCESS;
+}
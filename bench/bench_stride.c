@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "stride.h"
+#include "bench.h"
+
+#define BENCH_INPUT_COUNT ((size_t) 1 << 24)
+#define BENCH_REPEAT ((int) 5)
+
+static double bench_single_step(const struct machine_instance* machine, const int* inputs, int* outputs) {
+    double best = 1e9;
+
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int state = machine->entry_state;
+        double start = bench_now();
+        machine_run(machine, inputs, BENCH_INPUT_COUNT, outputs, &state);
+        double elapsed = bench_now() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+static double bench_stride(const struct machine_stride* stride, const struct machine_instance* machine,
+    const int* inputs, int* outputs)
+{
+    double best = 1e9;
+
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int state = machine->entry_state;
+        double start = bench_now();
+        machine_stride_run(stride, machine, inputs, BENCH_INPUT_COUNT, outputs, &state);
+        double elapsed = bench_now() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char** argv) {
+    const int machine_sizes[][2] = {
+        /* states, inputs */
+        { 16, 2 },
+        { 16, 4 },
+        { 64, 2 },
+        { 64, 4 },
+        { 256, 2 },
+        { 256, 8 },
+        { 1024, 4 },
+    };
+
+    const size_t cache_budget = (argc > 1) ? (size_t) strtoul(argv[1], NULL, 10) : STRIDE_DEFAULT_CACHE_BUDGET;
+
+    int* inputs = (int*) malloc(BENCH_INPUT_COUNT * sizeof(int));
+    int* outputs = (int*) malloc(BENCH_INPUT_COUNT * sizeof(int));
+    int* stride_outputs = (int*) malloc(BENCH_INPUT_COUNT * sizeof(int));
+
+    printf("Stride table benchmark: %zu inputs, cache budget %zu bytes\n\n", BENCH_INPUT_COUNT, cache_budget);
+    printf("%8s %8s %4s %14s %14s %10s\n", "states", "inputs", "k", "single ns/sym", "stride ns/sym", "speedup");
+
+    for (size_t i = 0; i < sizeof(machine_sizes) / sizeof(machine_sizes[0]); i++) {
+        struct machine_instance machine;
+        struct machine_stride stride;
+
+        bench_random_machine(&machine, machine_sizes[i][0], machine_sizes[i][1], 4, i + 1);
+        bench_random_inputs(inputs, BENCH_INPUT_COUNT, machine.input_list_size, i + 1);
+
+        if (machine_stride_init(&stride, &machine, cache_budget) != MACHINE_STATUS_SUCCESS) {
+            printf("%8d %8d %4s %14s\n", machine.state_list_size, machine.input_list_size, "-", "over budget");
+            machine_free(&machine);
+            continue;
+        }
+
+        double single_time = bench_single_step(&machine, inputs, outputs);
+        double stride_time = bench_stride(&stride, &machine, inputs, stride_outputs);
+
+        if (memcmp(outputs, stride_outputs, BENCH_INPUT_COUNT * sizeof(int)) != 0) {
+            fprintf(stderr, "Stride outputs differ from the single-step run\n");
+            return EXIT_FAILURE;
+        }
+
+        printf("%8d %8d %4d %14.2f %14.2f %9.2fx\n",
+            machine.state_list_size, machine.input_list_size, stride.k,
+            single_time * 1e9 / BENCH_INPUT_COUNT, stride_time * 1e9 / BENCH_INPUT_COUNT,
+            single_time / stride_time);
+
+        machine_stride_free(&stride);
+        machine_free(&machine);
+    }
+
+    free(inputs);
+    free(outputs);
+    free(stride_outputs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,46 @@
+/*****************************************************************************
+ *
+ * @file batch.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Bulk acceptance check of packed input records
+ *
+ *****************************************************************************/
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Number of records one thread runs interleaved
+ */
+#define BATCH_LANES ((int) 8)
+
+/**
+ * @def Number of records in the smallest work unit (one bitmap word)
+ */
+#define BATCH_UNIT ((size_t) 64)
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Check acceptance of `record_count` records.
+ * Record `i` is `symbols[offsets[i]] ... symbols[offsets[i + 1] - 1]` input identifiers,
+ * each record runs from the entry state.
+ *
+ * Bit `i % 64` of `accepted[i / 64]` is set if the record `i` is accepted.
+ * `end_states` is optional: if not NULL, the last state of every record is stored
+ * there (records are then run to their end, without the dead state early exit).
+ * `thread_count` <= 0 uses all online processors.
+ */
+enum machine_status machine_accept_batch(const struct machine_instance* machine, const int* symbols,
+    const size_t* offsets, size_t record_count, uint64_t* accepted, int* end_states, int thread_count);
+
+#endif /* __BATCH_H__ */
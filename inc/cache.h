@@ -0,0 +1,80 @@
+/*****************************************************************************
+ *
+ * @file cache.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief On-disk cache of machines compiled from DSML scripts
+ *
+ *****************************************************************************/
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Compiler version mixed into the cache key, bump when the compiled result changes
+ */
+#define CACHE_COMPILER_VERSION "dsm-1"
+
+/**
+ * @def Cache entry magic "DSMCACHE"
+ */
+#define CACHE_FILE_MAGIC ((uint64_t) 0x4548434143534D44ull)
+
+/**
+ * @def Cache entry layout version
+ */
+#define CACHE_FILE_VERSION ((uint32_t) 2)
+
+/**
+ * @def Alignment of the state records and the transition table in the entry
+ */
+#define CACHE_FILE_ALIGN ((size_t) 8)
+
+/**
+ * @def Cache entry file extension
+ */
+#define CACHE_FILE_EXT ".dsmc"
+
+/**
+ * @def Compile flag: minimize the machine
+ */
+#define CACHE_FLAG_MINIMIZE ((uint32_t) 1 << 0)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum cache_status {
+    CACHE_STATUS_SUCCESS,
+    CACHE_STATUS_NULL_PARAM,
+    CACHE_STATUS_INVAL_SCRIPT,
+    CACHE_STATUS_SYSTEM_ERROR,
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Key of the script contents compiled with `flags`
+ */
+uint64_t cache_key(const char* script, size_t script_size, uint32_t flags);
+
+/**
+ * Compile the script `script_path` or load it from `cache_dir`.
+ * Entries are keyed by the script contents and the compiler version, so
+ * a hit skips parsing and validation. A new entry is written to a temporary
+ * file and renamed, processes may share the directory. Failure to write
+ * the entry is not an error.
+ */
+enum cache_status cache_load_machine(struct machine_instance* machine, const char* script_path,
+    const char* cache_dir, uint32_t flags, bool* is_hit);
+
+#endif /* __CACHE_H__ */
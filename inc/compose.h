@@ -0,0 +1,30 @@
+/*****************************************************************************
+ *
+ * @file compose.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Composition of cascaded Determined State Machines
+ *
+ *****************************************************************************/
+
+#ifndef __COMPOSE_H__
+#define __COMPOSE_H__
+
+#include "machine.h"
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Build the product machine which reacts to the `first` machine inputs the
+ * same way as the `second` machine fed by the `first` machine outputs.
+ *
+ * Every `first` output symbol must be an input symbol of the `second` machine.
+ * Empty '-' output of the `first` machine leaves the `second` one in its state
+ * and gives empty output. Product state is final if both states are final.
+ * Only reachable state pairs are built, the product is minimized.
+ */
+enum machine_status machine_compose(struct machine_instance* product,
+    const struct machine_instance* first, const struct machine_instance* second);
+
+#endif /* __COMPOSE_H__ */
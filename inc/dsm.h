@@ -13,14 +13,35 @@
 
 #include <stdint.h>
 
+#include "machine.h"
+
 /* Constants ----------------------------------------------------------------*/
 
 /* Define -------------------------------------------------------------------*/
 
+/**
+ * @def Output runs buffered by the run-length encoded `dsm run`
+ */
+#define DSM_RUN_BUFFER_SIZE ((size_t) 1024)
+
 /* Enum ---------------------------------------------------------------------*/
 
+/**
+ * @enum
+ */
+enum dsm_status {
+    DSM_STATUS_SUCCESS,
+    DSM_STATUS_NULL_PARAM,
+    DSM_STATUS_INVAL_SCRIPT,
+};
+
 /* Structures ---------------------------------------------------------------*/
 
 /* Function Definitions -----------------------------------------------------*/
 
-#endif /* __DSM_H__ */
\ No newline at end of file
+/**
+ * Parse the DSML script and build the machine from it
+ */
+enum dsm_status dsm_load_machine(struct machine_instance* machine, const char* filename);
+
+#endif /* __DSM_H__ */
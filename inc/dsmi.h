@@ -0,0 +1,140 @@
+/*****************************************************************************
+ *
+ * @file dsmi.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Pre-tokenized binary input streams (.dsmi)
+ *
+ *****************************************************************************/
+
+#ifndef __DSMI_H__
+#define __DSMI_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Stream file magic "DSMINPUT"
+ */
+#define DSMI_FILE_MAGIC ((uint64_t) 0x5455504E494D5344ull)
+
+/**
+ * @def Stream file layout version
+ */
+#define DSMI_FILE_VERSION ((uint32_t) 1)
+
+/**
+ * @def Stream file extension
+ */
+#define DSMI_FILE_EXT ".dsmi"
+
+/**
+ * @def Alphabet is padded so the identifiers are aligned
+ */
+#define DSMI_FILE_ALIGN ((size_t) 8)
+
+/**
+ * @def Size of the text chunks read at once by the converter
+ */
+#define DSMI_CHUNK_SIZE ((size_t) 65536)
+
+/**
+ * @def Identifiers decoded at once by `dsmi_run`
+ */
+#define DSMI_BLOCK_SIZE ((size_t) 4096)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum dsmi_status {
+    DSMI_STATUS_SUCCESS,
+    DSMI_STATUS_NULL_PARAM,
+    DSMI_STATUS_SYSTEM_ERROR,
+    DSMI_STATUS_INVAL_FILE,
+    DSMI_STATUS_INVAL_TEXT,         /* Text token is longer than TOKEN_MAX_LEN */
+    DSMI_STATUS_UNKNOWN_SYMBOL,     /* Stream symbol is not an input of the machine */
+    DSMI_STATUS_OUT_OF_RANGE,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Stream file header, followed by the alphabet (`symbol_count` zero terminated
+ * symbols padded to DSMI_FILE_ALIGN) and `input_count` identifiers of
+ * `id_width` bytes, the narrowest width that fits the alphabet.
+ */
+struct dsmi_file_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t id_width;
+    uint64_t input_count;
+    uint32_t symbol_count;
+    uint32_t alphabet_size;
+};
+
+/**
+ * @struct
+ * Mapped stream file. Alphabet identifiers are translated to the inputs
+ * of the bound machine, so one file serves any machine with these inputs.
+ */
+struct dsmi_stream {
+    void* map;
+    size_t map_size;
+
+    int id_width;
+    uint64_t input_count;
+    const void* id_list;
+
+    int symbol_count;
+    const char** symbol_list;   /* Symbols inside the map */
+
+    const struct machine_instance* machine;
+    int* input_map;             /* Alphabet identifier -> machine input */
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Tokenize the whitespace separated `text` and write it as stream file.
+ * Alphabet is the symbols of the text in order of their first occurrence.
+ */
+enum dsmi_status dsmi_convert(FILE* text, const char* path);
+
+/**
+ * Map the stream file
+ */
+enum dsmi_status dsmi_open(struct dsmi_stream* stream, const char* path);
+
+/**
+ *
+ */
+void dsmi_close(struct dsmi_stream* stream);
+
+/**
+ * Resolve the alphabet to the inputs of the `machine` for the following runs
+ */
+enum dsmi_status dsmi_bind(struct dsmi_stream* stream, const struct machine_instance* machine);
+
+/**
+ * Get inputs [`first`, `first` + `count`) of the stream as input identifiers of the bound machine
+ */
+enum dsmi_status dsmi_decode(const struct dsmi_stream* stream, uint64_t first, size_t count, int* inputs);
+
+/**
+ * Run the bound machine from the `state` over inputs [`first`, `first` + `count`)
+ * of the stream straight from the map. Outputs are written to `outputs`
+ * unless it is NULL, the `state` is updated to the last state.
+ */
+enum dsmi_status dsmi_run(const struct dsmi_stream* stream, uint64_t first, uint64_t count, int* outputs,
+    int* state);
+
+#endif /* __DSMI_H__ */
@@ -12,9 +12,12 @@
 #ifndef __DSML_H__
 #define __DSML_H__
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "mem.h"
+
 /* Constants ----------------------------------------------------------------*/
 
 /**
@@ -27,7 +30,8 @@ static const char* DSML_KEYWORDS[] = {
     "entry",
     "input",
     "output",
-    "trans"
+    "trans",
+    "default"
 };
 
 /**
@@ -47,10 +51,20 @@ static const char* DSML_EMPTY_OUTPUT_SYMBOL = "-";
 
 /* Define -------------------------------------------------------------------*/
 
+/**
+ * @def Symbol selecting every state or every input in the 'trans' statement
+ */
+#define DSML_ANY_SYMBOL "*"
+
+/**
+ * @def Delimiter of the numbered symbols range 's0..s99'
+ */
+#define DSML_RANGE_DELIM ".."
+
 /**
  * @def
  */
-#define DSML_KEYWORDS_NUM ((int) 6)
+#define DSML_KEYWORDS_NUM ((int) 7)
 
 /**
  * @def
@@ -60,6 +74,16 @@ static const char* DSML_EMPTY_OUTPUT_SYMBOL = "-";
 #define MAX_STRING_LEN      ((size_t) 255)
 #define TRANS_OPERANDS_NUM  ((int) 4)
 
+/**
+ * @def Initial size of the symbol hash index, power of two
+ */
+#define DSML_INDEX_INIT_SIZE ((int) 16)
+
+/**
+ * @def Maximum number of digits of the range bound
+ */
+#define DSML_RANGE_MAX_DIGITS ((size_t) 9)
+
 /**
  * @def
  */
@@ -80,6 +104,7 @@ enum dsml_keyword_index {
     DSML_INPUT_KEYWORD_INDEX,
     DSML_OUTPUT_KEYWORD_INDEX,
     DSML_TRANS_KEYWORD_INDEX,
+    DSML_DEFAULT_KEYWORD_INDEX,
 };
 
 /**
@@ -90,6 +115,7 @@ enum dsml_lexeme_type {
     DSML_LEXEME_INPUT,
     DSML_LEXEME_OUTPUT,
     DSML_LEXEME_TRANS,
+    DSML_LEXEME_DEFAULT,
     DSML_LEXEME_UNDEF,
 };
 
@@ -113,11 +139,30 @@ enum dsml_status {
     DSML_STATUS_EMPTY_DSM,
     DSML_STATUS_STATIC_DSM,
     DSML_STATUS_INDETERM_TRANS,
+    DSML_STATUS_INVAL_RANGE,
     DSML_STATUS_UNDEF_ERROR,
 };
 
+/**
+ * @enum States the transition rule applies to
+ */
+enum dsml_selector {
+    DSML_SELECTOR_ANY,      /* '*' */
+    DSML_SELECTOR_RANGE,    /* 's0..s99' */
+};
+
 /* Structures ---------------------------------------------------------------*/
 
+/**
+ * @struct Open addressing index of the list positions by the key hash
+ */
+struct dsml_index {
+    int size;
+    int count;
+    uint64_t* hashes;
+    int* positions;     /* -1 for the free slot */
+};
+
 /**
  * @enum 
  */
@@ -134,12 +179,34 @@ struct dsml_parser {
     int trans_list_size;
     int trans_list_cap;
 
+    int rule_list_size;
+    int rule_list_cap;
+
     bool has_estate;
 
+    /* Explicit transitions may share the (state, input) pair, transitions may be missing */
+    bool is_nfa;
+
+    /* Allocations owned by the parser */
+    struct mem_stats mem;
+
     struct dsml_state** state_list;
     struct dsml_io** input_list;
     struct dsml_io** output_list;
     struct dsml_trans** trans_list;    
+    struct dsml_rule** rule_list;
+
+    /* Symbol indexes and (from state, input) index of the explicit transitions */
+    struct dsml_index state_index;
+    struct dsml_index input_index;
+    struct dsml_index output_index;
+    struct dsml_index trans_index;
+
+    /* Explicit transitions grouped by the From State, rebuilt when transitions are added */
+    int* state_trans_start;
+    int* state_trans_list;      /* Positions in the `trans_list` */
+    int grouped_state_count;
+    int grouped_trans_count;
 };
 
 /**
@@ -147,8 +214,15 @@ struct dsml_parser {
  */
 struct dsml_state {
     const char* symbol;
+    int id;
     bool is_entry;
     bool is_final;
+
+    /* Number of explicit transitions from the state */
+    int trans_count;
+
+    /* Transition for every input without an explicit one, NULL if absent */
+    struct dsml_trans* default_trans;
 };
 
 /**
@@ -156,6 +230,7 @@ struct dsml_state {
  */
 struct dsml_io {
     const char* symbol;
+    int id;
 };
 
 /**
@@ -168,6 +243,33 @@ struct dsml_trans {
     struct dsml_io* output;
 };
 
+/**
+ * @struct
+ * Transition rule of the 'trans' statement which From State is '*' or a range.
+ * For every (state, input) pair the most specific statement wins:
+ *  1. explicit transition 'trans s0 : a : ...'
+ *  2. transition of the state on any input 'trans s0 : * : ...' ('default')
+ *  3. range rule on the input 'trans s0..s9 : a : ...'
+ *  4. range rule on any input 'trans s0..s9 : * : ...'
+ *  5. rule of any state on the input 'trans * : a : ...'
+ *  6. rule of any state on any input 'trans * : * : ...'
+ * Statements of the same level must not overlap.
+ */
+struct dsml_rule {
+    enum dsml_selector selector;
+
+    /* Range of the state symbols <prefix><first> .. <prefix><last> */
+    const char* prefix;
+    long first;
+    long last;
+
+    /* Input of the rule, NULL for any input */
+    struct dsml_io* input;
+
+    /* Target, `from_state` and `input` are NULL */
+    struct dsml_trans trans;
+};
+
 /* Function Definitions -----------------------------------------------------*/
 
 /* Interface Functions */
@@ -177,6 +279,24 @@ struct dsml_trans {
  */
 struct dsml_parser* dsml_parse_script(const char* filename);
 
+/**
+ * Parse and validate script read from the stream
+ */
+struct dsml_parser* dsml_parse_stream(FILE* fin);
+
+/**
+ * Parse nondeterministic script: several 'trans' statements may give the same
+ * (state, input) pair different targets, pairs without any transition lead nowhere.
+ * Rules and default transitions apply to the pairs without explicit transitions.
+ * The parser is built into a machine by `machine_determinize`.
+ */
+struct dsml_parser* dsml_parse_nfa_script(const char* filename);
+
+/**
+ * Parse nondeterministic script read from the stream
+ */
+struct dsml_parser* dsml_parse_nfa_stream(FILE* fin);
+
 /* Initialisation/Destruction of Structures */
 
 /**
@@ -189,6 +309,11 @@ enum dsml_status dsml_parser_init(struct dsml_parser* parser);
  */
 enum dsml_status dsml_parser_free(struct dsml_parser* parser);
 
+/**
+ * Get memory used by the parser entities
+ */
+enum dsml_status dsml_parser_stats(const struct dsml_parser* parser, struct mem_stats* stats);
+
 /* Source Parsing */
 
 /**
@@ -211,6 +336,11 @@ enum dsml_status dsml_parse_io(struct dsml_parser* parser, const char* str, bool
  */
 enum dsml_status dsml_parse_trans(struct dsml_parser* parser, const char* str);
 
+/**
+ * Parse `default <state> [<state> ...] : <to state> : <output>` statement
+ */
+enum dsml_status dsml_parse_default(struct dsml_parser* parser, const char* str);
+
 /* State/IO/Transition Adding */
 
 /**
@@ -233,6 +363,11 @@ enum dsml_status dsml_add_output(struct dsml_parser* parser, const char* symbol)
  */
 enum dsml_status dsml_add_trans(struct dsml_parser* parser, struct dsml_trans* trans);
 
+/**
+ * Add rule, INDETERM_TRANS if it overlaps a rule of the same precedence
+ */
+enum dsml_status dsml_add_rule(struct dsml_parser* parser, struct dsml_rule* rule);
+
 /**
  * 
  */
@@ -265,6 +400,24 @@ enum dsml_status dsml_trim_symbol(const char* symbol, char* buffer, size_t buffe
  */
 enum dsml_status dsml_validate_dsm(struct dsml_parser* parser);
 
+/**
+ * Get transitions of the `state` for every input resolving rules by their
+ * precedence, `row` entries of the inputs without a transition are NULL
+ */
+void dsml_state_row(struct dsml_parser* parser, int state, const struct dsml_trans** row);
+
+/**
+ * Get positions in the `trans_list` of the explicit transitions of the `state`,
+ * valid until transitions are added. Returns their number.
+ */
+int dsml_state_trans(struct dsml_parser* parser, int state, const int** positions);
+
+/**
+ * Free explicit and default transitions of the `state` once its row is no longer needed.
+ * Rows of the state resolve to the rules only afterwards.
+ */
+void dsml_release_state_trans(struct dsml_parser* parser, int state);
+
 /**
  * 
  */
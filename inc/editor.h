@@ -0,0 +1,173 @@
+/*****************************************************************************
+ *
+ * @file editor.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Runtime editing of compiled machines with atomic publishing
+ *
+ *****************************************************************************/
+
+#ifndef __EDITOR_H__
+#define __EDITOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "machine.h"
+#include "mem.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Next state of the missing transition in the working table
+ */
+#define MACHINE_EDITOR_NO_TRANS ((int) -1)
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct Immutable published machine, freed once it is replaced and not held by readers
+ */
+struct machine_version {
+    struct machine_instance machine;
+    uint64_t number;
+
+    atomic_int reader_count;
+    struct machine_version* next_retired;
+};
+
+/**
+ * @struct Open addressing index of the symbol list positions
+ */
+struct machine_editor_index {
+    int size;
+    int* positions;     /* -1 for the free slot */
+};
+
+/**
+ * @struct
+ * Working copy of the machine: dense `state_list_cap` x `input_list_cap` tables
+ * edited in place, published versions are built from it and never change.
+ * The version copies the table of the previous one and appends the edited rows,
+ * the table is packed anew once the appended rows double it or an input is added.
+ * Edits and publishing belong to one thread, any thread may acquire versions.
+ */
+struct machine_editor {
+    int state_list_size;
+    int state_list_cap;
+
+    int input_list_size;
+    int input_list_cap;
+
+    int output_list_size;
+    int output_list_cap;
+
+    char** state_list;
+    bool* final_list;
+    char** input_list;
+    char** output_list;
+
+    int entry_state;
+
+    int* next_table;
+    int* output_table;
+
+    /* Number of (state, input) pairs without a transition, the version is published at zero */
+    int missing_count;
+
+    /* States which rows changed since the last version */
+    bool* dirty_list;
+    int dirty_count;
+    bool is_repack;
+
+    /* Table size of the last packed version */
+    int packed_table_size;
+
+    struct machine_editor_index state_index;
+    struct machine_editor_index input_index;
+    struct machine_editor_index output_index;
+
+    /* Allocations of the working copy */
+    struct mem_stats mem;
+
+    uint64_t version_count;
+    _Atomic(struct machine_version*) current;
+
+    /* Readers between loading the current version and counting themselves in it */
+    atomic_int entering_count;
+    struct machine_version* retired_list;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Start editing the machine. The machine is moved to the first published version,
+ * the caller's instance is left empty.
+ */
+enum machine_status machine_editor_init(struct machine_editor* editor, struct machine_instance* machine);
+
+/**
+ * Free the working copy and every version, no reader may hold a version
+ */
+enum machine_status machine_editor_free(struct machine_editor* editor);
+
+/**
+ * Add state without transitions, its identifier is written to `state`.
+ * MACHINE_STATUS_REDEF_SYMBOL if the symbol is taken.
+ */
+enum machine_status machine_editor_add_state(struct machine_editor* editor, const char* symbol, bool is_final,
+    int* state);
+
+/**
+ * Add input which no state has a transition for, its identifier is written to `input`
+ */
+enum machine_status machine_editor_add_input(struct machine_editor* editor, const char* symbol, int* input);
+
+/**
+ * Add output symbol, its identifier is written to `output`
+ */
+enum machine_status machine_editor_add_output(struct machine_editor* editor, const char* symbol, int* output);
+
+/**
+ * Set transition of the `state` on the `input`, `output` may be MACHINE_EMPTY_OUTPUT
+ */
+enum machine_status machine_editor_set_trans(struct machine_editor* editor, int state, int input,
+    int next_state, int output);
+
+/**
+ * Remove transition of the `state` on the `input`
+ */
+enum machine_status machine_editor_clear_trans(struct machine_editor* editor, int state, int input);
+
+/**
+ *
+ */
+enum machine_status machine_editor_set_final(struct machine_editor* editor, int state, bool is_final);
+
+/**
+ * Get identifier of the state, input or output symbol, -1 if there is none
+ */
+int machine_editor_find_state(const struct machine_editor* editor, const char* symbol);
+int machine_editor_find_input(const struct machine_editor* editor, const char* symbol);
+int machine_editor_find_output(const struct machine_editor* editor, const char* symbol);
+
+/**
+ * Build the machine from the working copy and make it the current version.
+ * MACHINE_STATUS_MISSING_TRANS while `missing_count` is not zero. Replaced
+ * versions are freed as soon as their readers release them.
+ */
+enum machine_status machine_editor_publish(struct machine_editor* editor);
+
+/**
+ * Get the current version, it stays valid until released
+ */
+const struct machine_version* machine_editor_acquire(struct machine_editor* editor);
+
+/**
+ *
+ */
+void machine_editor_release(const struct machine_version* version);
+
+#endif /* __EDITOR_H__ */
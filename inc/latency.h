@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *
+ * @file latency.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Sampled per-event latency histograms of the execution paths
+ *
+ *****************************************************************************/
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Linear sub-buckets of every power of two are 2^bits, values are kept within 1/32
+ */
+#define LATENCY_SUB_BUCKET_BITS ((int) 5)
+#define LATENCY_SUB_BUCKET_COUNT ((int) 1 << LATENCY_SUB_BUCKET_BITS)
+
+/**
+ * @def Values are nanoseconds below 2^bits (about 18 minutes), larger ones are clamped
+ */
+#define LATENCY_VALUE_BITS ((int) 40)
+
+/**
+ * @def Number of histogram buckets
+ */
+#define LATENCY_BUCKET_COUNT ((LATENCY_VALUE_BITS - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKET_COUNT)
+
+/**
+ * @def One of that many calls of the recorded path is timed (power of two)
+ */
+#ifndef LATENCY_SAMPLE_PERIOD
+#define LATENCY_SAMPLE_PERIOD ((uint32_t) 16)
+#endif
+
+/**
+ * @def Histograms the thread finds without the global list
+ */
+#define LATENCY_THREAD_SLOTS ((int) 8)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum Recorded path
+ */
+enum latency_path {
+    LATENCY_PATH_RUN,           /* machine_run */
+    LATENCY_PATH_DISPATCH,      /* session_table_dispatch */
+    LATENCY_PATH_SERVE,         /* Server tokens of one read */
+    LATENCY_PATH_NUM,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * HDR histogram of one thread for one machine and path. Counts are written by
+ * the owner thread only and read by the merge, relaxed atomics keep it lock free.
+ */
+struct latency_histogram {
+    const void* machine;
+    enum latency_path path;
+    const void* owner;      /* Thread recording to the histogram, NULL if it is not a thread histogram */
+
+    _Atomic uint64_t total_count;
+    _Atomic uint64_t max;
+    _Atomic uint64_t count_list[LATENCY_BUCKET_COUNT];
+
+    struct latency_histogram* next;
+};
+
+/**
+ * @struct Percentiles of the merged histograms, nanoseconds per event
+ */
+struct latency_summary {
+    uint64_t count;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Monotonic time in nanoseconds
+ */
+uint64_t latency_now(void);
+
+/**
+ *
+ */
+void latency_histogram_init(struct latency_histogram* histogram, const void* machine, enum latency_path path);
+
+/**
+ * Add `count` events of `value` nanoseconds each
+ */
+void latency_histogram_add(struct latency_histogram* histogram, uint64_t value, uint64_t count);
+
+/**
+ * Highest value equivalent to the `quantile` (0..1) of the events, 0 if there are none
+ */
+uint64_t latency_histogram_quantile(const struct latency_histogram* histogram, double quantile);
+
+/**
+ * Record the call of the `path` started at `start_time` which handled `event_count`
+ * events, every event is counted with the mean latency of the call
+ */
+void latency_record(const void* machine, enum latency_path path, uint64_t start_time, size_t event_count);
+
+/**
+ * Merge histograms of every thread for the machine and the path
+ */
+void latency_summarize(const void* machine, enum latency_path path, struct latency_summary* summary);
+
+/**
+ * Print the percentiles of every path of the machine that has events
+ */
+void latency_print(const void* machine, const char* name, FILE* fout);
+
+/**
+ * Free every histogram, no thread may be recording
+ */
+void latency_clear(void);
+
+/* Recording ----------------------------------------------------------------*/
+
+#ifdef DSM_LATENCY
+
+extern _Thread_local uint32_t latency_call_count;
+
+static inline bool latency_sample(void) {
+    return (++latency_call_count & (LATENCY_SAMPLE_PERIOD - 1)) == 0;
+}
+
+/**
+ * Time the sampled calls of the path, the macros compile out without DSM_LATENCY
+ */
+#define LATENCY_START() const uint64_t latency_start_time = latency_sample() ? latency_now() : 0
+
+#define LATENCY_STOP(machine, path, event_count) do { \
+    if (latency_start_time != 0) { \
+        latency_record((machine), (path), latency_start_time, (event_count)); \
+    } \
+} while (0)
+
+#else
+
+#define LATENCY_START()
+
+/* Operands are not evaluated, their variables still count as used */
+#define LATENCY_STOP(machine, path, event_count) do { (void) sizeof(event_count); } while (0)
+
+#endif /* DSM_LATENCY */
+
+#endif /* __LATENCY_H__ */
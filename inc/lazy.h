@@ -0,0 +1,79 @@
+/*****************************************************************************
+ *
+ * @file lazy.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Machine which transition table rows are built on the first entry
+ *
+ *****************************************************************************/
+
+#ifndef __LAZY_H__
+#define __LAZY_H__
+
+#include <stddef.h>
+
+#include "machine.h"
+
+struct dsml_parser;
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Base of the state which row is not built yet
+ */
+#define LAZY_NO_ROW ((int) -1)
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Machine which states start with LAZY_NO_ROW base. The row of the state is
+ * resolved from the parser and appended to the table the first time
+ * the state is entered, afterwards steps cost the same as for the eager machine.
+ * The embedded `machine` must only be run with `machine_lazy_run` until
+ * `machine_lazy_complete` is called.
+ */
+struct machine_lazy {
+    struct machine_instance machine;
+
+    int trans_table_cap;
+    int row_count;
+
+    /* Parser owned until the machine is completed, NULL afterwards */
+    struct dsml_parser* parser;
+    const struct dsml_trans** trans_row;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Take the validated DSML parser allocated with malloc, only the entry state row is built.
+ * The parser is owned by the lazy machine on success and released by
+ * `machine_lazy_complete` or `machine_lazy_free`.
+ */
+enum machine_status machine_lazy_init(struct machine_lazy* lazy, struct dsml_parser* parser);
+
+/**
+ *
+ */
+enum machine_status machine_lazy_free(struct machine_lazy* lazy);
+
+/**
+ * Build the row of the `state` if it is not built yet
+ */
+void machine_lazy_build_row(struct machine_lazy* lazy, int state);
+
+/**
+ * Run the machine from the `state`, see `machine_run`
+ */
+enum machine_status machine_lazy_run(struct machine_lazy* lazy, const int* inputs, size_t input_count,
+    int* outputs, int* state);
+
+/**
+ * Build all remaining rows and release the parser.
+ * The embedded machine is an ordinary one afterwards.
+ */
+enum machine_status machine_lazy_complete(struct machine_lazy* lazy);
+
+#endif /* __LAZY_H__ */
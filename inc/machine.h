@@ -1,46 +1,145 @@
 /*****************************************************************************
- * 
+ *
  * @file machine.h
  * @date 17 Jule 2021
  * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
- * 
+ *
  * @brief Determined State Machine program emulation
- * 
+ *
  *****************************************************************************/
 
 #ifndef __MACHINE_H__
 #define __MACHINE_H__
 
+#include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "mem.h"
+
+struct dsml_parser;
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Output identifier of the empty '-' output
+ */
+#define MACHINE_EMPTY_OUTPUT ((int) -1)
+
+/**
+ * @def Check value of the transition table slot that is not owned by any state
+ */
+#define MACHINE_FREE_SLOT ((int) -1)
+
+/**
+ * @def Maximum length of the generated script line (DSML parser reads lines up to 255 characters)
+ */
+#define MACHINE_SCRIPT_LINE_LEN ((size_t) 200)
+
+/**
+ * @def Symbol prefix compared as two words by the input resolver
+ */
+#define MACHINE_RESOLVER_PREFIX_LEN ((size_t) 16)
+
+/**
+ * @def Average number of inputs per resolver bucket
+ */
+#define MACHINE_RESOLVER_BUCKET_SIZE ((int) 3)
+
+/**
+ * @def Displacements tried for a resolver bucket before the hash seed is changed
+ */
+#define MACHINE_RESOLVER_MAX_DISPLACE ((uint32_t) 1 << 20)
+
+/**
+ * @def Hash seeds tried by the resolver build
+ */
+#define MACHINE_RESOLVER_MAX_ATTEMPTS ((int) 8)
+
+/**
+ * @def Symbols hashed ahead of their verification by `machine_find_inputs`
+ */
+#define MACHINE_RESOLVER_BLOCK_SIZE ((size_t) 32)
+
+/**
+ * @def Bases tried for the row by the table packing before it is appended at the end
+ */
+#define MACHINE_PACK_MAX_PROBES ((int) 16)
 
 /* Enum ---------------------------------------------------------------------*/
 
 /**
- * @enum 
+ * @enum
  */
 enum machine_status {
     MACHINE_STATUS_SUCCESS,
     MACHINE_STATUS_NULL_PARAM,
+    MACHINE_STATUS_INVAL_PARAM,
     MACHINE_STATUS_INVAL_PARSER,
+    MACHINE_STATUS_ALPHABET_MISMATCH,
+    MACHINE_STATUS_UNSUPPORTED,
+    MACHINE_STATUS_STATE_BUDGET,
+    MACHINE_STATUS_OUTPUT_CONFLICT,
+    MACHINE_STATUS_MISSING_TRANS,
+    MACHINE_STATUS_REDEF_SYMBOL,
+};
+
+/**
+ * @enum Outcome of the acceptance known as soon as the state is entered
+ */
+enum machine_verdict {
+    MACHINE_VERDICT_UNDECIDED,
+    MACHINE_VERDICT_REJECT,     /* No final state is reachable (dead state) */
+    MACHINE_VERDICT_ACCEPT,     /* Only final states are reachable (accepting trap) */
 };
 
 /* Structures ---------------------------------------------------------------*/
 
 /**
- * @struct
+ * @struct Transition table slot.
+ * The slot belongs to the state which identifier is stored in `check`.
  */
 struct machine_trans {
-    struct machine_state* next_state;
-    const char* output;
+    int check;
+    int next_state;
+    int output;
 };
 
 /**
  * @struct
+ * Transitions of the state are stored in the shared table starting from `base`
+ * offset (row displacement). Inputs which slots are not owned by the state
+ * take the `default_trans`.
  */
 struct machine_state {
     const char* symbol;
-    struct machine_trans* trans_table;
+    int base;
     bool is_final;
+    int8_t verdict;     /* enum machine_verdict */
+    struct machine_trans default_trans;
+};
+
+/**
+ * @struct Input of the resolver slot, the symbol prefix is zero padded
+ */
+struct machine_resolver_slot {
+    uint64_t prefix[MACHINE_RESOLVER_PREFIX_LEN / sizeof(uint64_t)];
+    uint32_t length;
+    int32_t input;
+};
+
+/**
+ * @struct
+ * Minimal perfect hash of the input symbols (hash and displace): the symbol
+ * hash selects a bucket, the hash and the bucket displacement select one of
+ * `input_list_size` slots. Slots are NULL if the machine has no inputs.
+ */
+struct machine_resolver {
+    uint64_t seed;
+    uint32_t bucket_count;
+    uint32_t* displace_list;
+    struct machine_resolver_slot* slot_list;
 };
 
 /**
@@ -50,24 +149,182 @@ struct machine_instance {
     int input_list_size;
     int state_list_size;
     int output_list_size;
+    int trans_table_size;
 
     const char** input_list;
-    struct machine_state** state_list;
+    struct machine_state* state_list;
     const char** output_list;
+    struct machine_trans* trans_table;
+
+    int entry_state;
+
+    /* Single block holding every symbol of the machine built by `machine_init_move`, NULL otherwise */
+    char* symbol_pool;
+    size_t symbol_pool_size;
+
+    struct machine_resolver resolver;
+
+    /* Allocations owned by the machine */
+    struct mem_stats mem;
+};
 
-    struct machine_state* entry_state;
+/**
+ * @struct Run of `count` successive steps with the same non-empty output
+ */
+struct machine_output_run {
+    int output;
+    uint64_t count;
 };
 
+/**
+ * Transition table row source.
+ * Fills `row` with `input_list_size` transitions of the `state`
+ * (`check` field is ignored).
+ */
+typedef void (*machine_row_fn)(void* context, int state, struct machine_trans* row);
+
 /* Function Definitions -----------------------------------------------------*/
 
 /**
- * 
+ * Build machine from the validated DSML parser
  */
 enum machine_status machine_init(struct machine_instance* machine, struct dsml_parser* parser);
 
 /**
- * 
+ * Build machine from the validated DSML parser allocated with malloc, the parser is consumed.
+ * Transitions of the parser are released as their rows are taken and its symbols
+ * are moved to the machine symbol pool, so the strings are not held twice.
+ */
+enum machine_status machine_init_move(struct machine_instance* machine, struct dsml_parser* parser);
+
+/**
+ * Check the validated DSML parser and copy its alphabets and states.
+ * The transition table is not built.
+ */
+enum machine_status machine_init_lists(struct machine_instance* machine, struct dsml_parser* parser);
+
+/**
+ *
  */
 enum machine_status machine_free(struct machine_instance* machine);
 
-#endif /* __MACHINE_H__ */
\ No newline at end of file
+/**
+ * Build comb-compressed transition table of the machine which
+ * lists sizes are already set. Rows are requested from `row_fn` one by one.
+ * Every row tries at most MACHINE_PACK_MAX_PROBES bases, so the build is linear in the state count.
+ */
+enum machine_status machine_build_table(struct machine_instance* machine, machine_row_fn row_fn, void* context);
+
+/**
+ * Build comb-compressed transition table from the dense
+ * `state_list_size` x `input_list_size` tables
+ */
+enum machine_status machine_build_dense(struct machine_instance* machine, const int* next_table, const int* output_table);
+
+/**
+ * Get memory used by the machine lists and transition table
+ */
+enum machine_status machine_stats(const struct machine_instance* machine, struct mem_stats* stats);
+
+/**
+ * 64-bit FNV-1a style hash of the alphabets, state symbols and flags and of the
+ * transition function. It does not depend on the transition table layout.
+ */
+uint64_t machine_fingerprint(const struct machine_instance* machine);
+
+/**
+ * 64-bit FNV-1a hash of the symbol of `length` characters
+ */
+uint64_t machine_symbol_hash(const char* symbol, size_t length);
+
+/**
+ * Remove unreachable states and merge equivalent ones.
+ * States of the minimized machine are numbered in BFS order from the entry state.
+ */
+enum machine_status machine_minimize(struct machine_instance* machine);
+
+/**
+ * Write the machine as DSML script
+ */
+enum machine_status machine_write_script(const struct machine_instance* machine, FILE* fout);
+
+/**
+ * Run the machine from the `state` over `input_count` input identifiers.
+ * Output identifier of every step is written to `outputs`,
+ * the `state` is updated to the last state.
+ */
+enum machine_status machine_run(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    int* outputs, int* state);
+
+/**
+ * Run the machine as `machine_run` counting the outputs instead of storing them.
+ * `counts[output]` of the `output_list_size` counts is increased on every step
+ * with the output, empty outputs are not counted.
+ */
+enum machine_status machine_run_count(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    uint64_t* counts, int* state);
+
+/**
+ * Run the machine as `machine_run` appending the runs of equal outputs to the
+ * `run_count` runs of `runs`, empty outputs are skipped. The last run is
+ * extended if the output repeats it, so the calls continue the stream.
+ * The run stops before the step which needs run `run_cap`, `input_done`
+ * is the number of inputs taken. The caller drains all runs but the last
+ * one, moves it to the front and goes on.
+ */
+enum machine_status machine_run_rle(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    struct machine_output_run* runs, size_t run_cap, size_t* run_count, size_t* input_done, int* state);
+
+/**
+ * Check if the machine ends in a final state after the `input_count` inputs
+ * starting from the entry state. Outputs are not produced, the run stops as
+ * soon as the state with known verdict is entered.
+ */
+enum machine_status machine_accept(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    bool* is_accepted);
+
+/**
+ * Build the input resolver of the machine which input list is set.
+ * Called by the machine constructors.
+ */
+enum machine_status machine_build_resolver(struct machine_instance* machine);
+
+/**
+ * Get identifier of the input `symbol` of `length` characters, -1 if it is not an input
+ */
+int machine_find_input(const struct machine_instance* machine, const char* symbol, size_t length);
+
+/**
+ * Get identifiers of `count` input symbols at once (-1 for the unknown ones).
+ * Returns the number of unknown symbols.
+ */
+size_t machine_find_inputs(const struct machine_instance* machine, const char* const* symbols,
+    const size_t* lengths, size_t count, int* inputs);
+
+/**
+ * Find dead states and accepting traps of the machine.
+ * Called by `machine_build_table`.
+ */
+enum machine_status machine_classify_states(struct machine_instance* machine);
+
+/**
+ * Get transition of the `state` on the `input`
+ */
+static inline struct machine_trans machine_get_trans(const struct machine_instance* machine, int state, int input) {
+    const struct machine_state* current_state = &machine->state_list[state];
+    const struct machine_trans* slot = &machine->trans_table[current_state->base + input];
+
+    return (slot->check == state) ? *slot : current_state->default_trans;
+}
+
+/**
+ * Get next state of the `state` on the `input`
+ */
+static inline int machine_get_next_state(const struct machine_instance* machine, int state, int input) {
+    const struct machine_state* current_state = &machine->state_list[state];
+    const struct machine_trans* slot = &machine->trans_table[current_state->base + input];
+
+    return (slot->check == state) ? slot->next_state : current_state->default_trans.next_state;
+}
+
+#endif /* __MACHINE_H__ */
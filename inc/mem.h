@@ -0,0 +1,95 @@
+/*****************************************************************************
+ *
+ * @file mem.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Tracked allocations of parser and machine data
+ *
+ *****************************************************************************/
+
+#ifndef __MEM_H__
+#define __MEM_H__
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum Kind of the tracked data
+ */
+enum mem_category {
+    MEM_CATEGORY_SYMBOL,    /* Symbol strings */
+    MEM_CATEGORY_ENTITY,    /* State, input/output and transition structures */
+    MEM_CATEGORY_LIST,      /* Entity and symbol lists */
+    MEM_CATEGORY_TABLE,     /* Transition tables */
+    MEM_CATEGORY_NUM,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Allocations of one owner (parser or machine). Sizes are the requested
+ * ones, allocator overhead is not included.
+ */
+struct mem_stats {
+    size_t bytes[MEM_CATEGORY_NUM];
+    size_t alloc_count[MEM_CATEGORY_NUM];   /* Live allocations */
+
+    size_t total_alloc_count;               /* Allocations and reallocations made */
+    size_t peak_bytes;
+
+    /* Allocated but unused list capacity (included in the list bytes) */
+    size_t slack_bytes;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ *
+ */
+void mem_stats_init(struct mem_stats* stats);
+
+/**
+ * Sum of the live bytes of all categories
+ */
+size_t mem_stats_bytes(const struct mem_stats* stats);
+
+/**
+ *
+ */
+void mem_stats_print(const struct mem_stats* stats, FILE* fout);
+
+/**
+ *
+ */
+void* mem_alloc(struct mem_stats* stats, enum mem_category category, size_t size);
+
+/**
+ *
+ */
+void* mem_calloc(struct mem_stats* stats, enum mem_category category, size_t count, size_t size);
+
+/**
+ * Resize the allocation of `old_size` bytes
+ */
+void* mem_realloc(struct mem_stats* stats, enum mem_category category, void* ptr, size_t old_size, size_t new_size);
+
+/**
+ *
+ */
+char* mem_strdup(struct mem_stats* stats, const char* str);
+
+/**
+ * Free the allocation of `size` bytes
+ */
+void mem_free(struct mem_stats* stats, enum mem_category category, void* ptr, size_t size);
+
+/**
+ * Free the string allocated with `mem_strdup`
+ */
+void mem_free_string(struct mem_stats* stats, const char* str);
+
+#endif /* __MEM_H__ */
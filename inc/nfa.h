@@ -0,0 +1,53 @@
+/*****************************************************************************
+ *
+ * @file nfa.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Determinization of nondeterministic DSML scripts
+ *
+ *****************************************************************************/
+
+#ifndef __NFA_H__
+#define __NFA_H__
+
+#include "dsml.h"
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Default limit of the deterministic states built from the subsets
+ */
+#define NFA_DEFAULT_STATE_BUDGET ((int) 65536)
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct Two states of the same subset giving different outputs on the input.
+ * States are parser state identifiers, outputs are parser output identifiers
+ * or MACHINE_EMPTY_OUTPUT.
+ */
+struct nfa_conflict {
+    int input;
+    int state_list[2];
+    int output_list[2];
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Build deterministic machine from the parser of the nondeterministic script.
+ *
+ * Machine states are the subsets of the script states reachable from the entry
+ * state, built lazily in BFS order. The subset is final if any of its states is
+ * final, the empty subset is the dead state. States of the same subset must give
+ * the same output on the input, otherwise the conflict is reported to stderr and
+ * to `conflict` if it is not NULL. Returns MACHINE_STATUS_STATE_BUDGET if more
+ * than `state_budget` subsets are reachable. The machine is minimized, the parser
+ * is left to the caller.
+ */
+enum machine_status machine_determinize(struct machine_instance* machine, struct dsml_parser* parser,
+    int state_budget, struct nfa_conflict* conflict);
+
+#endif /* __NFA_H__ */
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ *
+ * @file registry.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Named machines compiled from a directory of DSML scripts
+ *
+ *****************************************************************************/
+
+#ifndef __REGISTRY_H__
+#define __REGISTRY_H__
+
+#include <stdint.h>
+
+#include "machine.h"
+#include "mem.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Extension of the scripts compiled into the registry
+ */
+#define REGISTRY_SCRIPT_EXT ".dsml"
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum registry_status {
+    REGISTRY_STATUS_SUCCESS,
+    REGISTRY_STATUS_NULL_PARAM,
+    REGISTRY_STATUS_INVAL_SCRIPT,
+    REGISTRY_STATUS_SYSTEM_ERROR,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct Machine of the script `name` (file name without the extension)
+ */
+struct registry_entry {
+    const char* name;
+    struct machine_instance machine;
+    bool is_shared_table;   /* Transition table belongs to another entry */
+};
+
+/**
+ * @struct
+ * Entries are sorted by name. Machines are minimized, so structurally identical
+ * machines have identical transition tables; each such table is stored once.
+ */
+struct registry {
+    int entry_count;
+    struct registry_entry* entry_list;
+
+    int table_count;    /* Distinct transition tables */
+
+    /* Allocations owned by the registry besides the machines */
+    struct mem_stats mem;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ *
+ */
+void registry_init(struct registry* registry);
+
+/**
+ *
+ */
+void registry_free(struct registry* registry);
+
+/**
+ * Compile and minimize every script of the directory on `thread_count` threads
+ * (all online processors if <= 0) and add them to the empty registry.
+ * Nothing is added if any script fails.
+ */
+enum registry_status registry_load_dir(struct registry* registry, const char* dir_path, int thread_count);
+
+/**
+ * Get machine of the script `name`, NULL if there is none
+ */
+const struct machine_instance* registry_find(const struct registry* registry, const char* name);
+
+/**
+ * Get memory used by the registry and all of its machines, shared tables are counted once
+ */
+enum registry_status registry_stats(const struct registry* registry, struct mem_stats* stats);
+
+#endif /* __REGISTRY_H__ */
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ *
+ * @file replay.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Checkpoint index of the input logs for replaying from arbitrary offsets
+ *
+ *****************************************************************************/
+
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Index file magic "DSMREPLY"
+ */
+#define REPLAY_FILE_MAGIC ((uint64_t) 0x594C5045524D5344ull)
+
+/**
+ * @def Index file layout version
+ */
+#define REPLAY_FILE_VERSION ((uint32_t) 1)
+
+/**
+ * @def Extension of the index written next to the log
+ */
+#define REPLAY_FILE_EXT ".idx"
+
+/**
+ * @def Size of the log chunks read at once
+ */
+#define REPLAY_CHUNK_SIZE ((size_t) 65536)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum replay_status {
+    REPLAY_STATUS_SUCCESS,
+    REPLAY_STATUS_NULL_PARAM,
+    REPLAY_STATUS_INVAL_PARAM,
+    REPLAY_STATUS_SYSTEM_ERROR,
+    REPLAY_STATUS_UNKNOWN_SYMBOL,   /* Log token is not an input of the machine */
+    REPLAY_STATUS_INVAL_INDEX,      /* Index is corrupted or made for another machine or log */
+    REPLAY_STATUS_OUT_OF_RANGE,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct State of the machine before the symbol `symbol_offset` which starts after `byte_offset`
+ */
+struct replay_checkpoint {
+    uint64_t symbol_offset;
+    uint64_t byte_offset;
+    int32_t state;
+    uint32_t reserved;
+};
+
+/**
+ * @struct Index file header, followed by `checkpoint_count` checkpoints
+ */
+struct replay_file_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fingerprint;       /* machine_fingerprint of the recording machine */
+    uint64_t interval;
+    uint64_t symbol_count;
+    uint64_t log_size;
+    uint64_t checkpoint_count;
+};
+
+/**
+ * @struct
+ * Checkpoint i is taken before the symbol i * `interval`, so the nearest
+ * checkpoint of any offset is found without search.
+ */
+struct replay_index {
+    uint64_t interval;
+    uint64_t symbol_count;
+    uint64_t log_size;
+
+    uint64_t checkpoint_count;
+    struct replay_checkpoint* checkpoint_list;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Run the machine over the whole `log` from the entry state.
+ * Output symbols are written to `fout` line by line ('-' for the empty output)
+ * unless it is NULL. Checkpoints are taken every `interval` symbols and written
+ * to `index_path` unless it is NULL.
+ */
+enum replay_status replay_record(const struct machine_instance* machine, FILE* log, FILE* fout,
+    uint64_t interval, const char* index_path);
+
+/**
+ * Load the index of the `log` recorded by the same machine
+ */
+enum replay_status replay_index_load(struct replay_index* index, const char* index_path,
+    const struct machine_instance* machine, FILE* log);
+
+/**
+ *
+ */
+void replay_index_free(struct replay_index* index);
+
+/**
+ * Replay symbols [`first`, `last`) of the log starting from the nearest checkpoint.
+ * Outputs of the symbols are written to `outputs` (`last` - `first` entries),
+ * `state` is set to the state before the symbol `last`.
+ */
+enum replay_status replay_query(const struct machine_instance* machine, const struct replay_index* index,
+    FILE* log, uint64_t first, uint64_t last, int* outputs, int* state);
+
+#endif /* __REPLAY_H__ */
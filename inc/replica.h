@@ -0,0 +1,127 @@
+/*****************************************************************************
+ *
+ * @file replica.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief NUMA node replicas of the transition table backed by huge pages
+ *
+ *****************************************************************************/
+
+#ifndef __REPLICA_H__
+#define __REPLICA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Replica flag: back the tables with huge pages (hugetlbfs, then transparent ones)
+ */
+#define REPLICA_FLAG_HUGE_PAGES ((uint32_t) 1 << 0)
+
+/**
+ * @def Replica flag: copy the tables to every online NUMA node
+ */
+#define REPLICA_FLAG_PER_NODE ((uint32_t) 1 << 1)
+
+/**
+ * @def Huge page size the mappings are aligned to
+ */
+#define REPLICA_HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+/**
+ * @def Nodes above this number are not replicated to
+ */
+#define REPLICA_MAX_NODES ((int) 64)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum replica_status {
+    REPLICA_STATUS_SUCCESS,
+    REPLICA_STATUS_NULL_PARAM,
+    REPLICA_STATUS_SYSTEM_ERROR,
+};
+
+/**
+ * @enum Pages backing the replica
+ */
+enum replica_pages {
+    REPLICA_PAGES_SHARED,       /* Tables of the source machine are used as they are */
+    REPLICA_PAGES_SMALL,
+    REPLICA_PAGES_TRANSPARENT,  /* Transparent huge pages were advised, the kernel may not grant them */
+    REPLICA_PAGES_HUGE,         /* hugetlbfs pages */
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Copy of the machine which state list and transition table live in one
+ * mapping, everything else is shared with the source machine.
+ * The instance must not be freed with `machine_free`.
+ */
+struct replica {
+    struct machine_instance machine;
+
+    int node;               /* -1 if the replica serves every node */
+    bool is_bound;          /* Memory policy of the mapping prefers the node */
+    enum replica_pages pages;
+
+    void* map;
+    size_t map_size;
+};
+
+/**
+ * @struct
+ * Replicas of one machine, a replica per online node with REPLICA_FLAG_PER_NODE
+ * on a multi-node host and a single one otherwise. The source machine must
+ * outlive the set and must not change.
+ */
+struct replica_set {
+    const struct machine_instance* source;
+
+    int replica_count;
+    struct replica* replica_list;
+
+    /* Replica of every node up to the highest online one */
+    int node_count;
+    int* node_replica_list;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Build the replicas of the `machine`. Huge pages and node binding fall back
+ * to small pages and the default memory policy where the system refuses them.
+ */
+enum replica_status replica_set_init(struct replica_set* set, const struct machine_instance* machine, uint32_t flags);
+
+/**
+ *
+ */
+enum replica_status replica_set_free(struct replica_set* set);
+
+/**
+ * Get the replica of the `node`, the first replica if the node has none
+ */
+const struct machine_instance* replica_set_get(const struct replica_set* set, int node);
+
+/**
+ * Get the replica of the node the calling thread runs on. Workers should
+ * pin themselves to the node and call it once, the lookup is a system call.
+ */
+const struct machine_instance* replica_set_local(const struct replica_set* set);
+
+/**
+ * NUMA node the calling thread runs on, 0 if unknown
+ */
+int replica_current_node(void);
+
+#endif /* __REPLICA_H__ */
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ *
+ * @file runner.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Resumable machine run pulling outputs from fed input chunks
+ *
+ *****************************************************************************/
+
+#ifndef __RUNNER_H__
+#define __RUNNER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "machine.h"
+#include "token.h"
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum runner_status {
+    RUNNER_STATUS_READY,            /* Step is made, its output is returned */
+    RUNNER_STATUS_NEED_INPUT,       /* Fed chunk is consumed */
+    RUNNER_STATUS_UNKNOWN_INPUT,    /* Text token is not an input of the machine, it is skipped */
+    RUNNER_STATUS_TOO_LONG,         /* Text token is longer than TOKEN_MAX_LEN, it is skipped */
+    RUNNER_STATUS_NULL_PARAM,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Run of the machine which takes one step per pulled output. The runner holds
+ * no buffer of its own: identifier chunks are read in place and text chunks
+ * through the tokenizer, which copies only the token split between chunks.
+ * A chunk must stay valid until the runner asks for the next one.
+ */
+struct machine_runner {
+    const struct machine_instance* machine;
+
+    int state;
+    uint64_t step_count;    /* Steps made since the start */
+
+    /* Identifier chunk */
+    const int* inputs;
+    size_t input_count;
+
+    /* Text chunk */
+    struct tokenizer tokenizer;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Start the run in the entry state
+ */
+void machine_runner_init(struct machine_runner* runner, const struct machine_instance* machine);
+
+/**
+ * Continue the run from the `state` after `step_count` steps, for the run
+ * restored from a checkpoint. Fed chunks are dropped.
+ */
+void machine_runner_resume(struct machine_runner* runner, int state, uint64_t step_count);
+
+/**
+ * Feed the next chunk of input identifiers, they must be valid inputs of the machine
+ */
+void machine_runner_feed_inputs(struct machine_runner* runner, const int* inputs, size_t input_count);
+
+/**
+ * Feed the next chunk of whitespace separated input symbols, a symbol may be split between chunks
+ */
+void machine_runner_feed_text(struct machine_runner* runner, const char* data, size_t size);
+
+/**
+ * Make one step on the next fed input and get its output (MACHINE_EMPTY_OUTPUT for '-').
+ * Identifier chunk is taken before the text one.
+ */
+enum runner_status machine_runner_next(struct machine_runner* runner, int* output);
+
+/**
+ * Make up to `output_cap` steps writing their outputs to `outputs`, `output_count` is the number made.
+ * Stops early on the status other than RUNNER_STATUS_READY, which is returned.
+ */
+enum runner_status machine_runner_pull(struct machine_runner* runner, int* outputs, size_t output_cap,
+    size_t* output_count);
+
+/**
+ * End of the text stream: step on the last symbol if it is not followed by a whitespace.
+ * RUNNER_STATUS_NEED_INPUT if there is none.
+ */
+enum runner_status machine_runner_finish(struct machine_runner* runner, int* output);
+
+#endif /* __RUNNER_H__ */
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ *
+ * @file server.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Event-driven front end feeding machine sessions from file descriptors
+ *
+ *****************************************************************************/
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+
+#include "machine.h"
+#include "token.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Size of the buffer bytes are read to
+ */
+#define SERVER_READ_SIZE ((size_t) 64 * 1024)
+
+/**
+ * @def Maximum number of events handled per wait
+ */
+#define SERVER_MAX_EVENTS ((int) 256)
+
+/**
+ * @def Number of outputs gathered for one `writev`
+ */
+#define SERVER_IOV_NUM ((int) 512)
+
+/**
+ * @def Pending reply bytes after which the connection input is not read until they are written
+ */
+#define SERVER_PENDING_CAP ((size_t) 1024 * 1024)
+
+/**
+ * @def Reply to the token which is not an input symbol
+ */
+#define SERVER_UNKNOWN_REPLY "?\n"
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum server_status {
+    SERVER_STATUS_SUCCESS,
+    SERVER_STATUS_NULL_PARAM,
+    SERVER_STATUS_SYSTEM_ERROR,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+struct server_connection;
+
+/**
+ * @struct Connection file descriptor registered in epoll
+ */
+struct server_endpoint {
+    struct server_connection* connection;
+    bool is_output;
+};
+
+/**
+ * @struct
+ * Session of the machine fed from `fd_in` and replying to `fd_out`
+ * (the same descriptor for sockets). Every input token is answered with
+ * its output symbol line, '-' for the empty output.
+ */
+struct server_connection {
+    int fd_in;
+    int fd_out;
+    int state;
+
+    struct tokenizer tokenizer;
+    struct server_endpoint in_endpoint;
+    struct server_endpoint out_endpoint;
+
+    /* Replies not accepted by `fd_out` yet */
+    char* pending;
+    size_t pending_size;
+    size_t pending_cap;
+
+    bool is_input_closed;
+    bool is_input_paused;   /* Input is not watched while the pending replies are over SERVER_PENDING_CAP */
+    bool is_always_ready;   /* Input is a regular file which epoll refuses, it is read on every poll */
+    bool is_dead;           /* Closed once the events of the current batch are handled */
+
+    struct server_connection* prev;
+    struct server_connection* next;
+
+    /* Always ready connections, connections closed in the current batch */
+    struct server_connection* ready_prev;
+    struct server_connection* ready_next;
+    struct server_connection* dead_next;
+};
+
+/**
+ * @struct
+ */
+struct server {
+    const struct machine_instance* machine;
+
+    int epoll_fd;
+    int listen_fd;
+    volatile sig_atomic_t is_running;   /* Cleared by `server_stop`, which may be called from a signal handler */
+
+    struct server_connection* connections;
+    int connection_count;
+
+    /* Swept after every wait instead of all connections */
+    struct server_connection* ready_connections;
+    struct server_connection* dead_connections;
+
+    /* Replies are pre-rendered "<output>\n" lines indexed by output + 1 */
+    char** reply_list;
+    size_t* reply_len_list;
+
+    char* read_buffer;
+
+    uint64_t event_count;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ *
+ */
+enum server_status server_init(struct server* server, const struct machine_instance* machine);
+
+/**
+ * Close all connections and release the server
+ */
+enum server_status server_free(struct server* server);
+
+/**
+ * Accept connections on the Unix socket `path`
+ */
+enum server_status server_listen(struct server* server, const char* path);
+
+/**
+ * Add session reading from `fd_in` and writing to `fd_out`.
+ * Descriptors are switched to non-blocking mode and closed with the connection.
+ */
+enum server_status server_add_connection(struct server* server, int fd_in, int fd_out);
+
+/**
+ * Wait up to `timeout_ms` for ready descriptors and handle them
+ */
+enum server_status server_poll(struct server* server, int timeout_ms);
+
+/**
+ * Handle events until `server_stop` is called or all connections are
+ * closed while the server is not listening
+ */
+enum server_status server_run(struct server* server);
+
+/**
+ * Make `server_run` return after the current poll, safe to call from a signal handler
+ */
+void server_stop(struct server* server);
+
+#endif /* __SERVER_H__ */
@@ -0,0 +1,210 @@
+/*****************************************************************************
+ *
+ * @file session.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Current states of machine sessions with file-backed checkpoints
+ *
+ *****************************************************************************/
+
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Session file magic "DSMSESS\0"
+ */
+#define SESSION_FILE_MAGIC ((uint64_t) 0x00535345534D5344ull)
+
+/**
+ * @def Session file layout version
+ */
+#define SESSION_FILE_VERSION ((uint32_t) 1)
+
+/**
+ * @def Alignment of the session file sections
+ */
+#define SESSION_FILE_ALIGN ((size_t) 4096)
+
+/**
+ * @def Number of checkpoint slots, written in turn
+ */
+#define SESSION_CHECKPOINT_SLOTS ((int) 2)
+
+/**
+ * @def Last level cache size assumed if the system does not report it
+ */
+#define SESSION_DEFAULT_CACHE_SIZE ((size_t) 8 * 1024 * 1024)
+
+/**
+ * @def Number of table regions the grouped dispatch partitions events into (one radix pass)
+ */
+#define SESSION_DISPATCH_REGIONS ((int) 256)
+
+/**
+ * @def Sessions are counted in a dense array if there are at most that many per batch event
+ */
+#define SESSION_DISPATCH_DENSE_RATIO ((size_t) 16)
+
+/**
+ * @def Smallest batch the automatic dispatch groups
+ */
+#define SESSION_DISPATCH_MIN_EVENTS ((size_t) 4096)
+
+/**
+ * @def Cache line size, the automatic dispatch groups batches with an event per table line or more
+ */
+#define SESSION_CACHE_LINE_SIZE ((size_t) 64)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum session_status {
+    SESSION_STATUS_SUCCESS,
+    SESSION_STATUS_NULL_PARAM,
+    SESSION_STATUS_INVAL_PARAM,
+    SESSION_STATUS_SYSTEM_ERROR,
+    SESSION_STATUS_INVAL_FILE,          /* Not a session file, other version or no valid checkpoint */
+    SESSION_STATUS_MACHINE_MISMATCH,    /* Checkpoint belongs to other machine */
+};
+
+/**
+ * @enum What to do when the checkpoint was made with other machine
+ */
+enum session_restore_mode {
+    SESSION_RESTORE_STRICT,     /* Fail, the file is left as is */
+    SESSION_RESTORE_REMAP,      /* Map states by symbol, fail if some state is missing */
+};
+
+/**
+ * @enum Order the batch events are applied in
+ */
+enum session_dispatch_mode {
+    SESSION_DISPATCH_AUTO,      /* Grouped if the machine does not fit the last level cache and the batch reuses its lines */
+    SESSION_DISPATCH_DIRECT,    /* Batch order */
+    SESSION_DISPATCH_GROUPED,   /* Grouped by the transition table region of the current state */
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct Input of the session
+ */
+struct session_event {
+    size_t session;
+    int input;
+};
+
+/**
+ * @struct Checkpoint slot descriptor
+ */
+struct session_checkpoint {
+    uint64_t sequence;      /* 0 if the slot was never written */
+    uint64_t checksum;
+};
+
+/**
+ * @struct
+ * Session file header.
+ * The file holds the header, state symbols of the machine (zero separated),
+ * the live state array and SESSION_CHECKPOINT_SLOTS checkpoint arrays,
+ * every section is aligned to SESSION_FILE_ALIGN.
+ */
+struct session_file_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t state_count;
+
+    uint64_t machine_fingerprint;
+    uint64_t session_count;
+
+    uint64_t symbols_offset;
+    uint64_t symbols_size;
+    uint64_t live_offset;
+    uint64_t checkpoint_offset[SESSION_CHECKPOINT_SLOTS];
+
+    struct session_checkpoint checkpoint_list[SESSION_CHECKPOINT_SLOTS];
+};
+
+/**
+ * @struct
+ * Current state of every session. The state array is allocated in memory or
+ * mapped from the session file.
+ */
+struct session_table {
+    const struct machine_instance* machine;
+    uint64_t machine_fingerprint;
+
+    int* state_list;
+    size_t session_count;
+
+    /* Last level cache size the automatic dispatch compares the machine with */
+    size_t cache_size;
+
+    /* File backing, `fd` is -1 for the table in memory */
+    int fd;
+    void* map;
+    size_t map_size;
+    struct session_file_header* header;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Create table of `session_count` sessions in memory, all in the entry state
+ */
+enum session_status session_table_init(struct session_table* table, const struct machine_instance* machine,
+    size_t session_count);
+
+/**
+ * Create session file `path` of `session_count` sessions in the entry state.
+ * The file is prepared aside and renamed over `path`.
+ */
+enum session_status session_table_create(struct session_table* table, const struct machine_instance* machine,
+    const char* path, size_t session_count);
+
+/**
+ * Open session file `path` and restore sessions from its latest valid checkpoint.
+ * The file of other machine is remapped by state symbols and rewritten when
+ * `mode` is SESSION_RESTORE_REMAP.
+ */
+enum session_status session_table_open(struct session_table* table, const struct machine_instance* machine,
+    const char* path, enum session_restore_mode mode);
+
+/**
+ * Copy current states to the older checkpoint slot and make it the latest one.
+ * Does nothing for the table in memory.
+ */
+enum session_status session_table_checkpoint(struct session_table* table);
+
+/**
+ *
+ */
+enum session_status session_table_free(struct session_table* table);
+
+/**
+ * Run the `session` over `input_count` inputs, see `machine_run`
+ */
+enum session_status session_table_run(struct session_table* table, size_t session, const int* inputs,
+    size_t input_count, int* outputs);
+
+/**
+ * Apply `event_count` events of any sessions, output of the event `i` is written to `outputs[i]`.
+ * Events of the same session are applied in the batch order whatever the `mode` is.
+ * Grouped dispatch applies the events in waves, the n-th event of every session in
+ * the n-th wave, and sorts every wave by the table region of the current state.
+ */
+enum session_status session_table_dispatch(struct session_table* table, const struct session_event* events,
+    size_t event_count, int* outputs, enum session_dispatch_mode mode);
+
+#endif /* __SESSION_H__ */
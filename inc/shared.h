@@ -0,0 +1,174 @@
+/*****************************************************************************
+ *
+ * @file shared.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Session table and machine shared by processes in POSIX shared memory
+ *
+ *****************************************************************************/
+
+#ifndef __SHARED_H__
+#define __SHARED_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "machine.h"
+#include "session.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Segment magic "DSMSHM\0\0"
+ */
+#define SHARED_MAGIC ((uint64_t) 0x00004D48534D5344ull)
+
+/**
+ * @def Segment layout version, bump when any shared structure changes
+ */
+#define SHARED_LAYOUT_VERSION ((uint32_t) 2)
+
+/**
+ * @def Alignment of the segment sections
+ */
+#define SHARED_ALIGN ((size_t) 4096)
+
+/**
+ * @def Number of processes attached at once
+ */
+#define SHARED_MAX_PROCESSES ((int) 256)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum shared_status {
+    SHARED_STATUS_SUCCESS,
+    SHARED_STATUS_NULL_PARAM,
+    SHARED_STATUS_INVAL_PARAM,
+    SHARED_STATUS_SYSTEM_ERROR,
+    SHARED_STATUS_EXISTS,           /* Segment of the name is already there */
+    SHARED_STATUS_NOT_READY,        /* Segment is being created, or its creator died and it is removed */
+    SHARED_STATUS_LAYOUT_MISMATCH,  /* Segment was created by an incompatible build */
+    SHARED_STATUS_INVAL_SEGMENT,
+    SHARED_STATUS_NO_SLOT,          /* SHARED_MAX_PROCESSES live processes are attached */
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct State of the shared machine, symbols are in the symbol section
+ */
+struct shared_state {
+    int32_t base;
+    int32_t is_final;
+    int32_t verdict;
+    struct machine_trans default_trans;
+};
+
+/**
+ * @struct
+ * Segment header. The segment holds the header, the machine symbols (inputs,
+ * outputs and states, zero separated), the states, the transition table and
+ * the session states, every section is aligned to SHARED_ALIGN. Everything
+ * but the session states and the process slots is written once by the creator
+ * before `is_ready` is set. The creator process identifier is written along
+ * with the magic before the segment is sized, so the segment of the creator
+ * which died before it is ready can be told from the one being created.
+ */
+struct shared_header {
+    uint64_t magic;
+    uint32_t version;
+    atomic_int is_ready;
+    atomic_int creator_pid;         /* -1 once the segment of the dead creator is claimed for removal */
+
+    /* Sizes of the shared structures, builds which lay them out differently refuse the segment */
+    uint16_t header_size;
+    uint16_t state_size;
+    uint16_t trans_size;
+    uint16_t atomic_int_size;
+
+    uint64_t segment_size;
+    uint64_t machine_fingerprint;
+
+    int32_t input_list_size;
+    int32_t state_list_size;
+    int32_t output_list_size;
+    int32_t trans_table_size;
+    int32_t entry_state;
+
+    uint64_t symbols_offset;
+    uint64_t symbols_size;
+    uint64_t state_list_offset;
+    uint64_t trans_table_offset;
+    uint64_t session_offset;
+    uint64_t session_count;
+
+    /* Process identifiers of the attached processes, 0 for the free slot */
+    atomic_int process_list[SHARED_MAX_PROCESSES];
+};
+
+/**
+ * @struct
+ * Process attachment. The machine is a local view: its symbols, lists and
+ * resolver are copied on attach, the transition table is the shared one.
+ */
+struct shared_table {
+    struct machine_instance machine;
+
+    struct shared_header* header;
+    atomic_int* state_list;
+    size_t session_count;
+
+    void* map;
+    size_t map_size;
+    int process_slot;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Create segment `name` (shm_open name, "/dsm" for example) holding the machine
+ * and `session_count` sessions in the entry state. The segment is published
+ * ready once it is complete, the creator does not stay attached. The segment
+ * left not ready by the dead creator is removed and created again.
+ */
+enum shared_status shared_table_create(const char* name, const struct machine_instance* machine,
+    size_t session_count);
+
+/**
+ * Attach the process to the segment. Slots of the processes which died
+ * attached are taken over, a crash never leaves the segment inconsistent.
+ * The segment left not ready by the dead creator is removed, SHARED_STATUS_NOT_READY
+ * is returned and the next create builds it again.
+ */
+enum shared_status shared_table_attach(struct shared_table* table, const char* name);
+
+/**
+ * Release the process slot and unmap the segment
+ */
+enum shared_status shared_table_detach(struct shared_table* table);
+
+/**
+ * Remove the segment name, attached processes keep their mapping
+ */
+enum shared_status shared_table_unlink(const char* name);
+
+/**
+ * Number of live attached processes
+ */
+int shared_table_process_count(const struct shared_table* table);
+
+/**
+ * Apply `event_count` events, see `session_table_dispatch`. Every event is
+ * applied atomically: the state of the session is replaced by compare and swap,
+ * so events of one session sent by several processes are applied one after another.
+ */
+enum shared_status shared_table_dispatch(struct shared_table* table, const struct session_event* events,
+    size_t event_count, int* outputs);
+
+#endif /* __SHARED_H__ */
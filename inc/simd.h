@@ -0,0 +1,94 @@
+/*****************************************************************************
+ *
+ * @file simd.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Shuffle-based execution engine for machines with up to 64 states
+ *
+ *****************************************************************************/
+
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Maximum number of machine states
+ */
+#define SIMD_MAX_STATES ((int) 64)
+
+/**
+ * @def Number of inputs which transition functions are composed at once
+ */
+#define SIMD_CHUNK ((int) 16)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum simd_isa {
+    SIMD_ISA_AUTO,
+    SIMD_ISA_SCALAR,
+    SIMD_ISA_SSSE3,     /* Up to 16 states, PSHUFB */
+    SIMD_ISA_AVX2,      /* Up to 32 states, two VPSHUFB and blend */
+    SIMD_ISA_AVX512,    /* Up to 64 states, VPERMB (AVX-512 VBMI) */
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Transition function of the input `i` is the byte vector
+ * `next_vectors[i * width ... i * width + width - 1]` mapping state to the next state.
+ * AVX2 engine also keeps both 16-byte halves of every vector broadcast
+ * to the two 128-bit lanes in `lane_vectors`.
+ */
+struct machine_simd {
+    enum simd_isa isa;
+    int width;
+    int input_list_size;
+    uint8_t* next_vectors;
+    uint8_t* lane_vectors;
+    int16_t* output_table;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Check if the CPU supports the instruction set
+ */
+bool machine_simd_isa_supported(enum simd_isa isa);
+
+/**
+ * Build the shuffle tables. SIMD_ISA_AUTO picks the best instruction set
+ * supported by the CPU for the machine size. Returns MACHINE_STATUS_UNSUPPORTED
+ * if the machine has more than SIMD_MAX_STATES states or the requested
+ * instruction set is not available.
+ */
+enum machine_status machine_simd_init(struct machine_simd* simd, const struct machine_instance* machine,
+    enum simd_isa isa);
+
+/**
+ *
+ */
+enum machine_status machine_simd_free(struct machine_simd* simd);
+
+/**
+ * Same as `machine_run`
+ */
+enum machine_status machine_simd_run(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state);
+
+/**
+ *
+ */
+const char* machine_simd_isa_name(enum simd_isa isa);
+
+#endif /* __SIMD_H__ */
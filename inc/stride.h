@@ -0,0 +1,67 @@
+/*****************************************************************************
+ *
+ * @file stride.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Multi-symbol stride tables for machines with small input alphabets
+ *
+ *****************************************************************************/
+
+#ifndef __STRIDE_H__
+#define __STRIDE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Maximum number of input symbols consumed by one stride table lookup
+ */
+#define STRIDE_MAX_K ((int) 4)
+
+/**
+ * @def Default stride table size limit (typical L2 cache size)
+ */
+#define STRIDE_DEFAULT_CACHE_BUDGET ((size_t) 256 * 1024)
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Entry for the state and `k` inputs (i0, ..., ik-1) has index
+ * `state * width + ((i0 * I + i1) * I + ...)`, where I is the input alphabet size.
+ * Entry outputs are stored as `k` consecutive output identifiers.
+ */
+struct machine_stride {
+    int k;
+    int width;
+    int input_list_size;
+    int* next_table;
+    int16_t* output_table;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ * Build the stride table choosing the largest `k` which table fits into the
+ * `cache_budget` bytes. Returns MACHINE_STATUS_UNSUPPORTED if even `k` = 2 does not fit.
+ */
+enum machine_status machine_stride_init(struct machine_stride* stride, const struct machine_instance* machine,
+    size_t cache_budget);
+
+/**
+ *
+ */
+enum machine_status machine_stride_free(struct machine_stride* stride);
+
+/**
+ * Same as `machine_run`, but consumes `k` inputs per table lookup
+ */
+enum machine_status machine_stride_run(const struct machine_stride* stride, const struct machine_instance* machine,
+    const int* inputs, size_t input_count, int* outputs, int* state);
+
+#endif /* __STRIDE_H__ */
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ *
+ * @file token.h
+ * @date 19 October 2026
+ * @author Mikhail Malyarenko <malyarenko.md@gmail.com>
+ *
+ * @brief Incremental splitter of input symbol streams
+ *
+ *****************************************************************************/
+
+#ifndef __TOKEN_H__
+#define __TOKEN_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Define -------------------------------------------------------------------*/
+
+/**
+ * @def Maximum length of the token, same as the DSML line limit
+ */
+#define TOKEN_MAX_LEN ((size_t) 255)
+
+/* Enum ---------------------------------------------------------------------*/
+
+/**
+ * @enum
+ */
+enum token_status {
+    TOKEN_STATUS_READY,
+    TOKEN_STATUS_NEED_INPUT,
+    TOKEN_STATUS_TOO_LONG,
+};
+
+/* Structures ---------------------------------------------------------------*/
+
+/**
+ * @struct
+ * Tokens are separated by whitespace characters. Tokens inside the fed chunk
+ * are returned in place, only the token split between chunks is copied
+ * to the `buffer`.
+ */
+struct tokenizer {
+    const char* data;
+    size_t size;
+
+    char buffer[TOKEN_MAX_LEN + 1];
+    size_t length;
+    bool is_skipping;
+};
+
+/* Function Definitions -----------------------------------------------------*/
+
+/**
+ *
+ */
+void tokenizer_init(struct tokenizer* tokenizer);
+
+/**
+ * Set the next chunk of the stream. The chunk must stay valid until
+ * `tokenizer_next` returns TOKEN_STATUS_NEED_INPUT.
+ */
+void tokenizer_feed(struct tokenizer* tokenizer, const char* data, size_t size);
+
+/**
+ * Get the next complete token of the current chunk.
+ * Token longer than TOKEN_MAX_LEN is reported once with TOKEN_STATUS_TOO_LONG
+ * and skipped.
+ */
+enum token_status tokenizer_next(struct tokenizer* tokenizer, const char** token, size_t* length);
+
+/**
+ * Get the last token of the stream if it is not followed by a whitespace
+ */
+enum token_status tokenizer_finish(struct tokenizer* tokenizer, const char** token, size_t* length);
+
+#endif /* __TOKEN_H__ */
@@ -10,4 +10,9 @@
  */
 bool is_blank(const char* str);
 
+/**
+ * Reentrant `strtok`: `str` is NULL to continue the split kept in `save_ptr`
+ */
+char* str_token(char* str, const char* delim, char** save_ptr);
+
 #endif /* __UTIL_H__ */
\ No newline at end of file
@@ -1,3 +1,49 @@
 SOURCES = dsml.c \
           machine.c \
-		  util.c
\ No newline at end of file
+          compose.c \
+          editor.c \
+          nfa.c \
+          stride.c \
+          batch.c \
+          simd.c \
+          token.c \
+          mem.c \
+          lazy.c \
+          replay.c \
+          latency.c \
+          runner.c \
+		  util.c
+
+LINUX_SOURCES = server.c \
+                session.c \
+                cache.c \
+                registry.c \
+                dsmi.c \
+                replica.c \
+                shared.c
+
+MAIN_SOURCE = dsm.c
+
+BENCH_SOURCES = bench_stride.c \
+                bench_batch.c \
+                bench_simd.c \
+                bench_lazy.c \
+                bench_dsml.c \
+                bench_resolver.c \
+                bench_nfa.c \
+                bench_latency.c \
+                bench_output.c \
+                bench_runner.c \
+                bench_pack.c
+
+LINUX_BENCH_SOURCES = bench_server.c \
+                      bench_session.c \
+                      bench_cache.c \
+                      bench_build.c \
+                      bench_replay.c \
+                      bench_registry.c \
+                      bench_dsmi.c \
+                      bench_editor.c \
+                      bench_dispatch.c \
+                      bench_replica.c \
+                      bench_shared.c
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "machine.h"
+#include "batch.h"
+
+/**
+ * @struct Records range processed by one thread
+ */
+struct batch_task {
+    const struct machine_instance* machine;
+    const int* symbols;
+    const size_t* offsets;
+    size_t record_begin;
+    size_t record_end;
+    uint64_t* accepted;
+    int* end_states;
+};
+
+/**
+ * @struct Record in flight
+ */
+struct batch_lane {
+    const int* position;
+    const int* end;
+    size_t record;
+    int state;
+};
+
+static void batch_finish_record(const struct batch_task* task, const struct batch_lane* lane) {
+    const struct machine_instance* machine = task->machine;
+
+    if (machine->state_list[lane->state].is_final) {
+        task->accepted[lane->record / 64] |= (uint64_t) 1 << (lane->record % 64);
+    }
+
+    if (task->end_states != NULL) {
+        task->end_states[lane->record] = lane->state;
+    }
+}
+
+static void* batch_task_run(void* arg) {
+    const struct batch_task* task = (const struct batch_task*) arg;
+    const struct machine_instance* machine = task->machine;
+    const bool is_early_exit = (task->end_states == NULL);
+
+    struct batch_lane lanes[BATCH_LANES];
+    int lane_count = 0;
+    size_t next_record = task->record_begin;
+
+    /* Bitmap words of the range are owned by this task only */
+    memset(&task->accepted[task->record_begin / 64], 0,
+        ((task->record_end - task->record_begin + 63) / 64) * sizeof(uint64_t));
+
+    for (;;) {
+        /* Refill empty lanes, records finished before the first step are done right away */
+        while ((lane_count < BATCH_LANES) && (next_record < task->record_end)) {
+            struct batch_lane* lane = &lanes[lane_count];
+
+            lane->position = task->symbols + task->offsets[next_record];
+            lane->end = task->symbols + task->offsets[next_record + 1];
+            lane->record = next_record++;
+            lane->state = machine->entry_state;
+
+            if ((lane->position == lane->end) ||
+                (is_early_exit && (machine->state_list[lane->state].verdict != MACHINE_VERDICT_UNDECIDED)))
+            {
+                batch_finish_record(task, lane);
+            }
+            else {
+                lane_count++;
+            }
+        }
+
+        if (lane_count == 0) {
+            break;
+        }
+
+        /* One step of every lane: independent dependent-load chains overlap */
+        for (int i = 0; i < lane_count; i++) {
+            lanes[i].state = machine_get_next_state(machine, lanes[i].state, *lanes[i].position++);
+        }
+
+        for (int i = 0; i < lane_count; i++) {
+            if ((lanes[i].position == lanes[i].end) ||
+                (is_early_exit && (machine->state_list[lanes[i].state].verdict != MACHINE_VERDICT_UNDECIDED)))
+            {
+                batch_finish_record(task, &lanes[i]);
+                lanes[i--] = lanes[--lane_count];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+enum machine_status machine_accept_batch(const struct machine_instance* machine, const int* symbols,
+    const size_t* offsets, size_t record_count, uint64_t* accepted, int* end_states, int thread_count)
+{
+    if ((machine == NULL) || (symbols == NULL) || (offsets == NULL) || (accepted == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (thread_count <= 0) {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (processor_count > 0) ? (int) processor_count : 1;
+    }
+
+    /* Split by whole bitmap words so threads never share one */
+    const size_t unit_count = (record_count + BATCH_UNIT - 1) / BATCH_UNIT;
+
+    if ((size_t) thread_count > unit_count) {
+        thread_count = (unit_count > 0) ? (int) unit_count : 1;
+    }
+
+    struct batch_task* tasks = (struct batch_task*) malloc(thread_count * sizeof(struct batch_task));
+    pthread_t* threads = (pthread_t*) malloc(thread_count * sizeof(pthread_t));
+
+    for (int i = 0; i < thread_count; i++) {
+        size_t unit_begin = unit_count * i / thread_count;
+        size_t unit_end = unit_count * (i + 1) / thread_count;
+
+        tasks[i].machine = machine;
+        tasks[i].symbols = symbols;
+        tasks[i].offsets = offsets;
+        tasks[i].record_begin = unit_begin * BATCH_UNIT;
+        tasks[i].record_end = (unit_end * BATCH_UNIT < record_count) ? unit_end * BATCH_UNIT : record_count;
+        tasks[i].accepted = accepted;
+        tasks[i].end_states = end_states;
+    }
+
+    /* Calling thread takes the first range itself */
+    int started_count = 1;
+
+    for (int i = 1; i < thread_count; i++, started_count++) {
+        if (pthread_create(&threads[i], NULL, batch_task_run, &tasks[i]) != 0) {
+            break;
+        }
+    }
+
+    batch_task_run(&tasks[0]);
+
+    for (int i = started_count; i < thread_count; i++) {
+        batch_task_run(&tasks[i]);
+    }
+
+    for (int i = 1; i < started_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(tasks);
+    free(threads);
+
+    return MACHINE_STATUS_SUCCESS;
+}
@@ -0,0 +1,419 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "mem.h"
+#include "cache.h"
+
+/**
+ * @struct Cache entry header, followed by the symbols (inputs, outputs and
+ * states, zero terminated, padded to CACHE_FILE_ALIGN), state records and
+ * transition table
+ */
+struct cache_file_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint64_t key;
+
+    int32_t input_list_size;
+    int32_t state_list_size;
+    int32_t output_list_size;
+    int32_t trans_table_size;
+    int32_t entry_state;
+    uint32_t symbols_size;
+};
+
+_Static_assert(sizeof(struct cache_file_header) % CACHE_FILE_ALIGN == 0, "symbols must start aligned");
+
+/**
+ * @struct
+ */
+struct cache_state {
+    int32_t base;
+    int32_t default_next_state;
+    int32_t default_output;
+    uint8_t is_final;
+    int8_t verdict;
+    uint8_t reserved[2];
+};
+
+static size_t cache_align(size_t size) {
+    return (size + CACHE_FILE_ALIGN - 1) & ~(CACHE_FILE_ALIGN - 1);
+}
+
+static uint64_t cache_hash(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+uint64_t cache_key(const char* script, size_t script_size, uint32_t flags) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    hash = cache_hash(hash, CACHE_COMPILER_VERSION, sizeof(CACHE_COMPILER_VERSION));
+    hash = cache_hash(hash, &flags, sizeof(flags));
+    hash = cache_hash(hash, script, script_size);
+
+    return hash;
+}
+
+/**
+ * Read the whole file, NULL on failure
+ */
+static char* cache_read_file(const char* path, size_t* size) {
+    FILE* fin = fopen(path, "rb");
+
+    if (fin == NULL) {
+        return NULL;
+    }
+
+    char* data = NULL;
+    long file_size = -1;
+
+    if (fseek(fin, 0, SEEK_END) == 0) {
+        file_size = ftell(fin);
+    }
+
+    if ((file_size >= 0) && (fseek(fin, 0, SEEK_SET) == 0)) {
+        data = (char*) malloc((size_t) file_size + 1);
+
+        if (fread(data, 1, (size_t) file_size, fin) != (size_t) file_size) {
+            free(data);
+            data = NULL;
+        }
+        else {
+            data[file_size] = '\0';
+            *size = (size_t) file_size;
+        }
+    }
+
+    fclose(fin);
+    return data;
+}
+
+static bool cache_valid_trans(const struct cache_file_header* header, int next_state, int output) {
+    return (next_state >= 0) && (next_state < header->state_list_size) &&
+        (output >= MACHINE_EMPTY_OUTPUT) && (output < header->output_list_size);
+}
+
+/**
+ * Check that the entry is complete and every index stays in range
+ */
+static bool cache_validate(const char* data, size_t size, uint64_t key, uint32_t flags) {
+    if (size < sizeof(struct cache_file_header)) {
+        return false;
+    }
+
+    const struct cache_file_header* header = (const struct cache_file_header*) data;
+
+    if ((header->magic != CACHE_FILE_MAGIC) || (header->version != CACHE_FILE_VERSION) ||
+        (header->key != key) || (header->flags != flags) ||
+        (header->input_list_size <= 0) || (header->state_list_size <= 0) ||
+        (header->output_list_size < 0) || (header->trans_table_size < header->input_list_size) ||
+        (header->entry_state < 0) || (header->entry_state >= header->state_list_size))
+    {
+        return false;
+    }
+
+    const size_t states_offset = sizeof(struct cache_file_header) + cache_align(header->symbols_size);
+    const size_t table_offset = states_offset + (size_t) header->state_list_size * sizeof(struct cache_state);
+
+    if (table_offset + (size_t) header->trans_table_size * sizeof(struct machine_trans) != size) {
+        return false;
+    }
+
+    /* Symbols */
+    const char* symbols = data + sizeof(struct cache_file_header);
+    int symbol_count = 0;
+
+    for (uint32_t i = 0; i < header->symbols_size; i++) {
+        symbol_count += (symbols[i] == '\0');
+    }
+
+    if ((symbol_count != header->input_list_size + header->output_list_size + header->state_list_size) ||
+        ((header->symbols_size != 0) && (symbols[header->symbols_size - 1] != '\0')))
+    {
+        return false;
+    }
+
+    /* States */
+    const struct cache_state* states = (const struct cache_state*) (data + states_offset);
+
+    for (int i = 0; i < header->state_list_size; i++) {
+        if ((states[i].base < 0) || (states[i].base > header->trans_table_size - header->input_list_size) ||
+            !cache_valid_trans(header, states[i].default_next_state, states[i].default_output))
+        {
+            return false;
+        }
+    }
+
+    /* Transition table */
+    const struct machine_trans* table = (const struct machine_trans*) (data + table_offset);
+
+    for (int i = 0; i < header->trans_table_size; i++) {
+        if (table[i].check == MACHINE_FREE_SLOT) {
+            continue;
+        }
+
+        if ((table[i].check < 0) || (table[i].check >= header->state_list_size) ||
+            !cache_valid_trans(header, table[i].next_state, table[i].output))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static const char* cache_copy_symbols(struct machine_instance* machine, const char* symbols,
+    const char** symbol_list, int symbol_count)
+{
+    for (int i = 0; i < symbol_count; i++) {
+        symbol_list[i] = mem_strdup(&machine->mem, symbols);
+        symbols += strlen(symbols) + 1;
+    }
+
+    return symbols;
+}
+
+/**
+ * Load the machine from the validated entry
+ */
+static void cache_load_entry(struct machine_instance* machine, const char* data) {
+    const struct cache_file_header* header = (const struct cache_file_header*) data;
+    struct mem_stats* mem = &machine->mem;
+
+    mem_stats_init(mem);
+
+    machine->input_list_size = header->input_list_size;
+    machine->state_list_size = header->state_list_size;
+    machine->output_list_size = header->output_list_size;
+    machine->trans_table_size = header->trans_table_size;
+    machine->entry_state = header->entry_state;
+
+    machine->input_list =
+        (const char**) mem_alloc(mem, MEM_CATEGORY_LIST, machine->input_list_size * sizeof(const char*));
+    machine->output_list =
+        (const char**) mem_alloc(mem, MEM_CATEGORY_LIST, machine->output_list_size * sizeof(const char*));
+    machine->state_list = (struct machine_state*)
+        mem_alloc(mem, MEM_CATEGORY_ENTITY, machine->state_list_size * sizeof(struct machine_state));
+    machine->trans_table = (struct machine_trans*)
+        mem_alloc(mem, MEM_CATEGORY_TABLE, machine->trans_table_size * sizeof(struct machine_trans));
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+
+    const char* symbols = data + sizeof(struct cache_file_header);
+
+    symbols = cache_copy_symbols(machine, symbols, machine->input_list, machine->input_list_size);
+    machine_build_resolver(machine);
+    symbols = cache_copy_symbols(machine, symbols, machine->output_list, machine->output_list_size);
+
+    const struct cache_state* states = (const struct cache_state*) (data + sizeof(struct cache_file_header) +
+        cache_align(header->symbols_size));
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        struct machine_state* state = &machine->state_list[i];
+
+        state->symbol = mem_strdup(mem, symbols);
+        symbols += strlen(symbols) + 1;
+
+        state->base = states[i].base;
+        state->is_final = (states[i].is_final != 0);
+        state->verdict = states[i].verdict;
+        state->default_trans.check = i;
+        state->default_trans.next_state = states[i].default_next_state;
+        state->default_trans.output = states[i].default_output;
+    }
+
+    memcpy(machine->trans_table, (const char*) states + machine->state_list_size * sizeof(struct cache_state),
+        machine->trans_table_size * sizeof(struct machine_trans));
+}
+
+static bool cache_write_symbols(FILE* fout, const char** symbol_list, int symbol_count) {
+    for (int i = 0; i < symbol_count; i++) {
+        if (fwrite(symbol_list[i], 1, strlen(symbol_list[i]) + 1, fout) != strlen(symbol_list[i]) + 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Write the entry to a temporary file of the cache directory and rename it to `path`
+ */
+static bool cache_store_entry(const struct machine_instance* machine, const char* path, uint64_t key,
+    uint32_t flags)
+{
+    size_t path_len = strlen(path);
+    char* temp_path = (char*) malloc(path_len + sizeof(".XXXXXX"));
+
+    memcpy(temp_path, path, path_len);
+    memcpy(temp_path + path_len, ".XXXXXX", sizeof(".XXXXXX"));
+
+    int fd = mkstemp(temp_path);
+
+    if (fd < 0) {
+        free(temp_path);
+        return false;
+    }
+
+    FILE* fout = fdopen(fd, "wb");
+
+    struct cache_file_header header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.flags = flags;
+    header.key = key;
+    header.input_list_size = machine->input_list_size;
+    header.state_list_size = machine->state_list_size;
+    header.output_list_size = machine->output_list_size;
+    header.trans_table_size = machine->trans_table_size;
+    header.entry_state = machine->entry_state;
+
+    for (int i = 0; i < machine->input_list_size; i++) {
+        header.symbols_size += (uint32_t) strlen(machine->input_list[i]) + 1;
+    }
+
+    for (int i = 0; i < machine->output_list_size; i++) {
+        header.symbols_size += (uint32_t) strlen(machine->output_list[i]) + 1;
+    }
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        header.symbols_size += (uint32_t) strlen(machine->state_list[i].symbol) + 1;
+    }
+
+    bool is_written = (fout != NULL) &&
+        (fwrite(&header, sizeof(header), 1, fout) == 1) &&
+        cache_write_symbols(fout, machine->input_list, machine->input_list_size) &&
+        cache_write_symbols(fout, machine->output_list, machine->output_list_size);
+
+    for (int i = 0; is_written && (i < machine->state_list_size); i++) {
+        is_written = (fwrite(machine->state_list[i].symbol, 1, strlen(machine->state_list[i].symbol) + 1, fout) ==
+            strlen(machine->state_list[i].symbol) + 1);
+    }
+
+    /* State records and the table are read in place, their int32 fields must be aligned */
+    static const char padding[CACHE_FILE_ALIGN] = { 0 };
+    const size_t padding_size = cache_align(header.symbols_size) - header.symbols_size;
+
+    is_written = is_written && (fwrite(padding, 1, padding_size, fout) == padding_size);
+
+    for (int i = 0; is_written && (i < machine->state_list_size); i++) {
+        const struct machine_state* state = &machine->state_list[i];
+        struct cache_state record = {
+            .base = state->base,
+            .default_next_state = state->default_trans.next_state,
+            .default_output = state->default_trans.output,
+            .is_final = state->is_final,
+            .verdict = state->verdict,
+        };
+
+        is_written = (fwrite(&record, sizeof(record), 1, fout) == 1);
+    }
+
+    is_written = is_written &&
+        (fwrite(machine->trans_table, sizeof(struct machine_trans), machine->trans_table_size, fout) ==
+            (size_t) machine->trans_table_size) &&
+        (fflush(fout) == 0) && (fsync(fd) == 0);
+
+    if (fout != NULL) {
+        is_written = (fclose(fout) == 0) && is_written;
+    }
+    else {
+        close(fd);
+    }
+
+    /* Readers see either no entry or the complete one */
+    if (!is_written || (rename(temp_path, path) != 0)) {
+        unlink(temp_path);
+        is_written = false;
+    }
+
+    free(temp_path);
+    return is_written;
+}
+
+enum cache_status cache_load_machine(struct machine_instance* machine, const char* script_path,
+    const char* cache_dir, uint32_t flags, bool* is_hit)
+{
+    if ((machine == NULL) || (script_path == NULL) || (cache_dir == NULL)) {
+        return CACHE_STATUS_NULL_PARAM;
+    }
+
+    size_t script_size = 0;
+    char* script = cache_read_file(script_path, &script_size);
+
+    if (script == NULL) {
+        return CACHE_STATUS_SYSTEM_ERROR;
+    }
+
+    const uint64_t key = cache_key(script, script_size, flags);
+
+    size_t path_size = strlen(cache_dir) + 32;
+    char* path = (char*) malloc(path_size);
+    snprintf(path, path_size, "%s/%016llx%s", cache_dir, (unsigned long long) key, CACHE_FILE_EXT);
+
+    enum cache_status status = CACHE_STATUS_SUCCESS;
+    size_t entry_size = 0;
+    char* entry = cache_read_file(path, &entry_size);
+
+    if ((entry != NULL) && cache_validate(entry, entry_size, key, flags)) {
+        cache_load_entry(machine, entry);
+
+        if (is_hit != NULL) {
+            *is_hit = true;
+        }
+
+        goto EXIT;
+    }
+
+    if (is_hit != NULL) {
+        *is_hit = false;
+    }
+
+    /* Compile the very contents the key was computed from */
+    FILE* fin = (script_size == 0) ? NULL : fmemopen(script, script_size, "r");
+    struct dsml_parser* parser = (fin == NULL) ? NULL : dsml_parse_stream(fin);
+
+    if (fin != NULL) {
+        fclose(fin);
+    }
+
+    if (parser == NULL) {
+        status = CACHE_STATUS_INVAL_SCRIPT;
+        goto EXIT;
+    }
+
+    enum machine_status machine_status = machine_init_move(machine, parser);
+
+    if (machine_status != MACHINE_STATUS_SUCCESS) {
+        status = CACHE_STATUS_INVAL_SCRIPT;
+        goto EXIT;
+    }
+
+    if ((flags & CACHE_FLAG_MINIMIZE) && (machine_minimize(machine) != MACHINE_STATUS_SUCCESS)) {
+        machine_free(machine);
+        status = CACHE_STATUS_INVAL_SCRIPT;
+        goto EXIT;
+    }
+
+    cache_store_entry(machine, path, key, flags);
+
+EXIT:
+
+    free(script);
+    free(entry);
+    free(path);
+    return status;
+}
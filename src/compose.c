@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "compose.h"
+#include "mem.h"
+
+/**
+ * @struct Open addressing map of (first state, second state) pairs to product states
+ */
+struct compose_pair_map {
+    int size;
+    uint64_t* keys;
+    int* values;
+};
+
+static void compose_pair_map_init(struct compose_pair_map* map, int size) {
+    map->size = size;
+    map->keys = (uint64_t*) malloc(size * sizeof(uint64_t));
+    map->values = (int*) malloc(size * sizeof(int));
+
+    for (int i = 0; i < size; i++) {
+        map->values[i] = -1;
+    }
+}
+
+static int* compose_pair_map_slot(struct compose_pair_map* map, uint64_t key) {
+    int slot = (int) ((key * 0x9E3779B97F4A7C15ull) >> 33) & (map->size - 1);
+
+    while ((map->values[slot] >= 0) && (map->keys[slot] != key)) {
+        slot = (slot + 1) & (map->size - 1);
+    }
+
+    map->keys[slot] = key;
+    return &map->values[slot];
+}
+
+static void compose_pair_map_grow(struct compose_pair_map* map) {
+    struct compose_pair_map new_map;
+    compose_pair_map_init(&new_map, 2 * map->size);
+
+    for (int i = 0; i < map->size; i++) {
+        if (map->values[i] >= 0) {
+            *compose_pair_map_slot(&new_map, map->keys[i]) = map->values[i];
+        }
+    }
+
+    free(map->keys);
+    free(map->values);
+    *map = new_map;
+}
+
+enum machine_status machine_compose(struct machine_instance* product,
+    const struct machine_instance* first, const struct machine_instance* second)
+{
+    if ((product == NULL) || (first == NULL) || (second == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    /* Map First Machine outputs to Second Machine inputs by symbol */
+    int* output_map = (int*) malloc((first->output_list_size + 1) * sizeof(int));
+
+    for (int i = 0; i < first->output_list_size; i++) {
+        output_map[i] = -1;
+
+        for (int j = 0; j < second->input_list_size; j++) {
+            if (strcmp(first->output_list[i], second->input_list[j]) == 0) {
+                output_map[i] = j;
+                break;
+            }
+        }
+
+        if (output_map[i] < 0) {
+            fprintf(stderr, "Output '%s' is not an input of the second machine\n", first->output_list[i]);
+            free(output_map);
+            return MACHINE_STATUS_ALPHABET_MISMATCH;
+        }
+    }
+
+    const int input_count = first->input_list_size;
+
+    /* Product states are discovered in BFS order from the pair of entry states */
+    int pair_cap = 16;
+    int pair_size = 0;
+    int* first_states = (int*) malloc(pair_cap * sizeof(int));
+    int* second_states = (int*) malloc(pair_cap * sizeof(int));
+    int* next_table = (int*) malloc((size_t) pair_cap * input_count * sizeof(int));
+    int* output_table = (int*) malloc((size_t) pair_cap * input_count * sizeof(int));
+
+    struct compose_pair_map pair_map;
+    compose_pair_map_init(&pair_map, 64);
+
+    first_states[0] = first->entry_state;
+    second_states[0] = second->entry_state;
+    *compose_pair_map_slot(&pair_map, ((uint64_t) first->entry_state << 32) | (uint32_t) second->entry_state) = 0;
+    pair_size = 1;
+
+    for (int i = 0; i < pair_size; i++) {
+        for (int j = 0; j < input_count; j++) {
+            struct machine_trans first_trans = machine_get_trans(first, first_states[i], j);
+            int next_second_state = second_states[i];
+            int output = MACHINE_EMPTY_OUTPUT;
+
+            if (first_trans.output != MACHINE_EMPTY_OUTPUT) {
+                struct machine_trans second_trans =
+                    machine_get_trans(second, second_states[i], output_map[first_trans.output]);
+
+                next_second_state = second_trans.next_state;
+                output = second_trans.output;
+            }
+
+            if (2 * pair_size >= pair_map.size) {
+                compose_pair_map_grow(&pair_map);
+            }
+
+            int* pair_state = compose_pair_map_slot(&pair_map,
+                ((uint64_t) first_trans.next_state << 32) | (uint32_t) next_second_state);
+
+            if (*pair_state < 0) {
+                if (pair_size == pair_cap) {
+                    pair_cap *= 2;
+                    first_states = (int*) realloc(first_states, pair_cap * sizeof(int));
+                    second_states = (int*) realloc(second_states, pair_cap * sizeof(int));
+                    next_table = (int*) realloc(next_table, (size_t) pair_cap * input_count * sizeof(int));
+                    output_table = (int*) realloc(output_table, (size_t) pair_cap * input_count * sizeof(int));
+                }
+
+                first_states[pair_size] = first_trans.next_state;
+                second_states[pair_size] = next_second_state;
+                *pair_state = pair_size++;
+            }
+
+            next_table[i * input_count + j] = *pair_state;
+            output_table[i * input_count + j] = output;
+        }
+    }
+
+    /* Product Machine alphabets */
+    product->input_list_size = first->input_list_size;
+    product->state_list_size = pair_size;
+    product->output_list_size = second->output_list_size;
+    product->entry_state = 0;
+
+    mem_stats_init(&product->mem);
+
+    product->input_list =
+        (const char**) mem_alloc(&product->mem, MEM_CATEGORY_LIST, product->input_list_size * sizeof(const char*));
+    for (int i = 0; i < product->input_list_size; i++) {
+        product->input_list[i] = mem_strdup(&product->mem, first->input_list[i]);
+    }
+
+    machine_build_resolver(product);
+
+    product->output_list =
+        (const char**) mem_alloc(&product->mem, MEM_CATEGORY_LIST, product->output_list_size * sizeof(const char*));
+    for (int i = 0; i < product->output_list_size; i++) {
+        product->output_list[i] = mem_strdup(&product->mem, second->output_list[i]);
+    }
+
+    product->state_list = (struct machine_state*)
+        mem_alloc(&product->mem, MEM_CATEGORY_ENTITY, pair_size * sizeof(struct machine_state));
+    for (int i = 0; i < pair_size; i++) {
+        char buffer[32] = { 0 };
+        snprintf(buffer, sizeof(buffer), "q%d", i);
+
+        product->state_list[i].symbol = mem_strdup(&product->mem, buffer);
+        product->state_list[i].is_final =
+            first->state_list[first_states[i]].is_final && second->state_list[second_states[i]].is_final;
+    }
+
+    product->trans_table = NULL;
+    product->symbol_pool = NULL;
+    product->symbol_pool_size = 0;
+    product->trans_table_size = 0;
+
+    enum machine_status status = machine_build_dense(product, next_table, output_table);
+
+    if (status == MACHINE_STATUS_SUCCESS) {
+        status = machine_minimize(product);
+    }
+
+    free(output_map);
+    free(first_states);
+    free(second_states);
+    free(next_table);
+    free(output_table);
+    free(pair_map.keys);
+    free(pair_map.values);
+
+    return status;
+}
@@ -4,4 +4,599 @@
 
 #include "dsm.h"
 #include "dsml.h"
-#include "machine.h"
\ No newline at end of file
+#include "machine.h"
+#include "compose.h"
+#include "nfa.h"
+#include "replay.h"
+#include "latency.h"
+
+#ifdef __linux__
+#include <signal.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "cache.h"
+#include "dsmi.h"
+#endif
+
+static void dsm_usage(void) {
+    fprintf(stderr,
+        "Usage:\n"
+        "\tdsm compose <first script> <second script>\n"
+        "\tdsm convert <log> <stream.dsmi>\n"
+        "\tdsm determinize <script> [state budget]\n"
+        "\tdsm record <script> <log> <interval>\n"
+        "\tdsm replay <script> <log> <first> <last>\n"
+        "\tdsm run <script> <stream.dsmi> [outputs | counts | runs]\n"
+        "\tdsm serve <script> [socket path]\n"
+        "\tdsm stats <script>\n"
+        "\n"
+        "Scripts are compiled through the cache directory DSM_CACHE_DIR if it is set\n"
+        "Record writes the checkpoint index <log>" REPLAY_FILE_EXT ", replay reads it\n"
+        "Convert pre-tokenizes the log for the runs of any machine with its inputs\n"
+        "Determinize accepts the script with several transitions of the (state, input) pair\n"
+        "Run prints every output, the number of steps with each output or the runs of equal outputs\n"
+        "Run and serve print the latency percentiles to stderr if built with LATENCY=ON\n");
+}
+
+enum dsm_status dsm_load_machine(struct machine_instance* machine, const char* filename) {
+    if ((machine == NULL) || (filename == NULL)) {
+        return DSM_STATUS_NULL_PARAM;
+    }
+
+#ifdef __linux__
+    const char* cache_dir = getenv("DSM_CACHE_DIR");
+
+    if (cache_dir != NULL) {
+        if (cache_load_machine(machine, filename, cache_dir, 0, NULL) != CACHE_STATUS_SUCCESS) {
+            fprintf(stderr, "DSM> ERROR: Failed to build machine from '%s'\n", filename);
+            return DSM_STATUS_INVAL_SCRIPT;
+        }
+
+        return DSM_STATUS_SUCCESS;
+    }
+#endif
+
+    struct dsml_parser* parser = dsml_parse_script(filename);
+
+    if (parser == NULL) {
+        return DSM_STATUS_INVAL_SCRIPT;
+    }
+
+    enum machine_status status = machine_init_move(machine, parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to build machine from '%s'\n", filename);
+        return DSM_STATUS_INVAL_SCRIPT;
+    }
+
+    return DSM_STATUS_SUCCESS;
+}
+
+static int dsm_compose(int argc, char** argv) {
+    if (argc != 2) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance first;
+    struct machine_instance second;
+    struct machine_instance product;
+
+    if (dsm_load_machine(&first, argv[0]) != DSM_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    if (dsm_load_machine(&second, argv[1]) != DSM_STATUS_SUCCESS) {
+        machine_free(&first);
+        return EXIT_FAILURE;
+    }
+
+    enum machine_status status = machine_compose(&product, &first, &second);
+
+    machine_free(&first);
+    machine_free(&second);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to compose machines\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "# Composition of %s and %s\n\n", argv[0], argv[1]);
+    machine_write_script(&product, stdout);
+    machine_free(&product);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Build deterministic machine from the nondeterministic script and print it
+ */
+static int dsm_determinize(int argc, char** argv) {
+    if ((argc != 1) && (argc != 2)) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    const int state_budget = (argc == 2) ? atoi(argv[1]) : NFA_DEFAULT_STATE_BUDGET;
+
+    if (state_budget <= 0) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct dsml_parser* parser = dsml_parse_nfa_script(argv[0]);
+
+    if (parser == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+    enum machine_status status = machine_determinize(&machine, parser, state_budget, NULL);
+
+    dsml_parser_free(parser);
+    free(parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to determinize '%s'\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "# Determinization of %s\n\n", argv[0]);
+    machine_write_script(&machine, stdout);
+    machine_free(&machine);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run the machine over the log printing the outputs and write its checkpoint index
+ */
+static int dsm_record(int argc, char** argv) {
+    if (argc != 3) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    const long long interval = atoll(argv[2]);
+
+    if (interval <= 0) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+
+    if (dsm_load_machine(&machine, argv[0]) != DSM_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    FILE* log = fopen(argv[1], "rb");
+    char* index_path = (char*) malloc(strlen(argv[1]) + strlen(REPLAY_FILE_EXT) + 1);
+    enum replay_status status = REPLAY_STATUS_SYSTEM_ERROR;
+
+    strcpy(index_path, argv[1]);
+    strcat(index_path, REPLAY_FILE_EXT);
+
+    if (log != NULL) {
+        status = replay_record(&machine, log, stdout, (uint64_t) interval, index_path);
+        fclose(log);
+    }
+
+    if (status != REPLAY_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to record '%s' (status %d)\n", argv[1], (int) status);
+    }
+
+    free(index_path);
+    machine_free(&machine);
+
+    return (status == REPLAY_STATUS_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Print the state before the symbol <first> of the log and the outputs of the symbols up to <last>
+ */
+static int dsm_replay(int argc, char** argv) {
+    if (argc != 4) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    const long long first = atoll(argv[2]);
+    const long long last = atoll(argv[3]);
+
+    if ((first < 0) || (last < first)) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+
+    if (dsm_load_machine(&machine, argv[0]) != DSM_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    FILE* log = fopen(argv[1], "rb");
+    char* index_path = (char*) malloc(strlen(argv[1]) + strlen(REPLAY_FILE_EXT) + 1);
+    int* outputs = (int*) malloc(((size_t) (last - first) + 1) * sizeof(int));
+    struct replay_index index;
+    enum replay_status status = REPLAY_STATUS_SYSTEM_ERROR;
+    int state = 0;
+
+    strcpy(index_path, argv[1]);
+    strcat(index_path, REPLAY_FILE_EXT);
+
+    if ((log != NULL) && ((status = replay_index_load(&index, index_path, &machine, log)) == REPLAY_STATUS_SUCCESS)) {
+        /* State before the first symbol, then the outputs */
+        status = replay_query(&machine, &index, log, (uint64_t) first, (uint64_t) first, NULL, &state);
+
+        if (status == REPLAY_STATUS_SUCCESS) {
+            fprintf(stdout, "state %s\n", machine.state_list[state].symbol);
+            status = replay_query(&machine, &index, log, (uint64_t) first, (uint64_t) last, outputs, &state);
+        }
+
+        for (long long i = 0; (status == REPLAY_STATUS_SUCCESS) && (i < last - first); i++) {
+            fprintf(stdout, "%s\n", (outputs[i] == MACHINE_EMPTY_OUTPUT) ? "-" : machine.output_list[outputs[i]]);
+        }
+
+        replay_index_free(&index);
+    }
+
+    if (status != REPLAY_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to replay '%s' (status %d)\n", argv[1], (int) status);
+    }
+
+    if (log != NULL) {
+        fclose(log);
+    }
+
+    free(outputs);
+    free(index_path);
+    machine_free(&machine);
+
+    return (status == REPLAY_STATUS_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Print memory used by the parser of the script and by the machine built from it
+ */
+static int dsm_stats(int argc, char** argv) {
+    if (argc != 1) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct dsml_parser* parser = dsml_parse_script(argv[0]);
+
+    if (parser == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+    struct mem_stats stats;
+
+    enum machine_status status = machine_init(&machine, parser);
+
+    fprintf(stdout, "Parser: %d states, %d inputs, %d outputs, %d transitions\n",
+        parser->state_list_size, parser->input_list_size, parser->output_list_size, parser->trans_list_size);
+    dsml_parser_stats(parser, &stats);
+    mem_stats_print(&stats, stdout);
+
+    dsml_parser_free(parser);
+    free(parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to build machine from '%s'\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "Machine: %d states, %d inputs, %d outputs, %d table slots\n",
+        machine.state_list_size, machine.input_list_size, machine.output_list_size, machine.trans_table_size);
+    machine_stats(&machine, &stats);
+    mem_stats_print(&stats, stdout);
+
+    machine_free(&machine);
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef __linux__
+/**
+ * Tokenize the log once into the binary stream
+ */
+static int dsm_convert(int argc, char** argv) {
+    if (argc != 2) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    FILE* log = fopen(argv[0], "rb");
+    enum dsmi_status status = DSMI_STATUS_SYSTEM_ERROR;
+
+    if (log != NULL) {
+        status = dsmi_convert(log, argv[1]);
+        fclose(log);
+    }
+
+    if (status != DSMI_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to convert '%s' (status %d)\n", argv[0], (int) status);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Print every output of the run
+ */
+static enum dsmi_status dsm_run_outputs(const struct dsmi_stream* stream, const struct machine_instance* machine) {
+    int outputs[DSMI_BLOCK_SIZE];
+    int state = machine->entry_state;
+    enum dsmi_status status = DSMI_STATUS_SUCCESS;
+
+    for (uint64_t first = 0; (status == DSMI_STATUS_SUCCESS) && (first < stream->input_count);
+        first += DSMI_BLOCK_SIZE)
+    {
+        const uint64_t count = (stream->input_count - first < DSMI_BLOCK_SIZE) ?
+            stream->input_count - first : DSMI_BLOCK_SIZE;
+
+        status = dsmi_run(stream, first, count, outputs, &state);
+
+        for (uint64_t i = 0; (status == DSMI_STATUS_SUCCESS) && (i < count); i++) {
+            fputs((outputs[i] == MACHINE_EMPTY_OUTPUT) ? "-" : machine->output_list[outputs[i]], stdout);
+            fputc('\n', stdout);
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Print the number of steps with every output
+ */
+static enum dsmi_status dsm_run_counts(const struct dsmi_stream* stream, const struct machine_instance* machine) {
+    int inputs[DSMI_BLOCK_SIZE];
+    int state = machine->entry_state;
+    enum dsmi_status status = DSMI_STATUS_SUCCESS;
+    uint64_t* counts = (uint64_t*) calloc((size_t) machine->output_list_size + 1, sizeof(uint64_t));
+
+    if (counts == NULL) {
+        return DSMI_STATUS_SYSTEM_ERROR;
+    }
+
+    for (uint64_t first = 0; (status == DSMI_STATUS_SUCCESS) && (first < stream->input_count);
+        first += DSMI_BLOCK_SIZE)
+    {
+        const size_t count = (stream->input_count - first < DSMI_BLOCK_SIZE) ?
+            (size_t) (stream->input_count - first) : DSMI_BLOCK_SIZE;
+
+        status = dsmi_decode(stream, first, count, inputs);
+
+        if (status == DSMI_STATUS_SUCCESS) {
+            machine_run_count(machine, inputs, count, counts, &state);
+        }
+    }
+
+    for (int i = 0; (status == DSMI_STATUS_SUCCESS) && (i < machine->output_list_size); i++) {
+        fprintf(stdout, "%s %llu\n", machine->output_list[i], (unsigned long long) counts[i]);
+    }
+
+    free(counts);
+    return status;
+}
+
+static void dsm_print_runs(const struct machine_instance* machine, const struct machine_output_run* runs,
+    size_t run_count)
+{
+    for (size_t i = 0; i < run_count; i++) {
+        fprintf(stdout, "%s %llu\n", machine->output_list[runs[i].output], (unsigned long long) runs[i].count);
+    }
+}
+
+/**
+ * Print the runs of equal outputs, empty outputs are skipped
+ */
+static enum dsmi_status dsm_run_runs(const struct dsmi_stream* stream, const struct machine_instance* machine) {
+    int inputs[DSMI_BLOCK_SIZE];
+    struct machine_output_run runs[DSM_RUN_BUFFER_SIZE];
+    size_t run_count = 0;
+    int state = machine->entry_state;
+    enum dsmi_status status = DSMI_STATUS_SUCCESS;
+
+    for (uint64_t first = 0; (status == DSMI_STATUS_SUCCESS) && (first < stream->input_count);
+        first += DSMI_BLOCK_SIZE)
+    {
+        const size_t count = (stream->input_count - first < DSMI_BLOCK_SIZE) ?
+            (size_t) (stream->input_count - first) : DSMI_BLOCK_SIZE;
+
+        status = dsmi_decode(stream, first, count, inputs);
+
+        for (size_t done = 0; (status == DSMI_STATUS_SUCCESS) && (done < count);) {
+            size_t input_done = 0;
+
+            machine_run_rle(machine, &inputs[done], count - done, runs, DSM_RUN_BUFFER_SIZE, &run_count,
+                &input_done, &state);
+            done += input_done;
+
+            /* Buffer is full, the last run may still go on */
+            if (done < count) {
+                dsm_print_runs(machine, runs, run_count - 1);
+                runs[0] = runs[run_count - 1];
+                run_count = 1;
+            }
+        }
+    }
+
+    if (status == DSMI_STATUS_SUCCESS) {
+        dsm_print_runs(machine, runs, run_count);
+    }
+
+    return status;
+}
+
+/**
+ * Run the machine over the binary stream printing the outputs, their counts or runs
+ */
+static int dsm_run(int argc, char** argv) {
+    if ((argc != 2) && (argc != 3)) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    const char* mode = (argc == 3) ? argv[2] : "outputs";
+
+    if ((strcmp(mode, "outputs") != 0) && (strcmp(mode, "counts") != 0) && (strcmp(mode, "runs") != 0)) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+
+    if (dsm_load_machine(&machine, argv[0]) != DSM_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    struct dsmi_stream stream;
+    enum dsmi_status status = dsmi_open(&stream, argv[1]);
+
+    if (status == DSMI_STATUS_SUCCESS) {
+        status = dsmi_bind(&stream, &machine);
+    }
+
+    if (status == DSMI_STATUS_SUCCESS) {
+        if (strcmp(mode, "counts") == 0) {
+            status = dsm_run_counts(&stream, &machine);
+        }
+        else if (strcmp(mode, "runs") == 0) {
+            status = dsm_run_runs(&stream, &machine);
+        }
+        else {
+            status = dsm_run_outputs(&stream, &machine);
+        }
+    }
+
+    if (status != DSMI_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to run '%s' (status %d)\n", argv[1], (int) status);
+    }
+
+#ifdef DSM_LATENCY
+    latency_print(&machine, argv[0], stderr);
+#endif
+
+    dsmi_close(&stream);
+    machine_free(&machine);
+
+    return (status == DSMI_STATUS_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static struct server dsm_server;
+
+static void dsm_stop_server(int signal_number) {
+    (void) signal_number;
+    server_stop(&dsm_server);
+}
+
+/**
+ * Serve sessions of the machine on the Unix socket or on stdin/stdout
+ */
+static int dsm_serve(int argc, char** argv) {
+    if ((argc != 1) && (argc != 2)) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct machine_instance machine;
+
+    if (dsm_load_machine(&machine, argv[0]) != DSM_STATUS_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    int exit_code = EXIT_FAILURE;
+
+    if (server_init(&dsm_server, &machine) != SERVER_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to start server\n");
+        machine_free(&machine);
+        return EXIT_FAILURE;
+    }
+
+    enum server_status status = (argc == 2) ?
+        server_listen(&dsm_server, argv[1]) :
+        server_add_connection(&dsm_server, STDIN_FILENO, STDOUT_FILENO);
+
+    if (status != SERVER_STATUS_SUCCESS) {
+        fprintf(stderr, "DSM> ERROR: Failed to open '%s'\n", (argc == 2) ? argv[1] : "stdin");
+        goto EXIT;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = dsm_stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+
+    if (server_run(&dsm_server) == SERVER_STATUS_SUCCESS) {
+        exit_code = EXIT_SUCCESS;
+    }
+
+EXIT:
+    if (dsm_server.listen_fd >= 0) {
+        unlink(argv[1]);
+    }
+
+#ifdef DSM_LATENCY
+    latency_print(&machine, argv[0], stderr);
+#endif
+
+    server_free(&dsm_server);
+    machine_free(&machine);
+
+    return exit_code;
+}
+#endif
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        dsm_usage();
+        return EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[1], "compose") == 0) {
+        return dsm_compose(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "determinize") == 0) {
+        return dsm_determinize(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "stats") == 0) {
+        return dsm_stats(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "record") == 0) {
+        return dsm_record(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "replay") == 0) {
+        return dsm_replay(argc - 2, argv + 2);
+    }
+
+#ifdef __linux__
+    if (strcmp(argv[1], "convert") == 0) {
+        return dsm_convert(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "run") == 0) {
+        return dsm_run(argc - 2, argv + 2);
+    }
+
+    if (strcmp(argv[1], "serve") == 0) {
+        return dsm_serve(argc - 2, argv + 2);
+    }
+#endif
+
+    dsm_usage();
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,508 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "machine.h"
+#include "token.h"
+#include "dsmi.h"
+
+/**
+ * @struct Symbols of the converted text, hashed by name
+ */
+struct dsmi_alphabet {
+    int symbol_count;
+    int symbol_cap;
+    char** symbol_list;
+    size_t* length_list;
+
+    int slot_count;
+    int* slot_list;
+};
+
+/**
+ * @struct Identifiers of the converted text
+ */
+struct dsmi_id_list {
+    uint64_t count;
+    uint64_t cap;
+    uint32_t* list;
+};
+
+static size_t dsmi_align(size_t size) {
+    return (size + DSMI_FILE_ALIGN - 1) & ~(DSMI_FILE_ALIGN - 1);
+}
+
+static void dsmi_alphabet_init(struct dsmi_alphabet* alphabet) {
+    alphabet->symbol_count = 0;
+    alphabet->symbol_cap = 16;
+    alphabet->symbol_list = (char**) malloc(alphabet->symbol_cap * sizeof(char*));
+    alphabet->length_list = (size_t*) malloc(alphabet->symbol_cap * sizeof(size_t));
+
+    alphabet->slot_count = 32;
+    alphabet->slot_list = (int*) malloc(alphabet->slot_count * sizeof(int));
+
+    for (int i = 0; i < alphabet->slot_count; i++) {
+        alphabet->slot_list[i] = -1;
+    }
+}
+
+static void dsmi_alphabet_free(struct dsmi_alphabet* alphabet) {
+    for (int i = 0; i < alphabet->symbol_count; i++) {
+        free(alphabet->symbol_list[i]);
+    }
+
+    free(alphabet->symbol_list);
+    free(alphabet->length_list);
+    free(alphabet->slot_list);
+}
+
+static int dsmi_alphabet_slot(const struct dsmi_alphabet* alphabet, const char* symbol, size_t length) {
+    int slot = (int) (machine_symbol_hash(symbol, length) & (uint64_t) (alphabet->slot_count - 1));
+
+    while (alphabet->slot_list[slot] >= 0) {
+        const int id = alphabet->slot_list[slot];
+
+        if ((alphabet->length_list[id] == length) && (memcmp(alphabet->symbol_list[id], symbol, length) == 0)) {
+            break;
+        }
+
+        slot = (slot + 1) & (alphabet->slot_count - 1);
+    }
+
+    return slot;
+}
+
+/**
+ * Get identifier of the symbol, new symbols are appended
+ */
+static uint32_t dsmi_alphabet_add(struct dsmi_alphabet* alphabet, const char* symbol, size_t length) {
+    int slot = dsmi_alphabet_slot(alphabet, symbol, length);
+
+    if (alphabet->slot_list[slot] >= 0) {
+        return (uint32_t) alphabet->slot_list[slot];
+    }
+
+    if (alphabet->symbol_count == alphabet->symbol_cap) {
+        alphabet->symbol_cap *= 2;
+        alphabet->symbol_list = (char**) realloc(alphabet->symbol_list, alphabet->symbol_cap * sizeof(char*));
+        alphabet->length_list = (size_t*) realloc(alphabet->length_list, alphabet->symbol_cap * sizeof(size_t));
+    }
+
+    const int id = alphabet->symbol_count++;
+
+    alphabet->symbol_list[id] = (char*) malloc(length + 1);
+    memcpy(alphabet->symbol_list[id], symbol, length);
+    alphabet->symbol_list[id][length] = '\0';
+    alphabet->length_list[id] = length;
+    alphabet->slot_list[slot] = id;
+
+    /* Keep the load under one half */
+    if (2 * alphabet->symbol_count > alphabet->slot_count) {
+        free(alphabet->slot_list);
+
+        alphabet->slot_count *= 2;
+        alphabet->slot_list = (int*) malloc(alphabet->slot_count * sizeof(int));
+
+        for (int i = 0; i < alphabet->slot_count; i++) {
+            alphabet->slot_list[i] = -1;
+        }
+
+        for (int i = 0; i < alphabet->symbol_count; i++) {
+            slot = dsmi_alphabet_slot(alphabet, alphabet->symbol_list[i], alphabet->length_list[i]);
+            alphabet->slot_list[slot] = i;
+        }
+    }
+
+    return (uint32_t) id;
+}
+
+static void dsmi_id_list_add(struct dsmi_id_list* id_list, uint32_t id) {
+    if (id_list->count == id_list->cap) {
+        id_list->cap = (id_list->cap == 0) ? DSMI_CHUNK_SIZE : 2 * id_list->cap;
+        id_list->list = (uint32_t*) realloc(id_list->list, id_list->cap * sizeof(uint32_t));
+    }
+
+    id_list->list[id_list->count++] = id;
+}
+
+/**
+ * Tokenize the whole text into the alphabet and identifiers
+ */
+static enum dsmi_status dsmi_tokenize(FILE* text, struct dsmi_alphabet* alphabet, struct dsmi_id_list* id_list) {
+    enum dsmi_status status = DSMI_STATUS_SUCCESS;
+    char* chunk = (char*) malloc(DSMI_CHUNK_SIZE);
+    struct tokenizer tokenizer;
+    const char* token = NULL;
+    size_t length = 0;
+
+    tokenizer_init(&tokenizer);
+
+    for (;;) {
+        size_t size = fread(chunk, 1, DSMI_CHUNK_SIZE, text);
+
+        if (size == 0) {
+            if (ferror(text)) {
+                status = DSMI_STATUS_SYSTEM_ERROR;
+            }
+            else if (tokenizer_finish(&tokenizer, &token, &length) == TOKEN_STATUS_READY) {
+                dsmi_id_list_add(id_list, dsmi_alphabet_add(alphabet, token, length));
+            }
+
+            break;
+        }
+
+        tokenizer_feed(&tokenizer, chunk, size);
+
+        enum token_status token_status;
+
+        while ((token_status = tokenizer_next(&tokenizer, &token, &length)) == TOKEN_STATUS_READY) {
+            dsmi_id_list_add(id_list, dsmi_alphabet_add(alphabet, token, length));
+        }
+
+        if (token_status == TOKEN_STATUS_TOO_LONG) {
+            status = DSMI_STATUS_INVAL_TEXT;
+            break;
+        }
+    }
+
+    free(chunk);
+    return status;
+}
+
+/**
+ * Write identifiers narrowed to `id_width` bytes, one block at a time
+ */
+static bool dsmi_write_ids(const struct dsmi_id_list* id_list, int id_width, FILE* fout) {
+    uint8_t block[DSMI_BLOCK_SIZE * sizeof(uint32_t)];
+
+    for (uint64_t first = 0; first < id_list->count; first += DSMI_BLOCK_SIZE) {
+        const uint32_t* ids = &id_list->list[first];
+        const size_t count = (id_list->count - first < DSMI_BLOCK_SIZE) ?
+            (size_t) (id_list->count - first) : DSMI_BLOCK_SIZE;
+
+        for (size_t i = 0; i < count; i++) {
+            if (id_width == 1) {
+                block[i] = (uint8_t) ids[i];
+            }
+            else if (id_width == 2) {
+                const uint16_t id = (uint16_t) ids[i];
+                memcpy(&block[2 * i], &id, sizeof(id));
+            }
+            else {
+                memcpy(&block[4 * i], &ids[i], sizeof(uint32_t));
+            }
+        }
+
+        if (fwrite(block, (size_t) id_width, count, fout) != count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+enum dsmi_status dsmi_convert(FILE* text, const char* path) {
+    if ((text == NULL) || (path == NULL)) {
+        return DSMI_STATUS_NULL_PARAM;
+    }
+
+    struct dsmi_alphabet alphabet;
+    struct dsmi_id_list id_list = { 0, 0, NULL };
+    FILE* fout = NULL;
+
+    dsmi_alphabet_init(&alphabet);
+
+    enum dsmi_status status = dsmi_tokenize(text, &alphabet, &id_list);
+
+    if (status != DSMI_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    struct dsmi_file_header header;
+    size_t symbols_size = 0;
+
+    for (int i = 0; i < alphabet.symbol_count; i++) {
+        symbols_size += alphabet.length_list[i] + 1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = DSMI_FILE_MAGIC;
+    header.version = DSMI_FILE_VERSION;
+    header.id_width = (alphabet.symbol_count <= 0x100) ? 1 : (alphabet.symbol_count <= 0x10000) ? 2 : 4;
+    header.input_count = id_list.count;
+    header.symbol_count = (uint32_t) alphabet.symbol_count;
+    header.alphabet_size = (uint32_t) dsmi_align(symbols_size);
+
+    static const char padding[DSMI_FILE_ALIGN] = { 0 };
+    bool is_written = false;
+
+    fout = fopen(path, "wb");
+
+    if (fout != NULL) {
+        is_written = (fwrite(&header, sizeof(header), 1, fout) == 1);
+
+        for (int i = 0; is_written && (i < alphabet.symbol_count); i++) {
+            is_written = (fwrite(alphabet.symbol_list[i], 1, alphabet.length_list[i] + 1, fout) ==
+                alphabet.length_list[i] + 1);
+        }
+
+        is_written = is_written &&
+            (fwrite(padding, 1, header.alphabet_size - symbols_size, fout) == header.alphabet_size - symbols_size) &&
+            dsmi_write_ids(&id_list, (int) header.id_width, fout);
+    }
+
+    if (!is_written) {
+        status = DSMI_STATUS_SYSTEM_ERROR;
+    }
+
+EXIT:
+
+    if ((fout != NULL) && (fclose(fout) != 0)) {
+        status = DSMI_STATUS_SYSTEM_ERROR;
+    }
+
+    if ((status != DSMI_STATUS_SUCCESS) && (fout != NULL)) {
+        remove(path);
+    }
+
+    dsmi_alphabet_free(&alphabet);
+    free(id_list.list);
+
+    return status;
+}
+
+/**
+ * Check the layout of the mapped file and find its symbols
+ */
+static enum dsmi_status dsmi_parse_map(struct dsmi_stream* stream) {
+    const struct dsmi_file_header* header = (const struct dsmi_file_header*) stream->map;
+
+    if ((stream->map_size < sizeof(struct dsmi_file_header)) || (header->magic != DSMI_FILE_MAGIC) ||
+        (header->version != DSMI_FILE_VERSION) || (header->symbol_count > (uint32_t) 0x7FFFFFFF) ||
+        ((header->id_width != 1) && (header->id_width != 2) && (header->id_width != 4)) ||
+        (header->alphabet_size % DSMI_FILE_ALIGN != 0) ||
+        (header->alphabet_size > stream->map_size - sizeof(struct dsmi_file_header)))
+    {
+        return DSMI_STATUS_INVAL_FILE;
+    }
+
+    const char* alphabet = (const char*) stream->map + sizeof(struct dsmi_file_header);
+    const size_t id_size = stream->map_size - sizeof(struct dsmi_file_header) - header->alphabet_size;
+
+    if ((id_size % header->id_width != 0) || (id_size / header->id_width != header->input_count)) {
+        return DSMI_STATUS_INVAL_FILE;
+    }
+
+    stream->symbol_list = (const char**) malloc((header->symbol_count + 1) * sizeof(const char*));
+    stream->symbol_count = (int) header->symbol_count;
+
+    size_t offset = 0;
+
+    for (int i = 0; i < stream->symbol_count; i++) {
+        const char* symbol_end = (offset < header->alphabet_size) ?
+            (const char*) memchr(alphabet + offset, '\0', header->alphabet_size - offset) : NULL;
+
+        if (symbol_end == NULL) {
+            return DSMI_STATUS_INVAL_FILE;
+        }
+
+        stream->symbol_list[i] = alphabet + offset;
+        offset = (size_t) (symbol_end - alphabet) + 1;
+    }
+
+    stream->id_width = (int) header->id_width;
+    stream->input_count = header->input_count;
+    stream->id_list = alphabet + header->alphabet_size;
+
+    return DSMI_STATUS_SUCCESS;
+}
+
+enum dsmi_status dsmi_open(struct dsmi_stream* stream, const char* path) {
+    if ((stream == NULL) || (path == NULL)) {
+        return DSMI_STATUS_NULL_PARAM;
+    }
+
+    stream->map = NULL;
+    stream->map_size = 0;
+    stream->id_width = 0;
+    stream->input_count = 0;
+    stream->id_list = NULL;
+    stream->symbol_count = 0;
+    stream->symbol_list = NULL;
+    stream->machine = NULL;
+    stream->input_map = NULL;
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return DSMI_STATUS_SYSTEM_ERROR;
+    }
+
+    enum dsmi_status status = DSMI_STATUS_INVAL_FILE;
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) < 0) {
+        status = DSMI_STATUS_SYSTEM_ERROR;
+        goto EXIT;
+    }
+
+    if ((size_t) file_stat.st_size < sizeof(struct dsmi_file_header)) {
+        goto EXIT;
+    }
+
+    stream->map = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (stream->map == MAP_FAILED) {
+        stream->map = NULL;
+        status = DSMI_STATUS_SYSTEM_ERROR;
+        goto EXIT;
+    }
+
+    stream->map_size = (size_t) file_stat.st_size;
+
+    /* Runs read the identifiers front to back */
+    posix_madvise(stream->map, stream->map_size, POSIX_MADV_SEQUENTIAL);
+
+    status = dsmi_parse_map(stream);
+
+EXIT:
+
+    close(fd);
+
+    if (status != DSMI_STATUS_SUCCESS) {
+        dsmi_close(stream);
+    }
+
+    return status;
+}
+
+void dsmi_close(struct dsmi_stream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    if (stream->map != NULL) {
+        munmap(stream->map, stream->map_size);
+    }
+
+    free(stream->symbol_list);
+    free(stream->input_map);
+
+    stream->map = NULL;
+    stream->map_size = 0;
+    stream->id_width = 0;
+    stream->input_count = 0;
+    stream->id_list = NULL;
+    stream->symbol_count = 0;
+    stream->symbol_list = NULL;
+    stream->machine = NULL;
+    stream->input_map = NULL;
+}
+
+enum dsmi_status dsmi_bind(struct dsmi_stream* stream, const struct machine_instance* machine) {
+    if ((stream == NULL) || (machine == NULL)) {
+        return DSMI_STATUS_NULL_PARAM;
+    }
+
+    int* input_map = (int*) malloc((stream->symbol_count + 1) * sizeof(int));
+    input_map[stream->symbol_count] = 0;
+
+    for (int i = 0; i < stream->symbol_count; i++) {
+        input_map[i] = machine_find_input(machine, stream->symbol_list[i], strlen(stream->symbol_list[i]));
+
+        if (input_map[i] < 0) {
+            free(input_map);
+            return DSMI_STATUS_UNKNOWN_SYMBOL;
+        }
+    }
+
+    free(stream->input_map);
+    stream->input_map = input_map;
+    stream->machine = machine;
+
+    return DSMI_STATUS_SUCCESS;
+}
+
+/**
+ * Translate identifiers of the map to machine inputs, false on identifier out of the alphabet
+ */
+static bool dsmi_decode_block(const struct dsmi_stream* stream, uint64_t first, size_t count, int* inputs) {
+    const uint32_t symbol_count = (uint32_t) stream->symbol_count;
+    const int* input_map = stream->input_map;
+    uint32_t max_id = 0;
+
+    if (stream->id_width == 1) {
+        const uint8_t* ids = (const uint8_t*) stream->id_list + first;
+
+        for (size_t i = 0; i < count; i++) {
+            max_id = (ids[i] > max_id) ? ids[i] : max_id;
+            inputs[i] = input_map[(ids[i] < symbol_count) ? ids[i] : 0];
+        }
+    }
+    else if (stream->id_width == 2) {
+        const uint16_t* ids = (const uint16_t*) stream->id_list + first;
+
+        for (size_t i = 0; i < count; i++) {
+            max_id = (ids[i] > max_id) ? ids[i] : max_id;
+            inputs[i] = input_map[(ids[i] < symbol_count) ? ids[i] : 0];
+        }
+    }
+    else {
+        const uint32_t* ids = (const uint32_t*) stream->id_list + first;
+
+        for (size_t i = 0; i < count; i++) {
+            max_id = (ids[i] > max_id) ? ids[i] : max_id;
+            inputs[i] = input_map[(ids[i] < symbol_count) ? ids[i] : 0];
+        }
+    }
+
+    return (count == 0) || (max_id < symbol_count);
+}
+
+enum dsmi_status dsmi_decode(const struct dsmi_stream* stream, uint64_t first, size_t count, int* inputs) {
+    if ((stream == NULL) || (stream->input_map == NULL) || ((inputs == NULL) && (count != 0))) {
+        return DSMI_STATUS_NULL_PARAM;
+    }
+
+    if ((first > stream->input_count) || (count > stream->input_count - first)) {
+        return DSMI_STATUS_OUT_OF_RANGE;
+    }
+
+    return dsmi_decode_block(stream, first, count, inputs) ? DSMI_STATUS_SUCCESS : DSMI_STATUS_INVAL_FILE;
+}
+
+enum dsmi_status dsmi_run(const struct dsmi_stream* stream, uint64_t first, uint64_t count, int* outputs,
+    int* state)
+{
+    if ((stream == NULL) || (stream->input_map == NULL) || (state == NULL)) {
+        return DSMI_STATUS_NULL_PARAM;
+    }
+
+    if ((first > stream->input_count) || (count > stream->input_count - first)) {
+        return DSMI_STATUS_OUT_OF_RANGE;
+    }
+
+    /* Block of inputs stays in L1 between decoding and the run */
+    int inputs[DSMI_BLOCK_SIZE];
+    int block_outputs[DSMI_BLOCK_SIZE];
+    int current_state = *state;
+
+    for (uint64_t done = 0; done < count; done += DSMI_BLOCK_SIZE) {
+        const size_t block_count = (count - done < DSMI_BLOCK_SIZE) ? (size_t) (count - done) : DSMI_BLOCK_SIZE;
+
+        if (!dsmi_decode_block(stream, first + done, block_count, inputs)) {
+            return DSMI_STATUS_INVAL_FILE;
+        }
+
+        machine_run(stream->machine, inputs, block_count, (outputs != NULL) ? &outputs[done] : block_outputs,
+            &current_state);
+    }
+
+    *state = current_state;
+    return DSMI_STATUS_SUCCESS;
+}
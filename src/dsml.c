@@ -6,8 +6,239 @@
 
 #include "dsml.h"
 #include "util.h"
+#include "mem.h"
 
-struct dsml_parser* dsml_parse_script(const char* filename) {
+static uint64_t dsml_hash(const char* symbol) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (const char* c_ptr = symbol; *c_ptr != '\0'; c_ptr++) {
+        hash = (hash ^ (unsigned char) *c_ptr) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static uint64_t dsml_pair_hash(int state_id, int input_id) {
+    uint64_t key = ((uint64_t) (uint32_t) state_id << 32) | (uint32_t) input_id;
+
+    key *= 0x9E3779B97F4A7C15ull;
+    return key ^ (key >> 29);
+}
+
+static void dsml_index_init(struct dsml_parser* parser, struct dsml_index* index) {
+    index->size = DSML_INDEX_INIT_SIZE;
+    index->count = 0;
+    index->hashes = (uint64_t*) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, index->size * sizeof(uint64_t));
+    index->positions = (int*) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, index->size * sizeof(int));
+    memset(index->positions, -1, index->size * sizeof(int));
+}
+
+static void dsml_index_free(struct dsml_parser* parser, struct dsml_index* index) {
+    mem_free(&parser->mem, MEM_CATEGORY_LIST, index->hashes, index->size * sizeof(uint64_t));
+    mem_free(&parser->mem, MEM_CATEGORY_LIST, index->positions, index->size * sizeof(int));
+
+    index->hashes = NULL;
+    index->positions = NULL;
+    index->size = 0;
+    index->count = 0;
+}
+
+static int dsml_index_slot(const struct dsml_index* index, uint64_t hash) {
+    return (int) (hash >> 32) & (index->size - 1);
+}
+
+static void dsml_index_insert(struct dsml_index* index, uint64_t hash, int position) {
+    int slot = dsml_index_slot(index, hash);
+
+    while (index->positions[slot] >= 0) {
+        slot = (slot + 1) & (index->size - 1);
+    }
+
+    index->hashes[slot] = hash;
+    index->positions[slot] = position;
+    index->count++;
+}
+
+/**
+ * Add list position to the index, the index is kept at most half full
+ */
+static void dsml_index_add(struct dsml_parser* parser, struct dsml_index* index, uint64_t hash, int position) {
+    if (2 * (index->count + 1) > index->size) {
+        struct dsml_index old_index = *index;
+
+        index->size = 2 * old_index.size;
+        index->count = 0;
+        index->hashes = (uint64_t*) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, index->size * sizeof(uint64_t));
+        index->positions = (int*) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, index->size * sizeof(int));
+        memset(index->positions, -1, index->size * sizeof(int));
+
+        for (int i = 0; i < old_index.size; i++) {
+            if (old_index.positions[i] >= 0) {
+                dsml_index_insert(index, old_index.hashes[i], old_index.positions[i]);
+            }
+        }
+
+        dsml_index_free(parser, &old_index);
+    }
+
+    dsml_index_insert(index, hash, position);
+}
+
+/**
+ * Split the symbol of `length` characters into the prefix and the decimal number suffix.
+ * The number is written without leading zeros.
+ */
+static bool dsml_split_numbered(const char* symbol, size_t length, size_t* prefix_len, long* number) {
+    size_t digit_count = 0;
+
+    while ((digit_count < length) && isdigit((unsigned char) symbol[length - 1 - digit_count])) {
+        digit_count++;
+    }
+
+    if ((digit_count == 0) || (digit_count > DSML_RANGE_MAX_DIGITS)) {
+        return false;
+    }
+
+    const char* digits = symbol + length - digit_count;
+
+    if ((digits[0] == '0') && (digit_count > 1)) {
+        return false;
+    }
+
+    long value = 0;
+
+    for (size_t i = 0; i < digit_count; i++) {
+        value = 10 * value + (digits[i] - '0');
+    }
+
+    *prefix_len = length - digit_count;
+    *number = value;
+    return true;
+}
+
+/**
+ * Parse range 'p<first>..p<last>' of the numbered symbols with the same prefix
+ */
+static enum dsml_status dsml_parse_range(const char* range, size_t* prefix_len, long* first, long* last) {
+    const char* delim = strstr(range, DSML_RANGE_DELIM);
+    const char* last_symbol = delim + strlen(DSML_RANGE_DELIM);
+    size_t last_prefix_len = 0;
+
+    if (!dsml_split_numbered(range, (size_t) (delim - range), prefix_len, first) ||
+        !dsml_split_numbered(last_symbol, strlen(last_symbol), &last_prefix_len, last) ||
+        (*prefix_len != last_prefix_len) || (memcmp(range, last_symbol, last_prefix_len) != 0) ||
+        (*first > *last))
+    {
+        return DSML_STATUS_INVAL_RANGE;
+    }
+
+    for (size_t i = 0; i < *prefix_len; i++) {
+        if (!isalnum((unsigned char) range[i])) {
+            return DSML_STATUS_INVAL_SYMBOL;
+        }
+    }
+
+    return DSML_STATUS_SUCCESS;
+}
+
+static bool dsml_rule_matches(const struct dsml_rule* rule, const char* symbol, size_t prefix_len, long number) {
+    return (strlen(rule->prefix) == prefix_len) && (memcmp(rule->prefix, symbol, prefix_len) == 0) &&
+        (number >= rule->first) && (number <= rule->last);
+}
+
+/**
+ * Precedence level of the rule, rules of higher levels override lower ones
+ */
+static int dsml_rule_level(const struct dsml_rule* rule) {
+    return 2 * (rule->selector == DSML_SELECTOR_RANGE) + (rule->input != NULL);
+}
+
+static void dsml_free_rule(struct dsml_parser* parser, struct dsml_rule* rule) {
+    mem_free_string(&parser->mem, rule->prefix);
+    mem_free(&parser->mem, MEM_CATEGORY_ENTITY, rule, sizeof(struct dsml_rule));
+}
+
+static struct dsml_trans* dsml_find_trans(struct dsml_parser* parser, const struct dsml_state* from_state,
+    const struct dsml_io* input)
+{
+    const struct dsml_index* index = &parser->trans_index;
+    uint64_t hash = dsml_pair_hash(from_state->id, input->id);
+
+    for (int slot = dsml_index_slot(index, hash); index->positions[slot] >= 0; slot = (slot + 1) & (index->size - 1)) {
+        struct dsml_trans* trans = parser->trans_list[index->positions[slot]];
+
+        if ((index->hashes[slot] == hash) && (trans != NULL) && (trans->from_state == from_state) &&
+            (trans->input == input))
+        {
+            return trans;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Only one default transition per state is allowed
+ */
+static enum dsml_status dsml_set_default(struct dsml_parser* parser, struct dsml_state* from_state,
+    struct dsml_state* to_state, struct dsml_io* output)
+{
+    if (from_state->default_trans != NULL) {
+        return DSML_STATUS_INDETERM_TRANS;
+    }
+
+    struct dsml_trans* new_trans =
+        (struct dsml_trans*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_trans));
+
+    new_trans->from_state = from_state;
+    new_trans->input = NULL;
+    new_trans->to_state = to_state;
+    new_trans->output = output;
+
+    from_state->default_trans = new_trans;
+    return DSML_STATUS_SUCCESS;
+}
+
+/**
+ * Group explicit transitions by the From State if they changed since the last grouping
+ */
+static void dsml_group_trans(struct dsml_parser* parser) {
+    if ((parser->state_trans_start != NULL) &&
+        (parser->grouped_state_count == parser->state_list_size) &&
+        (parser->grouped_trans_count == parser->trans_list_size))
+    {
+        return;
+    }
+
+    struct mem_stats* mem = &parser->mem;
+
+    mem_free(mem, MEM_CATEGORY_LIST, parser->state_trans_start, (parser->grouped_state_count + 1) * sizeof(int));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->state_trans_list, parser->grouped_trans_count * sizeof(int));
+
+    parser->grouped_state_count = parser->state_list_size;
+    parser->grouped_trans_count = parser->trans_list_size;
+    parser->state_trans_start = (int*) mem_calloc(mem, MEM_CATEGORY_LIST, parser->state_list_size + 1, sizeof(int));
+    parser->state_trans_list = (int*) mem_alloc(mem, MEM_CATEGORY_LIST, parser->trans_list_size * sizeof(int));
+
+    for (int i = 0; i < parser->state_list_size; i++) {
+        parser->state_trans_start[i + 1] = parser->state_trans_start[i] + parser->state_list[i]->trans_count;
+    }
+
+    int* fill = (int*) malloc(parser->state_list_size * sizeof(int));
+    memcpy(fill, parser->state_trans_start, parser->state_list_size * sizeof(int));
+
+    for (int i = 0; i < parser->trans_list_size; i++) {
+        if (parser->trans_list[i] != NULL) {
+            parser->state_trans_list[fill[parser->trans_list[i]->from_state->id]++] = i;
+        }
+    }
+
+    free(fill);
+}
+
+static struct dsml_parser* dsml_parse(FILE* fin, bool is_nfa);
+
+static struct dsml_parser* dsml_parse_file(const char* filename, bool is_nfa) {
     if (filename == NULL) {
         fprintf(stderr, "DSML> ERROR: Script filename is NULL\n");
         return NULL;
@@ -20,6 +251,34 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
         return NULL;
     }
 
+    struct dsml_parser* parser = dsml_parse(fin, is_nfa);
+
+    fclose(fin);
+    return parser;
+}
+
+struct dsml_parser* dsml_parse_script(const char* filename) {
+    return dsml_parse_file(filename, false);
+}
+
+struct dsml_parser* dsml_parse_stream(FILE* fin) {
+    return dsml_parse(fin, false);
+}
+
+struct dsml_parser* dsml_parse_nfa_script(const char* filename) {
+    return dsml_parse_file(filename, true);
+}
+
+struct dsml_parser* dsml_parse_nfa_stream(FILE* fin) {
+    return dsml_parse(fin, true);
+}
+
+static struct dsml_parser* dsml_parse(FILE* fin, bool is_nfa) {
+    if (fin == NULL) {
+        fprintf(stderr, "DSML> ERROR: Script stream is NULL\n");
+        return NULL;
+    }
+
     struct dsml_parser* parser = (struct dsml_parser*) malloc(sizeof(struct dsml_parser));
     enum dsml_status status = dsml_parser_init(parser);
 
@@ -28,6 +287,8 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
         return NULL;
     }
 
+    parser->is_nfa = is_nfa;
+
     char buffer[MAX_STRING_LEN + 1] = { 0 };
     unsigned int line_count = 0;
 
@@ -51,7 +312,8 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
         }
 
         char* next_string = strdup(buffer);
-        char* keyword = strtok(next_string, DSML_SYMBOL_DELIM);
+        char* save_ptr = NULL;
+        char* keyword = str_token(next_string, DSML_SYMBOL_DELIM, &save_ptr);
 
         if (strlen(buffer) == strlen(keyword)) {
             fprintf(stderr, "DSML> ERROR at line %d: Expected expression\n", line_count);
@@ -79,6 +341,10 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
             status = dsml_parse_trans(parser, lexeme);
             break;
 
+        case DSML_LEXEME_DEFAULT:
+            status = dsml_parse_default(parser, lexeme);
+            break;
+
         default:
             fprintf(stderr, "DSML> ERROR at line %d: Unknown keyword\n", line_count);
             free(next_string);
@@ -99,8 +365,7 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
         status = dsml_validate_dsm(parser);
 
         if (status == DSML_STATUS_SUCCESS) {
-            fprintf(stdout, "DSML> Script is parsed successfully\n");
-            fclose(fin);
+            fprintf(stderr, "DSML> Script is parsed successfully\n");
             return parser;
         }
         else {
@@ -116,7 +381,6 @@ struct dsml_parser* dsml_parse_script(const char* filename) {
 
 PARSER_ERROR:
 
-    fclose(fin);
     dsml_parser_free(parser);
     free(parser);
     return NULL;
@@ -139,12 +403,34 @@ enum dsml_status dsml_parser_init(struct dsml_parser* parser) {
     parser->trans_list_cap = INIT_CAP;
     parser->trans_list_size = 0;
 
-    parser->has_estate = false;
+    parser->rule_list_cap = INIT_CAP;
+    parser->rule_list_size = 0;
 
-    parser->state_list = (struct dsml_state**) malloc(INIT_CAP * sizeof(struct dsml_state*));
-    parser->input_list = (struct dsml_io**) malloc(INIT_CAP * sizeof(struct dsml_io*));
-    parser->output_list = (struct dsml_io**) malloc(INIT_CAP * sizeof(struct dsml_io*));
-    parser->trans_list = (struct dsml_trans**) malloc(INIT_CAP * sizeof(struct dsml_trans*));
+    parser->has_estate = false;
+    parser->is_nfa = false;
+
+    mem_stats_init(&parser->mem);
+
+    parser->state_list =
+        (struct dsml_state**) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, INIT_CAP * sizeof(struct dsml_state*));
+    parser->input_list =
+        (struct dsml_io**) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, INIT_CAP * sizeof(struct dsml_io*));
+    parser->output_list =
+        (struct dsml_io**) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, INIT_CAP * sizeof(struct dsml_io*));
+    parser->trans_list =
+        (struct dsml_trans**) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, INIT_CAP * sizeof(struct dsml_trans*));
+    parser->rule_list =
+        (struct dsml_rule**) mem_alloc(&parser->mem, MEM_CATEGORY_LIST, INIT_CAP * sizeof(struct dsml_rule*));
+
+    dsml_index_init(parser, &parser->state_index);
+    dsml_index_init(parser, &parser->input_index);
+    dsml_index_init(parser, &parser->output_index);
+    dsml_index_init(parser, &parser->trans_index);
+
+    parser->state_trans_start = NULL;
+    parser->state_trans_list = NULL;
+    parser->grouped_state_count = 0;
+    parser->grouped_trans_count = 0;
 
     return DSML_STATUS_SUCCESS;
 }
@@ -154,44 +440,81 @@ enum dsml_status dsml_parser_free(struct dsml_parser* parser) {
         return DSML_STATUS_NULL_PARAM;
     }
 
+    struct mem_stats* mem = &parser->mem;
+
     for (int i = 0; i < parser->state_list_size; i++) {
-        free((char*) parser->state_list[i]->symbol);
-        free(parser->state_list[i]);
+        mem_free_string(mem, parser->state_list[i]->symbol);
+        mem_free(mem, MEM_CATEGORY_ENTITY, parser->state_list[i]->default_trans, sizeof(struct dsml_trans));
+        mem_free(mem, MEM_CATEGORY_ENTITY, parser->state_list[i], sizeof(struct dsml_state));
     }
 
     for (int i = 0; i < parser->input_list_size; i++) {
-        free((char*) parser->input_list[i]->symbol);
-        free(parser->input_list[i]);
+        mem_free_string(mem, parser->input_list[i]->symbol);
+        mem_free(mem, MEM_CATEGORY_ENTITY, parser->input_list[i], sizeof(struct dsml_io));
     }
 
     for (int i = 0; i < parser->output_list_size; i++) {
-        free((char*) parser->output_list[i]->symbol);
-        free(parser->output_list[i]);
+        mem_free_string(mem, parser->output_list[i]->symbol);
+        mem_free(mem, MEM_CATEGORY_ENTITY, parser->output_list[i], sizeof(struct dsml_io));
     }
 
     for (int i = 0; i < parser->trans_list_size; i++) {
-        free(parser->trans_list[i]);
+        mem_free(mem, MEM_CATEGORY_ENTITY, parser->trans_list[i], sizeof(struct dsml_trans));
+    }
+
+    for (int i = 0; i < parser->rule_list_size; i++) {
+        dsml_free_rule(parser, parser->rule_list[i]);
     }
 
-    free(parser->state_list);
-    free(parser->input_list);
-    free(parser->output_list);
-    free(parser->trans_list);
+    mem_free(mem, MEM_CATEGORY_LIST, parser->state_list, parser->state_list_cap * sizeof(struct dsml_state*));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->input_list, parser->input_list_cap * sizeof(struct dsml_io*));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->output_list, parser->output_list_cap * sizeof(struct dsml_io*));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->trans_list, parser->trans_list_cap * sizeof(struct dsml_trans*));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->rule_list, parser->rule_list_cap * sizeof(struct dsml_rule*));
+
+    dsml_index_free(parser, &parser->state_index);
+    dsml_index_free(parser, &parser->input_index);
+    dsml_index_free(parser, &parser->output_index);
+    dsml_index_free(parser, &parser->trans_index);
+
+    mem_free(mem, MEM_CATEGORY_LIST, parser->state_trans_start, (parser->grouped_state_count + 1) * sizeof(int));
+    mem_free(mem, MEM_CATEGORY_LIST, parser->state_trans_list, parser->grouped_trans_count * sizeof(int));
 
     parser->state_list = NULL;
     parser->input_list = NULL;
     parser->output_list = NULL;
     parser->trans_list = NULL;
+    parser->rule_list = NULL;
+    parser->state_trans_start = NULL;
+    parser->state_trans_list = NULL;
 
     parser->state_list_size = 0;
     parser->input_list_size = 0;
     parser->output_list_size = 0;
     parser->trans_list_size = 0;
+    parser->rule_list_size = 0;
 
     parser->state_list_cap = 0;
     parser->input_list_cap = 0;
     parser->output_list_cap = 0;
     parser->trans_list_cap = 0;
+    parser->rule_list_cap = 0;
+
+    return DSML_STATUS_SUCCESS;
+}
+
+enum dsml_status dsml_parser_stats(const struct dsml_parser* parser, struct mem_stats* stats) {
+    if ((parser == NULL) || (stats == NULL)) {
+        return DSML_STATUS_NULL_PARAM;
+    }
+
+    *stats = parser->mem;
+    stats->slack_bytes =
+        (parser->state_list_cap - parser->state_list_size) * sizeof(struct dsml_state*) +
+        (parser->input_list_cap - parser->input_list_size) * sizeof(struct dsml_io*) +
+        (parser->output_list_cap - parser->output_list_size) * sizeof(struct dsml_io*) +
+        (parser->trans_list_cap - parser->trans_list_size) * sizeof(struct dsml_trans*) +
+        (parser->rule_list_cap - parser->rule_list_size) * sizeof(struct dsml_rule*);
 
     return DSML_STATUS_SUCCESS;
 }
@@ -213,6 +536,9 @@ enum dsml_lexeme_type dsml_parse_lexeme_keyword(const char* str) {
     else if (strcmp(str, DSML_KEYWORDS[DSML_TRANS_KEYWORD_INDEX]) == 0) {
         return DSML_LEXEME_TRANS;
     }
+    else if (strcmp(str, DSML_KEYWORDS[DSML_DEFAULT_KEYWORD_INDEX]) == 0) {
+        return DSML_LEXEME_DEFAULT;
+    }
     else {
         return DSML_LEXEME_UNDEF;
     }
@@ -233,7 +559,8 @@ enum dsml_status dsml_parse_state(struct dsml_parser* parser, const char* str) {
     bool is_final = false;
     bool is_entry = false;
 
-    char* next_symbol = strtok(str_mutable, DSML_SYMBOL_DELIM);
+    char* save_ptr = NULL;
+    char* next_symbol = str_token(str_mutable, DSML_SYMBOL_DELIM, &save_ptr);
 
     if (next_symbol == NULL) {
         status = DSML_STATUS_EMPTY_SYMBOL;
@@ -245,7 +572,7 @@ enum dsml_status dsml_parse_state(struct dsml_parser* parser, const char* str) {
         if (strcmp(next_symbol, DSML_KEYWORDS[DSML_FINAL_KEYWORD_INDEX]) == 0) {
             if (!is_final) {
                 is_final = true;
-                next_symbol = strtok(NULL, DSML_SYMBOL_DELIM);
+                next_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
             }
             else {
                 status = DSML_STATUS_REDEF_KEYWORD;
@@ -261,7 +588,7 @@ enum dsml_status dsml_parse_state(struct dsml_parser* parser, const char* str) {
                 else {
                     is_entry = true;
                     parser->has_estate = true;
-                    next_symbol = strtok(NULL, DSML_SYMBOL_DELIM);
+                    next_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
                 }
             }
             else {
@@ -289,6 +616,45 @@ enum dsml_status dsml_parse_state(struct dsml_parser* parser, const char* str) {
             goto EXIT;
         }
 
+        /* Range of the numbered states 's0..s99' */
+        if (strstr(next_symbol, DSML_RANGE_DELIM) != NULL) {
+            size_t prefix_len = 0;
+            long first = 0;
+            long last = 0;
+
+            status = dsml_parse_range(next_symbol, &prefix_len, &first, &last);
+
+            if (status != DSML_STATUS_SUCCESS) {
+                goto EXIT;
+            }
+
+            if (is_entry && (first != last)) {
+                status = DSML_STATUS_MULT_ENTRY;
+                goto EXIT;
+            }
+
+            char symbol[MAX_STRING_LEN + 1] = { 0 };
+
+            for (long number = first; number <= last; number++) {
+                snprintf(symbol, sizeof(symbol), "%.*s%ld", (int) prefix_len, next_symbol, number);
+
+                if (!dsml_validate_symbol(symbol)) {
+                    status = DSML_STATUS_INVAL_SYMBOL;
+                    goto EXIT;
+                }
+
+                if (dsml_symbol_exists(parser, symbol, DSML_LEXEME_STATE)) {
+                    status = DSML_STATUS_REDEF_SYMBOL;
+                    goto EXIT;
+                }
+
+                dsml_add_state(parser, symbol, is_final, is_entry);
+            }
+
+            next_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
+            continue;
+        }
+
         if (!dsml_validate_symbol(next_symbol)) {
             status = DSML_STATUS_INVAL_SYMBOL;
             goto EXIT;
@@ -300,7 +666,7 @@ enum dsml_status dsml_parse_state(struct dsml_parser* parser, const char* str) {
         }
 
         dsml_add_state(parser, next_symbol, is_final, is_entry);
-        next_symbol = strtok(NULL, DSML_SYMBOL_DELIM);
+        next_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
     }
 
     if (symbol_count == 0) {
@@ -328,7 +694,8 @@ enum dsml_status dsml_parse_io(struct dsml_parser* parser, const char* str, bool
     int symbol_count = 0;
     enum  dsml_lexeme_type lexeme_type = is_input ? DSML_LEXEME_INPUT : DSML_LEXEME_OUTPUT;
 
-    char* next_symbol = strtok(str_mutable, DSML_SYMBOL_DELIM);
+    char* save_ptr = NULL;
+    char* next_symbol = str_token(str_mutable, DSML_SYMBOL_DELIM, &save_ptr);
 
     if (next_symbol == NULL) {
         status = DSML_STATUS_EMPTY_SYMBOL;
@@ -356,7 +723,7 @@ enum dsml_status dsml_parse_io(struct dsml_parser* parser, const char* str, bool
             dsml_add_output(parser, next_symbol);
         }
 
-        next_symbol = strtok(NULL, DSML_SYMBOL_DELIM);
+        next_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
     }
 
     if (symbol_count == 0) {
@@ -379,24 +746,54 @@ enum dsml_status dsml_parse_trans(struct dsml_parser* parser, const char* str) {
     }
 
     char* str_mutable = strdup(str);
-    char* str_mutable_tail_ptr = str_mutable + strlen(str_mutable) + 1;
+    struct dsml_io** inputs = NULL;
 
     enum dsml_status status = 0;
     char buffer[MAX_STRING_LEN + 1] = { 0 };
     const size_t buffer_size = MAX_STRING_LEN + 1;
 
-    char* next_symbol = strtok(str_mutable, DSML_TRANS_DELIM);
+    /* Exactly four ':' separated operands */
+    char* operand_list[TRANS_OPERANDS_NUM];
+    int operand_count = 0;
+    char* next_operand = str_mutable;
 
-    /* From State symbol */
+    while ((next_operand != NULL) && (operand_count < TRANS_OPERANDS_NUM)) {
+        operand_list[operand_count++] = next_operand;
+        next_operand = strpbrk(next_operand, DSML_TRANS_DELIM);
+
+        if (next_operand != NULL) {
+            *next_operand++ = '\0';
+        }
+    }
+
+    if ((operand_count != TRANS_OPERANDS_NUM) || (next_operand != NULL)) {
+        status = DSML_STATUS_INVAL_PARAM_NUM;
+        goto EXIT;
+    }
+
+    /* From State: symbol, range or any state */
     struct dsml_state* from_state = NULL;
+    struct dsml_rule selector_rule = { .selector = DSML_SELECTOR_ANY, .prefix = NULL };
+    char range_prefix[MAX_STRING_LEN + 1] = { 0 };
+    size_t prefix_len = 0;
 
-    if (next_symbol != NULL) {
-        status = dsml_trim_symbol(next_symbol, buffer, buffer_size);
+    status = dsml_trim_symbol(operand_list[TRANS_FROM_STATE], buffer, buffer_size);
+
+    if (status != DSML_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    if (strstr(buffer, DSML_RANGE_DELIM) != NULL) {
+        status = dsml_parse_range(buffer, &prefix_len, &selector_rule.first, &selector_rule.last);
 
         if (status != DSML_STATUS_SUCCESS) {
             goto EXIT;
         }
 
+        memcpy(range_prefix, buffer, prefix_len);
+        selector_rule.selector = DSML_SELECTOR_RANGE;
+    }
+    else if (strcmp(buffer, DSML_ANY_SYMBOL) != 0) {
         from_state = dsml_get_entity(parser, buffer, DSML_LEXEME_STATE);
 
         if (from_state == NULL) {
@@ -404,139 +801,243 @@ enum dsml_status dsml_parse_trans(struct dsml_parser* parser, const char* str) {
             goto EXIT;
         }
     }
-    else {
-        status = DSML_STATUS_INVAL_PARAM_NUM;
-        goto EXIT;
-    }
 
-    next_symbol = strtok(NULL, DSML_TRANS_DELIM);
-
-    /* Input symbols */
-    struct dsml_io** inputs = (struct dsml_io**) malloc(parser->input_list_size * sizeof(struct dsml_io*));
+    /* Input symbols or any input */
+    inputs = (struct dsml_io**) malloc((parser->input_list_size + 1) * sizeof(struct dsml_io*));
     int input_count = 0;
-    char* backup_ptr = NULL;
-    
-    if (next_symbol != NULL) {
-        backup_ptr = next_symbol + strlen(next_symbol) + 1;
-        if (backup_ptr == str_mutable_tail_ptr) {
-            status = DSML_STATUS_INVAL_PARAM_NUM;
-            goto EXIT;
-        }
+    bool is_any_input = false;
+
+    char* save_ptr = NULL;
+    char* input_symbol = str_token(operand_list[TRANS_INPUT], DSML_SYMBOL_DELIM, &save_ptr);
 
-        char* input_symbol_list = strdup(next_symbol);
-        char* input_symbol = strtok(input_symbol_list, DSML_SYMBOL_DELIM);
-        struct dsml_io* input = NULL;
+    while (input_symbol != NULL) {
+        if (strcmp(input_symbol, DSML_ANY_SYMBOL) == 0) {
+            is_any_input = true;
+        }
+        else {
+            struct dsml_io* input = dsml_get_entity(parser, input_symbol, DSML_LEXEME_INPUT);
 
-        while (input_symbol != NULL) {
-            if ((input = dsml_get_entity(parser, input_symbol, DSML_LEXEME_INPUT)) == NULL) {
+            if (input == NULL) {
                 status = DSML_STATUS_UNDEF_SYMBOL;
-                free(input_symbol_list);
                 goto EXIT;
             }
-            else {
-                /* Check if input symbol was already used */
-                for (size_t i = 0; i < input_count; i++) {
-                    if (strcmp(input_symbol, inputs[i]->symbol) == 0) {
-                        status = DSML_STATUS_REDEF_SYMBOL;
-                        free(input_symbol_list);
-                        goto EXIT;
-                    }
-                }
 
-                /* Check if transition with this From State and Input was already defined */
-                if (dsml_get_trans(parser, from_state->symbol, input_symbol) != NULL) {
-                    status = DSML_STATUS_INDETERM_TRANS;
-                    free(input_symbol_list);
+            /* Check if input symbol was already used */
+            for (int i = 0; i < input_count; i++) {
+                if (inputs[i] == input) {
+                    status = DSML_STATUS_REDEF_SYMBOL;
                     goto EXIT;
                 }
-
-                inputs[input_count++] = input;
-                input_symbol = strtok(NULL, DSML_SYMBOL_DELIM);
             }
+
+            inputs[input_count++] = input;
         }
 
-        free(input_symbol_list);
+        input_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
+    }
+
+    if ((input_count == 0) && !is_any_input) {
+        status = DSML_STATUS_EMPTY_SYMBOL;
+        goto EXIT;
+    }
+
+    /* '*' stands alone */
+    if (is_any_input && (input_count != 0)) {
+        status = DSML_STATUS_INVAL_SYMBOL_NUM;
+        goto EXIT;
+    }
+
+    /* To State */
+    status = dsml_trim_symbol(operand_list[TRANS_TO_STATE], buffer, buffer_size);
+
+    if (status != DSML_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    struct dsml_state* to_state = dsml_get_entity(parser, buffer, DSML_LEXEME_STATE);
+
+    if (to_state == NULL) {
+        status = DSML_STATUS_UNDEF_SYMBOL;
+        goto EXIT;
+    }
+
+    /* Output */
+    status = dsml_trim_symbol(operand_list[TRANS_OUTPUT], buffer, buffer_size);
+
+    if (status != DSML_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    struct dsml_io* output = NULL;
+
+    /* Check if Output is not an Empty Output */
+    if (strcmp(buffer, DSML_EMPTY_OUTPUT_SYMBOL) != 0) {
+        output = dsml_get_entity(parser, buffer, DSML_LEXEME_OUTPUT);
 
-        if (input_count == 0) {
-            status = DSML_STATUS_EMPTY_SYMBOL;
+        if (output == NULL) {
+            status = DSML_STATUS_UNDEF_SYMBOL;
             goto EXIT;
         }
     }
-    else {
-        status = DSML_STATUS_INVAL_PARAM_NUM;
+
+    /* State on any input is the default transition of the state */
+    if ((from_state != NULL) && is_any_input) {
+        status = dsml_set_default(parser, from_state, to_state, output);
         goto EXIT;
     }
 
-    next_symbol = strtok(backup_ptr, DSML_TRANS_DELIM);
+    /* Create new Transition(s) */
+    if (from_state != NULL) {
+        for (int i = 0; i < input_count; i++) {
+            /* Check if transition with this From State and Input was already defined */
+            if (!parser->is_nfa && (dsml_find_trans(parser, from_state, inputs[i]) != NULL)) {
+                status = DSML_STATUS_INDETERM_TRANS;
+                goto EXIT;
+            }
 
-    /* To State */
-    struct dsml_state* to_state = NULL;
+            struct dsml_trans* new_trans =
+                (struct dsml_trans*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_trans));
 
-    if (next_symbol != NULL) {
-        status = dsml_trim_symbol(next_symbol, buffer, buffer_size);
+            new_trans->from_state = from_state;
+            new_trans->input = inputs[i];
+            new_trans->to_state = to_state;
+            new_trans->output = output;
 
-        if (status != DSML_STATUS_SUCCESS) {
-            goto EXIT;
+            status = dsml_add_trans(parser, new_trans);
+            if (status != DSML_STATUS_SUCCESS) {
+                goto EXIT;
+            }
         }
 
-        to_state = dsml_get_entity(parser, buffer, DSML_LEXEME_STATE);
+        goto EXIT;
+    }
+
+    /* Create new Rule(s), one per input */
+    if (is_any_input) {
+        inputs[input_count++] = NULL;
+    }
 
-        if (to_state == NULL) {
-            status = DSML_STATUS_UNDEF_SYMBOL;
+    for (int i = 0; i < input_count; i++) {
+        struct dsml_rule* new_rule =
+            (struct dsml_rule*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_rule));
+
+        *new_rule = selector_rule;
+        new_rule->input = inputs[i];
+        new_rule->trans.from_state = NULL;
+        new_rule->trans.input = NULL;
+        new_rule->trans.to_state = to_state;
+        new_rule->trans.output = output;
+
+        if (new_rule->selector == DSML_SELECTOR_RANGE) {
+            char* prefix = (char*) mem_alloc(&parser->mem, MEM_CATEGORY_SYMBOL, prefix_len + 1);
+
+            memcpy(prefix, range_prefix, prefix_len);
+            prefix[prefix_len] = '\0';
+            new_rule->prefix = prefix;
+        }
+
+        status = dsml_add_rule(parser, new_rule);
+
+        if (status != DSML_STATUS_SUCCESS) {
+            dsml_free_rule(parser, new_rule);
             goto EXIT;
         }
     }
-    else {
+
+EXIT:
+
+    free(str_mutable);
+    free(inputs);
+    return status;
+}
+
+enum dsml_status dsml_parse_default(struct dsml_parser* parser, const char* str) {
+    if ((parser == NULL) || (str == NULL)) {
+        return DSML_STATUS_NULL_PARAM;
+    }
+
+    if (strlen(str) == 0) {
+        return DSML_STATUS_INVAL_PARAM;
+    }
+
+    char* str_mutable = strdup(str);
+
+    enum dsml_status status = 0;
+    char buffer[MAX_STRING_LEN + 1] = { 0 };
+    const size_t buffer_size = MAX_STRING_LEN + 1;
+
+    char* save_ptr = NULL;
+    char* state_symbol_list = str_token(str_mutable, DSML_TRANS_DELIM, &save_ptr);
+    char* to_state_symbol = str_token(NULL, DSML_TRANS_DELIM, &save_ptr);
+    char* output_symbol = str_token(NULL, DSML_TRANS_DELIM, &save_ptr);
+
+    if ((output_symbol == NULL) || (str_token(NULL, DSML_TRANS_DELIM, &save_ptr) != NULL)) {
         status = DSML_STATUS_INVAL_PARAM_NUM;
         goto EXIT;
     }
 
-    next_symbol = strtok(NULL, DSML_TRANS_DELIM);
+    /* To State */
+    status = dsml_trim_symbol(to_state_symbol, buffer, buffer_size);
+
+    if (status != DSML_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    struct dsml_state* to_state = dsml_get_entity(parser, buffer, DSML_LEXEME_STATE);
+
+    if (to_state == NULL) {
+        status = DSML_STATUS_UNDEF_SYMBOL;
+        goto EXIT;
+    }
 
     /* Output */
+    status = dsml_trim_symbol(output_symbol, buffer, buffer_size);
+
+    if (status != DSML_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
     struct dsml_io* output = NULL;
 
-    if (next_symbol != NULL) {
-        status = dsml_trim_symbol(next_symbol, buffer, buffer_size);
+    if (strcmp(buffer, DSML_EMPTY_OUTPUT_SYMBOL) != 0) {
+        output = dsml_get_entity(parser, buffer, DSML_LEXEME_OUTPUT);
 
-        if (status != DSML_STATUS_SUCCESS) {
+        if (output == NULL) {
+            status = DSML_STATUS_UNDEF_SYMBOL;
             goto EXIT;
         }
+    }
 
-        /* Check if Output is not an Empty Output */
-        if (strcmp(buffer, DSML_EMPTY_OUTPUT_SYMBOL) != 0) {
-            output = dsml_get_entity(parser, buffer, DSML_LEXEME_OUTPUT);
+    /* From State symbols */
+    char* from_state_symbol = str_token(state_symbol_list, DSML_SYMBOL_DELIM, &save_ptr);
+    int state_count = 0;
 
-            if (output == NULL) {
-                status = DSML_STATUS_UNDEF_SYMBOL;
-                goto EXIT;
-            }
+    while (from_state_symbol != NULL) {
+        struct dsml_state* from_state = dsml_get_entity(parser, from_state_symbol, DSML_LEXEME_STATE);
+
+        if (from_state == NULL) {
+            status = DSML_STATUS_UNDEF_SYMBOL;
+            goto EXIT;
         }
-    }
-    else {
-        status = DSML_STATUS_INVAL_PARAM_NUM;
-        goto EXIT;
-    }
-    
-    /* Create new Transition(s) */
-    for (int i = 0; i < input_count; i++) {
-        struct dsml_trans* new_trans = (struct dsml_trans*) malloc(sizeof(struct dsml_trans));
 
-        new_trans->from_state = from_state;
-        new_trans->input = inputs[i];
-        new_trans->to_state = to_state;
-        new_trans->output = output;
+        status = dsml_set_default(parser, from_state, to_state, output);
 
-        status = dsml_add_trans(parser, new_trans);
         if (status != DSML_STATUS_SUCCESS) {
-            break;
+            goto EXIT;
         }
+
+        state_count++;
+
+        from_state_symbol = str_token(NULL, DSML_SYMBOL_DELIM, &save_ptr);
+    }
+
+    if (state_count == 0) {
+        status = DSML_STATUS_EMPTY_SYMBOL;
     }
 
 EXIT:
 
     free(str_mutable);
-    free(inputs);
     return status;
 }
 
@@ -547,15 +1048,20 @@ enum dsml_status dsml_add_state(struct dsml_parser* parser, const char* symbol,
 
     if (parser->state_list_size == parser->state_list_cap) {
         parser->state_list_cap += CAP_INCR;
-        parser->state_list = 
-            (struct dsml_state**) realloc(parser->state_list, parser->state_list_cap * sizeof(struct dsml_state*));
+        parser->state_list = (struct dsml_state**) mem_realloc(&parser->mem, MEM_CATEGORY_LIST, parser->state_list,
+            (parser->state_list_cap - CAP_INCR) * sizeof(struct dsml_state*), parser->state_list_cap * sizeof(struct dsml_state*));
     }
 
-    struct dsml_state* new_state = (struct dsml_state*) malloc(sizeof(struct dsml_state));
-    new_state->symbol = strdup(symbol);
+    struct dsml_state* new_state =
+        (struct dsml_state*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_state));
+    new_state->symbol = mem_strdup(&parser->mem, symbol);
+    new_state->id = parser->state_list_size;
     new_state->is_final = is_final;
     new_state->is_entry = is_entry;
+    new_state->trans_count = 0;
+    new_state->default_trans = NULL;
     parser->state_list[parser->state_list_size] = new_state;
+    dsml_index_add(parser, &parser->state_index, dsml_hash(symbol), parser->state_list_size);
     parser->state_list_size++;
     return DSML_STATUS_SUCCESS;
 }
@@ -567,12 +1073,15 @@ enum dsml_status dsml_add_input(struct dsml_parser* parser, const char* symbol)
 
     if (parser->input_list_size == parser->input_list_cap) {
         parser->input_list_cap += CAP_INCR;
-        parser->input_list = 
-            (struct dsml_io**) realloc(parser->input_list, parser->input_list_cap * sizeof(struct dsml_io*));
+        parser->input_list = (struct dsml_io**) mem_realloc(&parser->mem, MEM_CATEGORY_LIST, parser->input_list,
+            (parser->input_list_cap - CAP_INCR) * sizeof(struct dsml_io*), parser->input_list_cap * sizeof(struct dsml_io*));
     }
 
-    parser->input_list[parser->input_list_size] = (struct dsml_io*) malloc(sizeof(struct dsml_io));
-    parser->input_list[parser->input_list_size]->symbol = strdup(symbol);
+    parser->input_list[parser->input_list_size] =
+        (struct dsml_io*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_io));
+    parser->input_list[parser->input_list_size]->symbol = mem_strdup(&parser->mem, symbol);
+    parser->input_list[parser->input_list_size]->id = parser->input_list_size;
+    dsml_index_add(parser, &parser->input_index, dsml_hash(symbol), parser->input_list_size);
     parser->input_list_size++;
     return DSML_STATUS_SUCCESS;
 }
@@ -584,12 +1093,15 @@ enum dsml_status dsml_add_output(struct dsml_parser* parser, const char* symbol)
 
     if (parser->output_list_size == parser->output_list_cap) {
         parser->output_list_cap += CAP_INCR;
-        parser->output_list = 
-            (struct dsml_io**) realloc(parser->output_list, parser->output_list_cap * sizeof(struct dsml_io*));
+        parser->output_list = (struct dsml_io**) mem_realloc(&parser->mem, MEM_CATEGORY_LIST, parser->output_list,
+            (parser->output_list_cap - CAP_INCR) * sizeof(struct dsml_io*), parser->output_list_cap * sizeof(struct dsml_io*));
     }
 
-    parser->output_list[parser->output_list_size] = (struct dsml_io*) malloc(sizeof(struct dsml_io));
-    parser->output_list[parser->output_list_size]->symbol = strdup(symbol);
+    parser->output_list[parser->output_list_size] =
+        (struct dsml_io*) mem_alloc(&parser->mem, MEM_CATEGORY_ENTITY, sizeof(struct dsml_io));
+    parser->output_list[parser->output_list_size]->symbol = mem_strdup(&parser->mem, symbol);
+    parser->output_list[parser->output_list_size]->id = parser->output_list_size;
+    dsml_index_add(parser, &parser->output_index, dsml_hash(symbol), parser->output_list_size);
     parser->output_list_size++;
     return DSML_STATUS_SUCCESS;
 }
@@ -601,11 +1113,44 @@ enum dsml_status dsml_add_trans(struct dsml_parser* parser, struct dsml_trans* t
 
     if (parser->trans_list_size == parser->trans_list_cap) {
         parser->trans_list_cap += CAP_INCR;
-        parser->trans_list = 
-            (struct dsml_trans**) realloc(parser->trans_list, parser->trans_list_cap * sizeof(struct dsml_trans*));
+        parser->trans_list = (struct dsml_trans**) mem_realloc(&parser->mem, MEM_CATEGORY_LIST, parser->trans_list,
+            (parser->trans_list_cap - CAP_INCR) * sizeof(struct dsml_trans*), parser->trans_list_cap * sizeof(struct dsml_trans*));
     }
 
+    dsml_index_add(parser, &parser->trans_index, dsml_pair_hash(trans->from_state->id, trans->input->id),
+        parser->trans_list_size);
     parser->trans_list[parser->trans_list_size++] = trans;
+    trans->from_state->trans_count++;
+    return DSML_STATUS_SUCCESS;
+}
+
+enum dsml_status dsml_add_rule(struct dsml_parser* parser, struct dsml_rule* rule) {
+    if ((parser == NULL) || (rule == NULL)) {
+        return DSML_STATUS_NULL_PARAM;
+    }
+
+    /* Rules of the same precedence must select disjoint (state, input) pairs */
+    for (int i = 0; i < parser->rule_list_size; i++) {
+        const struct dsml_rule* other = parser->rule_list[i];
+
+        if ((other->selector != rule->selector) || (other->input != rule->input)) {
+            continue;
+        }
+
+        if ((rule->selector == DSML_SELECTOR_ANY) ||
+            ((strcmp(other->prefix, rule->prefix) == 0) && (other->first <= rule->last) && (rule->first <= other->last)))
+        {
+            return DSML_STATUS_INDETERM_TRANS;
+        }
+    }
+
+    if (parser->rule_list_size == parser->rule_list_cap) {
+        parser->rule_list_cap += CAP_INCR;
+        parser->rule_list = (struct dsml_rule**) mem_realloc(&parser->mem, MEM_CATEGORY_LIST, parser->rule_list,
+            (parser->rule_list_cap - CAP_INCR) * sizeof(struct dsml_rule*), parser->rule_list_cap * sizeof(struct dsml_rule*));
+    }
+
+    parser->rule_list[parser->rule_list_size++] = rule;
     return DSML_STATUS_SUCCESS;
 }
 
@@ -679,102 +1224,69 @@ EXIT:
 }
 
 bool dsml_symbol_exists(struct dsml_parser* parser, const char* symbol, enum dsml_lexeme_type type) {
+    return dsml_get_entity(parser, symbol, type) != NULL;
+}
+
+void* dsml_get_entity(struct dsml_parser* parser, const char* symbol, enum dsml_lexeme_type type) {
     assert((parser != NULL) && (symbol != NULL));
     assert((type != DSML_LEXEME_TRANS) && (type != DSML_LEXEME_UNDEF));
 
-    bool exists = false;
+    const struct dsml_index* index = NULL;
 
     switch (type) {
     case DSML_LEXEME_STATE:
-        for (int i = 0; i < parser->state_list_size; i++) {
-            if (strcmp(symbol, parser->state_list[i]->symbol) == 0) {
-                exists = true;
-                break;
-            }
-        }
+        index = &parser->state_index;
         break;
 
     case DSML_LEXEME_INPUT:
-        for (int i = 0; i < parser->input_list_size; i++) {
-            if (strcmp(symbol, parser->input_list[i]->symbol) == 0) {
-                exists = true;
-                break;
-            }
-        }
+        index = &parser->input_index;
         break;
 
     case DSML_LEXEME_OUTPUT:
-        for (int i = 0; i < parser->output_list_size; i++) {
-            if (strcmp(symbol, parser->output_list[i]->symbol) == 0) {
-                exists = true;
-                break;
-            }
-        }
+        index = &parser->output_index;
         break;
-    
+
     default:
-        break;
+        return NULL;
     }
 
-    return exists;
-}
+    uint64_t hash = dsml_hash(symbol);
 
-void* dsml_get_entity(struct dsml_parser* parser, const char* symbol, enum dsml_lexeme_type type) {
-    assert((parser != NULL) && (symbol != NULL));
-    assert((type != DSML_LEXEME_TRANS) && (type != DSML_LEXEME_UNDEF));
-
-    void* entity_ptr = NULL;
-
-    switch (type) {
-    case DSML_LEXEME_STATE:
-        for (int i = 0; i < parser->state_list_size; i++) {
-            if (strcmp(symbol, parser->state_list[i]->symbol) == 0) {
-                entity_ptr = (void*) parser->state_list[i];
-                break;
-            }
+    for (int slot = dsml_index_slot(index, hash); index->positions[slot] >= 0; slot = (slot + 1) & (index->size - 1)) {
+        if (index->hashes[slot] != hash) {
+            continue;
         }
-        break;
 
-    case DSML_LEXEME_INPUT:
-        for (int i = 0; i < parser->input_list_size; i++) {
-            if (strcmp(symbol, parser->input_list[i]->symbol) == 0) {
-                entity_ptr = (void*) parser->input_list[i];
-                break;
+        int position = index->positions[slot];
+
+        if (type == DSML_LEXEME_STATE) {
+            if (strcmp(symbol, parser->state_list[position]->symbol) == 0) {
+                return (void*) parser->state_list[position];
             }
         }
-        break;
+        else {
+            struct dsml_io* io = (type == DSML_LEXEME_INPUT) ? parser->input_list[position] : parser->output_list[position];
 
-    case DSML_LEXEME_OUTPUT:
-        for (int i = 0; i < parser->output_list_size; i++) {
-            if (strcmp(symbol, parser->output_list[i]->symbol) == 0) {
-                entity_ptr = (void*) parser->output_list[i];
-                break;
+            if (strcmp(symbol, io->symbol) == 0) {
+                return (void*) io;
             }
         }
-        break;
-    
-    default:
-        break;
     }
 
-    return entity_ptr;
+    return NULL;
 }
 
 struct dsml_trans* dsml_get_trans(struct dsml_parser* parser, const char* from_state_symbol, const char* input_symbol) {
     assert((parser != NULL) && (from_state_symbol != NULL) && (input_symbol != NULL));
 
-    struct dsml_trans* trans_ptr = NULL;
+    struct dsml_state* from_state = dsml_get_entity(parser, from_state_symbol, DSML_LEXEME_STATE);
+    struct dsml_io* input = dsml_get_entity(parser, input_symbol, DSML_LEXEME_INPUT);
 
-    for (int i = 0; i < parser->trans_list_size; i++) {
-        if ((strcmp(parser->trans_list[i]->from_state->symbol, from_state_symbol) == 0) &&
-            (strcmp(parser->trans_list[i]->input->symbol, input_symbol) == 0))
-        {
-            trans_ptr = parser->trans_list[i];
-            break;
-        }
+    if ((from_state == NULL) || (input == NULL)) {
+        return NULL;
     }
 
-    return trans_ptr;
+    return dsml_find_trans(parser, from_state, input);
 }
 
 enum dsml_status dsml_validate_dsm(struct dsml_parser* parser) {
@@ -794,30 +1306,142 @@ enum dsml_status dsml_validate_dsm(struct dsml_parser* parser) {
         return DSML_STATUS_STATIC_DSM;
     }
 
-    bool is_dsm_determined = true;
-    const char* state_symbol = NULL;
+    /* Missing transitions of the nondeterministic machine lead nowhere */
+    if (parser->is_nfa) {
+        return DSML_STATUS_SUCCESS;
+    }
 
+    enum dsml_status status = DSML_STATUS_SUCCESS;
+    const struct dsml_trans** row = NULL;
+
+    /* 
+     * Transitions are unique per (state, input) pair, so the state is determined
+     * if it has either a default transition or a transition for every input.
+     * Otherwise the rules have to cover the rest of the inputs.
+     */
     for (int i = 0; i < parser->state_list_size; i++) {
-        state_symbol = parser->state_list[i]->symbol;
+        struct dsml_state* state = parser->state_list[i];
+
+        if ((state->default_trans != NULL) || (state->trans_count == parser->input_list_size)) {
+            continue;
+        }
+
+        if (parser->rule_list_size == 0) {
+            fprintf(stderr, "Not all input reactions for the state '%s' are defined\n", state->symbol);
+            status = DSML_STATUS_INDETERM_TRANS;
+            goto EXIT;
+        }
+
+        if (row == NULL) {
+            row = (const struct dsml_trans**) malloc(parser->input_list_size * sizeof(struct dsml_trans*));
+        }
+
+        dsml_state_row(parser, i, row);
 
         for (int j = 0; j < parser->input_list_size; j++) {
-            const char* input_symbol = parser->input_list[j]->symbol;
+            if (row[j] == NULL) {
+                fprintf(stderr, "Not all input reactions for the state '%s' are defined (input '%s')\n",
+                    state->symbol, parser->input_list[j]->symbol);
+                status = DSML_STATUS_INDETERM_TRANS;
+                goto EXIT;
+            }
+        }
+    }
+
+EXIT:
+
+    free(row);
+    return status;
+}
 
-            if (dsml_get_trans(parser, state_symbol, input_symbol) == NULL) {
-                is_dsm_determined = false;
-                goto EXIT_CYCLE;
+void dsml_state_row(struct dsml_parser* parser, int state, const struct dsml_trans** row) {
+    assert((parser != NULL) && (row != NULL));
+    assert((state >= 0) && (state < parser->state_list_size));
+
+    const struct dsml_state* from_state = parser->state_list[state];
+
+    for (int i = 0; i < parser->input_list_size; i++) {
+        row[i] = NULL;
+    }
+
+    /* Rules from the least specific level, so the more specific ones override them */
+    if (parser->rule_list_size != 0) {
+        size_t prefix_len = 0;
+        long number = 0;
+        bool is_numbered = dsml_split_numbered(from_state->symbol, strlen(from_state->symbol), &prefix_len, &number);
+
+        for (int level = 0; level < 4; level++) {
+            for (int i = 0; i < parser->rule_list_size; i++) {
+                const struct dsml_rule* rule = parser->rule_list[i];
+
+                if (dsml_rule_level(rule) != level) {
+                    continue;
+                }
+
+                if ((rule->selector == DSML_SELECTOR_RANGE) &&
+                    !(is_numbered && dsml_rule_matches(rule, from_state->symbol, prefix_len, number)))
+                {
+                    continue;
+                }
+
+                if (rule->input == NULL) {
+                    for (int j = 0; j < parser->input_list_size; j++) {
+                        row[j] = &rule->trans;
+                    }
+                }
+                else {
+                    row[rule->input->id] = &rule->trans;
+                }
             }
         }
     }
 
-EXIT_CYCLE:
+    if (from_state->default_trans != NULL) {
+        for (int i = 0; i < parser->input_list_size; i++) {
+            row[i] = from_state->default_trans;
+        }
+    }
 
-    if (!is_dsm_determined) {
-        fprintf(stderr, "Not all input reactions for the state '%s' are defined\n", state_symbol);
-        return DSML_STATUS_INDETERM_TRANS;
+    /* Explicit transitions */
+    dsml_group_trans(parser);
+
+    for (int i = parser->state_trans_start[state]; i < parser->state_trans_start[state + 1]; i++) {
+        const struct dsml_trans* trans = parser->trans_list[parser->state_trans_list[i]];
+
+        if (trans != NULL) {
+            row[trans->input->id] = trans;
+        }
     }
+}
 
-    return DSML_STATUS_SUCCESS;
+int dsml_state_trans(struct dsml_parser* parser, int state, const int** positions) {
+    assert((parser != NULL) && (positions != NULL));
+    assert((state >= 0) && (state < parser->state_list_size));
+
+    dsml_group_trans(parser);
+
+    *positions = &parser->state_trans_list[parser->state_trans_start[state]];
+    return parser->state_trans_start[state + 1] - parser->state_trans_start[state];
+}
+
+void dsml_release_state_trans(struct dsml_parser* parser, int state) {
+    assert((parser != NULL) && (state >= 0) && (state < parser->state_list_size));
+
+    struct dsml_state* from_state = parser->state_list[state];
+
+    dsml_group_trans(parser);
+
+    for (int i = parser->state_trans_start[state]; i < parser->state_trans_start[state + 1]; i++) {
+        const int position = parser->state_trans_list[i];
+
+        mem_free(&parser->mem, MEM_CATEGORY_ENTITY, parser->trans_list[position], sizeof(struct dsml_trans));
+        parser->trans_list[position] = NULL;
+    }
+
+    from_state->trans_count = 0;
+
+    mem_free(&parser->mem, MEM_CATEGORY_ENTITY, from_state->default_trans, sizeof(struct dsml_trans));
+    from_state->default_trans = NULL;
 }
 
 bool dsml_is_comment(const char* str) {
@@ -887,6 +1511,9 @@ const char* dsml_status_message(enum dsml_status status) {
     case DSML_STATUS_INDETERM_TRANS:
         message = "DSM error: Indetermined transition";
         break;
+    case DSML_STATUS_INVAL_RANGE:
+        message = "Syntax error: Invalid range of numbered symbols";
+        break;
     case DSML_STATUS_UNDEF_ERROR:
         message = "Unknown error";
         break;
@@ -919,6 +1546,14 @@ void dsml_parser_print(struct dsml_parser* parser) {
         }
 
         printf("\n");
+
+        struct dsml_trans* default_trans = parser->state_list[i]->default_trans;
+
+        if (default_trans != NULL) {
+            printf("\t\tDefault: %s : %s\n",
+                default_trans->to_state->symbol,
+                (default_trans->output == NULL) ? DSML_EMPTY_OUTPUT_SYMBOL : default_trans->output->symbol);
+        }
     }
 
     printf("\n");
@@ -936,6 +1571,11 @@ void dsml_parser_print(struct dsml_parser* parser) {
     printf("\n");
 
     for (int i = 0; i < parser->trans_list_size; i++) {
+        /* Released by the machine build */
+        if (parser->trans_list[i] == NULL) {
+            continue;
+        }
+
         printf("\tTransition %d:\n", i + 1);
         printf("\t\tFrom State: %s\n", parser->trans_list[i]->from_state->symbol);
         printf("\t\tInput: %s\n", parser->trans_list[i]->input->symbol);
@@ -949,6 +1589,26 @@ void dsml_parser_print(struct dsml_parser* parser) {
     }
 
     printf("\n");
+
+    for (int i = 0; i < parser->rule_list_size; i++) {
+        const struct dsml_rule* rule = parser->rule_list[i];
+
+        printf("\tRule %d:\n", i + 1);
+
+        if (rule->selector == DSML_SELECTOR_RANGE) {
+            printf("\t\tFrom States: %s%ld..%s%ld\n", rule->prefix, rule->first, rule->prefix, rule->last);
+        }
+        else {
+            printf("\t\tFrom States: %s\n", DSML_ANY_SYMBOL);
+        }
+
+        printf("\t\tInput: %s\n", (rule->input == NULL) ? DSML_ANY_SYMBOL : rule->input->symbol);
+        printf("\t\tTo State: %s\n", rule->trans.to_state->symbol);
+        printf("\t\tOutput: %s\n",
+            (rule->trans.output == NULL) ? DSML_EMPTY_OUTPUT_SYMBOL : rule->trans.output->symbol);
+    }
+
+    printf("\n");
 }
 
 #endif /* !NDEBUG */
\ No newline at end of file
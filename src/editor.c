@@ -0,0 +1,637 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "machine.h"
+#include "editor.h"
+#include "mem.h"
+
+/* Symbol Index */
+
+static void machine_editor_index_init(struct machine_editor* editor, struct machine_editor_index* index, int size) {
+    index->size = size;
+    index->positions = (int*) mem_alloc(&editor->mem, MEM_CATEGORY_TABLE, size * sizeof(int));
+
+    for (int i = 0; i < size; i++) {
+        index->positions[i] = -1;
+    }
+}
+
+static void machine_editor_index_free(struct machine_editor* editor, struct machine_editor_index* index) {
+    mem_free(&editor->mem, MEM_CATEGORY_TABLE, index->positions, index->size * sizeof(int));
+    index->positions = NULL;
+    index->size = 0;
+}
+
+/**
+ * Slot of the `symbol` in the index of the `symbols`, or the free slot it takes
+ */
+static int machine_editor_index_slot(const struct machine_editor_index* index, char* const* symbols,
+    const char* symbol)
+{
+    int slot = (int) (machine_symbol_hash(symbol, strlen(symbol)) & (uint64_t) (index->size - 1));
+
+    while ((index->positions[slot] >= 0) && (strcmp(symbols[index->positions[slot]], symbol) != 0)) {
+        slot = (slot + 1) & (index->size - 1);
+    }
+
+    return slot;
+}
+
+static void machine_editor_index_add(struct machine_editor* editor, struct machine_editor_index* index,
+    char* const* symbols, int count)
+{
+    if (2 * count >= index->size) {
+        const int new_size = 2 * index->size;
+
+        machine_editor_index_free(editor, index);
+        machine_editor_index_init(editor, index, new_size);
+
+        for (int i = 0; i < count - 1; i++) {
+            index->positions[machine_editor_index_slot(index, symbols, symbols[i])] = i;
+        }
+    }
+
+    index->positions[machine_editor_index_slot(index, symbols, symbols[count - 1])] = count - 1;
+}
+
+static int machine_editor_index_find(const struct machine_editor_index* index, char* const* symbols,
+    const char* symbol)
+{
+    return index->positions[machine_editor_index_slot(index, symbols, symbol)];
+}
+
+/* Initialisation/Destruction */
+
+static void machine_editor_init_index(struct machine_editor* editor, struct machine_editor_index* index,
+    char* const* symbols, int count)
+{
+    int size = 16;
+
+    while (size <= 2 * count) {
+        size <<= 1;
+    }
+
+    machine_editor_index_init(editor, index, size);
+
+    for (int i = 0; i < count; i++) {
+        index->positions[machine_editor_index_slot(index, symbols, symbols[i])] = i;
+    }
+}
+
+static void machine_editor_free_version(struct machine_version* version) {
+    machine_free(&version->machine);
+    free(version);
+}
+
+enum machine_status machine_editor_init(struct machine_editor* editor, struct machine_instance* machine) {
+    if ((editor == NULL) || (machine == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    mem_stats_init(&editor->mem);
+
+    editor->state_list_size = machine->state_list_size;
+    editor->state_list_cap = (machine->state_list_size > 0) ? machine->state_list_size : 1;
+    editor->input_list_size = machine->input_list_size;
+    editor->input_list_cap = (machine->input_list_size > 0) ? machine->input_list_size : 1;
+    editor->output_list_size = machine->output_list_size;
+    editor->output_list_cap = (machine->output_list_size > 0) ? machine->output_list_size : 1;
+    editor->entry_state = machine->entry_state;
+    editor->missing_count = 0;
+    editor->dirty_count = 0;
+    editor->is_repack = false;
+    editor->packed_table_size = machine->trans_table_size;
+
+    editor->state_list = (char**) mem_alloc(&editor->mem, MEM_CATEGORY_LIST, editor->state_list_cap * sizeof(char*));
+    editor->final_list = (bool*) mem_alloc(&editor->mem, MEM_CATEGORY_LIST, editor->state_list_cap * sizeof(bool));
+    editor->dirty_list = (bool*) mem_calloc(&editor->mem, MEM_CATEGORY_LIST, editor->state_list_cap, sizeof(bool));
+    editor->input_list = (char**) mem_alloc(&editor->mem, MEM_CATEGORY_LIST, editor->input_list_cap * sizeof(char*));
+    editor->output_list =
+        (char**) mem_alloc(&editor->mem, MEM_CATEGORY_LIST, editor->output_list_cap * sizeof(char*));
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        editor->state_list[i] = mem_strdup(&editor->mem, machine->state_list[i].symbol);
+        editor->final_list[i] = machine->state_list[i].is_final;
+    }
+
+    for (int i = 0; i < editor->input_list_size; i++) {
+        editor->input_list[i] = mem_strdup(&editor->mem, machine->input_list[i]);
+    }
+
+    for (int i = 0; i < editor->output_list_size; i++) {
+        editor->output_list[i] = mem_strdup(&editor->mem, machine->output_list[i]);
+    }
+
+    machine_editor_init_index(editor, &editor->state_index, editor->state_list, editor->state_list_size);
+    machine_editor_init_index(editor, &editor->input_index, editor->input_list, editor->input_list_size);
+    machine_editor_init_index(editor, &editor->output_index, editor->output_list, editor->output_list_size);
+
+    /* Working tables are dense, so the edits do not depend on the comb layout */
+    const size_t table_size = (size_t) editor->state_list_cap * editor->input_list_cap;
+
+    editor->next_table = (int*) mem_alloc(&editor->mem, MEM_CATEGORY_TABLE, table_size * sizeof(int));
+    editor->output_table = (int*) mem_alloc(&editor->mem, MEM_CATEGORY_TABLE, table_size * sizeof(int));
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        for (int j = 0; j < editor->input_list_size; j++) {
+            struct machine_trans trans = machine_get_trans(machine, i, j);
+
+            editor->next_table[(size_t) i * editor->input_list_cap + j] = trans.next_state;
+            editor->output_table[(size_t) i * editor->input_list_cap + j] = trans.output;
+        }
+    }
+
+    /* The machine itself is the first version */
+    struct machine_version* version = (struct machine_version*) malloc(sizeof(struct machine_version));
+
+    version->machine = *machine;
+    version->number = 1;
+    version->next_retired = NULL;
+    atomic_init(&version->reader_count, 0);
+
+    memset(machine, 0, sizeof(struct machine_instance));
+
+    editor->version_count = 1;
+    editor->retired_list = NULL;
+    atomic_init(&editor->current, version);
+    atomic_init(&editor->entering_count, 0);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_free(struct machine_editor* editor) {
+    if (editor == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    while (editor->retired_list != NULL) {
+        struct machine_version* version = editor->retired_list;
+
+        editor->retired_list = version->next_retired;
+        machine_editor_free_version(version);
+    }
+
+    struct machine_version* current = atomic_exchange(&editor->current, NULL);
+
+    if (current != NULL) {
+        machine_editor_free_version(current);
+    }
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        mem_free_string(&editor->mem, editor->state_list[i]);
+    }
+
+    for (int i = 0; i < editor->input_list_size; i++) {
+        mem_free_string(&editor->mem, editor->input_list[i]);
+    }
+
+    for (int i = 0; i < editor->output_list_size; i++) {
+        mem_free_string(&editor->mem, editor->output_list[i]);
+    }
+
+    const size_t table_size = (size_t) editor->state_list_cap * editor->input_list_cap;
+
+    mem_free(&editor->mem, MEM_CATEGORY_LIST, editor->state_list, editor->state_list_cap * sizeof(char*));
+    mem_free(&editor->mem, MEM_CATEGORY_LIST, editor->final_list, editor->state_list_cap * sizeof(bool));
+    mem_free(&editor->mem, MEM_CATEGORY_LIST, editor->dirty_list, editor->state_list_cap * sizeof(bool));
+    mem_free(&editor->mem, MEM_CATEGORY_LIST, editor->input_list, editor->input_list_cap * sizeof(char*));
+    mem_free(&editor->mem, MEM_CATEGORY_LIST, editor->output_list, editor->output_list_cap * sizeof(char*));
+    mem_free(&editor->mem, MEM_CATEGORY_TABLE, editor->next_table, table_size * sizeof(int));
+    mem_free(&editor->mem, MEM_CATEGORY_TABLE, editor->output_table, table_size * sizeof(int));
+
+    machine_editor_index_free(editor, &editor->state_index);
+    machine_editor_index_free(editor, &editor->input_index);
+    machine_editor_index_free(editor, &editor->output_index);
+
+    editor->state_list = NULL;
+    editor->final_list = NULL;
+    editor->dirty_list = NULL;
+    editor->input_list = NULL;
+    editor->output_list = NULL;
+    editor->next_table = NULL;
+    editor->output_table = NULL;
+
+    editor->state_list_size = 0;
+    editor->state_list_cap = 0;
+    editor->input_list_size = 0;
+    editor->input_list_cap = 0;
+    editor->output_list_size = 0;
+    editor->output_list_cap = 0;
+    editor->missing_count = 0;
+    editor->dirty_count = 0;
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+/* Editing */
+
+static void machine_editor_mark_dirty(struct machine_editor* editor, int state) {
+    if (!editor->dirty_list[state]) {
+        editor->dirty_list[state] = true;
+        editor->dirty_count++;
+    }
+}
+
+/**
+ * Move the working tables to the new capacities, new pairs have no transition
+ */
+static void machine_editor_resize_tables(struct machine_editor* editor, int state_cap, int input_cap) {
+    const size_t old_size = (size_t) editor->state_list_cap * editor->input_list_cap;
+    const size_t new_size = (size_t) state_cap * input_cap;
+
+    int* next_table = (int*) mem_alloc(&editor->mem, MEM_CATEGORY_TABLE, new_size * sizeof(int));
+    int* output_table = (int*) mem_alloc(&editor->mem, MEM_CATEGORY_TABLE, new_size * sizeof(int));
+
+    for (size_t i = 0; i < new_size; i++) {
+        next_table[i] = MACHINE_EDITOR_NO_TRANS;
+        output_table[i] = MACHINE_EMPTY_OUTPUT;
+    }
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        memcpy(&next_table[(size_t) i * input_cap], &editor->next_table[(size_t) i * editor->input_list_cap],
+            editor->input_list_size * sizeof(int));
+        memcpy(&output_table[(size_t) i * input_cap], &editor->output_table[(size_t) i * editor->input_list_cap],
+            editor->input_list_size * sizeof(int));
+    }
+
+    mem_free(&editor->mem, MEM_CATEGORY_TABLE, editor->next_table, old_size * sizeof(int));
+    mem_free(&editor->mem, MEM_CATEGORY_TABLE, editor->output_table, old_size * sizeof(int));
+
+    editor->next_table = next_table;
+    editor->output_table = output_table;
+    editor->state_list_cap = state_cap;
+    editor->input_list_cap = input_cap;
+}
+
+enum machine_status machine_editor_add_state(struct machine_editor* editor, const char* symbol, bool is_final,
+    int* state)
+{
+    if ((editor == NULL) || (symbol == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (machine_editor_find_state(editor, symbol) >= 0) {
+        return MACHINE_STATUS_REDEF_SYMBOL;
+    }
+
+    if (editor->state_list_size == editor->state_list_cap) {
+        const int new_cap = 2 * editor->state_list_cap;
+
+        editor->state_list = (char**) mem_realloc(&editor->mem, MEM_CATEGORY_LIST, editor->state_list,
+            editor->state_list_cap * sizeof(char*), new_cap * sizeof(char*));
+        editor->final_list = (bool*) mem_realloc(&editor->mem, MEM_CATEGORY_LIST, editor->final_list,
+            editor->state_list_cap * sizeof(bool), new_cap * sizeof(bool));
+        editor->dirty_list = (bool*) mem_realloc(&editor->mem, MEM_CATEGORY_LIST, editor->dirty_list,
+            editor->state_list_cap * sizeof(bool), new_cap * sizeof(bool));
+
+        machine_editor_resize_tables(editor, new_cap, editor->input_list_cap);
+    }
+
+    const int new_state = editor->state_list_size++;
+
+    editor->state_list[new_state] = mem_strdup(&editor->mem, symbol);
+    editor->final_list[new_state] = is_final;
+    editor->dirty_list[new_state] = false;
+    machine_editor_mark_dirty(editor, new_state);
+    machine_editor_index_add(editor, &editor->state_index, editor->state_list, editor->state_list_size);
+
+    for (int i = 0; i < editor->input_list_size; i++) {
+        editor->next_table[(size_t) new_state * editor->input_list_cap + i] = MACHINE_EDITOR_NO_TRANS;
+        editor->output_table[(size_t) new_state * editor->input_list_cap + i] = MACHINE_EMPTY_OUTPUT;
+    }
+
+    editor->missing_count += editor->input_list_size;
+
+    if (state != NULL) {
+        *state = new_state;
+    }
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_add_input(struct machine_editor* editor, const char* symbol, int* input) {
+    if ((editor == NULL) || (symbol == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (machine_editor_find_input(editor, symbol) >= 0) {
+        return MACHINE_STATUS_REDEF_SYMBOL;
+    }
+
+    if (editor->input_list_size == editor->input_list_cap) {
+        const int new_cap = 2 * editor->input_list_cap;
+
+        editor->input_list = (char**) mem_realloc(&editor->mem, MEM_CATEGORY_LIST, editor->input_list,
+            editor->input_list_cap * sizeof(char*), new_cap * sizeof(char*));
+
+        machine_editor_resize_tables(editor, editor->state_list_cap, new_cap);
+    }
+
+    const int new_input = editor->input_list_size++;
+
+    editor->input_list[new_input] = mem_strdup(&editor->mem, symbol);
+    machine_editor_index_add(editor, &editor->input_index, editor->input_list, editor->input_list_size);
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        editor->next_table[(size_t) i * editor->input_list_cap + new_input] = MACHINE_EDITOR_NO_TRANS;
+        editor->output_table[(size_t) i * editor->input_list_cap + new_input] = MACHINE_EMPTY_OUTPUT;
+    }
+
+    editor->missing_count += editor->state_list_size;
+    editor->is_repack = true;
+
+    if (input != NULL) {
+        *input = new_input;
+    }
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_add_output(struct machine_editor* editor, const char* symbol, int* output) {
+    if ((editor == NULL) || (symbol == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (machine_editor_find_output(editor, symbol) >= 0) {
+        return MACHINE_STATUS_REDEF_SYMBOL;
+    }
+
+    if (editor->output_list_size == editor->output_list_cap) {
+        const int new_cap = 2 * editor->output_list_cap;
+
+        editor->output_list = (char**) mem_realloc(&editor->mem, MEM_CATEGORY_LIST, editor->output_list,
+            editor->output_list_cap * sizeof(char*), new_cap * sizeof(char*));
+        editor->output_list_cap = new_cap;
+    }
+
+    const int new_output = editor->output_list_size++;
+
+    editor->output_list[new_output] = mem_strdup(&editor->mem, symbol);
+    machine_editor_index_add(editor, &editor->output_index, editor->output_list, editor->output_list_size);
+
+    if (output != NULL) {
+        *output = new_output;
+    }
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_set_trans(struct machine_editor* editor, int state, int input,
+    int next_state, int output)
+{
+    if (editor == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if ((state < 0) || (state >= editor->state_list_size) || (input < 0) || (input >= editor->input_list_size) ||
+        (next_state < 0) || (next_state >= editor->state_list_size) ||
+        (output < MACHINE_EMPTY_OUTPUT) || (output >= editor->output_list_size))
+    {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    const size_t pair = (size_t) state * editor->input_list_cap + input;
+
+    if (editor->next_table[pair] == MACHINE_EDITOR_NO_TRANS) {
+        editor->missing_count--;
+    }
+
+    editor->next_table[pair] = next_state;
+    editor->output_table[pair] = output;
+    machine_editor_mark_dirty(editor, state);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_clear_trans(struct machine_editor* editor, int state, int input) {
+    if (editor == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if ((state < 0) || (state >= editor->state_list_size) || (input < 0) || (input >= editor->input_list_size)) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    const size_t pair = (size_t) state * editor->input_list_cap + input;
+
+    if (editor->next_table[pair] != MACHINE_EDITOR_NO_TRANS) {
+        editor->missing_count++;
+    }
+
+    editor->next_table[pair] = MACHINE_EDITOR_NO_TRANS;
+    editor->output_table[pair] = MACHINE_EMPTY_OUTPUT;
+    machine_editor_mark_dirty(editor, state);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_editor_set_final(struct machine_editor* editor, int state, bool is_final) {
+    if (editor == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if ((state < 0) || (state >= editor->state_list_size)) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    editor->final_list[state] = is_final;
+    return MACHINE_STATUS_SUCCESS;
+}
+
+int machine_editor_find_state(const struct machine_editor* editor, const char* symbol) {
+    return machine_editor_index_find(&editor->state_index, editor->state_list, symbol);
+}
+
+int machine_editor_find_input(const struct machine_editor* editor, const char* symbol) {
+    return machine_editor_index_find(&editor->input_index, editor->input_list, symbol);
+}
+
+int machine_editor_find_output(const struct machine_editor* editor, const char* symbol) {
+    return machine_editor_index_find(&editor->output_index, editor->output_list, symbol);
+}
+
+/* Publishing */
+
+static void machine_editor_row(void* context, int state, struct machine_trans* row) {
+    const struct machine_editor* editor = (const struct machine_editor*) context;
+    const size_t start = (size_t) state * editor->input_list_cap;
+
+    for (int i = 0; i < editor->input_list_size; i++) {
+        row[i].next_state = editor->next_table[start + i];
+        row[i].output = editor->output_table[start + i];
+    }
+}
+
+/**
+ * Copy the table of the `previous` version and append the rows of the edited
+ * states whole, the slots they owned before are freed
+ */
+static void machine_editor_patch_table(struct machine_editor* editor, struct machine_instance* machine,
+    const struct machine_instance* previous)
+{
+    const int input_count = editor->input_list_size;
+
+    machine->trans_table_size = previous->trans_table_size + editor->dirty_count * input_count;
+    machine->trans_table = (struct machine_trans*) mem_alloc(&machine->mem, MEM_CATEGORY_TABLE,
+        machine->trans_table_size * sizeof(struct machine_trans));
+    memcpy(machine->trans_table, previous->trans_table, previous->trans_table_size * sizeof(struct machine_trans));
+
+    int base = previous->trans_table_size;
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        struct machine_state* state = &machine->state_list[i];
+
+        if (!editor->dirty_list[i]) {
+            state->base = previous->state_list[i].base;
+            state->default_trans = previous->state_list[i].default_trans;
+            continue;
+        }
+
+        if (i < previous->state_list_size) {
+            struct machine_trans* old_row = &machine->trans_table[previous->state_list[i].base];
+
+            for (int j = 0; j < input_count; j++) {
+                if (old_row[j].check == i) {
+                    old_row[j].check = MACHINE_FREE_SLOT;
+                }
+            }
+        }
+
+        struct machine_trans* row = &machine->trans_table[base];
+        machine_editor_row(editor, i, row);
+
+        for (int j = 0; j < input_count; j++) {
+            row[j].check = i;
+        }
+
+        /* Every slot of the row is owned, the default is never taken */
+        state->default_trans = row[0];
+        state->base = base;
+        base += input_count;
+    }
+}
+
+/**
+ * Free the replaced versions no reader holds. A reader which has loaded the
+ * version but not counted itself in yet is visible in `entering_count`.
+ */
+static void machine_editor_reclaim(struct machine_editor* editor) {
+    if (atomic_load(&editor->entering_count) != 0) {
+        return;
+    }
+
+    struct machine_version** link = &editor->retired_list;
+
+    while (*link != NULL) {
+        struct machine_version* version = *link;
+
+        if (atomic_load(&version->reader_count) == 0) {
+            *link = version->next_retired;
+            machine_editor_free_version(version);
+        }
+        else {
+            link = &version->next_retired;
+        }
+    }
+}
+
+enum machine_status machine_editor_publish(struct machine_editor* editor) {
+    if (editor == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (editor->missing_count != 0) {
+        return MACHINE_STATUS_MISSING_TRANS;
+    }
+
+    struct machine_version* version = (struct machine_version*) malloc(sizeof(struct machine_version));
+    struct machine_instance* machine = &version->machine;
+
+    mem_stats_init(&machine->mem);
+
+    machine->input_list_size = editor->input_list_size;
+    machine->state_list_size = editor->state_list_size;
+    machine->output_list_size = editor->output_list_size;
+    machine->entry_state = editor->entry_state;
+
+    machine->input_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->input_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->input_list_size; i++) {
+        machine->input_list[i] = mem_strdup(&machine->mem, editor->input_list[i]);
+    }
+
+    machine_build_resolver(machine);
+
+    machine->output_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->output_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->output_list_size; i++) {
+        machine->output_list[i] = mem_strdup(&machine->mem, editor->output_list[i]);
+    }
+
+    machine->state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, machine->state_list_size * sizeof(struct machine_state));
+    for (int i = 0; i < machine->state_list_size; i++) {
+        machine->state_list[i].symbol = mem_strdup(&machine->mem, editor->state_list[i]);
+        machine->state_list[i].is_final = editor->final_list[i];
+    }
+
+    machine->trans_table = NULL;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+    machine->trans_table_size = 0;
+
+    /* Only the writer replaces the current version */
+    struct machine_version* previous = atomic_load(&editor->current);
+    const int patched_size = previous->machine.trans_table_size + editor->dirty_count * editor->input_list_size;
+    enum machine_status status = MACHINE_STATUS_SUCCESS;
+
+    if (editor->is_repack || (patched_size > 2 * editor->packed_table_size + editor->input_list_size)) {
+        status = machine_build_table(machine, machine_editor_row, editor);
+        editor->packed_table_size = machine->trans_table_size;
+    }
+    else {
+        machine_editor_patch_table(editor, machine, &previous->machine);
+        status = machine_classify_states(machine);
+    }
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        machine_editor_free_version(version);
+        return status;
+    }
+
+    version->number = ++editor->version_count;
+    version->next_retired = NULL;
+    atomic_init(&version->reader_count, 0);
+
+    for (int i = 0; i < editor->state_list_size; i++) {
+        editor->dirty_list[i] = false;
+    }
+
+    editor->dirty_count = 0;
+    editor->is_repack = false;
+
+    /* Readers see either the whole previous version or the whole new one */
+    atomic_store(&editor->current, version);
+
+    previous->next_retired = editor->retired_list;
+    editor->retired_list = previous;
+
+    machine_editor_reclaim(editor);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+const struct machine_version* machine_editor_acquire(struct machine_editor* editor) {
+    atomic_fetch_add(&editor->entering_count, 1);
+
+    struct machine_version* version = atomic_load(&editor->current);
+    atomic_fetch_add(&version->reader_count, 1);
+
+    atomic_fetch_sub(&editor->entering_count, 1);
+    return version;
+}
+
+void machine_editor_release(const struct machine_version* version) {
+    atomic_fetch_sub(&((struct machine_version*) version)->reader_count, 1);
+}
@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+
+/**
+ * @struct Histogram of the thread, valid while `generation` matches the global one
+ */
+struct latency_slot {
+    const void* machine;
+    enum latency_path path;
+    uint64_t generation;
+    struct latency_histogram* histogram;
+};
+
+static const char* latency_path_name_list[LATENCY_PATH_NUM] = {
+    "run",
+    "dispatch",
+    "serve",
+};
+
+/* Histograms of every thread, new ones are pushed to the head */
+static _Atomic(struct latency_histogram*) latency_histogram_list = NULL;
+
+/* Bumped by the clear, so the threads do not use the freed histograms */
+static _Atomic uint64_t latency_generation = 1;
+
+static _Thread_local struct latency_slot latency_slot_list[LATENCY_THREAD_SLOTS];
+static _Thread_local int latency_next_slot = 0;
+
+_Thread_local uint32_t latency_call_count = 0;
+
+static int latency_bucket(uint64_t value) {
+    if (value >= ((uint64_t) 1 << LATENCY_VALUE_BITS)) {
+        value = ((uint64_t) 1 << LATENCY_VALUE_BITS) - 1;
+    }
+
+    int exponent = 0;
+
+    while ((value >> exponent) >= (uint64_t) (2 * LATENCY_SUB_BUCKET_COUNT)) {
+        exponent++;
+    }
+
+    return exponent * LATENCY_SUB_BUCKET_COUNT + (int) (value >> exponent);
+}
+
+/**
+ * Highest value of the bucket
+ */
+static uint64_t latency_bucket_value(int bucket) {
+    const int exponent = (bucket < 2 * LATENCY_SUB_BUCKET_COUNT) ? 0 : bucket / LATENCY_SUB_BUCKET_COUNT - 1;
+    const uint64_t sub_bucket = (uint64_t) (bucket - exponent * LATENCY_SUB_BUCKET_COUNT);
+
+    return ((sub_bucket + 1) << exponent) - 1;
+}
+
+static void latency_add_relaxed(_Atomic uint64_t* counter, uint64_t value) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+uint64_t latency_now(void) {
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+void latency_histogram_init(struct latency_histogram* histogram, const void* machine, enum latency_path path) {
+    histogram->machine = machine;
+    histogram->path = path;
+    histogram->owner = NULL;
+    histogram->next = NULL;
+
+    atomic_init(&histogram->total_count, 0);
+    atomic_init(&histogram->max, 0);
+
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        atomic_init(&histogram->count_list[i], 0);
+    }
+}
+
+void latency_histogram_add(struct latency_histogram* histogram, uint64_t value, uint64_t count) {
+    latency_add_relaxed(&histogram->count_list[latency_bucket(value)], count);
+    latency_add_relaxed(&histogram->total_count, count);
+
+    if (value > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+    }
+}
+
+uint64_t latency_histogram_quantile(const struct latency_histogram* histogram, double quantile) {
+    const uint64_t total_count = atomic_load_explicit(&histogram->total_count, memory_order_relaxed);
+
+    if (total_count == 0) {
+        return 0;
+    }
+
+    /* Rank of the event, 1-based */
+    uint64_t rank = (uint64_t) (quantile * (double) total_count + 0.5);
+    uint64_t count = 0;
+
+    rank = (rank < 1) ? 1 : (rank > total_count) ? total_count : rank;
+
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        count += atomic_load_explicit(&histogram->count_list[i], memory_order_relaxed);
+
+        if (count >= rank) {
+            const uint64_t value = latency_bucket_value(i);
+            const uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+
+            return (value < max) ? value : max;
+        }
+    }
+
+    return atomic_load_explicit(&histogram->max, memory_order_relaxed);
+}
+
+/**
+ * Histogram of the calling thread, created and published on the first use.
+ * The slots cache the recent ones, the evicted histogram stays in the list
+ * and is found there again.
+ */
+static struct latency_histogram* latency_thread_histogram(const void* machine, enum latency_path path) {
+    const uint64_t generation = atomic_load_explicit(&latency_generation, memory_order_acquire);
+
+    for (int i = 0; i < LATENCY_THREAD_SLOTS; i++) {
+        const struct latency_slot* slot = &latency_slot_list[i];
+
+        if ((slot->machine == machine) && (slot->path == path) && (slot->generation == generation)) {
+            return slot->histogram;
+        }
+    }
+
+    /* Thread local variable address tells the threads apart, a thread which reuses it reuses the histograms */
+    const void* owner = &latency_next_slot;
+    struct latency_histogram* histogram = atomic_load_explicit(&latency_histogram_list, memory_order_acquire);
+
+    while ((histogram != NULL) &&
+        ((histogram->owner != owner) || (histogram->machine != machine) || (histogram->path != path)))
+    {
+        histogram = histogram->next;
+    }
+
+    if (histogram == NULL) {
+        histogram = (struct latency_histogram*) malloc(sizeof(struct latency_histogram));
+
+        if (histogram == NULL) {
+            return NULL;
+        }
+
+        latency_histogram_init(histogram, machine, path);
+        histogram->owner = owner;
+        histogram->next = atomic_load_explicit(&latency_histogram_list, memory_order_relaxed);
+
+        while (!atomic_compare_exchange_weak_explicit(&latency_histogram_list, &histogram->next, histogram,
+            memory_order_release, memory_order_relaxed))
+        {
+        }
+    }
+
+    latency_slot_list[latency_next_slot] = (struct latency_slot) {
+        .machine = machine,
+        .path = path,
+        .generation = generation,
+        .histogram = histogram,
+    };
+
+    latency_next_slot = (latency_next_slot + 1) % LATENCY_THREAD_SLOTS;
+
+    return histogram;
+}
+
+void latency_record(const void* machine, enum latency_path path, uint64_t start_time, size_t event_count) {
+    const uint64_t elapsed = latency_now() - start_time;
+
+    if (event_count == 0) {
+        return;
+    }
+
+    struct latency_histogram* histogram = latency_thread_histogram(machine, path);
+
+    if (histogram != NULL) {
+        latency_histogram_add(histogram, elapsed / event_count, event_count);
+    }
+}
+
+void latency_summarize(const void* machine, enum latency_path path, struct latency_summary* summary) {
+    struct latency_histogram* merged = (struct latency_histogram*) malloc(sizeof(struct latency_histogram));
+
+    memset(summary, 0, sizeof(struct latency_summary));
+
+    if (merged == NULL) {
+        return;
+    }
+
+    latency_histogram_init(merged, machine, path);
+
+    for (struct latency_histogram* histogram = atomic_load_explicit(&latency_histogram_list, memory_order_acquire);
+        histogram != NULL; histogram = histogram->next)
+    {
+        if ((histogram->machine != machine) || (histogram->path != path)) {
+            continue;
+        }
+
+        for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+            latency_add_relaxed(&merged->count_list[i],
+                atomic_load_explicit(&histogram->count_list[i], memory_order_relaxed));
+        }
+
+        latency_add_relaxed(&merged->total_count, atomic_load_explicit(&histogram->total_count, memory_order_relaxed));
+
+        const uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+
+        if (max > atomic_load_explicit(&merged->max, memory_order_relaxed)) {
+            atomic_store_explicit(&merged->max, max, memory_order_relaxed);
+        }
+    }
+
+    /* Total is summed separately from the buckets, the owners may be recording */
+    uint64_t total_count = 0;
+
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        total_count += atomic_load_explicit(&merged->count_list[i], memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&merged->total_count, total_count, memory_order_relaxed);
+
+    summary->count = total_count;
+    summary->p50 = latency_histogram_quantile(merged, 0.5);
+    summary->p99 = latency_histogram_quantile(merged, 0.99);
+    summary->p999 = latency_histogram_quantile(merged, 0.999);
+    summary->max = atomic_load_explicit(&merged->max, memory_order_relaxed);
+
+    free(merged);
+}
+
+void latency_print(const void* machine, const char* name, FILE* fout) {
+    if (fout == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < LATENCY_PATH_NUM; i++) {
+        struct latency_summary summary;
+        latency_summarize(machine, (enum latency_path) i, &summary);
+
+        if (summary.count == 0) {
+            continue;
+        }
+
+        fprintf(fout, "%s %-8s %12llu events  p50 %8llu ns  p99 %8llu ns  p99.9 %8llu ns  max %10llu ns\n",
+            (name != NULL) ? name : "machine", latency_path_name_list[i], (unsigned long long) summary.count,
+            (unsigned long long) summary.p50, (unsigned long long) summary.p99, (unsigned long long) summary.p999,
+            (unsigned long long) summary.max);
+    }
+}
+
+void latency_clear(void) {
+    struct latency_histogram* histogram = atomic_exchange(&latency_histogram_list, NULL);
+
+    atomic_fetch_add(&latency_generation, 1);
+
+    while (histogram != NULL) {
+        struct latency_histogram* next = histogram->next;
+        free(histogram);
+        histogram = next;
+    }
+}
@@ -0,0 +1,154 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "mem.h"
+#include "lazy.h"
+
+enum machine_status machine_lazy_init(struct machine_lazy* lazy, struct dsml_parser* parser) {
+    if ((lazy == NULL) || (parser == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct machine_instance* machine = &lazy->machine;
+    enum machine_status status = machine_init_lists(machine, parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        return status;
+    }
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        machine->state_list[i].base = LAZY_NO_ROW;
+        machine->state_list[i].verdict = MACHINE_VERDICT_UNDECIDED;
+    }
+
+    lazy->parser = parser;
+    lazy->trans_row = (const struct dsml_trans**) malloc(parser->input_list_size * sizeof(struct dsml_trans*));
+    lazy->trans_table_cap = 0;
+    lazy->row_count = 0;
+
+    machine_lazy_build_row(lazy, machine->entry_state);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+static void machine_lazy_free_parser(struct machine_lazy* lazy) {
+    if (lazy->parser != NULL) {
+        dsml_parser_free(lazy->parser);
+        free(lazy->parser);
+    }
+
+    free(lazy->trans_row);
+
+    lazy->parser = NULL;
+    lazy->trans_row = NULL;
+}
+
+enum machine_status machine_lazy_free(struct machine_lazy* lazy) {
+    if (lazy == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct machine_instance* machine = &lazy->machine;
+
+    machine_lazy_free_parser(lazy);
+
+    /* Table capacity may exceed the used size */
+    mem_free(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table,
+        lazy->trans_table_cap * sizeof(struct machine_trans));
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+    lazy->trans_table_cap = 0;
+
+    return machine_free(machine);
+}
+
+void machine_lazy_build_row(struct machine_lazy* lazy, int state) {
+    struct machine_instance* machine = &lazy->machine;
+    const int input_count = machine->input_list_size;
+
+    if (machine->state_list[state].base != LAZY_NO_ROW) {
+        return;
+    }
+
+    /* Rows are appended whole, the table grows geometrically */
+    if (machine->trans_table_size + input_count > lazy->trans_table_cap) {
+        int new_cap = (lazy->trans_table_cap == 0) ? 16 * input_count : 2 * lazy->trans_table_cap;
+
+        machine->trans_table = (struct machine_trans*) mem_realloc(&machine->mem, MEM_CATEGORY_TABLE,
+            machine->trans_table, lazy->trans_table_cap * sizeof(struct machine_trans),
+            new_cap * sizeof(struct machine_trans));
+        lazy->trans_table_cap = new_cap;
+    }
+
+    const int base = machine->trans_table_size;
+    struct machine_trans* row = &machine->trans_table[base];
+
+    dsml_state_row(lazy->parser, state, lazy->trans_row);
+
+    for (int i = 0; i < input_count; i++) {
+        const struct dsml_trans* trans = lazy->trans_row[i];
+
+        row[i].check = state;
+        row[i].next_state = trans->to_state->id;
+        row[i].output = (trans->output == NULL) ? MACHINE_EMPTY_OUTPUT : trans->output->id;
+    }
+
+    /* Every slot of the row is owned, the default is never taken */
+    machine->state_list[state].default_trans = row[0];
+    machine->state_list[state].base = base;
+    machine->trans_table_size += input_count;
+    lazy->row_count++;
+}
+
+enum machine_status machine_lazy_run(struct machine_lazy* lazy, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    if ((lazy == NULL) || (inputs == NULL) || (outputs == NULL) || (state == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct machine_instance* machine = &lazy->machine;
+    int current_state = *state;
+
+    machine_lazy_build_row(lazy, current_state);
+
+    for (size_t i = 0; i < input_count; i++) {
+        struct machine_trans trans = machine_get_trans(machine, current_state, inputs[i]);
+
+        outputs[i] = trans.output;
+        current_state = trans.next_state;
+
+        /* Rows are built on entry, so the lookup above always hits a built row */
+        if (machine->state_list[current_state].base == LAZY_NO_ROW) {
+            machine_lazy_build_row(lazy, current_state);
+        }
+    }
+
+    *state = current_state;
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_lazy_complete(struct machine_lazy* lazy) {
+    if (lazy == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct machine_instance* machine = &lazy->machine;
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        machine_lazy_build_row(lazy, i);
+    }
+
+    /* Shrink the table so it is freed as an ordinary one */
+    machine->trans_table = (struct machine_trans*) mem_realloc(&machine->mem, MEM_CATEGORY_TABLE,
+        machine->trans_table, lazy->trans_table_cap * sizeof(struct machine_trans),
+        machine->trans_table_size * sizeof(struct machine_trans));
+    lazy->trans_table_cap = machine->trans_table_size;
+
+    machine_lazy_free_parser(lazy);
+
+    return machine_classify_states(machine);
+}
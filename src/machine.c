@@ -4,17 +4,91 @@
 
 #include "dsml.h"
 #include "machine.h"
+#include "mem.h"
+#include "latency.h"
 
-enum machine_status machine_init(struct machine_instance* machine, struct dsml_parser* parser) {
+/**
+ * @struct Parser and the buffer of the state row transitions
+ */
+struct machine_parser_rows {
+    struct dsml_parser* parser;
+    const struct dsml_trans** trans_row;
+    bool is_release;    /* Release transitions of the state once its row is taken */
+};
+
+static void machine_parser_row(void* context, int state, struct machine_trans* row) {
+    struct machine_parser_rows* rows = (struct machine_parser_rows*) context;
+    struct dsml_parser* parser = rows->parser;
+
+    dsml_state_row(parser, state, rows->trans_row);
+
+    for (int i = 0; i < parser->input_list_size; i++) {
+        const struct dsml_trans* trans = rows->trans_row[i];
+
+        row[i].next_state = trans->to_state->id;
+        row[i].output = (trans->output == NULL) ? MACHINE_EMPTY_OUTPUT : trans->output->id;
+    }
+
+    if (rows->is_release) {
+        dsml_release_state_trans(parser, state);
+    }
+}
+
+static const char* machine_move_symbol(struct dsml_parser* parser, const char** symbol, char** pool_ptr) {
+    const size_t size = strlen(*symbol) + 1;
+    char* pool_symbol = *pool_ptr;
+
+    memcpy(pool_symbol, *symbol, size);
+    mem_free_string(&parser->mem, *symbol);
+    *symbol = NULL;
+
+    *pool_ptr += size;
+    return pool_symbol;
+}
+
+/**
+ * Move symbols of the parser to the single pool of the machine, parser strings are freed one by one
+ */
+static void machine_move_symbols(struct machine_instance* machine, struct dsml_parser* parser) {
+    size_t pool_size = 0;
+
+    for (int i = 0; i < parser->input_list_size; i++) {
+        pool_size += strlen(parser->input_list[i]->symbol) + 1;
+    }
+
+    for (int i = 0; i < parser->state_list_size; i++) {
+        pool_size += strlen(parser->state_list[i]->symbol) + 1;
+    }
+
+    for (int i = 0; i < parser->output_list_size; i++) {
+        pool_size += strlen(parser->output_list[i]->symbol) + 1;
+    }
+
+    machine->symbol_pool = (char*) mem_alloc(&machine->mem, MEM_CATEGORY_SYMBOL, pool_size);
+    machine->symbol_pool_size = pool_size;
+
+    char* pool_ptr = machine->symbol_pool;
+
+    for (int i = 0; i < parser->input_list_size; i++) {
+        machine->input_list[i] = machine_move_symbol(parser, &parser->input_list[i]->symbol, &pool_ptr);
+    }
+
+    for (int i = 0; i < parser->state_list_size; i++) {
+        machine->state_list[i].symbol = machine_move_symbol(parser, &parser->state_list[i]->symbol, &pool_ptr);
+    }
+
+    for (int i = 0; i < parser->output_list_size; i++) {
+        machine->output_list[i] = machine_move_symbol(parser, &parser->output_list[i]->symbol, &pool_ptr);
+    }
+}
+
+enum machine_status machine_init_lists(struct machine_instance* machine, struct dsml_parser* parser) {
     if ((machine == NULL) || (parser == NULL)) {
         return MACHINE_STATUS_NULL_PARAM;
     }
 
-    if (!parser->has_estate ||
-        (parser->input_list_size == 0) ||
-        (parser->state_list_size == 0) ||
-        (parser->trans_list_size != (parser->state_list_size * parser->input_list_size)))
-    {
+    /* Every (state, input) pair must be covered by a transition or a rule */
+    if (parser->is_nfa || (dsml_validate_dsm(parser) != DSML_STATUS_SUCCESS)) {
         return MACHINE_STATUS_INVAL_PARSER;
     }
 
@@ -22,90 +96,1359 @@ enum machine_status machine_init(struct machine_instance* machine, struct dsml_p
     machine->state_list_size = parser->state_list_size;
     machine->output_list_size = parser->output_list_size;
 
+    mem_stats_init(&machine->mem);
+
     /* Allocate & initialise Machine Inputs */
-    machine->input_list = (const char**) malloc(machine->input_list_size * sizeof(const char*));
-    for (int i = 0; i < parser->input_list_size; i++) {
-        machine->input_list[i] = strdup(parser->input_list[i]->symbol);
+    machine->input_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->input_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->input_list_size; i++) {
+        machine->input_list[i] = mem_strdup(&machine->mem, parser->input_list[i]->symbol);
     }
 
     /* Allocate & initialise Machine States */
-    machine->state_list = (struct machine_state**) malloc(machine->state_list_size * sizeof(struct machine_state*));
+    machine->state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, machine->state_list_size * sizeof(struct machine_state));
     for (int i = 0; i < machine->state_list_size; i++) {
-        machine->state_list[i] = (struct machine_state*) malloc(sizeof(struct machine_state));
-        machine->state_list[i]->symbol = strdup(parser->state_list[i]->symbol);
-        machine->state_list[i]->trans_table = 
-            (struct machine_trans*) malloc(machine->input_list_size * sizeof(struct machine_trans));
-        machine->state_list[i]->is_final = parser->state_list[i]->is_final;
+        machine->state_list[i].symbol = mem_strdup(&machine->mem, parser->state_list[i]->symbol);
+        machine->state_list[i].is_final = parser->state_list[i]->is_final;
 
         /* Set Entry State for the Machine */
         if (parser->state_list[i]->is_entry) {
-            machine->entry_state = machine->state_list[i];
+            machine->entry_state = i;
         }
     }
 
     /* Allocate & initialise Machine Outputs */
-    machine->output_list = (const char**) malloc(machine->output_list_size * sizeof(const char*));
+    machine->output_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->output_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->output_list_size; i++) {
+        machine->output_list[i] = mem_strdup(&machine->mem, parser->output_list[i]->symbol);
+    }
+
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+
+    /* Inputs of the validated parser are distinct, so the resolver is always built */
+    machine_build_resolver(machine);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_init(struct machine_instance* machine, struct dsml_parser* parser) {
+    enum machine_status status = machine_init_lists(machine, parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        return status;
+    }
+
+    struct machine_parser_rows rows = {
+        .parser = parser,
+        .trans_row = (const struct dsml_trans**) malloc(parser->input_list_size * sizeof(struct dsml_trans*)),
+        .is_release = false,
+    };
+
+    /* Connect Machine states via transitions */
+    status = machine_build_table(machine, machine_parser_row, &rows);
+
+    free(rows.trans_row);
+
+    return status;
+}
+
+enum machine_status machine_init_move(struct machine_instance* machine, struct dsml_parser* parser) {
+    if ((machine == NULL) || (parser == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    enum machine_status status = MACHINE_STATUS_SUCCESS;
+
+    /* Nondeterministic parser is built by `machine_determinize` */
+    if (parser->is_nfa || (dsml_validate_dsm(parser) != DSML_STATUS_SUCCESS)) {
+        status = MACHINE_STATUS_INVAL_PARSER;
+        goto EXIT;
+    }
+
+    machine->input_list_size = parser->input_list_size;
+    machine->state_list_size = parser->state_list_size;
+    machine->output_list_size = parser->output_list_size;
+
+    mem_stats_init(&machine->mem);
+
+    /* Symbols are taken after the table, rows of the ranges are resolved by the state symbols */
+    machine->input_list =
+        (const char**) mem_calloc(&machine->mem, MEM_CATEGORY_LIST, machine->input_list_size, sizeof(const char*));
+    machine->output_list =
+        (const char**) mem_calloc(&machine->mem, MEM_CATEGORY_LIST, machine->output_list_size, sizeof(const char*));
+    machine->state_list = (struct machine_state*)
+        mem_calloc(&machine->mem, MEM_CATEGORY_ENTITY, machine->state_list_size, sizeof(struct machine_state));
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        machine->state_list[i].is_final = parser->state_list[i]->is_final;
+
+        if (parser->state_list[i]->is_entry) {
+            machine->entry_state = i;
+        }
+    }
+
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+
+    machine->resolver.bucket_count = 0;
+    machine->resolver.displace_list = NULL;
+    machine->resolver.slot_list = NULL;
+
+    struct machine_parser_rows rows = {
+        .parser = parser,
+        .trans_row = (const struct dsml_trans**) malloc(parser->input_list_size * sizeof(struct dsml_trans*)),
+        .is_release = true,
+    };
+
+    status = machine_build_table(machine, machine_parser_row, &rows);
+
+    free(rows.trans_row);
+
+    machine_move_symbols(machine, parser);
+    machine_build_resolver(machine);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        machine_free(machine);
+    }
+
+EXIT:
+
+    dsml_parser_free(parser);
+    free(parser);
+    return status;
+}
+
+enum machine_status machine_free(struct machine_instance* machine) {
+    if (machine == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct mem_stats* mem = &machine->mem;
+    struct machine_resolver* resolver = &machine->resolver;
+
+    mem_free(mem, MEM_CATEGORY_TABLE, resolver->displace_list, resolver->bucket_count * sizeof(uint32_t));
+    mem_free(mem, MEM_CATEGORY_TABLE, resolver->slot_list,
+        machine->input_list_size * sizeof(struct machine_resolver_slot));
+
+    /* Pooled symbols are freed at once */
+    if (machine->symbol_pool == NULL) {
+        for (int i = 0; i < machine->input_list_size; i++) {
+            mem_free_string(mem, machine->input_list[i]);
+        }
+
+        for (int i = 0; i < machine->state_list_size; i++) {
+            mem_free_string(mem, machine->state_list[i].symbol);
+        }
+
+        for (int i = 0; i < machine->output_list_size; i++) {
+            mem_free_string(mem, machine->output_list[i]);
+        }
+    }
+
+    mem_free(mem, MEM_CATEGORY_SYMBOL, machine->symbol_pool, machine->symbol_pool_size);
+    mem_free(mem, MEM_CATEGORY_LIST, machine->input_list, machine->input_list_size * sizeof(const char*));
+    mem_free(mem, MEM_CATEGORY_ENTITY, machine->state_list, machine->state_list_size * sizeof(struct machine_state));
+    mem_free(mem, MEM_CATEGORY_LIST, machine->output_list, machine->output_list_size * sizeof(const char*));
+
+    mem_free(mem, MEM_CATEGORY_TABLE, machine->trans_table, machine->trans_table_size * sizeof(struct machine_trans));
+
+    machine->input_list = NULL;
+    machine->state_list = NULL;
+    machine->output_list = NULL;
+    machine->trans_table = NULL;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+
+    resolver->bucket_count = 0;
+    resolver->displace_list = NULL;
+    resolver->slot_list = NULL;
+
+    machine->input_list_size = 0;
+    machine->state_list_size = 0;
+    machine->output_list_size = 0;
+    machine->trans_table_size = 0;
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_stats(const struct machine_instance* machine, struct mem_stats* stats) {
+    if ((machine == NULL) || (stats == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    /* Lists of the machine are allocated exactly, so there is no slack */
+    *stats = machine->mem;
+    stats->slack_bytes = 0;
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+static uint64_t machine_hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static uint64_t machine_hash_int(uint64_t hash, int value) {
+    return (hash ^ (uint64_t) (uint32_t) value) * 0x100000001B3ull;
+}
+
+uint64_t machine_symbol_hash(const char* symbol, size_t length) {
+    return machine_hash_bytes(0xCBF29CE484222325ull, symbol, length);
+}
+
+uint64_t machine_fingerprint(const struct machine_instance* machine) {
+    if (machine == NULL) {
+        return 0;
+    }
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    hash = machine_hash_int(hash, machine->input_list_size);
+    hash = machine_hash_int(hash, machine->state_list_size);
+    hash = machine_hash_int(hash, machine->output_list_size);
+    hash = machine_hash_int(hash, machine->entry_state);
+
+    /* Symbols are hashed with their terminating zero, so "ab" "c" differs from "a" "bc" */
+    for (int i = 0; i < machine->input_list_size; i++) {
+        hash = machine_hash_bytes(hash, machine->input_list[i], strlen(machine->input_list[i]) + 1);
+    }
+
     for (int i = 0; i < machine->output_list_size; i++) {
-        machine->output_list[i] = strdup(parser->output_list[i]);
+        hash = machine_hash_bytes(hash, machine->output_list[i], strlen(machine->output_list[i]) + 1);
     }
 
-    /* Connect Machine states via transitions and set symbols */
-    struct dsml_trans* trans = NULL;
     for (int i = 0; i < machine->state_list_size; i++) {
-        struct machine_state* current_state = machine->state_list[i];
-        const char* state_symbol = current_state->symbol;
-        
-        for (int j = 0; j < machine->input_list; j++) {
-            const char* input_symbol = machine->input_list[i];
-            trans = dsml_get_trans(parser, state_symbol, input_symbol);
-
-            const char* next_state_symbol = trans->to_state->symbol;
-            
-            for (int  k = 0; k < machine->state_list_size; k++) {
-                if (strcmp(next_state_symbol, machine->state_list[k]->symbol) == 0) {
-                    current_state->trans_table[j].next_state = machine->state_list[k];
+        const struct machine_state* state = &machine->state_list[i];
+
+        hash = machine_hash_bytes(hash, state->symbol, strlen(state->symbol) + 1);
+        hash = machine_hash_int(hash, state->is_final);
+
+        for (int j = 0; j < machine->input_list_size; j++) {
+            struct machine_trans trans = machine_get_trans(machine, i, j);
+
+            hash = machine_hash_int(hash, trans.next_state);
+            hash = machine_hash_int(hash, trans.output);
+        }
+    }
+
+    return hash;
+}
+
+enum machine_status machine_run(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    if ((machine == NULL) || (inputs == NULL) || (outputs == NULL) || (state == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    LATENCY_START();
+    int current_state = *state;
+
+    for (size_t i = 0; i < input_count; i++) {
+        struct machine_trans trans = machine_get_trans(machine, current_state, inputs[i]);
+
+        outputs[i] = trans.output;
+        current_state = trans.next_state;
+    }
+
+    *state = current_state;
+
+    LATENCY_STOP(machine, LATENCY_PATH_RUN, input_count);
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_run_count(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    uint64_t* counts, int* state)
+{
+    if ((machine == NULL) || (inputs == NULL) || (counts == NULL) || (state == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    LATENCY_START();
+    int current_state = *state;
+
+    for (size_t i = 0; i < input_count; i++) {
+        struct machine_trans trans = machine_get_trans(machine, current_state, inputs[i]);
+
+        if (trans.output != MACHINE_EMPTY_OUTPUT) {
+            counts[trans.output]++;
+        }
+
+        current_state = trans.next_state;
+    }
+
+    *state = current_state;
+
+    LATENCY_STOP(machine, LATENCY_PATH_RUN, input_count);
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_run_rle(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    struct machine_output_run* runs, size_t run_cap, size_t* run_count, size_t* input_done, int* state)
+{
+    if ((machine == NULL) || (inputs == NULL) || (runs == NULL) || (run_count == NULL) || (input_done == NULL) ||
+        (state == NULL))
+    {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (*run_count > run_cap) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    LATENCY_START();
+    int current_state = *state;
+    size_t current_run_count = *run_count;
+    int last_output = (current_run_count != 0) ? runs[current_run_count - 1].output : MACHINE_EMPTY_OUTPUT;
+    size_t i = 0;
+
+    for (; i < input_count; i++) {
+        struct machine_trans trans = machine_get_trans(machine, current_state, inputs[i]);
+
+        if ((trans.output != last_output) && (trans.output != MACHINE_EMPTY_OUTPUT)) {
+            if (current_run_count == run_cap) {
+                break;
+            }
+
+            runs[current_run_count].output = trans.output;
+            runs[current_run_count].count = 0;
+            current_run_count++;
+            last_output = trans.output;
+        }
+
+        if (trans.output != MACHINE_EMPTY_OUTPUT) {
+            runs[current_run_count - 1].count++;
+        }
+
+        current_state = trans.next_state;
+    }
+
+    *state = current_state;
+    *run_count = current_run_count;
+    *input_done = i;
+
+    LATENCY_STOP(machine, LATENCY_PATH_RUN, i);
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_accept(const struct machine_instance* machine, const int* inputs, size_t input_count,
+    bool* is_accepted)
+{
+    if ((machine == NULL) || (inputs == NULL) || (is_accepted == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    int current_state = machine->entry_state;
+
+    for (size_t i = 0; (i < input_count) && (machine->state_list[current_state].verdict == MACHINE_VERDICT_UNDECIDED); i++) {
+        current_state = machine_get_next_state(machine, current_state, inputs[i]);
+    }
+
+    /* Dead states are never final and accepting traps always are */
+    *is_accepted = machine->state_list[current_state].is_final;
+    return MACHINE_STATUS_SUCCESS;
+}
+
+/* Input Resolver */
+
+static inline uint64_t machine_mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static inline uint64_t machine_mix_word(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Hash the symbol a word at a time and get its zero padded prefix
+ */
+static inline uint64_t machine_resolver_hash(const char* symbol, size_t length, uint64_t seed, uint64_t* prefix) {
+    prefix[0] = 0;
+    prefix[1] = 0;
+    memcpy(prefix, symbol, (length < MACHINE_RESOLVER_PREFIX_LEN) ? length : MACHINE_RESOLVER_PREFIX_LEN);
+
+    uint64_t hash = machine_mix_word(seed, (uint64_t) length);
+    hash = machine_mix_word(hash, prefix[0]);
+    hash = machine_mix_word(hash, prefix[1]);
+
+    for (size_t i = MACHINE_RESOLVER_PREFIX_LEN; i < length; i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        memcpy(&word, symbol + i, (length - i < sizeof(uint64_t)) ? length - i : sizeof(uint64_t));
+        hash = machine_mix_word(hash, word);
+    }
+
+    return machine_mix(hash);
+}
+
+/**
+ * Scale the 32-bit hash to [0, `size`) without division
+ */
+static inline uint32_t machine_resolver_scale(uint64_t hash, uint32_t size) {
+    return (uint32_t) (((hash & 0xFFFFFFFFull) * size) >> 32);
+}
+
+static inline uint32_t machine_resolver_bucket(const struct machine_resolver* resolver, uint64_t hash) {
+    return machine_resolver_scale(hash >> 32, resolver->bucket_count);
+}
+
+static inline uint32_t machine_resolver_slot(uint64_t hash, uint32_t displace, uint32_t slot_count) {
+    return machine_resolver_scale(machine_mix(hash + displace * 0x9E3779B97F4A7C15ull), slot_count);
+}
+
+/**
+ * Check the symbol against its slot: prefix words and length, then the rest of a long symbol
+ */
+static inline int machine_resolver_match(const struct machine_instance* machine, uint32_t slot,
+    const char* symbol, size_t length, const uint64_t* prefix)
+{
+    const struct machine_resolver_slot* entry = &machine->resolver.slot_list[slot];
+
+    if ((entry->length != length) || (entry->prefix[0] != prefix[0]) || (entry->prefix[1] != prefix[1])) {
+        return -1;
+    }
+
+    if ((length > MACHINE_RESOLVER_PREFIX_LEN) && (memcmp(symbol + MACHINE_RESOLVER_PREFIX_LEN,
+        machine->input_list[entry->input] + MACHINE_RESOLVER_PREFIX_LEN, length - MACHINE_RESOLVER_PREFIX_LEN) != 0))
+    {
+        return -1;
+    }
+
+    return entry->input;
+}
+
+/**
+ * Find displacements of the buckets, largest buckets first. False if some bucket does not fit.
+ */
+static bool machine_resolver_place(struct machine_resolver* resolver, const uint64_t* hashes, int input_count,
+    uint32_t* slots)
+{
+    const uint32_t bucket_count = resolver->bucket_count;
+    const uint32_t slot_count = (uint32_t) input_count;
+
+    /* Inputs grouped by bucket */
+    int* bucket_start = (int*) calloc(bucket_count + 1, sizeof(int));
+    int* bucket_inputs = (int*) malloc(input_count * sizeof(int));
+    int* bucket_order = (int*) malloc(bucket_count * sizeof(int));
+    int* size_start = (int*) calloc(input_count + 2, sizeof(int));
+    bool* is_taken = (bool*) calloc(slot_count, sizeof(bool));
+    bool is_placed = true;
+
+    for (int i = 0; i < input_count; i++) {
+        bucket_start[machine_resolver_bucket(resolver, hashes[i]) + 1]++;
+    }
+
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        bucket_start[i + 1] += bucket_start[i];
+    }
+
+    for (int i = 0; i < input_count; i++) {
+        const uint32_t bucket = machine_resolver_bucket(resolver, hashes[i]);
+        bucket_inputs[bucket_start[bucket]++] = i;
+    }
+
+    for (uint32_t i = bucket_count; i > 0; i--) {
+        bucket_start[i] = bucket_start[i - 1];
+    }
+
+    bucket_start[0] = 0;
+
+    /* Counting sort of the buckets by size, descending */
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        size_start[input_count - (bucket_start[i + 1] - bucket_start[i]) + 1]++;
+    }
+
+    for (int i = 0; i <= input_count; i++) {
+        size_start[i + 1] += size_start[i];
+    }
+
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        bucket_order[size_start[input_count - (bucket_start[i + 1] - bucket_start[i])]++] = (int) i;
+    }
+
+    for (uint32_t i = 0; is_placed && (i < bucket_count); i++) {
+        const int bucket = bucket_order[i];
+        const int first = bucket_start[bucket];
+        const int last = bucket_start[bucket + 1];
+        uint32_t displace = 0;
+
+        resolver->displace_list[bucket] = 0;
+
+        if (first == last) {
+            continue;
+        }
+
+        for (; displace < MACHINE_RESOLVER_MAX_DISPLACE; displace++) {
+            int placed_count = 0;
+
+            for (; placed_count < last - first; placed_count++) {
+                const int input = bucket_inputs[first + placed_count];
+                const uint32_t slot = machine_resolver_slot(hashes[input], displace, slot_count);
+
+                if (is_taken[slot]) {
                     break;
                 }
+
+                is_taken[slot] = true;
+                slots[input] = slot;
             }
 
-            const char* output_symbol = trans->output->symbol;
-            if (output_symbol == NULL) {
-                current_state->trans_table[j].output = NULL;
+            if (placed_count == last - first) {
+                break;
             }
-            else {
-                for (int  k = 0; k < machine->output_list_size; k++) {
-                    if (strcmp(output_symbol, machine->output_list[k]) == 0) {
-                        current_state->trans_table[j].output = output_symbol;
-                        break;
-                    }
-                }
+
+            for (int j = 0; j < placed_count; j++) {
+                is_taken[slots[bucket_inputs[first + j]]] = false;
             }
         }
+
+        resolver->displace_list[bucket] = displace;
+        is_placed = (displace < MACHINE_RESOLVER_MAX_DISPLACE);
     }
 
-    return MACHINE_STATUS_SUCCESS;
+    free(bucket_start);
+    free(bucket_inputs);
+    free(bucket_order);
+    free(size_start);
+    free(is_taken);
+
+    return is_placed;
 }
 
-enum machine_status machine_free(struct machine_instance* machine) {
+enum machine_status machine_build_resolver(struct machine_instance* machine) {
     if (machine == NULL) {
         return MACHINE_STATUS_NULL_PARAM;
     }
 
-    for (int  i = 0; i < machine->input_list_size; i++) {
-        free((char*) machine->input_list[i]);
-    }
-    free(machine->input_list);
+    struct machine_resolver* resolver = &machine->resolver;
+    const int input_count = machine->input_list_size;
 
-    for (int i = 0; i < machine->state_list_size; i++) {
-        free((char*) machine->state_list[i]->symbol);
-        free(machine->state_list[i]->trans_table);
+    resolver->seed = 0;
+    resolver->bucket_count = 0;
+    resolver->displace_list = NULL;
+    resolver->slot_list = NULL;
+
+    if (input_count == 0) {
+        return MACHINE_STATUS_SUCCESS;
     }
-    free(machine->state_list);
 
-    for (int i = 0; i < machine->output_list_size; i++) {
-        free((char*) machine->output_list[i]);
+    uint64_t* hashes = (uint64_t*) malloc(input_count * sizeof(uint64_t));
+    uint32_t* slots = (uint32_t*) malloc(input_count * sizeof(uint32_t));
+    uint64_t prefix[MACHINE_RESOLVER_PREFIX_LEN / sizeof(uint64_t)];
+    bool is_placed = false;
+
+    resolver->bucket_count = (uint32_t) (input_count / MACHINE_RESOLVER_BUCKET_SIZE + 1);
+    resolver->displace_list = (uint32_t*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_TABLE, resolver->bucket_count * sizeof(uint32_t));
+
+    /* Another seed redistributes the buckets if some of them cannot be placed */
+    for (int attempt = 0; !is_placed && (attempt < MACHINE_RESOLVER_MAX_ATTEMPTS); attempt++) {
+        resolver->seed = machine_mix(0xCBF29CE484222325ull + (uint64_t) attempt);
+
+        for (int i = 0; i < input_count; i++) {
+            hashes[i] = machine_resolver_hash(machine->input_list[i], strlen(machine->input_list[i]),
+                resolver->seed, prefix);
+        }
+
+        is_placed = machine_resolver_place(resolver, hashes, input_count, slots);
     }
-    free(machine->output_list);
 
-    return MACHINE_STATUS_SUCCESS;
-}
\ No newline at end of file
+    if (is_placed) {
+        resolver->slot_list = (struct machine_resolver_slot*)
+            mem_alloc(&machine->mem, MEM_CATEGORY_TABLE, input_count * sizeof(struct machine_resolver_slot));
+
+        for (int i = 0; i < input_count; i++) {
+            struct machine_resolver_slot* entry = &resolver->slot_list[slots[i]];
+            const size_t length = strlen(machine->input_list[i]);
+
+            machine_resolver_hash(machine->input_list[i], length, resolver->seed, entry->prefix);
+            entry->length = (uint32_t) length;
+            entry->input = i;
+        }
+    }
+    else {
+        /* Duplicate inputs, lookups fall back to the scan */
+        mem_free(&machine->mem, MEM_CATEGORY_TABLE, resolver->displace_list,
+            resolver->bucket_count * sizeof(uint32_t));
+        resolver->displace_list = NULL;
+        resolver->bucket_count = 0;
+    }
+
+    free(hashes);
+    free(slots);
+
+    return is_placed ? MACHINE_STATUS_SUCCESS : MACHINE_STATUS_INVAL_PARAM;
+}
+
+static int machine_scan_input(const struct machine_instance* machine, const char* symbol, size_t length) {
+    for (int i = 0; i < machine->input_list_size; i++) {
+        if ((strlen(machine->input_list[i]) == length) && (memcmp(machine->input_list[i], symbol, length) == 0)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int machine_find_input(const struct machine_instance* machine, const char* symbol, size_t length) {
+    if ((machine == NULL) || (symbol == NULL)) {
+        return -1;
+    }
+
+    const struct machine_resolver* resolver = &machine->resolver;
+
+    if (resolver->slot_list == NULL) {
+        return machine_scan_input(machine, symbol, length);
+    }
+
+    uint64_t prefix[MACHINE_RESOLVER_PREFIX_LEN / sizeof(uint64_t)];
+    const uint64_t hash = machine_resolver_hash(symbol, length, resolver->seed, prefix);
+    const uint32_t displace = resolver->displace_list[machine_resolver_bucket(resolver, hash)];
+
+    return machine_resolver_match(machine, machine_resolver_slot(hash, displace, (uint32_t) machine->input_list_size),
+        symbol, length, prefix);
+}
+
+size_t machine_find_inputs(const struct machine_instance* machine, const char* const* symbols,
+    const size_t* lengths, size_t count, int* inputs)
+{
+    if ((machine == NULL) || (symbols == NULL) || (lengths == NULL) || (inputs == NULL)) {
+        return count;
+    }
+
+    const struct machine_resolver* resolver = &machine->resolver;
+    size_t unknown_count = 0;
+
+    if (resolver->slot_list == NULL) {
+        for (size_t i = 0; i < count; i++) {
+            inputs[i] = machine_scan_input(machine, symbols[i], lengths[i]);
+            unknown_count += (inputs[i] < 0);
+        }
+
+        return unknown_count;
+    }
+
+    /* Slots of the whole block are computed first, so their loads overlap */
+    uint64_t prefix[MACHINE_RESOLVER_BLOCK_SIZE][MACHINE_RESOLVER_PREFIX_LEN / sizeof(uint64_t)];
+    uint32_t slots[MACHINE_RESOLVER_BLOCK_SIZE];
+
+    for (size_t first = 0; first < count; first += MACHINE_RESOLVER_BLOCK_SIZE) {
+        const size_t block_count =
+            (count - first < MACHINE_RESOLVER_BLOCK_SIZE) ? count - first : MACHINE_RESOLVER_BLOCK_SIZE;
+
+        for (size_t i = 0; i < block_count; i++) {
+            const uint64_t hash = machine_resolver_hash(symbols[first + i], lengths[first + i], resolver->seed,
+                prefix[i]);
+            const uint32_t displace = resolver->displace_list[machine_resolver_bucket(resolver, hash)];
+
+            slots[i] = machine_resolver_slot(hash, displace, (uint32_t) machine->input_list_size);
+        }
+
+        for (size_t i = 0; i < block_count; i++) {
+            inputs[first + i] =
+                machine_resolver_match(machine, slots[i], symbols[first + i], lengths[first + i], prefix[i]);
+            unknown_count += (inputs[first + i] < 0);
+        }
+    }
+
+    return unknown_count;
+}
+
+/**
+ * Mark states which reach any state of the `is_final` kind moving backwards
+ * over the reversed transitions
+ */
+static void machine_mark_reaching(const struct machine_instance* machine, const int* pred_start, const int* pred,
+    bool is_final, bool* is_reaching, int* queue)
+{
+    int queue_size = 0;
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        is_reaching[i] = (machine->state_list[i].is_final == is_final);
+
+        if (is_reaching[i]) {
+            queue[queue_size++] = i;
+        }
+    }
+
+    for (int i = 0; i < queue_size; i++) {
+        for (int j = pred_start[queue[i]]; j < pred_start[queue[i] + 1]; j++) {
+            if (!is_reaching[pred[j]]) {
+                is_reaching[pred[j]] = true;
+                queue[queue_size++] = pred[j];
+            }
+        }
+    }
+}
+
+enum machine_status machine_classify_states(struct machine_instance* machine) {
+    if (machine == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    const int state_count = machine->state_list_size;
+
+    if (state_count <= 0) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    /* 
+     * Distinct edges of the state are its default transition and its table
+     * slots, so the reversed graph is built without expanding the rows
+     */
+    int* pred_start = (int*) calloc(state_count + 1, sizeof(int));
+
+    for (int i = 0; i < state_count; i++) {
+        pred_start[machine->state_list[i].default_trans.next_state + 1]++;
+    }
+
+    for (int i = 0; i < machine->trans_table_size; i++) {
+        if (machine->trans_table[i].check != MACHINE_FREE_SLOT) {
+            pred_start[machine->trans_table[i].next_state + 1]++;
+        }
+    }
+
+    for (int i = 0; i < state_count; i++) {
+        pred_start[i + 1] += pred_start[i];
+    }
+
+    int* pred = (int*) malloc((size_t) pred_start[state_count] * sizeof(int));
+    int* pred_fill = (int*) malloc((size_t) state_count * sizeof(int));
+    memcpy(pred_fill, pred_start, (size_t) state_count * sizeof(int));
+
+    for (int i = 0; i < state_count; i++) {
+        pred[pred_fill[machine->state_list[i].default_trans.next_state]++] = i;
+    }
+
+    for (int i = 0; i < machine->trans_table_size; i++) {
+        const struct machine_trans* slot = &machine->trans_table[i];
+
+        if (slot->check != MACHINE_FREE_SLOT) {
+            pred[pred_fill[slot->next_state]++] = slot->check;
+        }
+    }
+
+    bool* reaches_final = (bool*) malloc((size_t) state_count * sizeof(bool));
+    bool* reaches_non_final = (bool*) malloc((size_t) state_count * sizeof(bool));
+
+    machine_mark_reaching(machine, pred_start, pred, true, reaches_final, pred_fill);
+    machine_mark_reaching(machine, pred_start, pred, false, reaches_non_final, pred_fill);
+
+    for (int i = 0; i < state_count; i++) {
+        if (!reaches_final[i]) {
+            machine->state_list[i].verdict = MACHINE_VERDICT_REJECT;
+        }
+        else if (!reaches_non_final[i]) {
+            machine->state_list[i].verdict = MACHINE_VERDICT_ACCEPT;
+        }
+        else {
+            machine->state_list[i].verdict = MACHINE_VERDICT_UNDECIDED;
+        }
+    }
+
+    free(pred_start);
+    free(pred);
+    free(pred_fill);
+    free(reaches_final);
+    free(reaches_non_final);
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+/* Transition Table Compression */
+
+static inline uint64_t machine_trans_key(const struct machine_trans* trans) {
+    return ((uint64_t) (uint32_t) trans->next_state << 32) | (uint32_t) trans->output;
+}
+
+/**
+ * Find the most frequent transition of the row. It becomes the state default
+ * transition so only the rest of the row has to be stored in the table.
+ */
+static struct machine_trans machine_row_mode(const struct machine_trans* row, int row_size,
+    uint64_t* keys, int* counts, int hash_size)
+{
+    int mode_index = 0;
+    int mode_count = 0;
+
+    memset(counts, 0, hash_size * sizeof(int));
+
+    for (int i = 0; i < row_size; i++) {
+        uint64_t key = machine_trans_key(&row[i]);
+        int slot = (int) ((key * 0x9E3779B97F4A7C15ull) >> 40) & (hash_size - 1);
+
+        while ((counts[slot] != 0) && (keys[slot] != key)) {
+            slot = (slot + 1) & (hash_size - 1);
+        }
+
+        keys[slot] = key;
+
+        if (++counts[slot] > mode_count) {
+            mode_count = counts[slot];
+            mode_index = i;
+        }
+    }
+
+    return row[mode_index];
+}
+
+/**
+ * @struct Row of the state which transitions differ from the default one
+ */
+struct machine_sparse_row {
+    int state;
+    int start;
+    int size;
+};
+
+/**
+ * Get the first free slot starting from `slot`, `next_free` links every taken slot to the next one.
+ * Slots from `size` on are free.
+ */
+static int machine_next_free(int* next_free, int size, int slot) {
+    int root = slot;
+
+    while ((root < size) && (next_free[root] != root)) {
+        root = next_free[root];
+    }
+
+    /* Path compression keeps the chains of the taken slots short */
+    while (slot != root) {
+        int next = next_free[slot];
+        next_free[slot] = root;
+        slot = next;
+    }
+
+    return root;
+}
+
+static int machine_sparse_row_compare(const void* lhs, const void* rhs) {
+    const struct machine_sparse_row* lhs_row = (const struct machine_sparse_row*) lhs;
+    const struct machine_sparse_row* rhs_row = (const struct machine_sparse_row*) rhs;
+
+    /* Densest rows first, then by state to keep layout stable */
+    if (lhs_row->size != rhs_row->size) {
+        return (lhs_row->size > rhs_row->size) ? -1 : 1;
+    }
+
+    return (lhs_row->state > rhs_row->state) - (lhs_row->state < rhs_row->state);
+}
+
+enum machine_status machine_build_table(struct machine_instance* machine, machine_row_fn row_fn, void* context) {
+    if ((machine == NULL) || (row_fn == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if ((machine->state_list_size <= 0) || (machine->input_list_size <= 0)) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    const int input_count = machine->input_list_size;
+    const int state_count = machine->state_list_size;
+
+    int hash_size = 1;
+    while (hash_size < 2 * input_count) {
+        hash_size <<= 1;
+    }
+
+    struct machine_trans* row = (struct machine_trans*) malloc(input_count * sizeof(struct machine_trans));
+    uint64_t* hash_keys = (uint64_t*) malloc(hash_size * sizeof(uint64_t));
+    int* hash_counts = (int*) malloc(hash_size * sizeof(int));
+
+    struct machine_sparse_row* sparse_rows =
+        (struct machine_sparse_row*) malloc(state_count * sizeof(struct machine_sparse_row));
+
+    int exception_cap = state_count;
+    int exception_size = 0;
+    int* exception_inputs = (int*) malloc(exception_cap * sizeof(int));
+    struct machine_trans* exceptions = (struct machine_trans*) malloc(exception_cap * sizeof(struct machine_trans));
+
+    /* Split every row into the default transition and exceptions */
+    for (int i = 0; i < state_count; i++) {
+        row_fn(context, i, row);
+
+        struct machine_trans default_trans = machine_row_mode(row, input_count, hash_keys, hash_counts, hash_size);
+        default_trans.check = i;
+        machine->state_list[i].default_trans = default_trans;
+
+        sparse_rows[i].state = i;
+        sparse_rows[i].start = exception_size;
+
+        for (int j = 0; j < input_count; j++) {
+            if ((row[j].next_state == default_trans.next_state) && (row[j].output == default_trans.output)) {
+                continue;
+            }
+
+            if (exception_size == exception_cap) {
+                exception_cap *= 2;
+                exception_inputs = (int*) realloc(exception_inputs, exception_cap * sizeof(int));
+                exceptions = (struct machine_trans*) realloc(exceptions, exception_cap * sizeof(struct machine_trans));
+            }
+
+            exception_inputs[exception_size] = j;
+            exceptions[exception_size] = row[j];
+            exceptions[exception_size].check = i;
+            exception_size++;
+        }
+
+        sparse_rows[i].size = exception_size - sparse_rows[i].start;
+    }
+
+    free(row);
+    free(hash_keys);
+    free(hash_counts);
+
+    /* First-fit row displacement, densest rows first */
+    qsort(sparse_rows, state_count, sizeof(struct machine_sparse_row), machine_sparse_row_compare);
+
+    int check_cap = exception_size + input_count;
+    int* check = (int*) malloc(check_cap * sizeof(int));
+    int* next_free = (int*) malloc(check_cap * sizeof(int));
+
+    for (int i = 0; i < check_cap; i++) {
+        check[i] = MACHINE_FREE_SLOT;
+        next_free[i] = i;
+    }
+
+    int first_free = 0;
+    int end_slot = 0;   /* Slots from it on are all free */
+    int max_base = 0;
+
+    for (int i = 0; i < state_count; i++) {
+        const struct machine_sparse_row* sparse_row = &sparse_rows[i];
+        const int* inputs = &exception_inputs[sparse_row->start];
+
+        if (sparse_row->size == 0) {
+            machine->state_list[sparse_row->state].base = 0;
+            continue;
+        }
+
+        /* Only the bases putting the first exception to a free slot are tried */
+        int slot = machine_next_free(next_free, check_cap, (first_free > inputs[0]) ? first_free : inputs[0]);
+        int base = 0;
+
+        for (int probe = 0;; probe++) {
+            /* Row which does not fit the gaps is appended */
+            base = (probe < MACHINE_PACK_MAX_PROBES) ? slot - inputs[0] :
+                (end_slot > inputs[0]) ? end_slot - inputs[0] : 0;
+
+            if (base + input_count > check_cap) {
+                int new_cap = 2 * (base + input_count);
+                check = (int*) realloc(check, new_cap * sizeof(int));
+                next_free = (int*) realloc(next_free, new_cap * sizeof(int));
+                for (int j = check_cap; j < new_cap; j++) {
+                    check[j] = MACHINE_FREE_SLOT;
+                    next_free[j] = j;
+                }
+                check_cap = new_cap;
+            }
+
+            if (probe == MACHINE_PACK_MAX_PROBES) {
+                break;
+            }
+
+            bool fits = true;
+            for (int j = 1; j < sparse_row->size; j++) {
+                if (check[base + inputs[j]] != MACHINE_FREE_SLOT) {
+                    fits = false;
+                    break;
+                }
+            }
+
+            if (fits) {
+                break;
+            }
+
+            slot = machine_next_free(next_free, check_cap, slot + 1);
+        }
+
+        for (int j = 0; j < sparse_row->size; j++) {
+            check[base + inputs[j]] = sparse_row->state;
+            next_free[base + inputs[j]] = base + inputs[j] + 1;
+        }
+
+        if (base + inputs[sparse_row->size - 1] + 1 > end_slot) {
+            end_slot = base + inputs[sparse_row->size - 1] + 1;
+        }
+
+        first_free = machine_next_free(next_free, check_cap, first_free);
+
+        machine->state_list[sparse_row->state].base = base;
+
+        if (base > max_base) {
+            max_base = base;
+        }
+    }
+
+    /* Every (base + input) index stays inside the table, so lookup needs no bounds check */
+    machine->trans_table_size = max_base + input_count;
+    machine->trans_table = (struct machine_trans*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table_size * sizeof(struct machine_trans));
+
+    for (int i = 0; i < machine->trans_table_size; i++) {
+        machine->trans_table[i].check = MACHINE_FREE_SLOT;
+        machine->trans_table[i].next_state = 0;
+        machine->trans_table[i].output = MACHINE_EMPTY_OUTPUT;
+    }
+
+    for (int i = 0; i < state_count; i++) {
+        const struct machine_sparse_row* sparse_row = &sparse_rows[i];
+        const int base = machine->state_list[sparse_row->state].base;
+
+        for (int j = sparse_row->start; j < sparse_row->start + sparse_row->size; j++) {
+            machine->trans_table[base + exception_inputs[j]] = exceptions[j];
+        }
+    }
+
+    free(check);
+    free(next_free);
+    free(sparse_rows);
+    free(exception_inputs);
+    free(exceptions);
+
+    return machine_classify_states(machine);
+}
+
+/* Minimization */
+
+/**
+ * @struct Dense copy of the machine transitions used by the offline passes
+ */
+struct machine_dense_rows {
+    int input_list_size;
+    const int* next_table;
+    const int* output_table;
+};
+
+static void machine_dense_row(void* context, int state, struct machine_trans* row) {
+    const struct machine_dense_rows* rows = (const struct machine_dense_rows*) context;
+    const int offset = state * rows->input_list_size;
+
+    for (int i = 0; i < rows->input_list_size; i++) {
+        row[i].next_state = rows->next_table[offset + i];
+        row[i].output = rows->output_table[offset + i];
+    }
+}
+
+enum machine_status machine_build_dense(struct machine_instance* machine, const int* next_table, const int* output_table) {
+    if ((machine == NULL) || (next_table == NULL) || (output_table == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    struct machine_dense_rows rows = {
+        .input_list_size = machine->input_list_size,
+        .next_table = next_table,
+        .output_table = output_table,
+    };
+
+    return machine_build_table(machine, machine_dense_row, &rows);
+}
+
+static uint64_t machine_signature_hash(const int* classes, int state, const int* next_table,
+    const int* output_table, int input_count)
+{
+    uint64_t hash = 0xCBF29CE484222325ull ^ (uint64_t) classes[state];
+
+    for (int i = 0; i < input_count; i++) {
+        hash = (hash ^ (uint64_t) (uint32_t) classes[next_table[state * input_count + i]]) * 0x100000001B3ull;
+        hash = (hash ^ (uint64_t) (uint32_t) output_table[state * input_count + i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static bool machine_signature_equal(const int* classes, int lhs, int rhs, const int* next_table,
+    const int* output_table, int input_count)
+{
+    if (classes[lhs] != classes[rhs]) {
+        return false;
+    }
+
+    for (int i = 0; i < input_count; i++) {
+        if ((classes[next_table[lhs * input_count + i]] != classes[next_table[rhs * input_count + i]]) ||
+            (output_table[lhs * input_count + i] != output_table[rhs * input_count + i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+enum machine_status machine_minimize(struct machine_instance* machine) {
+    if (machine == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    const int input_count = machine->input_list_size;
+    const int state_count = machine->state_list_size;
+
+    /* Collect reachable states in BFS order from the entry state */
+    int* order = (int*) malloc(state_count * sizeof(int));
+    int* order_index = (int*) malloc(state_count * sizeof(int));
+
+    for (int i = 0; i < state_count; i++) {
+        order_index[i] = -1;
+    }
+
+    int reachable_count = 0;
+    order[reachable_count] = machine->entry_state;
+    order_index[machine->entry_state] = reachable_count++;
+
+    for (int i = 0; i < reachable_count; i++) {
+        for (int j = 0; j < input_count; j++) {
+            int next_state = machine_get_trans(machine, order[i], j).next_state;
+
+            if (order_index[next_state] < 0) {
+                order[reachable_count] = next_state;
+                order_index[next_state] = reachable_count++;
+            }
+        }
+    }
+
+    /* Dense table over the reachable states */
+    int* next_table = (int*) malloc((size_t) reachable_count * input_count * sizeof(int));
+    int* output_table = (int*) malloc((size_t) reachable_count * input_count * sizeof(int));
+
+    for (int i = 0; i < reachable_count; i++) {
+        for (int j = 0; j < input_count; j++) {
+            struct machine_trans trans = machine_get_trans(machine, order[i], j);
+            next_table[i * input_count + j] = order_index[trans.next_state];
+            output_table[i * input_count + j] = trans.output;
+        }
+    }
+
+    /* Moore partition refinement, starting from final / non-final split */
+    int* classes = (int*) malloc(reachable_count * sizeof(int));
+    int* new_classes = (int*) malloc(reachable_count * sizeof(int));
+
+    int hash_size = 1;
+    while (hash_size < 2 * reachable_count) {
+        hash_size <<= 1;
+    }
+
+    int* hash_slots = (int*) malloc(hash_size * sizeof(int));
+    int class_count = 0;
+
+    for (int i = 0; i < reachable_count; i++) {
+        classes[i] = machine->state_list[order[i]].is_final ? 1 : 0;
+    }
+
+    for (;;) {
+        int new_class_count = 0;
+
+        for (int i = 0; i < hash_size; i++) {
+            hash_slots[i] = -1;
+        }
+
+        for (int i = 0; i < reachable_count; i++) {
+            uint64_t hash = machine_signature_hash(classes, i, next_table, output_table, input_count);
+            int slot = (int) (hash >> 33) & (hash_size - 1);
+
+            while ((hash_slots[slot] >= 0) &&
+                !machine_signature_equal(classes, hash_slots[slot], i, next_table, output_table, input_count))
+            {
+                slot = (slot + 1) & (hash_size - 1);
+            }
+
+            if (hash_slots[slot] < 0) {
+                hash_slots[slot] = i;
+                new_classes[i] = new_class_count++;
+            }
+            else {
+                new_classes[i] = new_classes[hash_slots[slot]];
+            }
+        }
+
+        int* swap = classes;
+        classes = new_classes;
+        new_classes = swap;
+
+        if (new_class_count == class_count) {
+            break;
+        }
+
+        class_count = new_class_count;
+    }
+
+    free(hash_slots);
+    free(new_classes);
+
+    /* 
+     * States are visited in BFS order, so class numbers are assigned in BFS order
+     * of the minimized machine and the first state of the class is its representative
+     */
+    int* representative = (int*) malloc(class_count * sizeof(int));
+
+    for (int i = reachable_count - 1; i >= 0; i--) {
+        representative[classes[i]] = i;
+    }
+
+    int* min_next_table = (int*) malloc((size_t) class_count * input_count * sizeof(int));
+    int* min_output_table = (int*) malloc((size_t) class_count * input_count * sizeof(int));
+
+    for (int i = 0; i < class_count; i++) {
+        for (int j = 0; j < input_count; j++) {
+            min_next_table[i * input_count + j] = classes[next_table[representative[i] * input_count + j]];
+            min_output_table[i * input_count + j] = output_table[representative[i] * input_count + j];
+        }
+    }
+
+    struct machine_state* state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, class_count * sizeof(struct machine_state));
+
+    for (int i = 0; i < class_count; i++) {
+        struct machine_state* old_state = &machine->state_list[order[representative[i]]];
+
+        state_list[i].symbol = old_state->symbol;
+        state_list[i].is_final = old_state->is_final;
+        old_state->symbol = NULL;
+    }
+
+    /* Symbols of the removed states stay in the pool until the machine is freed */
+    for (int i = 0; (machine->symbol_pool == NULL) && (i < state_count); i++) {
+        mem_free_string(&machine->mem, machine->state_list[i].symbol);
+    }
+
+    mem_free(&machine->mem, MEM_CATEGORY_ENTITY, machine->state_list, state_count * sizeof(struct machine_state));
+    mem_free(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table,
+        machine->trans_table_size * sizeof(struct machine_trans));
+
+    machine->state_list = state_list;
+    machine->state_list_size = class_count;
+    machine->entry_state = classes[order_index[machine->entry_state]];
+    machine->trans_table = NULL;
+    machine->trans_table_size = 0;
+
+    enum machine_status status = machine_build_dense(machine, min_next_table, min_output_table);
+
+    free(order);
+    free(order_index);
+    free(next_table);
+    free(output_table);
+    free(classes);
+    free(representative);
+    free(min_next_table);
+    free(min_output_table);
+
+    return status;
+}
+
+/* Script Generation */
+
+/**
+ * Flush `trans` statement keeping the line inside the parser line limit
+ */
+static void machine_write_trans_group(const struct machine_instance* machine, FILE* fout, int state,
+    struct machine_trans trans, const int* inputs, int input_count)
+{
+    const char* output_symbol = (trans.output == MACHINE_EMPTY_OUTPUT) ? "-" : machine->output_list[trans.output];
+    const char* state_symbol = machine->state_list[state].symbol;
+    const char* next_state_symbol = machine->state_list[trans.next_state].symbol;
+
+    const size_t fixed_len = strlen(state_symbol) + strlen(next_state_symbol) + strlen(output_symbol) + 16;
+    int i = 0;
+
+    while (i < input_count) {
+        size_t line_len = fixed_len;
+
+        fprintf(fout, "trans %s :", state_symbol);
+
+        do {
+            fprintf(fout, " %s", machine->input_list[inputs[i]]);
+            line_len += strlen(machine->input_list[inputs[i]]) + 1;
+            i++;
+        } while ((i < input_count) && (line_len + strlen(machine->input_list[inputs[i]]) + 1 < MACHINE_SCRIPT_LINE_LEN));
+
+        fprintf(fout, " : %s : %s\n", next_state_symbol, output_symbol);
+    }
+}
+
+enum machine_status machine_write_script(const struct machine_instance* machine, FILE* fout) {
+    if ((machine == NULL) || (fout == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    for (int i = 0; i < machine->input_list_size; i++) {
+        fprintf(fout, "input %s\n", machine->input_list[i]);
+    }
+
+    fprintf(fout, "\n");
+
+    for (int i = 0; i < machine->output_list_size; i++) {
+        fprintf(fout, "output %s\n", machine->output_list[i]);
+    }
+
+    fprintf(fout, "\n");
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        fprintf(fout, "state %s%s%s\n",
+            (i == machine->entry_state) ? "entry " : "",
+            machine->state_list[i].is_final ? "final " : "",
+            machine->state_list[i].symbol);
+    }
+
+    int* inputs = (int*) malloc(machine->input_list_size * sizeof(int));
+    bool* is_written = (bool*) malloc(machine->input_list_size * sizeof(bool));
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        const struct machine_trans default_trans = machine->state_list[i].default_trans;
+        const int base = machine->state_list[i].base;
+
+        fprintf(fout, "\n");
+
+        /* Group explicit slots of the state by the transition they take */
+        memset(is_written, 0, machine->input_list_size * sizeof(bool));
+
+        for (int j = 0; j < machine->input_list_size; j++) {
+            const struct machine_trans* slot = &machine->trans_table[base + j];
+
+            if (is_written[j] || (slot->check != i)) {
+                continue;
+            }
+
+            int group_size = 0;
+
+            for (int k = j; k < machine->input_list_size; k++) {
+                const struct machine_trans* other = &machine->trans_table[base + k];
+
+                if (!is_written[k] && (other->check == i) &&
+                    (other->next_state == slot->next_state) && (other->output == slot->output))
+                {
+                    inputs[group_size++] = k;
+                    is_written[k] = true;
+                }
+            }
+
+            machine_write_trans_group(machine, fout, i, *slot, inputs, group_size);
+        }
+
+        fprintf(fout, "default %s : %s : %s\n",
+            machine->state_list[i].symbol,
+            machine->state_list[default_trans.next_state].symbol,
+            (default_trans.output == MACHINE_EMPTY_OUTPUT) ? "-" : machine->output_list[default_trans.output]);
+    }
+
+    free(inputs);
+    free(is_written);
+
+    return MACHINE_STATUS_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mem.h"
+
+static const char* mem_category_name_list[MEM_CATEGORY_NUM] = {
+    "symbols",
+    "entities",
+    "lists",
+    "tables",
+};
+
+static void mem_stats_add(struct mem_stats* stats, enum mem_category category, size_t size) {
+    stats->bytes[category] += size;
+    stats->alloc_count[category]++;
+    stats->total_alloc_count++;
+
+    size_t bytes = mem_stats_bytes(stats);
+
+    if (bytes > stats->peak_bytes) {
+        stats->peak_bytes = bytes;
+    }
+}
+
+void mem_stats_init(struct mem_stats* stats) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(struct mem_stats));
+    }
+}
+
+size_t mem_stats_bytes(const struct mem_stats* stats) {
+    size_t bytes = 0;
+
+    for (int i = 0; i < MEM_CATEGORY_NUM; i++) {
+        bytes += stats->bytes[i];
+    }
+
+    return bytes;
+}
+
+void mem_stats_print(const struct mem_stats* stats, FILE* fout) {
+    if ((stats == NULL) || (fout == NULL)) {
+        return;
+    }
+
+    size_t alloc_count = 0;
+
+    for (int i = 0; i < MEM_CATEGORY_NUM; i++) {
+        fprintf(fout, "\t%-10s %12zu bytes %10zu allocations\n",
+            mem_category_name_list[i], stats->bytes[i], stats->alloc_count[i]);
+        alloc_count += stats->alloc_count[i];
+    }
+
+    fprintf(fout, "\t%-10s %12zu bytes\n", "slack", stats->slack_bytes);
+    fprintf(fout, "\t%-10s %12zu bytes %10zu allocations\n", "total", mem_stats_bytes(stats), alloc_count);
+    fprintf(fout, "\t%-10s %12zu bytes %10zu allocations made\n", "peak", stats->peak_bytes,
+        stats->total_alloc_count);
+}
+
+void* mem_alloc(struct mem_stats* stats, enum mem_category category, size_t size) {
+    void* ptr = malloc(size);
+
+    if (ptr != NULL) {
+        mem_stats_add(stats, category, size);
+    }
+
+    return ptr;
+}
+
+void* mem_calloc(struct mem_stats* stats, enum mem_category category, size_t count, size_t size) {
+    void* ptr = calloc(count, size);
+
+    if (ptr != NULL) {
+        mem_stats_add(stats, category, count * size);
+    }
+
+    return ptr;
+}
+
+void* mem_realloc(struct mem_stats* stats, enum mem_category category, void* ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) {
+        return mem_alloc(stats, category, new_size);
+    }
+
+    void* new_ptr = realloc(ptr, new_size);
+
+    if (new_ptr != NULL) {
+        stats->bytes[category] -= old_size;
+        stats->alloc_count[category]--;
+        mem_stats_add(stats, category, new_size);
+    }
+
+    return new_ptr;
+}
+
+char* mem_strdup(struct mem_stats* stats, const char* str) {
+    size_t size = strlen(str) + 1;
+    char* new_str = (char*) mem_alloc(stats, MEM_CATEGORY_SYMBOL, size);
+
+    if (new_str != NULL) {
+        memcpy(new_str, str, size);
+    }
+
+    return new_str;
+}
+
+void mem_free(struct mem_stats* stats, enum mem_category category, void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    stats->bytes[category] -= size;
+    stats->alloc_count[category]--;
+    free(ptr);
+}
+
+void mem_free_string(struct mem_stats* stats, const char* str) {
+    if (str != NULL) {
+        mem_free(stats, MEM_CATEGORY_SYMBOL, (char*) str, strlen(str) + 1);
+    }
+}
@@ -0,0 +1,443 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nfa.h"
+#include "mem.h"
+
+/**
+ * @struct Targets of the script states, `start` is indexed by state * input count + input
+ */
+struct nfa_targets {
+    int* start;
+    int* state_list;
+    int* output_list;
+};
+
+/**
+ * @struct Reachable subsets of the script states.
+ * Sorted members of the subsets are stored one after another in the `member_list`.
+ */
+struct nfa_subsets {
+    int size;
+    int cap;
+    int* start;
+    int* parent_list;           /* Subset and input the subset is first reached by */
+    int* parent_input_list;
+
+    int member_list_size;
+    int member_list_cap;
+    int* member_list;
+
+    /* Open addressing map of the subset hashes, -1 for the free slot */
+    int map_size;
+    uint64_t* hashes;
+    int* positions;
+};
+
+static int nfa_compare_states(const void* lhs, const void* rhs) {
+    return *(const int*) lhs - *(const int*) rhs;
+}
+
+static int nfa_trans_output(const struct dsml_trans* trans) {
+    return (trans->output == NULL) ? MACHINE_EMPTY_OUTPUT : trans->output->id;
+}
+
+/**
+ * Collect targets of every (state, input) pair: all explicit transitions of the
+ * pair if there are any, otherwise the default transition or the rule
+ */
+static void nfa_build_targets(struct nfa_targets* targets, struct dsml_parser* parser) {
+    const int state_count = parser->state_list_size;
+    const int input_count = parser->input_list_size;
+    const size_t pair_count = (size_t) state_count * input_count;
+    const size_t target_cap = pair_count + parser->trans_list_size;
+
+    const struct dsml_trans** row = (const struct dsml_trans**) malloc(input_count * sizeof(struct dsml_trans*));
+    int* cursor = (int*) malloc(input_count * sizeof(int));
+
+    targets->start = (int*) malloc((pair_count + 1) * sizeof(int));
+    targets->state_list = (int*) malloc(target_cap * sizeof(int));
+    targets->output_list = (int*) malloc(target_cap * sizeof(int));
+
+    int target_count = 0;
+
+    for (int i = 0; i < state_count; i++) {
+        const int* positions = NULL;
+        const int trans_count = dsml_state_trans(parser, i, &positions);
+
+        dsml_state_row(parser, i, row);
+        memset(cursor, 0, input_count * sizeof(int));
+
+        for (int j = 0; j < trans_count; j++) {
+            cursor[parser->trans_list[positions[j]]->input->id]++;
+        }
+
+        /* Space is reserved for the explicit transitions, the rest is taken from the row */
+        for (int j = 0; j < input_count; j++) {
+            const int explicit_count = cursor[j];
+
+            targets->start[(size_t) i * input_count + j] = target_count;
+            cursor[j] = target_count;
+
+            if (explicit_count != 0) {
+                target_count += explicit_count;
+            }
+            else if (row[j] != NULL) {
+                targets->state_list[target_count] = row[j]->to_state->id;
+                targets->output_list[target_count] = nfa_trans_output(row[j]);
+                target_count++;
+            }
+        }
+
+        for (int j = 0; j < trans_count; j++) {
+            const struct dsml_trans* trans = parser->trans_list[positions[j]];
+            const int target = cursor[trans->input->id]++;
+
+            targets->state_list[target] = trans->to_state->id;
+            targets->output_list[target] = nfa_trans_output(trans);
+        }
+    }
+
+    targets->start[pair_count] = target_count;
+
+    free(row);
+    free(cursor);
+}
+
+static void nfa_subsets_init(struct nfa_subsets* subsets) {
+    subsets->size = 0;
+    subsets->cap = 16;
+    subsets->start = (int*) malloc((subsets->cap + 1) * sizeof(int));
+    subsets->parent_list = (int*) malloc(subsets->cap * sizeof(int));
+    subsets->parent_input_list = (int*) malloc(subsets->cap * sizeof(int));
+    subsets->start[0] = 0;
+
+    subsets->member_list_size = 0;
+    subsets->member_list_cap = 64;
+    subsets->member_list = (int*) malloc(subsets->member_list_cap * sizeof(int));
+
+    subsets->map_size = 64;
+    subsets->hashes = (uint64_t*) malloc(subsets->map_size * sizeof(uint64_t));
+    subsets->positions = (int*) malloc(subsets->map_size * sizeof(int));
+
+    for (int i = 0; i < subsets->map_size; i++) {
+        subsets->positions[i] = -1;
+    }
+}
+
+static void nfa_subsets_free(struct nfa_subsets* subsets) {
+    free(subsets->start);
+    free(subsets->parent_list);
+    free(subsets->parent_input_list);
+    free(subsets->member_list);
+    free(subsets->hashes);
+    free(subsets->positions);
+}
+
+static void nfa_subsets_grow_map(struct nfa_subsets* subsets) {
+    const int old_size = subsets->map_size;
+    uint64_t* old_hashes = subsets->hashes;
+    int* old_positions = subsets->positions;
+
+    subsets->map_size *= 2;
+    subsets->hashes = (uint64_t*) malloc(subsets->map_size * sizeof(uint64_t));
+    subsets->positions = (int*) malloc(subsets->map_size * sizeof(int));
+
+    for (int i = 0; i < subsets->map_size; i++) {
+        subsets->positions[i] = -1;
+    }
+
+    for (int i = 0; i < old_size; i++) {
+        if (old_positions[i] >= 0) {
+            int slot = (int) (old_hashes[i] & (uint64_t) (subsets->map_size - 1));
+
+            while (subsets->positions[slot] >= 0) {
+                slot = (slot + 1) & (subsets->map_size - 1);
+            }
+
+            subsets->hashes[slot] = old_hashes[i];
+            subsets->positions[slot] = old_positions[i];
+        }
+    }
+
+    free(old_hashes);
+    free(old_positions);
+}
+
+/**
+ * Find the subset of `count` sorted `members` or add it reached from the `parent`
+ * subset by the `input`. Returns -1 if the subset is new and `state_budget` is reached.
+ */
+static int nfa_subsets_find(struct nfa_subsets* subsets, const int* members, int count,
+    int parent, int input, int state_budget)
+{
+    const uint64_t hash = machine_symbol_hash((const char*) members, (size_t) count * sizeof(int));
+    int slot = (int) (hash & (uint64_t) (subsets->map_size - 1));
+
+    while (subsets->positions[slot] >= 0) {
+        const int subset = subsets->positions[slot];
+        const int subset_count = subsets->start[subset + 1] - subsets->start[subset];
+
+        if ((subsets->hashes[slot] == hash) && (subset_count == count) &&
+            (memcmp(&subsets->member_list[subsets->start[subset]], members, count * sizeof(int)) == 0))
+        {
+            return subset;
+        }
+
+        slot = (slot + 1) & (subsets->map_size - 1);
+    }
+
+    if (subsets->size == state_budget) {
+        return -1;
+    }
+
+    if (subsets->size == subsets->cap) {
+        subsets->cap *= 2;
+        subsets->start = (int*) realloc(subsets->start, (subsets->cap + 1) * sizeof(int));
+        subsets->parent_list = (int*) realloc(subsets->parent_list, subsets->cap * sizeof(int));
+        subsets->parent_input_list = (int*) realloc(subsets->parent_input_list, subsets->cap * sizeof(int));
+    }
+
+    while (subsets->member_list_size + count > subsets->member_list_cap) {
+        subsets->member_list_cap *= 2;
+        subsets->member_list = (int*) realloc(subsets->member_list, subsets->member_list_cap * sizeof(int));
+    }
+
+    const int subset = subsets->size++;
+
+    memcpy(&subsets->member_list[subsets->member_list_size], members, count * sizeof(int));
+    subsets->member_list_size += count;
+    subsets->start[subset + 1] = subsets->member_list_size;
+    subsets->parent_list[subset] = parent;
+    subsets->parent_input_list[subset] = input;
+
+    subsets->hashes[slot] = hash;
+    subsets->positions[slot] = subset;
+
+    if (2 * subsets->size >= subsets->map_size) {
+        nfa_subsets_grow_map(subsets);
+    }
+
+    return subset;
+}
+
+static const char* nfa_output_symbol(const struct dsml_parser* parser, int output) {
+    return (output == MACHINE_EMPTY_OUTPUT) ? DSML_EMPTY_OUTPUT_SYMBOL : parser->output_list[output]->symbol;
+}
+
+/**
+ * Report the conflict with the shortest inputs leading to its subset
+ */
+static void nfa_report_conflict(const struct dsml_parser* parser, const struct nfa_subsets* subsets, int subset,
+    const struct nfa_conflict* conflict)
+{
+    fprintf(stderr, "NFA> ERROR: Output conflict on input '%s' after the inputs '",
+        parser->input_list[conflict->input]->symbol);
+
+    int depth = 0;
+
+    for (int i = subset; i != 0; i = subsets->parent_list[i]) {
+        depth++;
+    }
+
+    int* path = (int*) malloc((depth + 1) * sizeof(int));
+
+    for (int i = subset, j = depth; i != 0; i = subsets->parent_list[i]) {
+        path[--j] = subsets->parent_input_list[i];
+    }
+
+    for (int i = 0; i < depth; i++) {
+        fprintf(stderr, (i == 0) ? "%s" : " %s", parser->input_list[path[i]]->symbol);
+    }
+
+    fprintf(stderr, "': state '%s' gives '%s', state '%s' gives '%s'\n",
+        parser->state_list[conflict->state_list[0]]->symbol, nfa_output_symbol(parser, conflict->output_list[0]),
+        parser->state_list[conflict->state_list[1]]->symbol, nfa_output_symbol(parser, conflict->output_list[1]));
+
+    free(path);
+}
+
+enum machine_status machine_determinize(struct machine_instance* machine, struct dsml_parser* parser,
+    int state_budget, struct nfa_conflict* conflict)
+{
+    if ((machine == NULL) || (parser == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (state_budget <= 0) {
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    if (dsml_validate_dsm(parser) != DSML_STATUS_SUCCESS) {
+        return MACHINE_STATUS_INVAL_PARSER;
+    }
+
+    const int state_count = parser->state_list_size;
+    const int input_count = parser->input_list_size;
+
+    struct nfa_targets targets;
+    nfa_build_targets(&targets, parser);
+
+    struct nfa_subsets subsets;
+    nfa_subsets_init(&subsets);
+
+    /* States collected into the next subset are marked with the stamp of the (subset, input) pair */
+    int* members = (int*) malloc(state_count * sizeof(int));
+    unsigned* stamps = (unsigned*) calloc(state_count, sizeof(unsigned));
+    unsigned stamp = 0;
+
+    int table_cap = subsets.cap;
+    int* next_table = (int*) malloc((size_t) table_cap * input_count * sizeof(int));
+    int* output_table = (int*) malloc((size_t) table_cap * input_count * sizeof(int));
+
+    enum machine_status status = MACHINE_STATUS_SUCCESS;
+
+    for (int i = 0; i < state_count; i++) {
+        if (parser->state_list[i]->is_entry) {
+            nfa_subsets_find(&subsets, &i, 1, 0, 0, state_budget);
+            break;
+        }
+    }
+
+    for (int i = 0; i < subsets.size; i++) {
+        if (i == table_cap) {
+            table_cap *= 2;
+            next_table = (int*) realloc(next_table, (size_t) table_cap * input_count * sizeof(int));
+            output_table = (int*) realloc(output_table, (size_t) table_cap * input_count * sizeof(int));
+        }
+
+        for (int j = 0; j < input_count; j++) {
+            int member_count = 0;
+            int output = MACHINE_EMPTY_OUTPUT;
+            int output_state = -1;
+
+            if (++stamp == 0) {
+                memset(stamps, 0, state_count * sizeof(unsigned));
+                stamp = 1;
+            }
+
+            for (int k = subsets.start[i]; k < subsets.start[i + 1]; k++) {
+                const int state = subsets.member_list[k];
+                const size_t pair = (size_t) state * input_count + j;
+
+                for (int t = targets.start[pair]; t < targets.start[pair + 1]; t++) {
+                    if (output_state < 0) {
+                        output = targets.output_list[t];
+                        output_state = state;
+                    }
+                    else if (targets.output_list[t] != output) {
+                        struct nfa_conflict report = {
+                            .input = j,
+                            .state_list = { output_state, state },
+                            .output_list = { output, targets.output_list[t] },
+                        };
+
+                        nfa_report_conflict(parser, &subsets, i, &report);
+
+                        if (conflict != NULL) {
+                            *conflict = report;
+                        }
+
+                        status = MACHINE_STATUS_OUTPUT_CONFLICT;
+                        goto EXIT;
+                    }
+
+                    const int target = targets.state_list[t];
+
+                    if (stamps[target] != stamp) {
+                        stamps[target] = stamp;
+                        members[member_count++] = target;
+                    }
+                }
+            }
+
+            qsort(members, member_count, sizeof(int), nfa_compare_states);
+
+            const int next_subset = nfa_subsets_find(&subsets, members, member_count, i, j, state_budget);
+
+            if (next_subset < 0) {
+                fprintf(stderr, "NFA> ERROR: More than %d states are reachable\n", state_budget);
+                status = MACHINE_STATUS_STATE_BUDGET;
+                goto EXIT;
+            }
+
+            next_table[(size_t) i * input_count + j] = next_subset;
+            output_table[(size_t) i * input_count + j] = output;
+        }
+    }
+
+    /* Deterministic Machine alphabets are the script ones */
+    machine->input_list_size = input_count;
+    machine->state_list_size = subsets.size;
+    machine->output_list_size = parser->output_list_size;
+    machine->entry_state = 0;
+
+    mem_stats_init(&machine->mem);
+
+    machine->input_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->input_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->input_list_size; i++) {
+        machine->input_list[i] = mem_strdup(&machine->mem, parser->input_list[i]->symbol);
+    }
+
+    machine_build_resolver(machine);
+
+    machine->output_list =
+        (const char**) mem_alloc(&machine->mem, MEM_CATEGORY_LIST, machine->output_list_size * sizeof(const char*));
+    for (int i = 0; i < machine->output_list_size; i++) {
+        machine->output_list[i] = mem_strdup(&machine->mem, parser->output_list[i]->symbol);
+    }
+
+    /* Single state subsets keep the script symbol, others are numbered apart from the script states */
+    machine->state_list = (struct machine_state*)
+        mem_alloc(&machine->mem, MEM_CATEGORY_ENTITY, subsets.size * sizeof(struct machine_state));
+
+    int name_number = 0;
+
+    for (int i = 0; i < subsets.size; i++) {
+        const int member_count = subsets.start[i + 1] - subsets.start[i];
+        char buffer[32] = { 0 };
+
+        if (member_count == 1) {
+            machine->state_list[i].symbol =
+                mem_strdup(&machine->mem, parser->state_list[subsets.member_list[subsets.start[i]]]->symbol);
+        }
+        else {
+            do {
+                snprintf(buffer, sizeof(buffer), "q%d", name_number++);
+            } while (dsml_symbol_exists(parser, buffer, DSML_LEXEME_STATE));
+
+            machine->state_list[i].symbol = mem_strdup(&machine->mem, buffer);
+        }
+
+        machine->state_list[i].is_final = false;
+
+        for (int k = subsets.start[i]; k < subsets.start[i + 1]; k++) {
+            machine->state_list[i].is_final |= parser->state_list[subsets.member_list[k]]->is_final;
+        }
+    }
+
+    machine->trans_table = NULL;
+    machine->symbol_pool = NULL;
+    machine->symbol_pool_size = 0;
+    machine->trans_table_size = 0;
+
+    status = machine_build_dense(machine, next_table, output_table);
+
+    if (status == MACHINE_STATUS_SUCCESS) {
+        status = machine_minimize(machine);
+    }
+
+EXIT:
+    free(targets.start);
+    free(targets.state_list);
+    free(targets.output_list);
+    nfa_subsets_free(&subsets);
+    free(members);
+    free(stamps);
+    free(next_table);
+    free(output_table);
+
+    return status;
+}
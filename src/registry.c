@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "dsml.h"
+#include "machine.h"
+#include "mem.h"
+#include "registry.h"
+
+/**
+ * @struct Scripts shared by the compile threads, the next one is taken under the lock
+ */
+struct registry_job {
+    const char* dir_path;
+    struct registry_entry* entry_list;
+    enum machine_status* status_list;
+    int entry_count;
+
+    int next_entry;
+    pthread_mutex_t lock;
+};
+
+static int registry_entry_compare(const void* lhs, const void* rhs) {
+    return strcmp(((const struct registry_entry*) lhs)->name, ((const struct registry_entry*) rhs)->name);
+}
+
+static enum machine_status registry_compile(const char* dir_path, struct registry_entry* entry) {
+    size_t path_size = strlen(dir_path) + strlen(entry->name) + strlen(REGISTRY_SCRIPT_EXT) + 2;
+    char* path = (char*) malloc(path_size);
+
+    snprintf(path, path_size, "%s/%s%s", dir_path, entry->name, REGISTRY_SCRIPT_EXT);
+
+    struct dsml_parser* parser = dsml_parse_script(path);
+    free(path);
+
+    if (parser == NULL) {
+        return MACHINE_STATUS_INVAL_PARSER;
+    }
+
+    enum machine_status status = machine_init_move(&entry->machine, parser);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        return status;
+    }
+
+    status = machine_minimize(&entry->machine);
+
+    if (status != MACHINE_STATUS_SUCCESS) {
+        machine_free(&entry->machine);
+    }
+
+    return status;
+}
+
+static void* registry_job_run(void* arg) {
+    struct registry_job* job = (struct registry_job*) arg;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int entry = job->next_entry++;
+        pthread_mutex_unlock(&job->lock);
+
+        if (entry >= job->entry_count) {
+            break;
+        }
+
+        job->status_list[entry] = registry_compile(job->dir_path, &job->entry_list[entry]);
+    }
+
+    return NULL;
+}
+
+/**
+ * Minimized machines of the same structure have byte-identical tables,
+ * and identical tables can be shared whatever the rest of the machines is
+ */
+static bool registry_table_equal(const struct machine_instance* lhs, const struct machine_instance* rhs) {
+    return (lhs->trans_table_size == rhs->trans_table_size) &&
+        (memcmp(lhs->trans_table, rhs->trans_table, lhs->trans_table_size * sizeof(struct machine_trans)) == 0);
+}
+
+/**
+ * Replace tables equal to an earlier one with the earlier table
+ */
+static void registry_share_tables(struct registry* registry) {
+    const int entry_count = registry->entry_count;
+
+    int hash_size = 1;
+    while (hash_size < 2 * entry_count) {
+        hash_size <<= 1;
+    }
+
+    uint64_t* hash_keys = (uint64_t*) malloc(hash_size * sizeof(uint64_t));
+    int* hash_entries = (int*) malloc(hash_size * sizeof(int));
+
+    for (int i = 0; i < hash_size; i++) {
+        hash_entries[i] = -1;
+    }
+
+    registry->table_count = 0;
+
+    for (int i = 0; i < entry_count; i++) {
+        struct registry_entry* entry = &registry->entry_list[i];
+        const uint64_t hash = machine_symbol_hash((const char*) entry->machine.trans_table,
+            entry->machine.trans_table_size * sizeof(struct machine_trans));
+        int slot = (int) (hash & (uint64_t) (hash_size - 1));
+
+        for (; hash_entries[slot] >= 0; slot = (slot + 1) & (hash_size - 1)) {
+            struct registry_entry* owner = &registry->entry_list[hash_entries[slot]];
+
+            if ((hash_keys[slot] == hash) && registry_table_equal(&owner->machine, &entry->machine)) {
+                break;
+            }
+        }
+
+        if (hash_entries[slot] < 0) {
+            hash_keys[slot] = hash;
+            hash_entries[slot] = i;
+            registry->table_count++;
+            continue;
+        }
+
+        struct machine_instance* machine = &entry->machine;
+
+        mem_free(&machine->mem, MEM_CATEGORY_TABLE, machine->trans_table,
+            machine->trans_table_size * sizeof(struct machine_trans));
+        machine->trans_table = registry->entry_list[hash_entries[slot]].machine.trans_table;
+        entry->is_shared_table = true;
+    }
+
+    free(hash_keys);
+    free(hash_entries);
+}
+
+void registry_init(struct registry* registry) {
+    if (registry == NULL) {
+        return;
+    }
+
+    registry->entry_count = 0;
+    registry->entry_list = NULL;
+    registry->table_count = 0;
+
+    mem_stats_init(&registry->mem);
+}
+
+void registry_free(struct registry* registry) {
+    if (registry == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < registry->entry_count; i++) {
+        struct registry_entry* entry = &registry->entry_list[i];
+
+        /* Shared table is freed with its owner only, its bytes were already released */
+        if (entry->is_shared_table) {
+            entry->machine.trans_table = NULL;
+        }
+
+        machine_free(&entry->machine);
+        mem_free_string(&registry->mem, entry->name);
+    }
+
+    mem_free(&registry->mem, MEM_CATEGORY_LIST, registry->entry_list,
+        registry->entry_count * sizeof(struct registry_entry));
+
+    registry->entry_count = 0;
+    registry->entry_list = NULL;
+    registry->table_count = 0;
+}
+
+enum registry_status registry_load_dir(struct registry* registry, const char* dir_path, int thread_count) {
+    if ((registry == NULL) || (dir_path == NULL)) {
+        return REGISTRY_STATUS_NULL_PARAM;
+    }
+
+    DIR* dir = opendir(dir_path);
+
+    if (dir == NULL) {
+        return REGISTRY_STATUS_SYSTEM_ERROR;
+    }
+
+    /* Collect the script names */
+    const size_t ext_length = strlen(REGISTRY_SCRIPT_EXT);
+    int entry_cap = 16;
+    int entry_count = 0;
+    struct registry_entry* entry_list = (struct registry_entry*)
+        mem_alloc(&registry->mem, MEM_CATEGORY_LIST, entry_cap * sizeof(struct registry_entry));
+    struct dirent* dir_entry = NULL;
+
+    while ((dir_entry = readdir(dir)) != NULL) {
+        const size_t name_length = strlen(dir_entry->d_name);
+
+        if ((name_length <= ext_length) ||
+            (strcmp(dir_entry->d_name + name_length - ext_length, REGISTRY_SCRIPT_EXT) != 0))
+        {
+            continue;
+        }
+
+        if (entry_count == entry_cap) {
+            entry_list = (struct registry_entry*) mem_realloc(&registry->mem, MEM_CATEGORY_LIST, entry_list,
+                entry_cap * sizeof(struct registry_entry), 2 * entry_cap * sizeof(struct registry_entry));
+            entry_cap *= 2;
+        }
+
+        char* name = (char*) mem_alloc(&registry->mem, MEM_CATEGORY_SYMBOL, name_length - ext_length + 1);
+        memcpy(name, dir_entry->d_name, name_length - ext_length);
+        name[name_length - ext_length] = '\0';
+
+        entry_list[entry_count].name = name;
+        entry_list[entry_count].is_shared_table = false;
+        entry_count++;
+    }
+
+    closedir(dir);
+
+    if (entry_count == 0) {
+        mem_free(&registry->mem, MEM_CATEGORY_LIST, entry_list, entry_cap * sizeof(struct registry_entry));
+        return REGISTRY_STATUS_SUCCESS;
+    }
+
+    entry_list = (struct registry_entry*) mem_realloc(&registry->mem, MEM_CATEGORY_LIST, entry_list,
+        entry_cap * sizeof(struct registry_entry), entry_count * sizeof(struct registry_entry));
+
+    /* Compile on the thread pool, the calling thread is one of the workers */
+    if (thread_count <= 0) {
+        long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = (processor_count > 0) ? (int) processor_count : 1;
+    }
+
+    if (thread_count > entry_count) {
+        thread_count = entry_count;
+    }
+
+    struct registry_job job = {
+        .dir_path = dir_path,
+        .entry_list = entry_list,
+        .status_list = (enum machine_status*) malloc(entry_count * sizeof(enum machine_status)),
+        .entry_count = entry_count,
+        .next_entry = 0,
+    };
+
+    pthread_mutex_init(&job.lock, NULL);
+
+    pthread_t* threads = (pthread_t*) malloc(thread_count * sizeof(pthread_t));
+    int started_count = 1;
+
+    for (int i = 1; i < thread_count; i++, started_count++) {
+        if (pthread_create(&threads[i], NULL, registry_job_run, &job) != 0) {
+            break;
+        }
+    }
+
+    registry_job_run(&job);
+
+    for (int i = 1; i < started_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+
+    enum registry_status status = REGISTRY_STATUS_SUCCESS;
+
+    for (int i = 0; i < entry_count; i++) {
+        if (job.status_list[i] != MACHINE_STATUS_SUCCESS) {
+            fprintf(stderr, "REGISTRY> ERROR: Failed to compile '%s'\n", entry_list[i].name);
+            status = REGISTRY_STATUS_INVAL_SCRIPT;
+        }
+    }
+
+    if (status != REGISTRY_STATUS_SUCCESS) {
+        for (int i = 0; i < entry_count; i++) {
+            if (job.status_list[i] == MACHINE_STATUS_SUCCESS) {
+                machine_free(&entry_list[i].machine);
+            }
+
+            mem_free_string(&registry->mem, entry_list[i].name);
+        }
+
+        mem_free(&registry->mem, MEM_CATEGORY_LIST, entry_list, entry_count * sizeof(struct registry_entry));
+        free(job.status_list);
+        return status;
+    }
+
+    free(job.status_list);
+
+    qsort(entry_list, entry_count, sizeof(struct registry_entry), registry_entry_compare);
+
+    registry->entry_list = entry_list;
+    registry->entry_count = entry_count;
+
+    registry_share_tables(registry);
+
+    return REGISTRY_STATUS_SUCCESS;
+}
+
+const struct machine_instance* registry_find(const struct registry* registry, const char* name) {
+    if ((registry == NULL) || (name == NULL)) {
+        return NULL;
+    }
+
+    const struct registry_entry key = { .name = name };
+    const struct registry_entry* entry = (const struct registry_entry*) bsearch(&key, registry->entry_list,
+        registry->entry_count, sizeof(struct registry_entry), registry_entry_compare);
+
+    return (entry == NULL) ? NULL : &entry->machine;
+}
+
+enum registry_status registry_stats(const struct registry* registry, struct mem_stats* stats) {
+    if ((registry == NULL) || (stats == NULL)) {
+        return REGISTRY_STATUS_NULL_PARAM;
+    }
+
+    *stats = registry->mem;
+
+    for (int i = 0; i < registry->entry_count; i++) {
+        const struct mem_stats* machine_mem = &registry->entry_list[i].machine.mem;
+
+        for (int j = 0; j < MEM_CATEGORY_NUM; j++) {
+            stats->bytes[j] += machine_mem->bytes[j];
+            stats->alloc_count[j] += machine_mem->alloc_count[j];
+        }
+
+        stats->total_alloc_count += machine_mem->total_alloc_count;
+    }
+
+    /* Peaks of the machines are not simultaneous, the live total is reported */
+    stats->peak_bytes = mem_stats_bytes(stats);
+    stats->slack_bytes = 0;
+
+    return REGISTRY_STATUS_SUCCESS;
+}
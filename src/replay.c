@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "machine.h"
+#include "token.h"
+#include "replay.h"
+
+/**
+ * @struct Tokenizer over the log chunks keeping the byte offset of the last token end
+ */
+struct replay_reader {
+    FILE* log;
+    char* chunk;
+    uint64_t chunk_offset;
+    uint64_t token_end;
+    bool is_eof;
+    struct tokenizer tokenizer;
+};
+
+static void replay_reader_init(struct replay_reader* reader, FILE* log, uint64_t byte_offset) {
+    reader->log = log;
+    reader->chunk = (char*) malloc(REPLAY_CHUNK_SIZE);
+    reader->chunk_offset = byte_offset;
+    reader->token_end = byte_offset;
+    reader->is_eof = false;
+
+    tokenizer_init(&reader->tokenizer);
+    tokenizer_feed(&reader->tokenizer, reader->chunk, 0);
+}
+
+static void replay_reader_free(struct replay_reader* reader) {
+    free(reader->chunk);
+    reader->chunk = NULL;
+}
+
+/**
+ * Get the next input of the log, `input` is -1 at the end of the log
+ */
+static enum replay_status replay_reader_next(const struct machine_instance* machine, struct replay_reader* reader,
+    int* input)
+{
+    struct tokenizer* tokenizer = &reader->tokenizer;
+    const char* token = NULL;
+    size_t length = 0;
+
+    for (;;) {
+        enum token_status status = tokenizer_next(tokenizer, &token, &length);
+
+        if (status == TOKEN_STATUS_TOO_LONG) {
+            return REPLAY_STATUS_UNKNOWN_SYMBOL;
+        }
+
+        if (status == TOKEN_STATUS_READY) {
+            reader->token_end = reader->chunk_offset + (uint64_t) (tokenizer->data - reader->chunk);
+            break;
+        }
+
+        if (reader->is_eof) {
+            *input = -1;
+            return REPLAY_STATUS_SUCCESS;
+        }
+
+        /* The whole chunk is consumed */
+        reader->chunk_offset += (uint64_t) (tokenizer->data - reader->chunk);
+
+        size_t size = fread(reader->chunk, 1, REPLAY_CHUNK_SIZE, reader->log);
+
+        if (size == 0) {
+            if (ferror(reader->log)) {
+                return REPLAY_STATUS_SYSTEM_ERROR;
+            }
+
+            reader->is_eof = true;
+
+            /* Last token is not followed by a separator */
+            if (tokenizer_finish(tokenizer, &token, &length) == TOKEN_STATUS_READY) {
+                reader->token_end = reader->chunk_offset;
+                break;
+            }
+        }
+
+        tokenizer_feed(tokenizer, reader->chunk, size);
+    }
+
+    *input = machine_find_input(machine, token, length);
+    return (*input < 0) ? REPLAY_STATUS_UNKNOWN_SYMBOL : REPLAY_STATUS_SUCCESS;
+}
+
+static uint64_t replay_log_size(FILE* log) {
+    if (fseek(log, 0, SEEK_END) != 0) {
+        return 0;
+    }
+
+    long size = ftell(log);
+    return (size < 0) ? 0 : (uint64_t) size;
+}
+
+enum replay_status replay_record(const struct machine_instance* machine, FILE* log, FILE* fout,
+    uint64_t interval, const char* index_path)
+{
+    if ((machine == NULL) || (log == NULL)) {
+        return REPLAY_STATUS_NULL_PARAM;
+    }
+
+    if ((index_path != NULL) && (interval == 0)) {
+        return REPLAY_STATUS_INVAL_PARAM;
+    }
+
+    enum replay_status status = REPLAY_STATUS_SUCCESS;
+    struct replay_file_header header;
+    FILE* index_file = NULL;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = REPLAY_FILE_MAGIC;
+    header.version = REPLAY_FILE_VERSION;
+    header.fingerprint = machine_fingerprint(machine);
+    header.interval = interval;
+    header.log_size = replay_log_size(log);
+
+    if (fseek(log, 0, SEEK_SET) != 0) {
+        return REPLAY_STATUS_SYSTEM_ERROR;
+    }
+
+    /* Header is rewritten once the checkpoint count is known */
+    if (index_path != NULL) {
+        index_file = fopen(index_path, "wb");
+
+        if ((index_file == NULL) || (fwrite(&header, sizeof(header), 1, index_file) != 1)) {
+            status = REPLAY_STATUS_SYSTEM_ERROR;
+            goto EXIT;
+        }
+    }
+
+    struct replay_reader reader;
+    replay_reader_init(&reader, log, 0);
+
+    int state = machine->entry_state;
+    int input = -1;
+    uint64_t next_checkpoint = 0;
+
+    for (;;) {
+        if ((index_file != NULL) && (header.symbol_count == next_checkpoint)) {
+            struct replay_checkpoint checkpoint = {
+                .symbol_offset = header.symbol_count,
+                .byte_offset = reader.token_end,
+                .state = state,
+                .reserved = 0,
+            };
+
+            if (fwrite(&checkpoint, sizeof(checkpoint), 1, index_file) != 1) {
+                status = REPLAY_STATUS_SYSTEM_ERROR;
+                break;
+            }
+
+            header.checkpoint_count++;
+            next_checkpoint += interval;
+        }
+
+        status = replay_reader_next(machine, &reader, &input);
+
+        if ((status != REPLAY_STATUS_SUCCESS) || (input < 0)) {
+            break;
+        }
+
+        struct machine_trans trans = machine_get_trans(machine, state, input);
+
+        if (fout != NULL) {
+            fputs((trans.output == MACHINE_EMPTY_OUTPUT) ? "-" : machine->output_list[trans.output], fout);
+            fputc('\n', fout);
+        }
+
+        state = trans.next_state;
+        header.symbol_count++;
+    }
+
+    replay_reader_free(&reader);
+
+    if ((status == REPLAY_STATUS_SUCCESS) && (index_file != NULL)) {
+        if ((fseek(index_file, 0, SEEK_SET) != 0) || (fwrite(&header, sizeof(header), 1, index_file) != 1)) {
+            status = REPLAY_STATUS_SYSTEM_ERROR;
+        }
+    }
+
+EXIT:
+
+    if ((index_file != NULL) && (fclose(index_file) != 0)) {
+        status = REPLAY_STATUS_SYSTEM_ERROR;
+    }
+
+    /* Index of the partially read log is useless */
+    if ((status != REPLAY_STATUS_SUCCESS) && (index_path != NULL)) {
+        remove(index_path);
+    }
+
+    return status;
+}
+
+enum replay_status replay_index_load(struct replay_index* index, const char* index_path,
+    const struct machine_instance* machine, FILE* log)
+{
+    if ((index == NULL) || (index_path == NULL) || (machine == NULL) || (log == NULL)) {
+        return REPLAY_STATUS_NULL_PARAM;
+    }
+
+    enum replay_status status = REPLAY_STATUS_SUCCESS;
+    struct replay_file_header header;
+    FILE* index_file = fopen(index_path, "rb");
+
+    index->checkpoint_list = NULL;
+    index->checkpoint_count = 0;
+
+    if (index_file == NULL) {
+        return REPLAY_STATUS_SYSTEM_ERROR;
+    }
+
+    if (fread(&header, sizeof(header), 1, index_file) != 1) {
+        status = REPLAY_STATUS_INVAL_INDEX;
+        goto EXIT;
+    }
+
+    /* Every checkpoint up to the end of the log is present */
+    if ((header.magic != REPLAY_FILE_MAGIC) || (header.version != REPLAY_FILE_VERSION) ||
+        (header.fingerprint != machine_fingerprint(machine)) || (header.interval == 0) ||
+        (header.log_size != replay_log_size(log)) ||
+        (header.checkpoint_count != header.symbol_count / header.interval + 1))
+    {
+        status = REPLAY_STATUS_INVAL_INDEX;
+        goto EXIT;
+    }
+
+    index->checkpoint_list =
+        (struct replay_checkpoint*) malloc(header.checkpoint_count * sizeof(struct replay_checkpoint));
+
+    if ((index->checkpoint_list == NULL) ||
+        (fread(index->checkpoint_list, sizeof(struct replay_checkpoint), header.checkpoint_count, index_file) !=
+            header.checkpoint_count))
+    {
+        status = REPLAY_STATUS_INVAL_INDEX;
+        goto EXIT;
+    }
+
+    for (uint64_t i = 0; i < header.checkpoint_count; i++) {
+        const struct replay_checkpoint* checkpoint = &index->checkpoint_list[i];
+
+        if ((checkpoint->symbol_offset != i * header.interval) || (checkpoint->byte_offset > header.log_size) ||
+            (checkpoint->state < 0) || (checkpoint->state >= machine->state_list_size))
+        {
+            status = REPLAY_STATUS_INVAL_INDEX;
+            goto EXIT;
+        }
+    }
+
+    index->interval = header.interval;
+    index->symbol_count = header.symbol_count;
+    index->log_size = header.log_size;
+    index->checkpoint_count = header.checkpoint_count;
+
+EXIT:
+
+    fclose(index_file);
+
+    if (status != REPLAY_STATUS_SUCCESS) {
+        replay_index_free(index);
+    }
+
+    return status;
+}
+
+void replay_index_free(struct replay_index* index) {
+    if (index == NULL) {
+        return;
+    }
+
+    free(index->checkpoint_list);
+    index->checkpoint_list = NULL;
+    index->checkpoint_count = 0;
+}
+
+enum replay_status replay_query(const struct machine_instance* machine, const struct replay_index* index,
+    FILE* log, uint64_t first, uint64_t last, int* outputs, int* state)
+{
+    if ((machine == NULL) || (index == NULL) || (log == NULL) || (state == NULL) ||
+        ((outputs == NULL) && (first != last)))
+    {
+        return REPLAY_STATUS_NULL_PARAM;
+    }
+
+    if ((first > last) || (last > index->symbol_count)) {
+        return REPLAY_STATUS_OUT_OF_RANGE;
+    }
+
+    const struct replay_checkpoint* checkpoint = &index->checkpoint_list[first / index->interval];
+
+    if (fseek(log, (long) checkpoint->byte_offset, SEEK_SET) != 0) {
+        return REPLAY_STATUS_SYSTEM_ERROR;
+    }
+
+    enum replay_status status = REPLAY_STATUS_SUCCESS;
+    struct replay_reader reader;
+    replay_reader_init(&reader, log, checkpoint->byte_offset);
+
+    int current_state = checkpoint->state;
+    int input = -1;
+
+    for (uint64_t i = checkpoint->symbol_offset; i < last; i++) {
+        status = replay_reader_next(machine, &reader, &input);
+
+        if (status != REPLAY_STATUS_SUCCESS) {
+            break;
+        }
+
+        /* Log is shorter than the index says */
+        if (input < 0) {
+            status = REPLAY_STATUS_INVAL_INDEX;
+            break;
+        }
+
+        struct machine_trans trans = machine_get_trans(machine, current_state, input);
+
+        if (i >= first) {
+            outputs[i - first] = trans.output;
+        }
+
+        current_state = trans.next_state;
+    }
+
+    replay_reader_free(&reader);
+
+    if (status == REPLAY_STATUS_SUCCESS) {
+        *state = current_state;
+    }
+
+    return status;
+}
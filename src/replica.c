@@ -0,0 +1,282 @@
+/* MAP_HUGETLB, MADV_HUGEPAGE and syscall() */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "machine.h"
+#include "replica.h"
+
+#define REPLICA_NODE_LIST_PATH "/sys/devices/system/node/online"
+
+static size_t replica_align(size_t size, size_t align) {
+    return (size + align - 1) & ~(align - 1);
+}
+
+/**
+ * Read the online nodes, "0-1,3" form. Single node 0 if the list is not available.
+ * Returns the highest online node plus one.
+ */
+static int replica_online_nodes(bool* online_list) {
+    FILE* fin = fopen(REPLICA_NODE_LIST_PATH, "r");
+    char buffer[256] = { 0 };
+    int node_count = 0;
+
+    memset(online_list, 0, REPLICA_MAX_NODES * sizeof(bool));
+
+    if ((fin != NULL) && (fgets(buffer, sizeof(buffer), fin) != NULL)) {
+        char* position = buffer;
+
+        while ((*position >= '0') && (*position <= '9')) {
+            long first = strtol(position, &position, 10);
+            long last = first;
+
+            if (*position == '-') {
+                last = strtol(position + 1, &position, 10);
+            }
+
+            for (long i = first; (i <= last) && (i < REPLICA_MAX_NODES); i++) {
+                online_list[i] = true;
+                node_count = (int) i + 1;
+            }
+
+            if (*position == ',') {
+                position++;
+            }
+        }
+    }
+
+    if (fin != NULL) {
+        fclose(fin);
+    }
+
+    if (node_count == 0) {
+        online_list[0] = true;
+        node_count = 1;
+    }
+
+    return node_count;
+}
+
+/**
+ * Map `size` bytes aligned to the huge page: hugetlbfs pages if `is_huge`
+ * and the pool has them, else anonymous pages advised to be transparent huge ones
+ */
+static void* replica_map(size_t size, bool is_huge, size_t* map_size, enum replica_pages* pages) {
+    if (is_huge) {
+        *map_size = replica_align(size, REPLICA_HUGE_PAGE_SIZE);
+
+        void* map = mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (map != MAP_FAILED) {
+            *pages = REPLICA_PAGES_HUGE;
+            return map;
+        }
+    }
+
+    *map_size = replica_align(size, (size_t) sysconf(_SC_PAGESIZE));
+    *pages = REPLICA_PAGES_SMALL;
+
+    if (!is_huge) {
+        void* map = mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (map != MAP_FAILED) ? map : NULL;
+    }
+
+    /* Transparent huge pages need the range aligned, the slack around it is unmapped */
+    *map_size = replica_align(size, REPLICA_HUGE_PAGE_SIZE);
+
+    const size_t reserve_size = *map_size + REPLICA_HUGE_PAGE_SIZE;
+    char* reserve = (char*) mmap(NULL, reserve_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (reserve == MAP_FAILED) {
+        return NULL;
+    }
+
+    char* map = (char*) replica_align((size_t) reserve, REPLICA_HUGE_PAGE_SIZE);
+    const size_t head_size = (size_t) (map - reserve);
+
+    if (head_size != 0) {
+        munmap(reserve, head_size);
+    }
+
+    munmap(map + *map_size, REPLICA_HUGE_PAGE_SIZE - head_size);
+
+    if (madvise(map, *map_size, MADV_HUGEPAGE) == 0) {
+        *pages = REPLICA_PAGES_TRANSPARENT;
+    }
+
+    return map;
+}
+
+/**
+ * Prefer the node for the pages of the mapping, they are not touched yet
+ */
+static bool replica_bind(void* map, size_t map_size, int node) {
+    unsigned long node_mask[(REPLICA_MAX_NODES + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))];
+
+    memset(node_mask, 0, sizeof(node_mask));
+    node_mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+
+    /* The kernel takes the mask size plus one */
+    return syscall(SYS_mbind, map, map_size, MPOL_PREFERRED, node_mask, 8 * sizeof(node_mask) + 1, 0) == 0;
+}
+
+static enum replica_status replica_init(struct replica* replica, const struct machine_instance* machine,
+    int node, bool is_huge)
+{
+    const size_t state_list_size = (size_t) machine->state_list_size * sizeof(struct machine_state);
+    const size_t table_offset = replica_align(state_list_size, 64);
+    const size_t table_size = (size_t) machine->trans_table_size * sizeof(struct machine_trans);
+
+    replica->machine = *machine;
+    replica->node = node;
+    replica->is_bound = false;
+
+    replica->map = replica_map(table_offset + table_size, is_huge, &replica->map_size, &replica->pages);
+
+    if (replica->map == NULL) {
+        fprintf(stderr, "REPLICA> ERROR: Failed to map %zu bytes\n", table_offset + table_size);
+        return REPLICA_STATUS_SYSTEM_ERROR;
+    }
+
+    if (node >= 0) {
+        replica->is_bound = replica_bind(replica->map, replica->map_size, node);
+    }
+
+    /* First touch, the pages are placed by the policy */
+    char* bytes = (char*) replica->map;
+
+    memcpy(bytes, machine->state_list, state_list_size);
+    memcpy(bytes + table_offset, machine->trans_table, table_size);
+
+    replica->machine.state_list = (struct machine_state*) bytes;
+    replica->machine.trans_table = (struct machine_trans*) (bytes + table_offset);
+
+    /* Symbols, lists and the resolver stay with the source */
+    mem_stats_init(&replica->machine.mem);
+
+    return REPLICA_STATUS_SUCCESS;
+}
+
+enum replica_status replica_set_init(struct replica_set* set, const struct machine_instance* machine, uint32_t flags) {
+    if ((set == NULL) || (machine == NULL)) {
+        return REPLICA_STATUS_NULL_PARAM;
+    }
+
+    bool online_list[REPLICA_MAX_NODES];
+    enum replica_status status = REPLICA_STATUS_SUCCESS;
+
+    const bool is_huge = (flags & REPLICA_FLAG_HUGE_PAGES) != 0;
+    int online_count = 0;
+
+    set->source = machine;
+    set->replica_count = 0;
+    set->node_count = replica_online_nodes(online_list);
+
+    for (int i = 0; i < set->node_count; i++) {
+        online_count += online_list[i];
+    }
+
+    const bool is_per_node = ((flags & REPLICA_FLAG_PER_NODE) != 0) && (online_count > 1);
+
+    set->replica_list = (struct replica*) calloc(is_per_node ? online_count : 1, sizeof(struct replica));
+    set->node_replica_list = (int*) calloc(set->node_count, sizeof(int));
+
+    if ((set->replica_list == NULL) || (set->node_replica_list == NULL)) {
+        status = REPLICA_STATUS_SYSTEM_ERROR;
+        goto EXIT;
+    }
+
+    if (!is_per_node && !is_huge) {
+        /* Nothing to copy, every node reads the source */
+        set->replica_list[0].machine = *machine;
+        set->replica_list[0].node = -1;
+        set->replica_list[0].pages = REPLICA_PAGES_SHARED;
+        mem_stats_init(&set->replica_list[0].machine.mem);
+        set->replica_count = 1;
+
+        goto EXIT;
+    }
+
+    if (!is_per_node) {
+        status = replica_init(&set->replica_list[0], machine, -1, is_huge);
+        set->replica_count = (status == REPLICA_STATUS_SUCCESS);
+
+        goto EXIT;
+    }
+
+    for (int i = 0; i < set->node_count; i++) {
+        if (!online_list[i]) {
+            continue;
+        }
+
+        status = replica_init(&set->replica_list[set->replica_count], machine, i, is_huge);
+
+        if (status != REPLICA_STATUS_SUCCESS) {
+            goto EXIT;
+        }
+
+        set->node_replica_list[i] = set->replica_count++;
+    }
+
+EXIT:
+    if (status != REPLICA_STATUS_SUCCESS) {
+        replica_set_free(set);
+    }
+
+    return status;
+}
+
+enum replica_status replica_set_free(struct replica_set* set) {
+    if (set == NULL) {
+        return REPLICA_STATUS_NULL_PARAM;
+    }
+
+    for (int i = 0; (set->replica_list != NULL) && (i < set->replica_count); i++) {
+        if (set->replica_list[i].map != NULL) {
+            munmap(set->replica_list[i].map, set->replica_list[i].map_size);
+        }
+    }
+
+    free(set->replica_list);
+    free(set->node_replica_list);
+
+    set->replica_list = NULL;
+    set->node_replica_list = NULL;
+    set->replica_count = 0;
+    set->node_count = 0;
+
+    return REPLICA_STATUS_SUCCESS;
+}
+
+const struct machine_instance* replica_set_get(const struct replica_set* set, int node) {
+    if ((set == NULL) || (set->replica_count == 0)) {
+        return NULL;
+    }
+
+    if ((node < 0) || (node >= set->node_count)) {
+        return &set->replica_list[0].machine;
+    }
+
+    return &set->replica_list[set->node_replica_list[node]].machine;
+}
+
+const struct machine_instance* replica_set_local(const struct replica_set* set) {
+    return replica_set_get(set, replica_current_node());
+}
+
+int replica_current_node(void) {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+        return 0;
+    }
+
+    return (int) node;
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>
+
+#include "runner.h"
+
+/**
+ * Step on the text token the tokenizer returned
+ */
+static enum runner_status machine_runner_step_text(struct machine_runner* runner, enum token_status token_status,
+    const char* token, size_t length, int* output)
+{
+    if (token_status == TOKEN_STATUS_NEED_INPUT) {
+        return RUNNER_STATUS_NEED_INPUT;
+    }
+
+    if (token_status == TOKEN_STATUS_TOO_LONG) {
+        return RUNNER_STATUS_TOO_LONG;
+    }
+
+    const int input = machine_find_input(runner->machine, token, length);
+
+    if (input < 0) {
+        return RUNNER_STATUS_UNKNOWN_INPUT;
+    }
+
+    struct machine_trans trans = machine_get_trans(runner->machine, runner->state, input);
+
+    runner->state = trans.next_state;
+    runner->step_count++;
+
+    *output = trans.output;
+    return RUNNER_STATUS_READY;
+}
+
+void machine_runner_init(struct machine_runner* runner, const struct machine_instance* machine) {
+    runner->machine = machine;
+    machine_runner_resume(runner, machine->entry_state, 0);
+}
+
+void machine_runner_resume(struct machine_runner* runner, int state, uint64_t step_count) {
+    runner->state = state;
+    runner->step_count = step_count;
+
+    runner->inputs = NULL;
+    runner->input_count = 0;
+
+    tokenizer_init(&runner->tokenizer);
+}
+
+void machine_runner_feed_inputs(struct machine_runner* runner, const int* inputs, size_t input_count) {
+    runner->inputs = inputs;
+    runner->input_count = input_count;
+}
+
+void machine_runner_feed_text(struct machine_runner* runner, const char* data, size_t size) {
+    tokenizer_feed(&runner->tokenizer, data, size);
+}
+
+enum runner_status machine_runner_next(struct machine_runner* runner, int* output) {
+    if ((runner == NULL) || (output == NULL)) {
+        return RUNNER_STATUS_NULL_PARAM;
+    }
+
+    if (runner->input_count != 0) {
+        struct machine_trans trans = machine_get_trans(runner->machine, runner->state, *runner->inputs);
+
+        runner->inputs++;
+        runner->input_count--;
+        runner->state = trans.next_state;
+        runner->step_count++;
+
+        *output = trans.output;
+        return RUNNER_STATUS_READY;
+    }
+
+    const char* token = NULL;
+    size_t length = 0;
+
+    enum token_status token_status = tokenizer_next(&runner->tokenizer, &token, &length);
+    return machine_runner_step_text(runner, token_status, token, length, output);
+}
+
+enum runner_status machine_runner_pull(struct machine_runner* runner, int* outputs, size_t output_cap,
+    size_t* output_count)
+{
+    if ((runner == NULL) || (outputs == NULL) || (output_count == NULL)) {
+        return RUNNER_STATUS_NULL_PARAM;
+    }
+
+    size_t count = 0;
+    enum runner_status status = RUNNER_STATUS_READY;
+
+    /* Identifier chunk is run in one go */
+    if (runner->input_count != 0) {
+        count = (runner->input_count < output_cap) ? runner->input_count : output_cap;
+
+        machine_run(runner->machine, runner->inputs, count, outputs, &runner->state);
+
+        runner->inputs += count;
+        runner->input_count -= count;
+        runner->step_count += count;
+    }
+
+    while ((count < output_cap) && (status == RUNNER_STATUS_READY)) {
+        status = machine_runner_next(runner, &outputs[count]);
+        count += (status == RUNNER_STATUS_READY);
+    }
+
+    *output_count = count;
+    return status;
+}
+
+enum runner_status machine_runner_finish(struct machine_runner* runner, int* output) {
+    if ((runner == NULL) || (output == NULL)) {
+        return RUNNER_STATUS_NULL_PARAM;
+    }
+
+    const char* token = NULL;
+    size_t length = 0;
+
+    enum token_status token_status = tokenizer_finish(&runner->tokenizer, &token, &length);
+    return machine_runner_step_text(runner, token_status, token, length, output);
+}
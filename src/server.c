@@ -0,0 +1,602 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "machine.h"
+#include "token.h"
+#include "server.h"
+#include "latency.h"
+
+static enum server_status server_set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if ((flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+enum server_status server_init(struct server* server, const struct machine_instance* machine) {
+    if ((server == NULL) || (machine == NULL)) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    server->epoll_fd = epoll_create1(0);
+
+    if (server->epoll_fd < 0) {
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    server->machine = machine;
+    server->listen_fd = -1;
+    server->is_running = 0;
+    server->connections = NULL;
+    server->connection_count = 0;
+    server->ready_connections = NULL;
+    server->dead_connections = NULL;
+    server->event_count = 0;
+    server->read_buffer = (char*) malloc(SERVER_READ_SIZE);
+
+    server->reply_list = (char**) malloc((machine->output_list_size + 1) * sizeof(char*));
+    server->reply_len_list = (size_t*) malloc((machine->output_list_size + 1) * sizeof(size_t));
+
+    for (int i = 0; i <= machine->output_list_size; i++) {
+        const char* symbol = (i == 0) ? "-" : machine->output_list[i - 1];
+        size_t symbol_len = strlen(symbol);
+
+        server->reply_list[i] = (char*) malloc(symbol_len + 2);
+        memcpy(server->reply_list[i], symbol, symbol_len);
+        server->reply_list[i][symbol_len] = '\n';
+        server->reply_list[i][symbol_len + 1] = '\0';
+        server->reply_len_list[i] = symbol_len + 1;
+    }
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+static void server_close_connection(struct server* server, struct server_connection* connection) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd_in, NULL);
+    close(connection->fd_in);
+
+    if (connection->fd_out != connection->fd_in) {
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd_out, NULL);
+        close(connection->fd_out);
+    }
+
+    if (connection->prev != NULL) {
+        connection->prev->next = connection->next;
+    }
+    else {
+        server->connections = connection->next;
+    }
+
+    if (connection->next != NULL) {
+        connection->next->prev = connection->prev;
+    }
+
+    server->connection_count--;
+
+    if (connection->is_always_ready) {
+        if (connection->ready_prev != NULL) {
+            connection->ready_prev->ready_next = connection->ready_next;
+        }
+        else {
+            server->ready_connections = connection->ready_next;
+        }
+
+        if (connection->ready_next != NULL) {
+            connection->ready_next->ready_prev = connection->ready_prev;
+        }
+    }
+
+    free(connection->pending);
+    free(connection);
+}
+
+enum server_status server_free(struct server* server) {
+    if (server == NULL) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    while (server->connections != NULL) {
+        server_close_connection(server, server->connections);
+    }
+
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+    }
+
+    close(server->epoll_fd);
+
+    for (int i = 0; i <= server->machine->output_list_size; i++) {
+        free(server->reply_list[i]);
+    }
+
+    free(server->reply_list);
+    free(server->reply_len_list);
+    free(server->read_buffer);
+
+    server->reply_list = NULL;
+    server->reply_len_list = NULL;
+    server->read_buffer = NULL;
+    server->listen_fd = -1;
+    server->epoll_fd = -1;
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+enum server_status server_listen(struct server* server, const char* path) {
+    if ((server == NULL) || (path == NULL)) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    strcpy(address.sun_path, path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listen_fd < 0) {
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    unlink(path);
+
+    if ((server_set_nonblocking(listen_fd) != SERVER_STATUS_SUCCESS) ||
+        (bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) < 0) ||
+        (listen(listen_fd, SOMAXCONN) < 0))
+    {
+        close(listen_fd);
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+        close(listen_fd);
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    server->listen_fd = listen_fd;
+    return SERVER_STATUS_SUCCESS;
+}
+
+enum server_status server_add_connection(struct server* server, int fd_in, int fd_out) {
+    if (server == NULL) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    if ((server_set_nonblocking(fd_in) != SERVER_STATUS_SUCCESS) ||
+        (server_set_nonblocking(fd_out) != SERVER_STATUS_SUCCESS))
+    {
+        return SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    struct server_connection* connection = (struct server_connection*) malloc(sizeof(struct server_connection));
+
+    connection->fd_in = fd_in;
+    connection->fd_out = fd_out;
+    connection->state = server->machine->entry_state;
+    connection->in_endpoint.connection = connection;
+    connection->in_endpoint.is_output = false;
+    connection->out_endpoint.connection = connection;
+    connection->out_endpoint.is_output = true;
+    connection->pending = NULL;
+    connection->pending_size = 0;
+    connection->pending_cap = 0;
+    connection->is_input_closed = false;
+    connection->is_input_paused = false;
+    connection->is_always_ready = false;
+    connection->is_dead = false;
+    connection->ready_prev = NULL;
+    connection->ready_next = NULL;
+    connection->dead_next = NULL;
+    tokenizer_init(&connection->tokenizer);
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = &connection->in_endpoint };
+
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd_in, &event) < 0) {
+        if (errno != EPERM) {
+            free(connection);
+            return SERVER_STATUS_SYSTEM_ERROR;
+        }
+
+        /* Regular file can not be polled, reading it never blocks */
+        connection->is_always_ready = true;
+    }
+
+    connection->prev = NULL;
+    connection->next = server->connections;
+
+    if (server->connections != NULL) {
+        server->connections->prev = connection;
+    }
+
+    server->connections = connection;
+    server->connection_count++;
+
+    if (connection->is_always_ready) {
+        connection->ready_next = server->ready_connections;
+
+        if (server->ready_connections != NULL) {
+            server->ready_connections->ready_prev = connection;
+        }
+
+        server->ready_connections = connection;
+    }
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+/**
+ * Watch `fd_out` for writability while there are pending replies
+ */
+static void server_watch_output(struct server* server, struct server_connection* connection, bool is_watching) {
+    if (connection->fd_out == connection->fd_in) {
+        struct epoll_event event = {
+            .events = (connection->is_input_paused ? 0 : EPOLLIN) | (is_watching ? EPOLLOUT : 0),
+            .data.ptr = &connection->in_endpoint,
+        };
+
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd_in, &event);
+    }
+    else {
+        struct epoll_event event = { .events = EPOLLOUT, .data.ptr = &connection->out_endpoint };
+
+        epoll_ctl(server->epoll_fd, is_watching ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, connection->fd_out, &event);
+    }
+}
+
+/**
+ * Stop reading the input of the peer which does not read its replies, and resume
+ */
+static void server_pause_input(struct server* server, struct server_connection* connection, bool is_paused) {
+    connection->is_input_paused = is_paused;
+
+    if (connection->fd_out == connection->fd_in) {
+        server_watch_output(server, connection, connection->pending_size != 0);
+    }
+    else {
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = &connection->in_endpoint };
+
+        epoll_ctl(server->epoll_fd, is_paused ? EPOLL_CTL_DEL : EPOLL_CTL_ADD, connection->fd_in, &event);
+    }
+}
+
+static void server_append_pending(struct server_connection* connection, const char* data, size_t size) {
+    if (connection->pending_size + size > connection->pending_cap) {
+        connection->pending_cap = 2 * (connection->pending_size + size);
+        connection->pending = (char*) realloc(connection->pending, connection->pending_cap);
+    }
+
+    memcpy(connection->pending + connection->pending_size, data, size);
+    connection->pending_size += size;
+}
+
+/**
+ * Write gathered replies with one `writev`, whatever is not accepted goes to pending
+ */
+static bool server_flush_replies(struct server* server, struct server_connection* connection,
+    struct iovec* iov, int iov_count)
+{
+    if (iov_count == 0) {
+        return true;
+    }
+
+    size_t written = 0;
+
+    if (connection->pending_size == 0) {
+        ssize_t result = writev(connection->fd_out, iov, iov_count);
+
+        if (result < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                return false;
+            }
+        }
+        else {
+            written = (size_t) result;
+        }
+    }
+
+    bool was_pending = (connection->pending_size != 0);
+
+    for (int i = 0; i < iov_count; i++) {
+        if (written >= iov[i].iov_len) {
+            written -= iov[i].iov_len;
+            continue;
+        }
+
+        server_append_pending(connection, (const char*) iov[i].iov_base + written, iov[i].iov_len - written);
+        written = 0;
+    }
+
+    if (!was_pending && (connection->pending_size != 0)) {
+        server_watch_output(server, connection, true);
+    }
+
+    return true;
+}
+
+static bool server_write_pending(struct server* server, struct server_connection* connection) {
+    while (connection->pending_size != 0) {
+        ssize_t result = write(connection->fd_out, connection->pending, connection->pending_size);
+
+        if (result < 0) {
+            return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+        }
+
+        memmove(connection->pending, connection->pending + result, connection->pending_size - (size_t) result);
+        connection->pending_size -= (size_t) result;
+    }
+
+    if (connection->is_input_paused) {
+        if (connection->is_always_ready) {
+            connection->is_input_paused = false;
+        }
+        else {
+            server_pause_input(server, connection, false);
+        }
+    }
+
+    server_watch_output(server, connection, false);
+    return true;
+}
+
+static void server_dispatch_token(struct server* server, struct server_connection* connection,
+    const char* token, size_t length, struct iovec* iov, int* iov_count)
+{
+    const struct machine_instance* machine = server->machine;
+    int input = machine_find_input(machine, token, length);
+
+    if (input < 0) {
+        iov[*iov_count].iov_base = (void*) SERVER_UNKNOWN_REPLY;
+        iov[*iov_count].iov_len = sizeof(SERVER_UNKNOWN_REPLY) - 1;
+    }
+    else {
+        struct machine_trans trans = machine_get_trans(machine, connection->state, input);
+
+        connection->state = trans.next_state;
+        iov[*iov_count].iov_base = server->reply_list[trans.output + 1];
+        iov[*iov_count].iov_len = server->reply_len_list[trans.output + 1];
+    }
+
+    (*iov_count)++;
+    server->event_count++;
+}
+
+/**
+ * Read everything available, dispatch complete tokens and write replies back
+ */
+static bool server_handle_input(struct server* server, struct server_connection* connection) {
+    struct iovec iov[SERVER_IOV_NUM];
+    int iov_count = 0;
+    const char* token = NULL;
+    size_t length = 0;
+
+    for (;;) {
+        ssize_t result = read(connection->fd_in, server->read_buffer, SERVER_READ_SIZE);
+
+        if (result < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        if (result == 0) {
+            connection->is_input_closed = true;
+            break;
+        }
+
+        tokenizer_feed(&connection->tokenizer, server->read_buffer, (size_t) result);
+
+        for (;;) {
+            enum token_status status = tokenizer_next(&connection->tokenizer, &token, &length);
+
+            if (status == TOKEN_STATUS_NEED_INPUT) {
+                break;
+            }
+
+            if (status == TOKEN_STATUS_TOO_LONG) {
+                token = "";
+                length = 0;
+            }
+
+            server_dispatch_token(server, connection, token, length, iov, &iov_count);
+
+            if (iov_count == SERVER_IOV_NUM) {
+                if (!server_flush_replies(server, connection, iov, iov_count)) {
+                    return false;
+                }
+
+                iov_count = 0;
+            }
+        }
+
+        /* Regular file is read one buffer per poll so the other connections are served */
+        if (((size_t) result < SERVER_READ_SIZE) || connection->is_always_ready ||
+            (connection->pending_size > SERVER_PENDING_CAP))
+        {
+            break;
+        }
+    }
+
+    if (connection->is_input_closed &&
+        (tokenizer_finish(&connection->tokenizer, &token, &length) == TOKEN_STATUS_READY))
+    {
+        server_dispatch_token(server, connection, token, length, iov, &iov_count);
+    }
+
+    if (!server_flush_replies(server, connection, iov, iov_count)) {
+        return false;
+    }
+
+    if (!connection->is_input_closed && (connection->pending_size > SERVER_PENDING_CAP)) {
+        if (connection->is_always_ready) {
+            connection->is_input_paused = true;
+        }
+        else {
+            server_pause_input(server, connection, true);
+        }
+    }
+
+    return true;
+}
+
+static bool server_serve_input(struct server* server, struct server_connection* connection) {
+    const uint64_t first_event = server->event_count;
+    LATENCY_START();
+
+    bool is_alive = server_handle_input(server, connection);
+
+    LATENCY_STOP(server->machine, LATENCY_PATH_SERVE, server->event_count - first_event);
+    return is_alive;
+}
+
+/**
+ * Connection is done once its input is over and all replies are written
+ */
+static void server_check_done(struct server* server, struct server_connection* connection, bool is_alive) {
+    if (!is_alive || (connection->is_input_closed && (connection->pending_size == 0))) {
+        if (!connection->is_dead) {
+            connection->is_dead = true;
+            connection->dead_next = server->dead_connections;
+            server->dead_connections = connection;
+        }
+    }
+    else if (connection->is_input_closed && (connection->fd_in == connection->fd_out)) {
+        server_watch_output(server, connection, true);
+    }
+}
+
+static bool server_is_ready(const struct server_connection* connection) {
+    return connection->is_always_ready && !connection->is_input_closed && !connection->is_input_paused &&
+        !connection->is_dead;
+}
+
+static void server_accept(struct server* server) {
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+
+        if (fd < 0) {
+            break;
+        }
+
+        if (server_add_connection(server, fd, fd) != SERVER_STATUS_SUCCESS) {
+            close(fd);
+        }
+    }
+}
+
+enum server_status server_poll(struct server* server, int timeout_ms) {
+    if (server == NULL) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    /* Always ready input is read without waiting */
+    for (struct server_connection* connection = server->ready_connections; connection != NULL;
+        connection = connection->ready_next)
+    {
+        if (server_is_ready(connection)) {
+            timeout_ms = 0;
+            break;
+        }
+    }
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    int event_count = epoll_wait(server->epoll_fd, events, SERVER_MAX_EVENTS, timeout_ms);
+
+    if (event_count < 0) {
+        return (errno == EINTR) ? SERVER_STATUS_SUCCESS : SERVER_STATUS_SYSTEM_ERROR;
+    }
+
+    for (int i = 0; i < event_count; i++) {
+        struct server_endpoint* endpoint = (struct server_endpoint*) events[i].data.ptr;
+
+        if (endpoint == NULL) {
+            server_accept(server);
+            continue;
+        }
+
+        struct server_connection* connection = endpoint->connection;
+        bool is_alive = true;
+
+        /* Connection closed by the previous event of the batch */
+        if (connection->is_dead) {
+            continue;
+        }
+
+        if (events[i].events & EPOLLOUT) {
+            is_alive = server_write_pending(server, connection);
+        }
+
+        if (is_alive && !endpoint->is_output && !connection->is_input_paused &&
+            (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        {
+            is_alive = server_serve_input(server, connection);
+        }
+
+        server_check_done(server, connection, is_alive);
+    }
+
+    for (struct server_connection* connection = server->ready_connections; connection != NULL;
+        connection = connection->ready_next)
+    {
+        if (server_is_ready(connection)) {
+            server_check_done(server, connection, server_serve_input(server, connection));
+        }
+    }
+
+    /* Events of the batch may refer to the connection until the batch is over */
+    while (server->dead_connections != NULL) {
+        struct server_connection* connection = server->dead_connections;
+
+        server->dead_connections = connection->dead_next;
+        server_close_connection(server, connection);
+    }
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+enum server_status server_run(struct server* server) {
+    if (server == NULL) {
+        return SERVER_STATUS_NULL_PARAM;
+    }
+
+    server->is_running = 1;
+
+    while (server->is_running && ((server->listen_fd >= 0) || (server->connection_count > 0))) {
+        enum server_status status = server_poll(server, -1);
+
+        if (status != SERVER_STATUS_SUCCESS) {
+            return status;
+        }
+    }
+
+    return SERVER_STATUS_SUCCESS;
+}
+
+void server_stop(struct server* server) {
+    if (server != NULL) {
+        server->is_running = 0;
+    }
+}
@@ -0,0 +1,732 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "machine.h"
+#include "session.h"
+#include "latency.h"
+
+static size_t session_align(size_t size) {
+    return (size + SESSION_FILE_ALIGN - 1) & ~(SESSION_FILE_ALIGN - 1);
+}
+
+/**
+ * Checksum of the checkpoint slot, the sequence is mixed in so a stale slot never matches
+ */
+static uint64_t session_checksum(const int* state_list, size_t session_count, uint64_t sequence) {
+    uint64_t hash = 0xCBF29CE484222325ull ^ sequence;
+    size_t word_count = session_count / 2;
+    const unsigned char* bytes = (const unsigned char*) state_list;
+
+    for (size_t i = 0; i < word_count; i++) {
+        uint64_t word;
+        memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+
+    if (session_count % 2 != 0) {
+        hash = (hash ^ (uint64_t) (uint32_t) state_list[session_count - 1]) * 0x100000001B3ull;
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+static int* session_slot(const struct session_table* table, int slot) {
+    return (int*) ((char*) table->map + table->header->checkpoint_offset[slot]);
+}
+
+/**
+ * Flush file range to the disk, the range is widened to the pages
+ */
+static enum session_status session_sync(const struct session_table* table, size_t offset, size_t size) {
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page_size - 1);
+
+    if (msync((char*) table->map + start, offset + size - start, MS_SYNC) < 0) {
+        return SESSION_STATUS_SYSTEM_ERROR;
+    }
+
+    return SESSION_STATUS_SUCCESS;
+}
+
+/**
+ * Size of the last level cache reported by the system
+ */
+static size_t session_cache_size(void) {
+    long size = -1;
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    if (size <= 0) {
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+#endif
+
+    return (size > 0) ? (size_t) size : SESSION_DEFAULT_CACHE_SIZE;
+}
+
+static void session_table_reset(struct session_table* table, const struct machine_instance* machine) {
+    table->machine = machine;
+    table->machine_fingerprint = machine_fingerprint(machine);
+    table->state_list = NULL;
+    table->session_count = 0;
+    table->cache_size = session_cache_size();
+    table->fd = -1;
+    table->map = NULL;
+    table->map_size = 0;
+    table->header = NULL;
+}
+
+enum session_status session_table_init(struct session_table* table, const struct machine_instance* machine,
+    size_t session_count)
+{
+    if ((table == NULL) || (machine == NULL)) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    session_table_reset(table, machine);
+
+    table->state_list = (int*) malloc(session_count * sizeof(int));
+
+    if ((table->state_list == NULL) && (session_count != 0)) {
+        return SESSION_STATUS_SYSTEM_ERROR;
+    }
+
+    table->session_count = session_count;
+
+    for (size_t i = 0; i < session_count; i++) {
+        table->state_list[i] = machine->entry_state;
+    }
+
+    return SESSION_STATUS_SUCCESS;
+}
+
+/**
+ * Create the session file with the `state_list` states, the entry state for every session if it is NULL.
+ * The states are checkpointed before the file is renamed over `path`.
+ */
+static enum session_status session_table_create_file(struct session_table* table,
+    const struct machine_instance* machine, const char* path, size_t session_count, const int* state_list)
+{
+    session_table_reset(table, machine);
+
+    /* File layout */
+    size_t symbols_size = 0;
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        symbols_size += strlen(machine->state_list[i].symbol) + 1;
+    }
+
+    const size_t states_size = session_align(session_count * sizeof(int));
+    const size_t symbols_offset = session_align(sizeof(struct session_file_header));
+    const size_t live_offset = symbols_offset + session_align(symbols_size);
+    const size_t file_size = live_offset + (1 + SESSION_CHECKPOINT_SLOTS) * states_size;
+
+    /* The file is filled aside, so `path` always holds a complete session file */
+    size_t path_len = strlen(path);
+    char* temp_path = (char*) malloc(path_len + sizeof(".tmp"));
+    memcpy(temp_path, path, path_len);
+    memcpy(temp_path + path_len, ".tmp", sizeof(".tmp"));
+
+    enum session_status status = SESSION_STATUS_SYSTEM_ERROR;
+
+    table->fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if ((table->fd < 0) || (ftruncate(table->fd, (off_t) file_size) < 0)) {
+        goto EXIT;
+    }
+
+    table->map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, table->fd, 0);
+
+    if (table->map == MAP_FAILED) {
+        table->map = NULL;
+        goto EXIT;
+    }
+
+    table->map_size = file_size;
+    table->header = (struct session_file_header*) table->map;
+    table->state_list = (int*) ((char*) table->map + live_offset);
+    table->session_count = session_count;
+
+    struct session_file_header* header = table->header;
+
+    header->magic = SESSION_FILE_MAGIC;
+    header->version = SESSION_FILE_VERSION;
+    header->state_count = (uint32_t) machine->state_list_size;
+    header->machine_fingerprint = table->machine_fingerprint;
+    header->session_count = session_count;
+    header->symbols_offset = symbols_offset;
+    header->symbols_size = symbols_size;
+    header->live_offset = live_offset;
+
+    for (int i = 0; i < SESSION_CHECKPOINT_SLOTS; i++) {
+        header->checkpoint_offset[i] = live_offset + (1 + i) * states_size;
+        header->checkpoint_list[i].sequence = 0;
+        header->checkpoint_list[i].checksum = 0;
+    }
+
+    char* symbols = (char*) table->map + symbols_offset;
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        size_t symbol_size = strlen(machine->state_list[i].symbol) + 1;
+
+        memcpy(symbols, machine->state_list[i].symbol, symbol_size);
+        symbols += symbol_size;
+    }
+
+    if (state_list != NULL) {
+        memcpy(table->state_list, state_list, session_count * sizeof(int));
+    }
+    else {
+        for (size_t i = 0; i < session_count; i++) {
+            table->state_list[i] = machine->entry_state;
+        }
+    }
+
+    status = session_table_checkpoint(table);
+
+    if ((status == SESSION_STATUS_SUCCESS) && (rename(temp_path, path) < 0)) {
+        status = SESSION_STATUS_SYSTEM_ERROR;
+    }
+
+EXIT:
+
+    if (status != SESSION_STATUS_SUCCESS) {
+        session_table_free(table);
+        unlink(temp_path);
+    }
+
+    free(temp_path);
+    return status;
+}
+
+enum session_status session_table_create(struct session_table* table, const struct machine_instance* machine,
+    const char* path, size_t session_count)
+{
+    if ((table == NULL) || (machine == NULL) || (path == NULL)) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    return session_table_create_file(table, machine, path, session_count, NULL);
+}
+
+/**
+ * Get the latest checkpoint slot which checksum is valid, -1 if there is none
+ */
+static int session_latest_slot(const struct session_table* table) {
+    const struct session_file_header* header = table->header;
+    int latest_slot = -1;
+
+    for (int i = 0; i < SESSION_CHECKPOINT_SLOTS; i++) {
+        const struct session_checkpoint* checkpoint = &header->checkpoint_list[i];
+
+        if ((checkpoint->sequence == 0) ||
+            ((latest_slot >= 0) && (checkpoint->sequence < header->checkpoint_list[latest_slot].sequence)))
+        {
+            continue;
+        }
+
+        uint64_t checksum = session_checksum(session_slot(table, i), table->session_count, checkpoint->sequence);
+
+        if (checksum == checkpoint->checksum) {
+            latest_slot = i;
+        }
+    }
+
+    return latest_slot;
+}
+
+/**
+ * Check that the header describes sections inside the file
+ */
+static bool session_validate_header(const struct session_file_header* header, size_t file_size) {
+    if ((header->magic != SESSION_FILE_MAGIC) || (header->version != SESSION_FILE_VERSION)) {
+        return false;
+    }
+
+    const uint64_t states_size = header->session_count * sizeof(int);
+
+    if ((header->session_count > file_size / sizeof(int)) ||
+        (header->symbols_offset + header->symbols_size > file_size) ||
+        (header->live_offset + states_size > file_size))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < SESSION_CHECKPOINT_SLOTS; i++) {
+        if (header->checkpoint_offset[i] + states_size > file_size) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Map state identifiers of the file to the states of the machine with the same symbols
+ */
+static enum session_status session_remap_states(const struct session_table* table,
+    const struct machine_instance* machine, int* state_map)
+{
+    const struct session_file_header* header = table->header;
+    const char* symbols = (const char*) table->map + header->symbols_offset;
+    const char* symbols_end = symbols + header->symbols_size;
+
+    /* Open addressing index of the machine state symbols */
+    int index_size = 1;
+    while (index_size < 2 * machine->state_list_size) {
+        index_size <<= 1;
+    }
+
+    int* index = (int*) malloc(index_size * sizeof(int));
+    memset(index, -1, index_size * sizeof(int));
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        const char* symbol = machine->state_list[i].symbol;
+        uint64_t hash = machine_symbol_hash(symbol, strlen(symbol));
+        int slot = (int) (hash & (uint64_t) (index_size - 1));
+
+        while (index[slot] >= 0) {
+            slot = (slot + 1) & (index_size - 1);
+        }
+
+        index[slot] = i;
+    }
+
+    enum session_status status = SESSION_STATUS_SUCCESS;
+
+    for (uint32_t i = 0; i < header->state_count; i++) {
+        size_t symbol_len = strnlen(symbols, (size_t) (symbols_end - symbols));
+
+        if (symbols + symbol_len >= symbols_end) {
+            status = SESSION_STATUS_INVAL_FILE;
+            break;
+        }
+
+        uint64_t hash = machine_symbol_hash(symbols, symbol_len);
+        int slot = (int) (hash & (uint64_t) (index_size - 1));
+
+        state_map[i] = -1;
+
+        while (index[slot] >= 0) {
+            if (strcmp(machine->state_list[index[slot]].symbol, symbols) == 0) {
+                state_map[i] = index[slot];
+                break;
+            }
+
+            slot = (slot + 1) & (index_size - 1);
+        }
+
+        symbols += symbol_len + 1;
+    }
+
+    free(index);
+    return status;
+}
+
+enum session_status session_table_open(struct session_table* table, const struct machine_instance* machine,
+    const char* path, enum session_restore_mode mode)
+{
+    if ((table == NULL) || (machine == NULL) || (path == NULL)) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    session_table_reset(table, machine);
+
+    table->fd = open(path, O_RDWR);
+
+    if (table->fd < 0) {
+        return SESSION_STATUS_SYSTEM_ERROR;
+    }
+
+    enum session_status status = SESSION_STATUS_INVAL_FILE;
+    struct stat file_stat;
+
+    if (fstat(table->fd, &file_stat) < 0) {
+        status = SESSION_STATUS_SYSTEM_ERROR;
+        goto EXIT;
+    }
+
+    if ((size_t) file_stat.st_size < sizeof(struct session_file_header)) {
+        goto EXIT;
+    }
+
+    table->map = mmap(NULL, (size_t) file_stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, table->fd, 0);
+
+    if (table->map == MAP_FAILED) {
+        table->map = NULL;
+        status = SESSION_STATUS_SYSTEM_ERROR;
+        goto EXIT;
+    }
+
+    table->map_size = (size_t) file_stat.st_size;
+    table->header = (struct session_file_header*) table->map;
+
+    if (!session_validate_header(table->header, table->map_size)) {
+        goto EXIT;
+    }
+
+    table->session_count = table->header->session_count;
+    table->state_list = (int*) ((char*) table->map + table->header->live_offset);
+
+    int slot = session_latest_slot(table);
+
+    if (slot < 0) {
+        goto EXIT;
+    }
+
+    const int* checkpoint = session_slot(table, slot);
+
+    if (table->header->machine_fingerprint == table->machine_fingerprint) {
+        memcpy(table->state_list, checkpoint, table->session_count * sizeof(int));
+        status = SESSION_STATUS_SUCCESS;
+        goto EXIT;
+    }
+
+    if (mode != SESSION_RESTORE_REMAP) {
+        status = SESSION_STATUS_MACHINE_MISMATCH;
+        goto EXIT;
+    }
+
+    /* Translate the checkpoint and write it to a new file of the machine */
+    int* state_map = (int*) malloc(table->header->state_count * sizeof(int));
+    int* state_list = (int*) malloc(table->session_count * sizeof(int));
+    size_t session_count = table->session_count;
+
+    status = session_remap_states(table, machine, state_map);
+
+    for (size_t i = 0; (status == SESSION_STATUS_SUCCESS) && (i < session_count); i++) {
+        int state = checkpoint[i];
+
+        if ((state < 0) || ((uint32_t) state >= table->header->state_count)) {
+            status = SESSION_STATUS_INVAL_FILE;
+        }
+        else if (state_map[state] < 0) {
+            status = SESSION_STATUS_MACHINE_MISMATCH;
+        }
+        else {
+            state_list[i] = state_map[state];
+        }
+    }
+
+    /* Remapped states are checkpointed before the new file replaces the old one */
+    if (status == SESSION_STATUS_SUCCESS) {
+        session_table_free(table);
+        status = session_table_create_file(table, machine, path, session_count, state_list);
+    }
+
+    free(state_map);
+    free(state_list);
+
+EXIT:
+
+    if (status != SESSION_STATUS_SUCCESS) {
+        session_table_free(table);
+    }
+
+    return status;
+}
+
+enum session_status session_table_checkpoint(struct session_table* table) {
+    if (table == NULL) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    if (table->header == NULL) {
+        return SESSION_STATUS_SUCCESS;
+    }
+
+    struct session_file_header* header = table->header;
+
+    /* Overwrite the older slot, the latest one stays valid until the new one is complete */
+    int slot = 0;
+    uint64_t sequence = 0;
+
+    for (int i = 0; i < SESSION_CHECKPOINT_SLOTS; i++) {
+        if (header->checkpoint_list[i].sequence < header->checkpoint_list[slot].sequence) {
+            slot = i;
+        }
+
+        if (header->checkpoint_list[i].sequence > sequence) {
+            sequence = header->checkpoint_list[i].sequence;
+        }
+    }
+
+    sequence++;
+
+    const size_t states_size = table->session_count * sizeof(int);
+    int* checkpoint = session_slot(table, slot);
+
+    memcpy(checkpoint, table->state_list, states_size);
+
+    enum session_status status = session_sync(table, header->checkpoint_offset[slot], states_size);
+
+    if (status != SESSION_STATUS_SUCCESS) {
+        return status;
+    }
+
+    header->checkpoint_list[slot].checksum = session_checksum(checkpoint, table->session_count, sequence);
+    header->checkpoint_list[slot].sequence = sequence;
+
+    return session_sync(table, 0, sizeof(struct session_file_header));
+}
+
+enum session_status session_table_free(struct session_table* table) {
+    if (table == NULL) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    if (table->map != NULL) {
+        munmap(table->map, table->map_size);
+    }
+    else if (table->fd < 0) {
+        free(table->state_list);
+    }
+
+    if (table->fd >= 0) {
+        close(table->fd);
+    }
+
+    table->state_list = NULL;
+    table->session_count = 0;
+    table->fd = -1;
+    table->map = NULL;
+    table->map_size = 0;
+    table->header = NULL;
+
+    return SESSION_STATUS_SUCCESS;
+}
+
+enum session_status session_table_run(struct session_table* table, size_t session, const int* inputs,
+    size_t input_count, int* outputs)
+{
+    if ((table == NULL) || (inputs == NULL) || (outputs == NULL)) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    if (session >= table->session_count) {
+        return SESSION_STATUS_INVAL_PARAM;
+    }
+
+    machine_run(table->machine, inputs, input_count, outputs, &table->state_list[session]);
+    return SESSION_STATUS_SUCCESS;
+}
+
+/* Batch Dispatch */
+
+/**
+ * @struct Event of the grouped wave, `slot` is the table slot it reads once the state is known
+ */
+struct session_dispatch_item {
+    size_t event;
+    int state;
+    int slot;
+};
+
+static void session_dispatch_direct(struct session_table* table, const struct session_event* events,
+    size_t event_count, int* outputs)
+{
+    for (size_t i = 0; i < event_count; i++) {
+        int* state = &table->state_list[events[i].session];
+        struct machine_trans trans = machine_get_trans(table->machine, *state, events[i].input);
+
+        outputs[i] = trans.output;
+        *state = trans.next_state;
+    }
+}
+
+/**
+ * Number the events of every session in the batch order, the number is the wave of the event.
+ * Sessions are counted in a dense array unless the batch is sparse over the table.
+ * Returns the number of waves.
+ */
+static int session_dispatch_waves(const struct session_table* table, const struct session_event* events,
+    size_t event_count, int* wave_list)
+{
+    int wave_count = 0;
+
+    if (table->session_count <= SESSION_DISPATCH_DENSE_RATIO * event_count) {
+        int* counts = (int*) calloc(table->session_count, sizeof(int));
+
+        for (size_t i = 0; i < event_count; i++) {
+            wave_list[i] = counts[events[i].session]++;
+
+            if (wave_list[i] >= wave_count) {
+                wave_count = wave_list[i] + 1;
+            }
+        }
+
+        free(counts);
+        return wave_count;
+    }
+
+    size_t map_size = 16;
+
+    while (map_size < 2 * event_count) {
+        map_size <<= 1;
+    }
+
+    /* Keys are the session numbers plus one, 0 for the free slot */
+    size_t* keys = (size_t*) calloc(map_size, sizeof(size_t));
+    int* counts = (int*) malloc(map_size * sizeof(int));
+
+    for (size_t i = 0; i < event_count; i++) {
+        const size_t key = events[i].session + 1;
+        size_t slot = (size_t) (((uint64_t) key * 0x9E3779B97F4A7C15ull) >> 20) & (map_size - 1);
+
+        while ((keys[slot] != 0) && (keys[slot] != key)) {
+            slot = (slot + 1) & (map_size - 1);
+        }
+
+        if (keys[slot] == 0) {
+            keys[slot] = key;
+            counts[slot] = 0;
+        }
+
+        wave_list[i] = counts[slot]++;
+
+        if (wave_list[i] >= wave_count) {
+            wave_count = wave_list[i] + 1;
+        }
+    }
+
+    free(keys);
+    free(counts);
+
+    return wave_count;
+}
+
+/**
+ * Apply the waves in turn, events of the wave belong to different sessions and
+ * are applied in the order of the table regions they read
+ */
+static void session_dispatch_grouped(struct session_table* table, const struct session_event* events,
+    size_t event_count, int* outputs)
+{
+    const struct machine_instance* machine = table->machine;
+
+    int* wave_list = (int*) malloc(event_count * sizeof(int));
+    const int wave_count = session_dispatch_waves(table, events, event_count, wave_list);
+
+    /* Stable counting sort of the event numbers by wave */
+    size_t* wave_start = (size_t*) calloc(wave_count + 1, sizeof(size_t));
+    size_t* wave_events = (size_t*) malloc(event_count * sizeof(size_t));
+    struct session_dispatch_item* items =
+        (struct session_dispatch_item*) malloc(event_count * sizeof(struct session_dispatch_item));
+    struct session_dispatch_item* sorted_items =
+        (struct session_dispatch_item*) malloc(event_count * sizeof(struct session_dispatch_item));
+
+    for (size_t i = 0; i < event_count; i++) {
+        wave_start[wave_list[i] + 1]++;
+    }
+
+    for (int i = 0; i < wave_count; i++) {
+        wave_start[i + 1] += wave_start[i];
+    }
+
+    for (size_t i = 0; i < event_count; i++) {
+        wave_events[wave_start[wave_list[i]]++] = i;
+    }
+
+    free(wave_list);
+
+    int shift = 0;
+
+    while (((size_t) machine->trans_table_size >> shift) >= (size_t) SESSION_DISPATCH_REGIONS) {
+        shift++;
+    }
+
+    size_t region_start[SESSION_DISPATCH_REGIONS + 1];
+
+    /* Wave starts were advanced to the wave ends by the sort */
+    for (int i = 0; i < wave_count; i++) {
+        const size_t begin = (i == 0) ? 0 : wave_start[i - 1];
+        const size_t end = wave_start[i];
+
+        memset(region_start, 0, sizeof(region_start));
+
+        for (size_t j = begin; j < end; j++) {
+            const struct session_event* event = &events[wave_events[j]];
+            struct session_dispatch_item* item = &items[j];
+
+            item->event = wave_events[j];
+            item->state = table->state_list[event->session];
+            item->slot = machine->state_list[item->state].base + event->input;
+
+            region_start[(item->slot >> shift) + 1]++;
+        }
+
+        for (int j = 0; j < SESSION_DISPATCH_REGIONS; j++) {
+            region_start[j + 1] += region_start[j];
+        }
+
+        for (size_t j = begin; j < end; j++) {
+            sorted_items[begin + region_start[items[j].slot >> shift]++] = items[j];
+        }
+
+        for (size_t j = begin; j < end; j++) {
+            const struct session_dispatch_item* item = &sorted_items[j];
+            struct machine_trans trans = machine->trans_table[item->slot];
+
+            if (trans.check != item->state) {
+                trans = machine->state_list[item->state].default_trans;
+            }
+
+            outputs[item->event] = trans.output;
+            table->state_list[events[item->event].session] = trans.next_state;
+        }
+    }
+
+    free(wave_start);
+    free(wave_events);
+    free(items);
+    free(sorted_items);
+}
+
+enum session_status session_table_dispatch(struct session_table* table, const struct session_event* events,
+    size_t event_count, int* outputs, enum session_dispatch_mode mode)
+{
+    if ((table == NULL) || (events == NULL) || (outputs == NULL)) {
+        return SESSION_STATUS_NULL_PARAM;
+    }
+
+    /* Nothing is applied if some event is invalid */
+    for (size_t i = 0; i < event_count; i++) {
+        if ((events[i].session >= table->session_count) || (events[i].input < 0) ||
+            (events[i].input >= table->machine->input_list_size))
+        {
+            return SESSION_STATUS_INVAL_PARAM;
+        }
+    }
+
+    if (mode == SESSION_DISPATCH_AUTO) {
+        const size_t machine_size = table->machine->trans_table_size * sizeof(struct machine_trans) +
+            table->machine->state_list_size * sizeof(struct machine_state);
+
+        const size_t table_line_count = table->machine->trans_table_size * sizeof(struct machine_trans) /
+            SESSION_CACHE_LINE_SIZE;
+
+        /* Sparser batch reads every line once whatever the order, grouping is only the overhead */
+        mode = ((event_count >= SESSION_DISPATCH_MIN_EVENTS) && (machine_size > table->cache_size) &&
+            (event_count >= table_line_count)) ? SESSION_DISPATCH_GROUPED : SESSION_DISPATCH_DIRECT;
+    }
+
+    LATENCY_START();
+
+    if (mode == SESSION_DISPATCH_GROUPED) {
+        session_dispatch_grouped(table, events, event_count, outputs);
+    }
+    else {
+        session_dispatch_direct(table, events, event_count, outputs);
+    }
+
+    LATENCY_STOP(table->machine, LATENCY_PATH_DISPATCH, event_count);
+    return SESSION_STATUS_SUCCESS;
+}
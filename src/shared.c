@@ -0,0 +1,552 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "machine.h"
+#include "session.h"
+#include "shared.h"
+#include "latency.h"
+
+/* Session states are updated by processes which share nothing but the segment */
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic_int must be lock free to be shared by processes");
+
+static size_t shared_align(size_t size) {
+    return (size + SHARED_ALIGN - 1) & ~(SHARED_ALIGN - 1);
+}
+
+static size_t shared_symbols_size(const char** symbol_list, int symbol_count) {
+    size_t size = 0;
+
+    for (int i = 0; i < symbol_count; i++) {
+        size += strlen(symbol_list[i]) + 1;
+    }
+
+    return size;
+}
+
+static char* shared_write_symbols(char* symbols, const char** symbol_list, int symbol_count) {
+    for (int i = 0; i < symbol_count; i++) {
+        const size_t symbol_size = strlen(symbol_list[i]) + 1;
+
+        memcpy(symbols, symbol_list[i], symbol_size);
+        symbols += symbol_size;
+    }
+
+    return symbols;
+}
+
+static bool shared_is_alive(int pid) {
+    return (kill((pid_t) pid, 0) == 0) || (errno == EPERM);
+}
+
+/**
+ * Remove the segment the creator of which died before it was ready. Of the
+ * processes which find it, only the one claiming it by compare and swap of
+ * the creator removes it, so the segment created again under the name is
+ * never removed by the late ones.
+ */
+static bool shared_remove_stale(const char* name) {
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat segment_stat;
+    bool is_removed = false;
+
+    /* Segment is not sized yet, its creator is unknown */
+    if ((fstat(fd, &segment_stat) < 0) || ((size_t) segment_stat.st_size < sizeof(struct shared_header))) {
+        close(fd);
+        return false;
+    }
+
+    struct shared_header* header =
+        (struct shared_header*) mmap(NULL, sizeof(struct shared_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (header == MAP_FAILED) {
+        return false;
+    }
+
+    int creator_pid = atomic_load(&header->creator_pid);
+
+    if ((header->magic == SHARED_MAGIC) && (header->version == SHARED_LAYOUT_VERSION) &&
+        (atomic_load_explicit(&header->is_ready, memory_order_acquire) == 0) &&
+        (creator_pid > 0) && !shared_is_alive(creator_pid) &&
+        atomic_compare_exchange_strong(&header->creator_pid, &creator_pid, -1))
+    {
+        is_removed = (shm_unlink(name) == 0);
+    }
+
+    munmap(header, sizeof(struct shared_header));
+    return is_removed;
+}
+
+enum shared_status shared_table_create(const char* name, const struct machine_instance* machine,
+    size_t session_count)
+{
+    if ((name == NULL) || (machine == NULL)) {
+        return SHARED_STATUS_NULL_PARAM;
+    }
+
+    /* Segment layout */
+    size_t symbols_size = shared_symbols_size(machine->input_list, machine->input_list_size) +
+        shared_symbols_size(machine->output_list, machine->output_list_size);
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        symbols_size += strlen(machine->state_list[i].symbol) + 1;
+    }
+
+    const size_t symbols_offset = shared_align(sizeof(struct shared_header));
+    const size_t state_list_offset = symbols_offset + shared_align(symbols_size);
+    const size_t trans_table_offset =
+        state_list_offset + shared_align(machine->state_list_size * sizeof(struct shared_state));
+    const size_t session_offset =
+        trans_table_offset + shared_align(machine->trans_table_size * sizeof(struct machine_trans));
+    const size_t segment_size = session_offset + shared_align(session_count * sizeof(atomic_int));
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if ((fd < 0) && (errno == EEXIST) && shared_remove_stale(name)) {
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+
+    if (fd < 0) {
+        return (errno == EEXIST) ? SHARED_STATUS_EXISTS : SHARED_STATUS_SYSTEM_ERROR;
+    }
+
+    enum shared_status status = SHARED_STATUS_SYSTEM_ERROR;
+    char* map = NULL;
+
+    /* Creator is recorded by the same write which gives the segment its header */
+    struct shared_header initial_header;
+    memset(&initial_header, 0, sizeof(initial_header));
+
+    initial_header.magic = SHARED_MAGIC;
+    initial_header.version = SHARED_LAYOUT_VERSION;
+    atomic_init(&initial_header.creator_pid, (int) getpid());
+
+    if ((write(fd, &initial_header, sizeof(initial_header)) != (ssize_t) sizeof(initial_header)) ||
+        (ftruncate(fd, (off_t) segment_size) < 0))
+    {
+        goto EXIT;
+    }
+
+    map = (char*) mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (map == MAP_FAILED) {
+        map = NULL;
+        goto EXIT;
+    }
+
+    /* Rest of the segment is zero filled, `is_ready` stays 0 until the segment is complete */
+    struct shared_header* header = (struct shared_header*) map;
+
+    header->magic = SHARED_MAGIC;
+    header->version = SHARED_LAYOUT_VERSION;
+    header->header_size = (uint16_t) sizeof(struct shared_header);
+    header->state_size = (uint16_t) sizeof(struct shared_state);
+    header->trans_size = (uint16_t) sizeof(struct machine_trans);
+    header->atomic_int_size = (uint16_t) sizeof(atomic_int);
+
+    header->segment_size = segment_size;
+    header->machine_fingerprint = machine_fingerprint(machine);
+
+    header->input_list_size = machine->input_list_size;
+    header->state_list_size = machine->state_list_size;
+    header->output_list_size = machine->output_list_size;
+    header->trans_table_size = machine->trans_table_size;
+    header->entry_state = machine->entry_state;
+
+    header->symbols_offset = symbols_offset;
+    header->symbols_size = symbols_size;
+    header->state_list_offset = state_list_offset;
+    header->trans_table_offset = trans_table_offset;
+    header->session_offset = session_offset;
+    header->session_count = session_count;
+
+    char* symbols = map + symbols_offset;
+    symbols = shared_write_symbols(symbols, machine->input_list, machine->input_list_size);
+    symbols = shared_write_symbols(symbols, machine->output_list, machine->output_list_size);
+
+    struct shared_state* state_list = (struct shared_state*) (map + state_list_offset);
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        const size_t symbol_size = strlen(machine->state_list[i].symbol) + 1;
+
+        memcpy(symbols, machine->state_list[i].symbol, symbol_size);
+        symbols += symbol_size;
+
+        state_list[i].base = machine->state_list[i].base;
+        state_list[i].is_final = machine->state_list[i].is_final;
+        state_list[i].verdict = machine->state_list[i].verdict;
+        state_list[i].default_trans = machine->state_list[i].default_trans;
+    }
+
+    memcpy(map + trans_table_offset, machine->trans_table, machine->trans_table_size * sizeof(struct machine_trans));
+
+    atomic_int* session_list = (atomic_int*) (map + session_offset);
+
+    for (size_t i = 0; i < session_count; i++) {
+        atomic_init(&session_list[i], machine->entry_state);
+    }
+
+    atomic_store_explicit(&header->is_ready, 1, memory_order_release);
+    status = SHARED_STATUS_SUCCESS;
+
+EXIT:
+    if (map != NULL) {
+        munmap(map, segment_size);
+    }
+
+    close(fd);
+
+    if (status != SHARED_STATUS_SUCCESS) {
+        shm_unlink(name);
+    }
+
+    return status;
+}
+
+/**
+ * Check that the header describes sections inside the segment
+ */
+static bool shared_validate_header(const struct shared_header* header, size_t map_size) {
+    if ((header->segment_size > map_size) || (header->input_list_size < 0) || (header->state_list_size <= 0) ||
+        (header->output_list_size < 0) || (header->trans_table_size < 0) ||
+        (header->entry_state < 0) || (header->entry_state >= header->state_list_size))
+    {
+        return false;
+    }
+
+    const uint64_t state_list_size = (uint64_t) header->state_list_size * sizeof(struct shared_state);
+    const uint64_t trans_table_size = (uint64_t) header->trans_table_size * sizeof(struct machine_trans);
+
+    return (header->symbols_offset + header->symbols_size <= map_size) &&
+        (header->state_list_offset + state_list_size <= map_size) &&
+        (header->trans_table_offset + trans_table_size <= map_size) &&
+        (header->session_count <= map_size / sizeof(atomic_int)) &&
+        (header->session_offset + header->session_count * sizeof(atomic_int) <= map_size);
+}
+
+static bool shared_valid_trans(const struct shared_header* header, struct machine_trans trans) {
+    return (trans.next_state >= 0) && (trans.next_state < header->state_list_size) &&
+        (trans.output >= MACHINE_EMPTY_OUTPUT) && (trans.output < header->output_list_size);
+}
+
+/**
+ * Point the list at the next `symbol_count` symbols of the pool, NULL if the pool ends first
+ */
+static const char* shared_read_symbols(const char* symbols, const char* symbols_end, const char** symbol_list,
+    int symbol_count)
+{
+    for (int i = 0; i < symbol_count; i++) {
+        const size_t symbol_len = strnlen(symbols, (size_t) (symbols_end - symbols));
+
+        if (symbols + symbol_len >= symbols_end) {
+            return NULL;
+        }
+
+        symbol_list[i] = symbols;
+        symbols += symbol_len + 1;
+    }
+
+    return symbols;
+}
+
+/**
+ * Build the local view of the shared machine, the table stays in the segment
+ */
+static enum shared_status shared_init_machine(struct shared_table* table) {
+    const struct shared_header* header = table->header;
+    const char* map = (const char*) table->map;
+    struct machine_instance* machine = &table->machine;
+
+    machine->input_list_size = header->input_list_size;
+    machine->state_list_size = header->state_list_size;
+    machine->output_list_size = header->output_list_size;
+    machine->trans_table_size = header->trans_table_size;
+    machine->entry_state = header->entry_state;
+
+    machine->symbol_pool_size = header->symbols_size;
+    machine->symbol_pool = (char*) mem_alloc(&machine->mem, MEM_CATEGORY_SYMBOL, header->symbols_size);
+    machine->input_list = (const char**)
+        mem_calloc(&machine->mem, MEM_CATEGORY_LIST, header->input_list_size, sizeof(const char*));
+    machine->output_list = (const char**)
+        mem_calloc(&machine->mem, MEM_CATEGORY_LIST, header->output_list_size, sizeof(const char*));
+    machine->state_list = (struct machine_state*)
+        mem_calloc(&machine->mem, MEM_CATEGORY_ENTITY, header->state_list_size, sizeof(struct machine_state));
+
+    if (((machine->symbol_pool == NULL) && (header->symbols_size != 0)) ||
+        ((machine->input_list == NULL) && (header->input_list_size != 0)) ||
+        ((machine->output_list == NULL) && (header->output_list_size != 0)) || (machine->state_list == NULL))
+    {
+        return SHARED_STATUS_SYSTEM_ERROR;
+    }
+
+    memcpy(machine->symbol_pool, map + header->symbols_offset, header->symbols_size);
+
+    const char* symbols = machine->symbol_pool;
+    const char* symbols_end = machine->symbol_pool + machine->symbol_pool_size;
+    const char** state_symbol_list = (const char**) malloc(header->state_list_size * sizeof(const char*));
+
+    symbols = shared_read_symbols(symbols, symbols_end, machine->input_list, header->input_list_size);
+    symbols = (symbols != NULL) ?
+        shared_read_symbols(symbols, symbols_end, machine->output_list, header->output_list_size) : NULL;
+    symbols = (symbols != NULL) ?
+        shared_read_symbols(symbols, symbols_end, state_symbol_list, header->state_list_size) : NULL;
+
+    enum shared_status status = (symbols != NULL) ? SHARED_STATUS_SUCCESS : SHARED_STATUS_INVAL_SEGMENT;
+    const struct shared_state* state_list = (const struct shared_state*) (map + header->state_list_offset);
+
+    for (int i = 0; (status == SHARED_STATUS_SUCCESS) && (i < header->state_list_size); i++) {
+        if ((state_list[i].base < 0) ||
+            ((int64_t) state_list[i].base + header->input_list_size > header->trans_table_size) ||
+            !shared_valid_trans(header, state_list[i].default_trans))
+        {
+            status = SHARED_STATUS_INVAL_SEGMENT;
+            break;
+        }
+
+        machine->state_list[i].symbol = state_symbol_list[i];
+        machine->state_list[i].base = state_list[i].base;
+        machine->state_list[i].is_final = (state_list[i].is_final != 0);
+        machine->state_list[i].verdict = (int8_t) state_list[i].verdict;
+        machine->state_list[i].default_trans = state_list[i].default_trans;
+    }
+
+    free(state_symbol_list);
+
+    if (status != SHARED_STATUS_SUCCESS) {
+        return status;
+    }
+
+    /* Slots of other states are not read, the owned ones must lead to valid states */
+    const struct machine_trans* trans_table = (const struct machine_trans*) (map + header->trans_table_offset);
+
+    for (int i = 0; i < header->trans_table_size; i++) {
+        if ((trans_table[i].check < MACHINE_FREE_SLOT) || (trans_table[i].check >= header->state_list_size) ||
+            ((trans_table[i].check != MACHINE_FREE_SLOT) && !shared_valid_trans(header, trans_table[i])))
+        {
+            return SHARED_STATUS_INVAL_SEGMENT;
+        }
+    }
+
+    machine->trans_table = (struct machine_trans*) trans_table;
+
+    if ((machine_build_resolver(machine) != MACHINE_STATUS_SUCCESS) ||
+        (machine_fingerprint(machine) != header->machine_fingerprint))
+    {
+        return SHARED_STATUS_INVAL_SEGMENT;
+    }
+
+    return SHARED_STATUS_SUCCESS;
+}
+
+/**
+ * Take a free slot, or the slot of a process which died attached
+ */
+static int shared_claim_slot(struct shared_header* header) {
+    const int pid = (int) getpid();
+
+    for (int i = 0; i < SHARED_MAX_PROCESSES; i++) {
+        int slot_pid = 0;
+
+        if (atomic_compare_exchange_strong(&header->process_list[i], &slot_pid, pid)) {
+            return i;
+        }
+    }
+
+    for (int i = 0; i < SHARED_MAX_PROCESSES; i++) {
+        int slot_pid = atomic_load(&header->process_list[i]);
+
+        if ((slot_pid != 0) && !shared_is_alive(slot_pid) &&
+            atomic_compare_exchange_strong(&header->process_list[i], &slot_pid, pid))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+enum shared_status shared_table_attach(struct shared_table* table, const char* name) {
+    if ((table == NULL) || (name == NULL)) {
+        return SHARED_STATUS_NULL_PARAM;
+    }
+
+    memset(table, 0, sizeof(struct shared_table));
+    mem_stats_init(&table->machine.mem);
+    table->process_slot = -1;
+
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0) {
+        return SHARED_STATUS_SYSTEM_ERROR;
+    }
+
+    enum shared_status status = SHARED_STATUS_SYSTEM_ERROR;
+    struct stat segment_stat;
+
+    if (fstat(fd, &segment_stat) < 0) {
+        goto EXIT;
+    }
+
+    /* Creator has not sized the segment yet */
+    if ((size_t) segment_stat.st_size < sizeof(struct shared_header)) {
+        status = SHARED_STATUS_NOT_READY;
+        goto EXIT;
+    }
+
+    table->map = mmap(NULL, (size_t) segment_stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (table->map == MAP_FAILED) {
+        table->map = NULL;
+        goto EXIT;
+    }
+
+    table->map_size = (size_t) segment_stat.st_size;
+    table->header = (struct shared_header*) table->map;
+
+    struct shared_header* header = table->header;
+
+    if (atomic_load_explicit(&header->is_ready, memory_order_acquire) == 0) {
+        shared_remove_stale(name);
+        status = SHARED_STATUS_NOT_READY;
+        goto EXIT;
+    }
+
+    if ((header->magic != SHARED_MAGIC) || (header->version != SHARED_LAYOUT_VERSION) ||
+        (header->header_size != sizeof(struct shared_header)) || (header->state_size != sizeof(struct shared_state)) ||
+        (header->trans_size != sizeof(struct machine_trans)) || (header->atomic_int_size != sizeof(atomic_int)))
+    {
+        status = SHARED_STATUS_LAYOUT_MISMATCH;
+        goto EXIT;
+    }
+
+    if (!shared_validate_header(header, table->map_size)) {
+        status = SHARED_STATUS_INVAL_SEGMENT;
+        goto EXIT;
+    }
+
+    status = shared_init_machine(table);
+
+    if (status != SHARED_STATUS_SUCCESS) {
+        goto EXIT;
+    }
+
+    table->state_list = (atomic_int*) ((char*) table->map + header->session_offset);
+    table->session_count = header->session_count;
+    table->process_slot = shared_claim_slot(header);
+
+    if (table->process_slot < 0) {
+        status = SHARED_STATUS_NO_SLOT;
+    }
+
+EXIT:
+    close(fd);
+
+    if (status != SHARED_STATUS_SUCCESS) {
+        shared_table_detach(table);
+    }
+
+    return status;
+}
+
+enum shared_status shared_table_detach(struct shared_table* table) {
+    if (table == NULL) {
+        return SHARED_STATUS_NULL_PARAM;
+    }
+
+    if (table->process_slot >= 0) {
+        int pid = (int) getpid();
+        atomic_compare_exchange_strong(&table->header->process_list[table->process_slot], &pid, 0);
+    }
+
+    /* The table belongs to the segment */
+    table->machine.trans_table = NULL;
+    table->machine.trans_table_size = 0;
+    machine_free(&table->machine);
+
+    if (table->map != NULL) {
+        munmap(table->map, table->map_size);
+    }
+
+    table->header = NULL;
+    table->state_list = NULL;
+    table->session_count = 0;
+    table->map = NULL;
+    table->map_size = 0;
+    table->process_slot = -1;
+
+    return SHARED_STATUS_SUCCESS;
+}
+
+enum shared_status shared_table_unlink(const char* name) {
+    if (name == NULL) {
+        return SHARED_STATUS_NULL_PARAM;
+    }
+
+    return (shm_unlink(name) == 0) ? SHARED_STATUS_SUCCESS : SHARED_STATUS_SYSTEM_ERROR;
+}
+
+int shared_table_process_count(const struct shared_table* table) {
+    if ((table == NULL) || (table->header == NULL)) {
+        return 0;
+    }
+
+    int process_count = 0;
+
+    for (int i = 0; i < SHARED_MAX_PROCESSES; i++) {
+        const int pid = atomic_load(&table->header->process_list[i]);
+        process_count += (pid != 0) && shared_is_alive(pid);
+    }
+
+    return process_count;
+}
+
+enum shared_status shared_table_dispatch(struct shared_table* table, const struct session_event* events,
+    size_t event_count, int* outputs)
+{
+    if ((table == NULL) || (table->header == NULL) || (events == NULL) || (outputs == NULL)) {
+        return SHARED_STATUS_NULL_PARAM;
+    }
+
+    const struct machine_instance* machine = &table->machine;
+
+    /* Nothing is applied if some event is invalid */
+    for (size_t i = 0; i < event_count; i++) {
+        if ((events[i].session >= table->session_count) || (events[i].input < 0) ||
+            (events[i].input >= machine->input_list_size))
+        {
+            return SHARED_STATUS_INVAL_PARAM;
+        }
+    }
+
+    LATENCY_START();
+
+    for (size_t i = 0; i < event_count; i++) {
+        atomic_int* state = &table->state_list[events[i].session];
+        int current_state = atomic_load_explicit(state, memory_order_relaxed);
+        struct machine_trans trans;
+
+        /* Another process moved the session meanwhile, the event applies to its new state */
+        do {
+            trans = machine_get_trans(machine, current_state, events[i].input);
+        } while (!atomic_compare_exchange_weak_explicit(state, &current_state, trans.next_state,
+            memory_order_relaxed, memory_order_relaxed));
+
+        outputs[i] = trans.output;
+    }
+
+    LATENCY_STOP(machine, LATENCY_PATH_DISPATCH, event_count);
+    return SHARED_STATUS_SUCCESS;
+}
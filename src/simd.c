@@ -0,0 +1,353 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "machine.h"
+#include "simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Every chunk of SIMD_CHUNK inputs is handled in two passes. First the
+ * prefix compositions P(j) = T(j - 1) o ... o T(0) of the input transition
+ * functions are built by shuffles. They do not depend on the current state,
+ * so SIMD_BLOCK_CHUNKS chunks are composed side by side. Then the state
+ * before the step j is read as P(j)[state], and the only dependent load left
+ * per chunk is the next chunk state P(SIMD_CHUNK)[state].
+ */
+
+#define SIMD_BLOCK_CHUNKS ((int) 2)
+
+static void simd_emit_chunk(const struct machine_simd* simd, const uint8_t* prefixes, const int* inputs,
+    int* outputs, int* state)
+{
+    const int width = simd->width;
+    const int current_state = *state;
+
+    for (int j = 0; j < SIMD_CHUNK; j++) {
+        int step_state = prefixes[j * width + current_state];
+        outputs[j] = simd->output_table[inputs[j] * width + step_state];
+    }
+
+    *state = prefixes[SIMD_CHUNK * width + current_state];
+}
+
+static void simd_run_scalar(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    const int width = simd->width;
+    int current_state = *state;
+
+    for (size_t i = 0; i < input_count; i++) {
+        outputs[i] = simd->output_table[inputs[i] * width + current_state];
+        current_state = simd->next_vectors[inputs[i] * width + current_state];
+    }
+
+    *state = current_state;
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("ssse3")))
+static size_t simd_run_ssse3(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    _Alignas(64) uint8_t prefixes[SIMD_BLOCK_CHUNKS][(SIMD_CHUNK + 1) * 16];
+    const size_t block_size = SIMD_CHUNK * SIMD_BLOCK_CHUNKS;
+    const size_t block_end = input_count - input_count % block_size;
+    const __m128i identity = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    for (size_t i = 0; i < block_end; i += block_size) {
+        __m128i prefix[SIMD_BLOCK_CHUNKS];
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            prefix[c] = identity;
+        }
+
+        for (int j = 0; j < SIMD_CHUNK; j++) {
+            for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+                const int input = inputs[i + c * SIMD_CHUNK + j];
+                const __m128i trans = _mm_load_si128((const __m128i*) &simd->next_vectors[input * 16]);
+
+                _mm_store_si128((__m128i*) &prefixes[c][j * 16], prefix[c]);
+                prefix[c] = _mm_shuffle_epi8(trans, prefix[c]);
+            }
+        }
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            _mm_store_si128((__m128i*) &prefixes[c][SIMD_CHUNK * 16], prefix[c]);
+            simd_emit_chunk(simd, prefixes[c], inputs + i + c * SIMD_CHUNK, outputs + i + c * SIMD_CHUNK, state);
+        }
+    }
+
+    return block_end;
+}
+
+__attribute__((target("avx2")))
+static size_t simd_run_avx2(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    _Alignas(64) uint8_t prefixes[SIMD_BLOCK_CHUNKS][(SIMD_CHUNK + 1) * 32];
+    const size_t block_size = SIMD_CHUNK * SIMD_BLOCK_CHUNKS;
+    const size_t block_end = input_count - input_count % block_size;
+    const __m256i identity = _mm256_setr_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+
+    for (size_t i = 0; i < block_end; i += block_size) {
+        __m256i prefix[SIMD_BLOCK_CHUNKS];
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            prefix[c] = identity;
+        }
+
+        for (int j = 0; j < SIMD_CHUNK; j++) {
+            for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+                /* VPSHUFB looks up inside 128-bit lanes: shuffle both halves, select by index bit 4 */
+                const uint8_t* lane_vector = &simd->lane_vectors[inputs[i + c * SIMD_CHUNK + j] * 64];
+                const __m256i trans_low = _mm256_load_si256((const __m256i*) lane_vector);
+                const __m256i trans_high = _mm256_load_si256((const __m256i*) (lane_vector + 32));
+                const __m256i select = _mm256_slli_epi16(prefix[c], 3);
+
+                _mm256_store_si256((__m256i*) &prefixes[c][j * 32], prefix[c]);
+                prefix[c] = _mm256_blendv_epi8(
+                    _mm256_shuffle_epi8(trans_low, prefix[c]),
+                    _mm256_shuffle_epi8(trans_high, prefix[c]),
+                    select);
+            }
+        }
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            _mm256_store_si256((__m256i*) &prefixes[c][SIMD_CHUNK * 32], prefix[c]);
+            simd_emit_chunk(simd, prefixes[c], inputs + i + c * SIMD_CHUNK, outputs + i + c * SIMD_CHUNK, state);
+        }
+    }
+
+    return block_end;
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static size_t simd_run_avx512(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    _Alignas(64) uint8_t prefixes[SIMD_BLOCK_CHUNKS][(SIMD_CHUNK + 1) * 64];
+    _Alignas(64) uint8_t identity_bytes[64];
+    const size_t block_size = SIMD_CHUNK * SIMD_BLOCK_CHUNKS;
+    const size_t block_end = input_count - input_count % block_size;
+
+    for (int i = 0; i < 64; i++) {
+        identity_bytes[i] = (uint8_t) i;
+    }
+
+    const __m512i identity = _mm512_load_si512((const void*) identity_bytes);
+
+    for (size_t i = 0; i < block_end; i += block_size) {
+        __m512i prefix[SIMD_BLOCK_CHUNKS];
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            prefix[c] = identity;
+        }
+
+        for (int j = 0; j < SIMD_CHUNK; j++) {
+            for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+                const int input = inputs[i + c * SIMD_CHUNK + j];
+                const __m512i trans = _mm512_load_si512((const void*) &simd->next_vectors[input * 64]);
+
+                _mm512_store_si512((void*) &prefixes[c][j * 64], prefix[c]);
+                prefix[c] = _mm512_permutexvar_epi8(prefix[c], trans);
+            }
+        }
+
+        for (int c = 0; c < SIMD_BLOCK_CHUNKS; c++) {
+            _mm512_store_si512((void*) &prefixes[c][SIMD_CHUNK * 64], prefix[c]);
+            simd_emit_chunk(simd, prefixes[c], inputs + i + c * SIMD_CHUNK, outputs + i + c * SIMD_CHUNK, state);
+        }
+    }
+
+    return block_end;
+}
+
+#endif /* SIMD_X86 */
+
+bool machine_simd_isa_supported(enum simd_isa isa) {
+    switch (isa) {
+    case SIMD_ISA_SCALAR:
+        return true;
+
+#ifdef SIMD_X86
+    case SIMD_ISA_SSSE3:
+        return __builtin_cpu_supports("ssse3");
+
+    case SIMD_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+
+    case SIMD_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vbmi");
+#endif
+
+    default:
+        return false;
+    }
+}
+
+static int simd_isa_width(enum simd_isa isa) {
+    switch (isa) {
+    case SIMD_ISA_SSSE3:
+        return 16;
+
+    case SIMD_ISA_AVX2:
+        return 32;
+
+    default:
+        return 64;
+    }
+}
+
+enum machine_status machine_simd_init(struct machine_simd* simd, const struct machine_instance* machine,
+    enum simd_isa isa)
+{
+    if ((simd == NULL) || (machine == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if ((machine->state_list_size > SIMD_MAX_STATES) || (machine->output_list_size > INT16_MAX)) {
+        return MACHINE_STATUS_UNSUPPORTED;
+    }
+
+    /* Narrowest supported vector which holds all the states */
+    if (isa == SIMD_ISA_AUTO) {
+        const enum simd_isa candidates[] = { SIMD_ISA_SSSE3, SIMD_ISA_AVX2, SIMD_ISA_AVX512 };
+
+        isa = SIMD_ISA_SCALAR;
+
+        for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+            if ((machine->state_list_size <= simd_isa_width(candidates[i])) &&
+                machine_simd_isa_supported(candidates[i]))
+            {
+                isa = candidates[i];
+                break;
+            }
+        }
+    }
+
+    if (!machine_simd_isa_supported(isa) || (machine->state_list_size > simd_isa_width(isa))) {
+        return MACHINE_STATUS_UNSUPPORTED;
+    }
+
+    const int width = simd_isa_width(isa);
+    const size_t vectors_size = (size_t) machine->input_list_size * width;
+
+    simd->isa = isa;
+    simd->width = width;
+    simd->input_list_size = machine->input_list_size;
+    simd->next_vectors = (uint8_t*) aligned_alloc(64, (vectors_size + 63) / 64 * 64);
+    simd->lane_vectors = NULL;
+    simd->output_table = (int16_t*) malloc(vectors_size * sizeof(int16_t));
+
+    for (int i = 0; i < machine->input_list_size; i++) {
+        for (int j = 0; j < width; j++) {
+            /* Lanes above the last state map to themselves and are never read */
+            uint8_t next_state = (uint8_t) j;
+            int16_t output = MACHINE_EMPTY_OUTPUT;
+
+            if (j < machine->state_list_size) {
+                struct machine_trans trans = machine_get_trans(machine, j, i);
+
+                next_state = (uint8_t) trans.next_state;
+                output = (int16_t) trans.output;
+            }
+
+            simd->next_vectors[i * width + j] = next_state;
+            simd->output_table[i * width + j] = output;
+        }
+    }
+
+    if (isa == SIMD_ISA_AVX2) {
+        simd->lane_vectors = (uint8_t*) aligned_alloc(64, (size_t) machine->input_list_size * 64);
+
+        for (int i = 0; i < machine->input_list_size; i++) {
+            uint8_t* lane_vector = &simd->lane_vectors[i * 64];
+
+            memcpy(lane_vector, &simd->next_vectors[i * 32], 16);
+            memcpy(lane_vector + 16, &simd->next_vectors[i * 32], 16);
+            memcpy(lane_vector + 32, &simd->next_vectors[i * 32 + 16], 16);
+            memcpy(lane_vector + 48, &simd->next_vectors[i * 32 + 16], 16);
+        }
+    }
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_simd_free(struct machine_simd* simd) {
+    if (simd == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    free(simd->next_vectors);
+    free(simd->lane_vectors);
+    free(simd->output_table);
+
+    simd->next_vectors = NULL;
+    simd->lane_vectors = NULL;
+    simd->output_table = NULL;
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_simd_run(const struct machine_simd* simd, const int* inputs, size_t input_count,
+    int* outputs, int* state)
+{
+    if ((simd == NULL) || (inputs == NULL) || (outputs == NULL) || (state == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    size_t processed = 0;
+
+    switch (simd->isa) {
+#ifdef SIMD_X86
+    case SIMD_ISA_SSSE3:
+        processed = simd_run_ssse3(simd, inputs, input_count, outputs, state);
+        break;
+
+    case SIMD_ISA_AVX2:
+        processed = simd_run_avx2(simd, inputs, input_count, outputs, state);
+        break;
+
+    case SIMD_ISA_AVX512:
+        processed = simd_run_avx512(simd, inputs, input_count, outputs, state);
+        break;
+#endif
+
+    default:
+        break;
+    }
+
+    simd_run_scalar(simd, inputs + processed, input_count - processed, outputs + processed, state);
+    return MACHINE_STATUS_SUCCESS;
+}
+
+const char* machine_simd_isa_name(enum simd_isa isa) {
+    switch (isa) {
+    case SIMD_ISA_AUTO:
+        return "auto";
+
+    case SIMD_ISA_SCALAR:
+        return "scalar";
+
+    case SIMD_ISA_SSSE3:
+        return "ssse3";
+
+    case SIMD_ISA_AVX2:
+        return "avx2";
+
+    case SIMD_ISA_AVX512:
+        return "avx512";
+
+    default:
+        return "unknown";
+    }
+}
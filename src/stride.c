@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include "machine.h"
+#include "stride.h"
+
+/**
+ * Size of the stride `k` table, SIZE_MAX if it is over the `cache_budget` or its width does not fit an int.
+ * Every product is checked before it is taken, I^k overflows for the large input lists.
+ */
+static size_t machine_stride_table_size(const struct machine_instance* machine, int k, size_t cache_budget) {
+    const size_t input_count = (size_t) machine->input_list_size;
+    const size_t state_count = (size_t) machine->state_list_size;
+    const size_t entry_size = sizeof(int) + k * sizeof(int16_t);
+    size_t width = 1;
+
+    for (int i = 0; i < k; i++) {
+        if ((input_count != 0) && (width > (size_t) INT_MAX / input_count)) {
+            return SIZE_MAX;
+        }
+
+        width *= input_count;
+    }
+
+    if ((state_count != 0) && (width > cache_budget / entry_size / state_count)) {
+        return SIZE_MAX;
+    }
+
+    return state_count * width * entry_size;
+}
+
+enum machine_status machine_stride_init(struct machine_stride* stride, const struct machine_instance* machine,
+    size_t cache_budget)
+{
+    if ((stride == NULL) || (machine == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    if (machine->output_list_size > INT16_MAX) {
+        return MACHINE_STATUS_UNSUPPORTED;
+    }
+
+    /* Table grows as I^k, take the widest stride within the budget */
+    int k = 0;
+
+    for (int i = 2; i <= STRIDE_MAX_K; i++) {
+        if (machine_stride_table_size(machine, i, cache_budget) > cache_budget) {
+            break;
+        }
+
+        k = i;
+    }
+
+    if (k == 0) {
+        return MACHINE_STATUS_UNSUPPORTED;
+    }
+
+    const int input_count = machine->input_list_size;
+
+    int width = 1;
+    for (int i = 0; i < k; i++) {
+        width *= input_count;
+    }
+
+    stride->k = k;
+    stride->width = width;
+    stride->input_list_size = input_count;
+    stride->next_table = (int*) malloc((size_t) machine->state_list_size * width * sizeof(int));
+    stride->output_table = (int16_t*) malloc((size_t) machine->state_list_size * width * k * sizeof(int16_t));
+
+    int inputs[STRIDE_MAX_K];
+
+    for (int i = 0; i < machine->state_list_size; i++) {
+        for (int j = 0; j < width; j++) {
+            const size_t entry = (size_t) i * width + j;
+            int current_state = i;
+
+            /* Decode the input combination, first input is the most significant digit */
+            for (int l = k - 1, combination = j; l >= 0; l--, combination /= input_count) {
+                inputs[l] = combination % input_count;
+            }
+
+            for (int l = 0; l < k; l++) {
+                struct machine_trans trans = machine_get_trans(machine, current_state, inputs[l]);
+
+                stride->output_table[entry * k + l] = (int16_t) trans.output;
+                current_state = trans.next_state;
+            }
+
+            stride->next_table[entry] = current_state;
+        }
+    }
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+enum machine_status machine_stride_free(struct machine_stride* stride) {
+    if (stride == NULL) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    free(stride->next_table);
+    free(stride->output_table);
+
+    stride->next_table = NULL;
+    stride->output_table = NULL;
+    stride->k = 0;
+    stride->width = 0;
+
+    return MACHINE_STATUS_SUCCESS;
+}
+
+/**
+ * Stride loop for the constant `k`, so the input combination and output copy get unrolled
+ */
+static inline size_t machine_stride_loop(const struct machine_stride* stride, const int k,
+    const int* inputs, size_t input_count, int* outputs, int* state)
+{
+    const int input_list_size = stride->input_list_size;
+    const int width = stride->width;
+    const size_t block_end = input_count - input_count % k;
+
+    int current_state = *state;
+
+    for (size_t i = 0; i < block_end; i += k) {
+        int combination = 0;
+
+        for (int j = 0; j < k; j++) {
+            combination = combination * input_list_size + inputs[i + j];
+        }
+
+        const size_t entry = (size_t) current_state * width + combination;
+
+        for (int j = 0; j < k; j++) {
+            outputs[i + j] = stride->output_table[entry * k + j];
+        }
+
+        current_state = stride->next_table[entry];
+    }
+
+    *state = current_state;
+    return block_end;
+}
+
+enum machine_status machine_stride_run(const struct machine_stride* stride, const struct machine_instance* machine,
+    const int* inputs, size_t input_count, int* outputs, int* state)
+{
+    if ((stride == NULL) || (machine == NULL) || (inputs == NULL) || (outputs == NULL) || (state == NULL)) {
+        return MACHINE_STATUS_NULL_PARAM;
+    }
+
+    size_t processed = 0;
+
+    switch (stride->k) {
+    case 2:
+        processed = machine_stride_loop(stride, 2, inputs, input_count, outputs, state);
+        break;
+
+    case 3:
+        processed = machine_stride_loop(stride, 3, inputs, input_count, outputs, state);
+        break;
+
+    case 4:
+        processed = machine_stride_loop(stride, 4, inputs, input_count, outputs, state);
+        break;
+
+    default:
+        return MACHINE_STATUS_INVAL_PARAM;
+    }
+
+    /* Tail shorter than the stride goes through the single-step table */
+    return machine_run(machine, inputs + processed, input_count - processed, outputs + processed, state);
+}
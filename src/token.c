@@ -0,0 +1,101 @@
+#include <string.h>
+#include <ctype.h>
+
+#include "token.h"
+
+void tokenizer_init(struct tokenizer* tokenizer) {
+    tokenizer->data = NULL;
+    tokenizer->size = 0;
+    tokenizer->length = 0;
+    tokenizer->is_skipping = false;
+}
+
+void tokenizer_feed(struct tokenizer* tokenizer, const char* data, size_t size) {
+    tokenizer->data = data;
+    tokenizer->size = size;
+}
+
+enum token_status tokenizer_next(struct tokenizer* tokenizer, const char** token, size_t* length) {
+    const char* data = tokenizer->data;
+    const char* end = data + tokenizer->size;
+
+    for (;;) {
+        /* Skip separators unless a token is already started */
+        if ((tokenizer->length == 0) && !tokenizer->is_skipping) {
+            while ((data < end) && isspace((unsigned char) *data)) {
+                data++;
+            }
+        }
+
+        if (data == end) {
+            tokenizer->data = data;
+            tokenizer->size = 0;
+            return TOKEN_STATUS_NEED_INPUT;
+        }
+
+        const char* token_end = data;
+        while ((token_end < end) && !isspace((unsigned char) *token_end)) {
+            token_end++;
+        }
+
+        const size_t part_length = (size_t) (token_end - data);
+
+        /* Rest of the token which is too long is dropped */
+        if (tokenizer->is_skipping) {
+            data = token_end;
+            tokenizer->is_skipping = (token_end == end);
+            continue;
+        }
+
+        if (tokenizer->length + part_length > TOKEN_MAX_LEN) {
+            tokenizer->length = 0;
+            tokenizer->is_skipping = (token_end == end);
+            tokenizer->data = token_end;
+            tokenizer->size = (size_t) (end - token_end);
+            return TOKEN_STATUS_TOO_LONG;
+        }
+
+        /* Token continues in the next chunk */
+        if (token_end == end) {
+            memcpy(tokenizer->buffer + tokenizer->length, data, part_length);
+            tokenizer->length += part_length;
+            tokenizer->data = end;
+            tokenizer->size = 0;
+            return TOKEN_STATUS_NEED_INPUT;
+        }
+
+        tokenizer->data = token_end;
+        tokenizer->size = (size_t) (end - token_end);
+
+        if (tokenizer->length == 0) {
+            *token = data;
+            *length = part_length;
+        }
+        else {
+            memcpy(tokenizer->buffer + tokenizer->length, data, part_length);
+            tokenizer->length += part_length;
+            tokenizer->buffer[tokenizer->length] = '\0';
+
+            *token = tokenizer->buffer;
+            *length = tokenizer->length;
+            tokenizer->length = 0;
+        }
+
+        return TOKEN_STATUS_READY;
+    }
+}
+
+enum token_status tokenizer_finish(struct tokenizer* tokenizer, const char** token, size_t* length) {
+    tokenizer->is_skipping = false;
+
+    if (tokenizer->length == 0) {
+        return TOKEN_STATUS_NEED_INPUT;
+    }
+
+    tokenizer->buffer[tokenizer->length] = '\0';
+    *token = tokenizer->buffer;
+    *length = tokenizer->length;
+    tokenizer->length = 0;
+
+    return TOKEN_STATUS_READY;
+}
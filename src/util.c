@@ -18,4 +18,31 @@ bool is_blank(const char* str) {
     }
 
     return true;
+}
+
+char* str_token(char* str, const char* delim, char** save_ptr) {
+    char* token = (str != NULL) ? str : *save_ptr;
+
+    if (token == NULL) {
+        return NULL;
+    }
+
+    token += strspn(token, delim);
+
+    if (*token == '\0') {
+        *save_ptr = NULL;
+        return NULL;
+    }
+
+    char* token_end = token + strcspn(token, delim);
+
+    if (*token_end == '\0') {
+        *save_ptr = NULL;
+    }
+    else {
+        *token_end = '\0';
+        *save_ptr = token_end + 1;
+    }
+
+    return token;
 }
\ No newline at end of file